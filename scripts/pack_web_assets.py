@@ -0,0 +1,139 @@
+"""Packs the static web assets into a C++ header embedded into the firmware.
+
+Every file in the web directory is gzipped (deterministically, so unchanged
+files keep their ETag) and written into src/net/web_assets.gen.h as a
+constant array, served by the WebServer under /static/ (see
+src/net/static_assets.h).
+
+Runs as a PlatformIO pre-build script (see extra_scripts in platformio.ini),
+or by hand from the project directory: python scripts/pack_web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+
+CONTENT_TYPES = {
+    ".css": "text/css; charset=utf-8",
+    ".html": "text/html; charset=utf-8",
+    ".ico": "image/x-icon",
+    ".js": "text/javascript; charset=utf-8",
+    ".json": "application/json",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+}
+
+URL_PREFIX = "/static/"
+BYTES_PER_LINE = 12
+
+
+def symbol_name(relative_path):
+    """Returns the name of the C++ array of a file."""
+    name = "".join(c if c.isalnum() else "_" for c in relative_path)
+    return "ASSET_" + name.upper()
+
+
+def pack(relative_path, content):
+    """Returns the C++ definitions of a file and its table entry."""
+    extension = os.path.splitext(relative_path)[1].lower()
+    if extension not in CONTENT_TYPES:
+        raise SystemExit("pack_web_assets: unknown file type: " +
+                         relative_path)
+
+    compressed = gzip.compress(content, compresslevel=9, mtime=0)
+    version = hashlib.sha256(compressed).hexdigest()[:16]
+    symbol = symbol_name(relative_path)
+    path = URL_PREFIX + relative_path
+
+    lines = ["/// " + path + " (" + str(len(content)) + " bytes uncompressed)",
+             "static const uint8_t " + symbol + "[] PROGMEM = {"]
+    for offset in range(0, len(compressed), BYTES_PER_LINE):
+        chunk = compressed[offset:offset + BYTES_PER_LINE]
+        lines.append("  " + ", ".join("0x%02x" % byte for byte in chunk) + ",")
+    lines.append("};")
+
+    entry = ('  {"%s", fnv1a("%s", %d),\n'
+             '   "%s", "\\"%s\\"", "%s",\n'
+             '   %s, sizeof(%s)},'
+             % (path, path, len(path), CONTENT_TYPES[extension], version,
+                version, symbol, symbol))
+    return "\n".join(lines), entry
+
+
+def generate(web_dir, header_path):
+    """Writes the header, if its content changed."""
+    files = []
+    for root, _, names in os.walk(web_dir):
+        for name in names:
+            relative_path = os.path.relpath(os.path.join(root, name), web_dir)
+            files.append(relative_path.replace(os.sep, "/"))
+
+    definitions = []
+    entries = []
+    for relative_path in sorted(files):
+        with open(os.path.join(web_dir, relative_path), "rb") as file:
+            definition, entry = pack(relative_path, file.read())
+        definitions.append(definition)
+        entries.append(entry)
+
+    if entries:
+        table = "\n".join(["inline constexpr StaticAsset WEB_ASSETS[] = {"]
+                          + entries + ["};"])
+    else:
+        table = "inline constexpr const StaticAsset *WEB_ASSETS = nullptr;"
+
+    header = "\n".join([
+        "//===-- net/web_assets.gen.h - Generated static web assets "
+        "----------------===//",
+        "//",
+        "// Generated by scripts/pack_web_assets.py from the web directory,",
+        "// DO NOT EDIT.",
+        "//",
+        "//===" + "-" * 70 + "===//",
+        "",
+        "#ifndef NET_WEB_ASSETS_GEN_H",
+        "#define NET_WEB_ASSETS_GEN_H",
+        "",
+        "namespace PTS",
+        "{",
+        "",
+        "namespace ASSETS",
+        "{",
+        "",
+        "\n\n".join(definitions),
+        "",
+        "/// The embedded assets.",
+        table,
+        "",
+        "inline constexpr size_t WEB_ASSET_COUNT = %d;" % len(entries),
+        "",
+        "} // namespace ASSETS",
+        "",
+        "} // namespace PTS",
+        "",
+        "#endif // NET_WEB_ASSETS_GEN_H",
+        "",
+    ])
+
+    if os.path.exists(header_path):
+        with open(header_path) as file:
+            if file.read() == header:
+                return
+    with open(header_path, "w") as file:
+        file.write(header)
+    print("pack_web_assets: packed %d files into %s" % (len(entries),
+                                                       header_path))
+
+
+def main(project_dir):
+    generate(os.path.join(project_dir, "web"),
+             os.path.join(project_dir, "src", "net", "web_assets.gen.h"))
+
+
+try:
+    Import  # noqa: F821 - defined when run by PlatformIO (SCons)
+except NameError:
+    main(os.getcwd())
+else:
+    Import("env")  # noqa: F821
+    main(env.subst("$PROJECT_DIR"))  # noqa: F821
@@ -0,0 +1,622 @@
+//===-- sim/Arduino.h - Host simulation of the Arduino core ---------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host (Linux) stand-in of the parts of the
+/// ESP32 Arduino core and FreeRTOS used by PTS, so that the sources build and
+/// run natively for tests and benchmarks (see the native environments in
+/// platformio.ini, which put the sim directory on the include path).
+///
+/// Time is the monotonic clock of the host, tasks are threads, and the pins
+/// are plain memory that tests can inspect through the SIM namespace. Only
+/// the used subset of every API is provided.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <pthread.h>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+
+#define PROGMEM
+
+using byte = uint8_t;
+
+namespace SIM
+{
+
+/// The number of simulated GPIO pins.
+static constexpr uint8_t PIN_COUNT = 40;
+
+/// \return the moment the simulation started (the zero of millis()).
+inline std::chrono::steady_clock::time_point epoch()
+{
+  static const auto epoch_ = std::chrono::steady_clock::now();
+  return epoch_;
+}
+
+/// \return the simulated pin levels (pins read back what was written).
+inline std::atomic<uint8_t> (&pinLevels())[PIN_COUNT]
+{
+  static std::atomic<uint8_t> levels_[PIN_COUNT];
+  return levels_;
+}
+
+/// \return the simulated pin modes.
+inline std::atomic<uint8_t> (&pinModes())[PIN_COUNT]
+{
+  static std::atomic<uint8_t> modes_[PIN_COUNT];
+  return modes_;
+}
+
+/// \return whether the Serial output is printed to stdout (benchmarks turn it
+/// off so the log doesn't skew them).
+inline std::atomic<bool> &serialEnabled()
+{
+  static std::atomic<bool> enabled_(true);
+  return enabled_;
+}
+
+} // namespace SIM
+
+//===-- Timing functions --------------------------------------------------===//
+
+inline unsigned long millis()
+{
+  return static_cast<unsigned long>(
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - SIM::epoch()).count());
+}
+
+inline unsigned long micros()
+{
+  return static_cast<unsigned long>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - SIM::epoch()).count());
+}
+
+inline void delay(uint32_t ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(uint32_t us)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+/// The hardware random number generator of the ESP32.
+inline uint32_t esp_random()
+{
+  static std::atomic<uint64_t> state_(
+    static_cast<uint64_t>(
+      std::chrono::system_clock::now().time_since_epoch().count()));
+  const uint64_t state = state_.fetch_add(0x9E3779B97F4A7C15ull);
+  return static_cast<uint32_t>((state ^ (state >> 29)) * 0xBF58476D1CE4E5B9ull
+                               >> 32);
+}
+
+//===-- GPIO functions ----------------------------------------------------===//
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin >= SIM::PIN_COUNT) return;
+  SIM::pinModes()[pin] = mode;
+  if (mode == INPUT_PULLUP) SIM::pinLevels()[pin] = HIGH;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+  if (pin < SIM::PIN_COUNT) SIM::pinLevels()[pin] = level ? HIGH : LOW;
+}
+
+inline int digitalRead(uint8_t pin)
+{
+  return pin < SIM::PIN_COUNT ? SIM::pinLevels()[pin].load() : LOW;
+}
+
+//===-- LEDC functions ----------------------------------------------------===//
+
+namespace SIM
+{
+
+/// The number of LEDC channels.
+static constexpr uint8_t LEDC_CHANNEL_COUNT = 16;
+/// The clock of the LEDC timers, bounding frequency times resolution.
+static constexpr uint32_t LEDC_CLOCK_HZ = 80000000;
+
+/// A simulated LEDC channel. A fade moves the duty linearly from its start
+/// to its target, the duty is computed when it is read.
+struct LedcChannel
+{
+  uint32_t frequency;
+  uint8_t resolution;
+  uint32_t duty;
+  uint32_t target;
+  uint32_t fade_start_ms;
+  uint32_t fade_ms;
+  /// The fade set up with ledc_set_fade_with_time(), until it is started.
+  uint32_t pending_target;
+  uint32_t pending_fade_ms;
+  /// The number of duty writes and started fades.
+  uint32_t writes;
+};
+
+/// \return the lock of the LEDC channels.
+inline std::mutex &ledcLock()
+{
+  static std::mutex lock_;
+  return lock_;
+}
+
+/// \return the simulated LEDC channels (lock ledcLock() to access them).
+inline LedcChannel (&ledcChannels())[LEDC_CHANNEL_COUNT]
+{
+  static LedcChannel channels_[LEDC_CHANNEL_COUNT];
+  return channels_;
+}
+
+/// \return the channel the pins are attached to, -1 for none.
+inline std::atomic<int8_t> (&ledcPins())[PIN_COUNT]
+{
+  static std::atomic<int8_t> pins_[PIN_COUNT];
+  static const bool detached_ = []()
+  {
+    for (auto &pin : pins_) pin = -1;
+    return true;
+  }();
+  (void)detached_;
+  return pins_;
+}
+
+/// \return the duty of a channel at a time, within its fade (lock
+/// ledcLock()).
+inline uint32_t ledcDutyAt(const LedcChannel &channel, uint32_t now)
+{
+  const uint32_t elapsed = now - channel.fade_start_ms;
+  if (channel.fade_ms == 0 || elapsed >= channel.fade_ms)
+    return channel.target;
+
+  const int64_t difference =
+    static_cast<int64_t>(channel.target) - channel.duty;
+  return static_cast<uint32_t>(channel.duty +
+                               difference * elapsed / channel.fade_ms);
+}
+
+/// \return the current duty of a channel.
+inline uint32_t ledcDuty(uint8_t channel)
+{
+  if (channel >= LEDC_CHANNEL_COUNT) return 0;
+
+  std::lock_guard<std::mutex> lock(ledcLock());
+  return ledcDutyAt(ledcChannels()[channel],
+                    static_cast<uint32_t>(millis()));
+}
+
+/// \return the number of duty writes and started fades of a channel.
+inline uint32_t ledcWrites(uint8_t channel)
+{
+  if (channel >= LEDC_CHANNEL_COUNT) return 0;
+
+  std::lock_guard<std::mutex> lock(ledcLock());
+  return ledcChannels()[channel].writes;
+}
+
+} // namespace SIM
+
+/// Sets up a channel.
+/// \return the frequency, 0 if the timer can't run that fast.
+inline uint32_t ledcSetup(uint8_t channel, uint32_t frequency,
+                          uint8_t resolution)
+{
+  if (channel >= SIM::LEDC_CHANNEL_COUNT || resolution == 0 ||
+      resolution > 20 ||
+      static_cast<uint64_t>(frequency) << resolution > SIM::LEDC_CLOCK_HZ)
+    return 0;
+
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  SIM::ledcChannels()[channel] = SIM::LedcChannel{frequency, resolution, 0, 0,
+                                                  0, 0, 0, 0, 0};
+  return frequency;
+}
+
+inline void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+  if (pin >= SIM::PIN_COUNT || channel >= SIM::LEDC_CHANNEL_COUNT) return;
+  SIM::ledcPins()[pin] = static_cast<int8_t>(channel);
+  SIM::pinModes()[pin] = OUTPUT;
+}
+
+inline void ledcDetachPin(uint8_t pin)
+{
+  if (pin < SIM::PIN_COUNT) SIM::ledcPins()[pin] = -1;
+}
+
+/// Sets the duty of a channel (stop a running fade first, see driver/ledc.h).
+inline void ledcWrite(uint8_t channel, uint32_t duty)
+{
+  if (channel >= SIM::LEDC_CHANNEL_COUNT) return;
+
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  SIM::LedcChannel &state = SIM::ledcChannels()[channel];
+  state.duty = duty;
+  state.target = duty;
+  state.fade_ms = 0;
+  state.writes++;
+}
+
+inline uint32_t ledcRead(uint8_t channel)
+{
+  return SIM::ledcDuty(channel);
+}
+
+/// Plays a square wave on a channel (at 10-bit resolution, half duty), 0 Hz
+/// for silence.
+/// \return the frequency, 0 if silent or the timer can't run that fast.
+inline uint32_t ledcWriteTone(uint8_t channel, uint32_t frequency)
+{
+  if (channel >= SIM::LEDC_CHANNEL_COUNT) return 0;
+
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  SIM::LedcChannel &state = SIM::ledcChannels()[channel];
+  const bool valid = frequency != 0 &&
+                     static_cast<uint64_t>(frequency) << 10 <=
+                       SIM::LEDC_CLOCK_HZ;
+  if (valid)
+  {
+    state.frequency = frequency;
+    state.resolution = 10;
+  }
+  state.duty = valid ? 0x1FF : 0;
+  state.target = state.duty;
+  state.fade_ms = 0;
+  state.writes++;
+  return valid ? frequency : 0;
+}
+
+inline uint32_t ledcReadFreq(uint8_t channel)
+{
+  if (channel >= SIM::LEDC_CHANNEL_COUNT) return 0;
+
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  return SIM::ledcChannels()[channel].frequency;
+}
+
+//===-- Printing classes --------------------------------------------------===//
+
+class Print;
+
+/// Interface of the objects that can print themselves.
+class Printable
+{
+ public:
+  virtual ~Printable() = default;
+  virtual size_t printTo(Print &printer) const = 0;
+};
+
+/// Minimal std::string backed String class.
+class String
+{
+ public:
+  String(const char *text = "") : m_text(text ? text : "") { }
+  String(const std::string &text) : m_text(text) { }
+
+  [[nodiscard]] const char *c_str() const { return m_text.c_str(); }
+  [[nodiscard]] size_t length() const { return m_text.length(); }
+
+ private:
+  std::string m_text;
+};
+
+/// Base class of the byte sinks, with the text formatting on top of write().
+class Print
+{
+ public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t character) = 0;
+
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t written = 0;
+    while (size--) written += write(*buffer++);
+    return written;
+  }
+
+  size_t write(const char *text)
+  {
+    return text ? write(reinterpret_cast<const uint8_t*>(text),
+                        std::strlen(text))
+                : 0;
+  }
+
+  size_t write(const char *buffer, size_t size)
+  {
+    return write(reinterpret_cast<const uint8_t*>(buffer), size);
+  }
+
+  virtual void flush() { }
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(const String &text) { return write(text.c_str()); }
+  size_t print(char character)
+  {
+    return write(static_cast<uint8_t>(character));
+  }
+  size_t print(unsigned char number) { return printNumber("%u", number); }
+  size_t print(int number) { return printNumber("%d", number); }
+  size_t print(unsigned int number) { return printNumber("%u", number); }
+  size_t print(long number) { return printNumber("%ld", number); }
+  size_t print(unsigned long number) { return printNumber("%lu", number); }
+  size_t print(long long number) { return printNumber("%lld", number); }
+  size_t print(unsigned long long number)
+  {
+    return printNumber("%llu", number);
+  }
+  size_t print(double number, int digits = 2)
+  {
+    char text[32];
+    const int length = std::snprintf(text, sizeof(text), "%.*f", digits,
+                                     number);
+    return write(text, static_cast<size_t>(length));
+  }
+  size_t print(const Printable &printable) { return printable.printTo(*this); }
+
+  template<typename TYPE>
+  size_t println(TYPE arg) { return print(arg) + println(); }
+  size_t println() { return write("\r\n"); }
+
+ private:
+  template<typename TYPE>
+  size_t printNumber(const char *format, TYPE number)
+  {
+    char text[24];
+    const int length = std::snprintf(text, sizeof(text), format, number);
+    return write(text, static_cast<size_t>(length));
+  }
+};
+
+/// Base class of the byte sources.
+class Stream : public Print
+{
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+/// The serial port, printing to stdout.
+class HardwareSerial : public Stream
+{
+ public:
+  void begin(unsigned long) { }
+
+  size_t write(uint8_t character) override
+  {
+    if (SIM::serialEnabled()) std::fputc(character, stdout);
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    if (SIM::serialEnabled()) std::fwrite(buffer, 1, size, stdout);
+    return size;
+  }
+  using Print::write;
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+inline HardwareSerial Serial;
+
+/// IPv4 address.
+class IPAddress : public Printable
+{
+ public:
+  IPAddress() : m_octets{0, 0, 0, 0} { }
+  IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+    : m_octets{first, second, third, fourth}
+  { }
+
+  [[nodiscard]] uint8_t operator[](size_t idx) const { return m_octets[idx]; }
+
+  [[nodiscard]] String toString() const
+  {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%u.%u.%u.%u", m_octets[0], m_octets[1],
+                  m_octets[2], m_octets[3]);
+    return String(text);
+  }
+
+  size_t printTo(Print &printer) const override
+  {
+    return printer.print(toString());
+  }
+
+ private:
+  uint8_t m_octets[4];
+};
+
+//===-- FreeRTOS functions ------------------------------------------------===//
+
+using BaseType_t = int;
+using UBaseType_t = unsigned int;
+using TickType_t = uint32_t;
+
+namespace SIM
+{
+
+/// The control block of a task. Threads can't be stopped from outside, so a
+/// suspended or deleted task is stopped at its next delay (or right away, if
+/// it suspends or deletes itself). The blocks are never freed, handles stay
+/// usable after deletion.
+struct Task
+{
+  std::mutex lock;
+  std::condition_variable resumed;
+  bool suspended = false;
+  bool deleted = false;
+  /// Set as a deleted task stops.
+  bool stopped = false;
+};
+
+/// \return the control block of the calling task (nullptr for the main
+/// thread).
+inline Task *&currentTask()
+{
+  static thread_local Task *task = nullptr;
+  return task;
+}
+
+/// Stops the calling task while it is suspended, and ends it if it has been
+/// deleted.
+inline void checkTask(Task *task)
+{
+  if (!task) return;
+
+  std::unique_lock<std::mutex> lock(task->lock);
+  task->resumed.wait(lock, [task]() { return !task->suspended; });
+  if (task->deleted)
+  {
+    task->stopped = true;
+    task->resumed.notify_all();
+    lock.unlock();
+    pthread_exit(nullptr);
+  }
+}
+
+} // namespace SIM
+
+using TaskHandle_t = SIM::Task*;
+using TaskFunction_t = void(*)(void*);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define tskIDLE_PRIORITY 0
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms) / portTICK_PERIOD_MS)
+
+/// Starts a task as a detached thread. Priorities and stack sizes are ignored,
+/// the handle suspends and deletes the task at its delays (see SIM::Task).
+inline BaseType_t xTaskCreate(TaskFunction_t function,
+                              const char*,
+                              uint32_t,
+                              void *parameters,
+                              UBaseType_t,
+                              TaskHandle_t *handle)
+{
+  SIM::Task *task = new SIM::Task();
+  if (handle) *handle = task;
+  std::thread([function, parameters, task]()
+  {
+    SIM::currentTask() = task;
+    function(parameters);
+  }).detach();
+  return pdPASS;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return SIM::currentTask();
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+  return static_cast<TickType_t>(millis() / portTICK_PERIOD_MS);
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+  SIM::checkTask(SIM::currentTask());
+  delay(ticks * portTICK_PERIOD_MS);
+  SIM::checkTask(SIM::currentTask());
+}
+
+/// Delays until previous + increment, like the FreeRTOS function.
+/// \return pdFALSE, if that time has already passed, pdTRUE otherwise.
+inline BaseType_t xTaskDelayUntil(TickType_t *previous, TickType_t increment)
+{
+  *previous += increment;
+  const int32_t remaining =
+    static_cast<int32_t>(*previous - xTaskGetTickCount());
+  if (remaining <= 0)
+  {
+    SIM::checkTask(SIM::currentTask());
+    return pdFALSE;
+  }
+
+  vTaskDelay(static_cast<TickType_t>(remaining));
+  return pdTRUE;
+}
+
+/// Suspends a task (nullptr for the calling one).
+inline void vTaskSuspend(TaskHandle_t handle)
+{
+  SIM::Task *task = handle ? handle : SIM::currentTask();
+  if (!task) return;
+
+  {
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->suspended = true;
+  }
+  if (task == SIM::currentTask()) SIM::checkTask(task);
+}
+
+inline void vTaskResume(TaskHandle_t handle)
+{
+  if (!handle) return;
+
+  std::lock_guard<std::mutex> lock(handle->lock);
+  handle->suspended = false;
+  handle->resumed.notify_all();
+}
+
+/// Deletes a task (nullptr for the calling one, which doesn't return).
+/// Another task runs no more after the call, like on the hardware: the call
+/// waits for it to stop at its next delay.
+inline void vTaskDelete(TaskHandle_t handle)
+{
+  SIM::Task *task = handle ? handle : SIM::currentTask();
+  if (!task) return;
+
+  std::unique_lock<std::mutex> lock(task->lock);
+  task->deleted = true;
+  task->suspended = false;
+  task->resumed.notify_all();
+  if (task == SIM::currentTask())
+  {
+    lock.unlock();
+    SIM::checkTask(task);
+  }
+  task->resumed.wait(lock, [task]() { return task->stopped; });
+}
+
+#endif // SIM_ARDUINO_H
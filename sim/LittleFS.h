@@ -0,0 +1,100 @@
+//===-- sim/LittleFS.h - Host simulation of the ESP32 LittleFS library ----===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the ESP32 LittleFS library,
+/// backed by the files of a host directory: "data" (the directory PlatformIO
+/// uploads with "pio run -t uploadfs"), or the one in the PTS_SIM_FS
+/// environment variable. Only reading is provided.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <Arduino.h>
+
+namespace fs
+{
+
+/// A file opened for reading.
+class File : public Stream
+{
+ public:
+  File() = default;
+  explicit File(std::FILE *file)
+  : m_file(file, [](std::FILE *opened) { std::fclose(opened); })
+  { }
+
+  explicit operator bool() const { return m_file != nullptr; }
+
+  size_t read(uint8_t *buffer, size_t size)
+  {
+    return m_file ? std::fread(buffer, 1, size, m_file.get()) : 0;
+  }
+
+  int read() override
+  {
+    return m_file ? std::fgetc(m_file.get()) : -1;
+  }
+
+  int peek() override
+  {
+    if (!m_file) return -1;
+    const int character = std::fgetc(m_file.get());
+    if (character != EOF) std::ungetc(character, m_file.get());
+    return character;
+  }
+
+  int available() override { return peek() == -1 ? 0 : 1; }
+
+  size_t write(uint8_t) override { return 0; }
+  using Print::write;
+
+  void close() { m_file.reset(); }
+
+ private:
+  std::shared_ptr<std::FILE> m_file;
+};
+
+/// The file system, rooted in the host directory.
+class LittleFSFS
+{
+ public:
+  bool begin(bool = false) { return true; }
+
+  bool exists(const char *path) const
+  {
+    std::FILE *file = std::fopen(hostPath(path).c_str(), "rb");
+    if (file) std::fclose(file);
+    return file != nullptr;
+  }
+
+  File open(const char *path, const char * = "r") const
+  {
+    return File(std::fopen(hostPath(path).c_str(), "rb"));
+  }
+
+ private:
+  static std::string hostPath(const char *path)
+  {
+    const char *root = std::getenv("PTS_SIM_FS");
+    return std::string(root ? root : "data") + path;
+  }
+};
+
+} // namespace fs
+
+using fs::File;
+
+inline fs::LittleFSFS LittleFS;
+
+#endif // SIM_LITTLEFS_H
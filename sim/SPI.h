@@ -0,0 +1,169 @@
+//===-- sim/SPI.h - Host simulation of the Arduino SPI library ------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the SPI bus. A bus clocks
+/// its bytes through a simulated device (e.g. SIM::ShiftRegisterChain), and
+/// counts its transactions, bytes and time on the wire, so tests can check
+/// the traffic of a scan.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_LSBFIRST 0
+#define SPI_MSBFIRST 1
+
+namespace SIM
+{
+
+/// The traffic of a simulated bus.
+struct BusStats
+{
+  /// The transactions, from a start to a stop.
+  uint32_t transactions = 0;
+  /// The bytes clocked (including addresses on I2C).
+  uint32_t bytes = 0;
+  /// The time on the wire at the bus clock.
+  uint64_t bus_ns = 0;
+};
+
+/// A simulated device on the SPI bus.
+class SpiDevice
+{
+ public:
+  virtual ~SpiDevice() = default;
+
+  /// Called at the start of a transaction.
+  virtual void select() { }
+
+  /// Clocks a byte through the device.
+  /// \return the byte shifted out of the device.
+  virtual uint8_t transfer(uint8_t out) = 0;
+
+  /// Called at the end of a transaction.
+  virtual void deselect() { }
+};
+
+/// A chain of 74HC165 (parallel in) and 74HC595 (parallel out) shift
+/// registers on a bus. The load and latch pulses around a transaction are
+/// assumed: the inputs are loaded at its start, the outputs latched at its
+/// end.
+class ShiftRegisterChain : public SpiDevice
+{
+ public:
+  /// \param inputs the number of 74HC165s, register 0 nearest to MISO.
+  /// \param outputs the number of 74HC595s, register 0 nearest to MOSI.
+  ShiftRegisterChain(size_t inputs, size_t outputs)
+  : m_inputs(inputs, 0), m_outputs(outputs, 0), m_sent(), m_received(0)
+  { }
+
+  /// Sets the levels on the inputs of a 74HC165.
+  void setInput(size_t reg, uint8_t levels) { m_inputs.at(reg) = levels; }
+
+  /// \return the levels latched on the outputs of a 74HC595.
+  [[nodiscard]] uint8_t output(size_t reg) const { return m_outputs.at(reg); }
+
+  void select() override
+  {
+    m_sent.clear();
+    m_received = 0;
+  }
+
+  uint8_t transfer(uint8_t out) override
+  {
+    m_sent.push_back(out);
+    // Past the end of the chain the serial input (tied low) shifts out.
+    const size_t reg = m_received++;
+    return reg < m_inputs.size() ? m_inputs[reg] : 0;
+  }
+
+  void deselect() override
+  {
+    // The last bytes sent stay in the chain, the very last nearest to MOSI.
+    for (size_t reg = 0; reg != m_outputs.size() && reg < m_sent.size(); reg++)
+      m_outputs[reg] = m_sent[m_sent.size() - 1 - reg];
+  }
+
+ private:
+  std::vector<uint8_t> m_inputs;
+  std::vector<uint8_t> m_outputs;
+  std::vector<uint8_t> m_sent;
+  size_t m_received;
+};
+
+} // namespace SIM
+
+class SPISettings
+{
+ public:
+  SPISettings() : _clock(1000000), _bitOrder(SPI_MSBFIRST), _dataMode(0) { }
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+  : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode)
+  { }
+
+  uint32_t _clock;
+  uint8_t _bitOrder;
+  uint8_t _dataMode;
+};
+
+class SPIClass
+{
+ public:
+  void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) { }
+  void end() { }
+
+  void beginTransaction(SPISettings settings)
+  {
+    m_lock.lock();
+    m_clock = settings._clock;
+    sim_stats.transactions++;
+    if (sim_device != nullptr) sim_device->select();
+  }
+
+  void endTransaction()
+  {
+    if (sim_device != nullptr) sim_device->deselect();
+    m_lock.unlock();
+  }
+
+  uint8_t transfer(uint8_t data)
+  {
+    sim_stats.bytes++;
+    sim_stats.bus_ns += 8000000000ull / m_clock;
+    return sim_device != nullptr ? sim_device->transfer(data) : 0xFF;
+  }
+
+  void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size)
+  {
+    for (uint32_t idx = 0; idx != size; idx++)
+    {
+      const uint8_t in = transfer(data != nullptr ? data[idx] : 0xFF);
+      if (out != nullptr) out[idx] = in;
+    }
+  }
+
+  /// The simulated device on the bus (the chip select is not simulated).
+  SIM::SpiDevice *sim_device = nullptr;
+  /// The traffic of the bus.
+  SIM::BusStats sim_stats;
+
+ private:
+  std::mutex m_lock;
+  uint32_t m_clock = 1000000;
+};
+
+inline SPIClass SPI;
+
+#endif // SIM_SPI_H
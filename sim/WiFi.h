@@ -0,0 +1,446 @@
+//===-- sim/WiFi.h - Host simulation of the ESP32 WiFi library ------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the ESP32 WiFi library,
+/// backed by POSIX TCP and UDP sockets on the loopback interface.
+///
+/// Like on the ESP32, copies of a WiFiClient share the socket, reads never
+/// block, writes do, and fd() exposes the socket for select() and send().
+/// Servers listen on their port plus SIM::portOffset(), so the simulation
+/// doesn't need privileged ports. Accepted connections get a send buffer as
+/// small as that of lwIP, so slow peers fill it as fast as on the device. UDP
+/// ports are used as they are, and a part of the sent datagrams can be
+/// dropped (see SIM::udpLossPercent()) to test protocols against loss.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Arduino.h"
+
+namespace SIM
+{
+
+/// \return the offset added to the port of every simulated server.
+inline std::atomic<uint16_t> &portOffset()
+{
+  static std::atomic<uint16_t> offset_(8000);
+  return offset_;
+}
+
+/// \return the percentage of the sent UDP datagrams silently dropped.
+inline std::atomic<uint8_t> &udpLossPercent()
+{
+  static std::atomic<uint8_t> percent_(0);
+  return percent_;
+}
+
+/// \return whether the next datagram is lost (a fixed pseudo-random
+/// sequence, so runs are repeatable).
+inline bool loseDatagram()
+{
+  static std::atomic<uint32_t> state_(12345);
+  const uint32_t state = state_.fetch_add(0x9E3779B9u) * 2654435761u;
+  return (state >> 16) % 100 < udpLossPercent();
+}
+
+} // namespace SIM
+
+/// A TCP connection.
+class WiFiClient : public Stream
+{
+  /// Owner of the socket, closing it with the last copy of the client.
+  struct Socket
+  {
+    explicit Socket(int fd_) : fd(fd_) { }
+    ~Socket() { close(); }
+
+    void close()
+    {
+      if (fd >= 0) ::close(fd);
+      fd = -1;
+    }
+
+    int fd;
+  };
+
+ public:
+  WiFiClient() : m_socket() { }
+  explicit WiFiClient(int fd) : m_socket(std::make_shared<Socket>(fd)) { }
+
+  /// \return the socket, -1 if the client is not connected.
+  [[nodiscard]] int fd() const { return m_socket ? m_socket->fd : -1; }
+
+  /// \return non-zero, if the connection is open (the peer may have sent
+  /// data before closing, it is connected until that is read).
+  uint8_t connected()
+  {
+    if (fd() < 0) return 0;
+
+    char probe;
+    const ssize_t result = ::recv(fd(), &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (result > 0) return 1;
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+    stop();
+    return 0;
+  }
+
+  explicit operator bool() { return connected(); }
+
+  void stop()
+  {
+    if (m_socket) m_socket->close();
+    m_socket.reset();
+  }
+
+  int available() override
+  {
+    int length = 0;
+    if (fd() < 0 || ::ioctl(fd(), FIONREAD, &length) < 0) return 0;
+    return length;
+  }
+
+  /// Reads without blocking.
+  /// \return the number of bytes read, -1 if there were none.
+  int read(uint8_t *buffer, size_t size)
+  {
+    if (fd() < 0) return -1;
+    const ssize_t length = ::recv(fd(), buffer, size, MSG_DONTWAIT);
+    return length > 0 ? static_cast<int>(length) : -1;
+  }
+
+  int read() override
+  {
+    uint8_t character;
+    return read(&character, 1) == 1 ? character : -1;
+  }
+
+  int peek() override
+  {
+    uint8_t character;
+    if (fd() < 0 ||
+        ::recv(fd(), &character, 1, MSG_PEEK | MSG_DONTWAIT) != 1)
+      return -1;
+    return character;
+  }
+
+  size_t write(uint8_t character) override { return write(&character, 1); }
+
+  /// Writes every byte, blocking while the socket buffer is full.
+  /// \return the number of bytes written (less on failure).
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    size_t written = 0;
+    while (fd() >= 0 && written != size)
+    {
+      const ssize_t length =
+        ::send(fd(), buffer + written, size - written, MSG_NOSIGNAL);
+      if (length <= 0) break;
+      written += static_cast<size_t>(length);
+    }
+    return written;
+  }
+  using Print::write;
+
+  void setNoDelay(bool no_delay)
+  {
+    const int flag = no_delay;
+    if (fd() >= 0)
+      ::setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+  }
+
+  [[nodiscard]] IPAddress remoteIP() const
+  {
+    sockaddr_in address{};
+    if (!peer(address)) return IPAddress();
+    const uint32_t host = ntohl(address.sin_addr.s_addr);
+    return IPAddress(host >> 24, host >> 16, host >> 8, host);
+  }
+
+  [[nodiscard]] uint16_t remotePort() const
+  {
+    sockaddr_in address{};
+    return peer(address) ? ntohs(address.sin_port) : 0;
+  }
+
+ private:
+  bool peer(sockaddr_in &address) const
+  {
+    socklen_t length = sizeof(address);
+    return fd() >= 0 && ::getpeername(fd(),
+      reinterpret_cast<sockaddr*>(&address), &length) == 0;
+  }
+
+  std::shared_ptr<Socket> m_socket;
+};
+
+/// A listening TCP socket on the loopback interface.
+class WiFiServer
+{
+  /// The send buffer of lwIP connections (TCP_SND_BUF of the ESP32 core).
+  static constexpr int SEND_BUFFER = 5744;
+
+ public:
+  explicit WiFiServer(uint16_t port = 80) : m_port(port), m_fd(-1) { }
+  ~WiFiServer() { end(); }
+
+  WiFiServer(const WiFiServer &other) : m_port(other.m_port), m_fd(-1) { }
+
+  /// Starts listening (without blocking accepts).
+  void begin()
+  {
+    if (m_fd >= 0) return;
+
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // Inherited by the accepted sockets.
+    ::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &SEND_BUFFER,
+                 sizeof(SEND_BUFFER));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port());
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(m_fd, 128) != 0)
+    {
+      std::perror("WiFiServer::begin");
+      end();
+      return;
+    }
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+  }
+
+  void end()
+  {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+  }
+
+  /// \return the host port the server listens on.
+  [[nodiscard]] uint16_t port() const { return m_port + SIM::portOffset(); }
+
+  /// \return true, if a connection is waiting to be accepted.
+  bool hasClient()
+  {
+    if (m_fd < 0) return false;
+    pollfd request{m_fd, POLLIN, 0};
+    return ::poll(&request, 1, 0) == 1;
+  }
+
+  /// \return the next waiting connection, or a disconnected client.
+  WiFiClient accept()
+  {
+    if (m_fd < 0) return WiFiClient();
+    const int fd = ::accept(m_fd, nullptr, nullptr);
+    return fd >= 0 ? WiFiClient(fd) : WiFiClient();
+  }
+
+  WiFiClient available() { return accept(); }
+
+ private:
+  uint16_t m_port;
+  int m_fd;
+};
+
+/// A UDP socket on the loopback interface. Datagrams to the broadcast
+/// address go to the loopback broadcast address, multicast groups are joined
+/// and sent to on the loopback interface, so every socket of the host bound to
+/// the port (or in the group) receives them.
+class WiFiUDP
+{
+ public:
+  WiFiUDP()
+    : m_fd(-1), m_in(), m_length(0), m_offset(0), m_remote(), m_remote_port(0),
+      m_destination(), m_out()
+  { }
+  ~WiFiUDP() { stop(); }
+
+  WiFiUDP(const WiFiUDP&) = delete;
+  WiFiUDP& operator=(const WiFiUDP&) = delete;
+
+  /// Binds the socket to a port (0 for any).
+  /// \return 1, if it succeeded, 0 otherwise.
+  uint8_t begin(uint16_t port)
+  {
+    stop();
+    m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    const int enable = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    ::setsockopt(m_fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) != 0)
+    {
+      std::perror("WiFiUDP::begin");
+      stop();
+      return 0;
+    }
+    const in_addr loopback{htonl(INADDR_LOOPBACK)};
+    ::setsockopt(m_fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback,
+                 sizeof(loopback));
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    return 1;
+  }
+
+  /// Binds the socket to a port and joins a multicast group.
+  /// \return 1, if it succeeded, 0 otherwise.
+  uint8_t beginMulticast(IPAddress group, uint16_t port)
+  {
+    if (!begin(port)) return 0;
+
+    ip_mreq request{};
+    request.imr_multiaddr.s_addr = htonl(address(group));
+    request.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    if (::setsockopt(m_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request,
+                     sizeof(request)) != 0)
+    {
+      std::perror("WiFiUDP::beginMulticast");
+      stop();
+      return 0;
+    }
+    return 1;
+  }
+
+  void stop()
+  {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+  }
+
+  /// Starts a datagram to an address.
+  /// \return 1, if the socket is open, 0 otherwise.
+  int beginPacket(IPAddress ip, uint16_t port)
+  {
+    if (m_fd < 0) return 0;
+
+    m_out.clear();
+    const bool broadcast = ip[0] == 255 && ip[1] == 255 && ip[2] == 255 &&
+                           ip[3] == 255;
+    m_destination = sockaddr_in{};
+    m_destination.sin_family = AF_INET;
+    m_destination.sin_port = htons(port);
+    m_destination.sin_addr.s_addr =
+      htonl(broadcast ? INADDR_LOOPBACK | 0x00ffffff : address(ip));
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t size)
+  {
+    m_out.append(reinterpret_cast<const char*>(data), size);
+    return size;
+  }
+
+  size_t write(uint8_t data) { return write(&data, 1); }
+
+  /// Sends the datagram (unless it is lost, see SIM::udpLossPercent()).
+  /// \return 1, if it was sent (or lost), 0 otherwise.
+  int endPacket()
+  {
+    if (m_fd < 0) return 0;
+    if (SIM::loseDatagram()) return 1;
+
+    return ::sendto(m_fd, m_out.data(), m_out.size(), 0,
+                    reinterpret_cast<sockaddr*>(&m_destination),
+                    sizeof(m_destination)) >= 0;
+  }
+
+  /// Receives the next datagram, dropping the rest of the previous one.
+  /// \return the size of the datagram, 0 if none is waiting.
+  int parsePacket()
+  {
+    m_length = 0;
+    m_offset = 0;
+    if (m_fd < 0) return 0;
+
+    sockaddr_in source{};
+    socklen_t source_length = sizeof(source);
+    const ssize_t length =
+      ::recvfrom(m_fd, m_in, sizeof(m_in), 0,
+                 reinterpret_cast<sockaddr*>(&source), &source_length);
+    if (length <= 0) return 0;
+
+    const uint32_t address = ntohl(source.sin_addr.s_addr);
+    m_remote = IPAddress(address >> 24, address >> 16 & 0xff,
+                         address >> 8 & 0xff, address & 0xff);
+    m_remote_port = ntohs(source.sin_port);
+    m_length = static_cast<size_t>(length);
+    return static_cast<int>(length);
+  }
+
+  /// Reads from the received datagram.
+  /// \return the number of bytes read.
+  int read(uint8_t *buffer, size_t size)
+  {
+    const size_t part = std::min(size, m_length - m_offset);
+    std::memcpy(buffer, m_in + m_offset, part);
+    m_offset += part;
+    return static_cast<int>(part);
+  }
+
+  int read(char *buffer, size_t size)
+  {
+    return read(reinterpret_cast<uint8_t*>(buffer), size);
+  }
+
+  [[nodiscard]] int available() const
+  {
+    return static_cast<int>(m_length - m_offset);
+  }
+
+  [[nodiscard]] IPAddress remoteIP() const { return m_remote; }
+  [[nodiscard]] uint16_t remotePort() const { return m_remote_port; }
+
+ private:
+  /// \return the address in host byte order.
+  static uint32_t address(IPAddress ip)
+  {
+    return static_cast<uint32_t>(ip[0]) << 24 |
+           static_cast<uint32_t>(ip[1]) << 16 |
+           static_cast<uint32_t>(ip[2]) << 8 | ip[3];
+  }
+
+  int m_fd;
+  char m_in[1500];
+  size_t m_length;
+  size_t m_offset;
+  IPAddress m_remote;
+  uint16_t m_remote_port;
+  sockaddr_in m_destination;
+  std::string m_out;
+};
+
+/// The WiFi driver, the soft AP is the loopback interface.
+class WiFiClass
+{
+ public:
+  bool softAP(const char*, const char*) { return true; }
+  IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+};
+
+inline WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,193 @@
+//===-- sim/Wire.h - Host simulation of the Arduino Wire (I2C) library ----===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the I2C bus. Simulated
+/// devices (e.g. SIM::Mcp23017) answer at their addresses, and the bus
+/// counts its transactions (a repeated start continues one), bytes and time
+/// on the wire, so tests can check the traffic of a scan.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Arduino.h"
+#include "SPI.h"
+
+namespace SIM
+{
+
+/// A simulated device on the I2C bus.
+class I2cDevice
+{
+ public:
+  virtual ~I2cDevice() = default;
+
+  /// Receives the bytes of a write.
+  virtual void receive(const uint8_t *data, size_t length) = 0;
+
+  /// \return the next byte of a read.
+  virtual uint8_t transmit() = 0;
+};
+
+/// An MCP23017 16 bit I/O expander in its default (IOCON.BANK = 0) register
+/// layout, with sequential addressing.
+class Mcp23017 : public I2cDevice
+{
+ public:
+  static constexpr uint8_t IODIRA = 0x00;
+  static constexpr uint8_t GPPUA = 0x0C;
+  static constexpr uint8_t GPIOA = 0x12;
+  static constexpr uint8_t OLATA = 0x14;
+  static constexpr uint8_t REGISTER_COUNT = 0x16;
+
+  Mcp23017() : m_registers(), m_pointer(0), m_inputs(0)
+  {
+    // All pins are inputs after a reset.
+    m_registers[IODIRA] = 0xFF;
+    m_registers[IODIRA + 1] = 0xFF;
+  }
+
+  /// Sets the levels driven on the pins from outside, port A in the low byte.
+  void setInputs(uint16_t levels) { m_inputs = levels; }
+
+  /// \return a register (port A of a pair in the low byte).
+  [[nodiscard]] uint16_t word(uint8_t reg) const
+  {
+    return static_cast<uint16_t>(m_registers[reg] | m_registers[reg + 1] << 8);
+  }
+
+  /// \return the levels of the pins, the inputs and the latched outputs.
+  [[nodiscard]] uint16_t pins() const
+  {
+    const uint16_t dir = word(IODIRA);
+    return static_cast<uint16_t>((m_inputs & dir) | (word(OLATA) & ~dir));
+  }
+
+  void receive(const uint8_t *data, size_t length) override
+  {
+    if (length == 0) return;
+    m_pointer = data[0] % REGISTER_COUNT;
+    for (size_t idx = 1; idx != length; idx++)
+    {
+      // Writing the port writes its output latch.
+      uint8_t reg = m_pointer;
+      if (reg == GPIOA || reg == GPIOA + 1) reg += OLATA - GPIOA;
+      m_registers[reg] = data[idx];
+      m_pointer = (m_pointer + 1) % REGISTER_COUNT;
+    }
+  }
+
+  uint8_t transmit() override
+  {
+    uint8_t value = m_registers[m_pointer];
+    if (m_pointer == GPIOA) value = static_cast<uint8_t>(pins());
+    if (m_pointer == GPIOA + 1) value = static_cast<uint8_t>(pins() >> 8);
+    m_pointer = (m_pointer + 1) % REGISTER_COUNT;
+    return value;
+  }
+
+ private:
+  uint8_t m_registers[REGISTER_COUNT];
+  uint8_t m_pointer;
+  uint16_t m_inputs;
+};
+
+} // namespace SIM
+
+class TwoWire
+{
+ public:
+  /// The number of 7 bit addresses.
+  static constexpr uint8_t ADDRESS_COUNT = 128;
+
+  bool begin(int = -1, int = -1, uint32_t frequency = 0)
+  {
+    if (frequency != 0) m_clock = frequency;
+    return true;
+  }
+
+  bool setClock(uint32_t frequency)
+  {
+    m_clock = frequency;
+    return true;
+  }
+
+  void beginTransmission(uint16_t address)
+  {
+    m_address = static_cast<uint8_t>(address % ADDRESS_COUNT);
+    m_tx.clear();
+  }
+
+  size_t write(uint8_t data)
+  {
+    m_tx.push_back(data);
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t length)
+  {
+    m_tx.insert(m_tx.end(), data, data + length);
+    return length;
+  }
+
+  /// \return 0 on success, 2 if no device acknowledged the address.
+  uint8_t endTransmission(bool sendStop = true)
+  {
+    SIM::I2cDevice *device = sim_devices[m_address];
+    clock(m_tx.size() + 1, sendStop);
+    if (device == nullptr) return 2;
+    device->receive(m_tx.data(), m_tx.size());
+    return 0;
+  }
+
+  /// \return the number of bytes read, 0 if no device acknowledged.
+  uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop = true)
+  {
+    SIM::I2cDevice *device = sim_devices[address % ADDRESS_COUNT];
+    clock(size_t(size) + 1, sendStop);
+    m_rx.clear();
+    if (device == nullptr) return 0;
+    for (uint8_t idx = 0; idx != size; idx++)
+      m_rx.push_back(device->transmit());
+    m_read = 0;
+    return size;
+  }
+
+  int available() { return static_cast<int>(m_rx.size() - m_read); }
+
+  int read() { return m_read < m_rx.size() ? m_rx[m_read++] : -1; }
+
+  /// The simulated devices at their addresses.
+  SIM::I2cDevice *sim_devices[ADDRESS_COUNT] = {};
+  /// The traffic of the bus.
+  SIM::BusStats sim_stats;
+
+ private:
+  /// Counts the bytes (9 clocks with the acknowledge), and the transaction
+  /// when it ends with a stop.
+  void clock(size_t bytes, bool stop)
+  {
+    sim_stats.bytes += static_cast<uint32_t>(bytes);
+    sim_stats.bus_ns += (bytes * 9 + 2) * 1000000000ull / m_clock;
+    if (stop) sim_stats.transactions++;
+  }
+
+  uint32_t m_clock = 100000;
+  uint8_t m_address = 0;
+  std::vector<uint8_t> m_tx;
+  std::vector<uint8_t> m_rx;
+  size_t m_read = 0;
+};
+
+inline TwoWire Wire;
+
+#endif // SIM_WIRE_H
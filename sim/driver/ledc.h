@@ -0,0 +1,132 @@
+//===-- sim/driver/ledc.h - Host simulation of the ESP-IDF LEDC driver ----===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the hardware fades of the
+/// ESP-IDF LEDC driver, on the channels simulated by sim/Arduino.h (the
+/// Arduino channels 0-7 are the high speed channels, 8-15 the low speed
+/// ones). A fade is computed from the clock when the duty is read, so it
+/// costs nothing while it runs, like the hardware.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_DRIVER_LEDC_H
+#define SIM_DRIVER_LEDC_H
+
+#include "../Arduino.h"
+#include "../esp_err.h"
+
+enum ledc_mode_t
+{
+  LEDC_HIGH_SPEED_MODE = 0,
+  LEDC_LOW_SPEED_MODE = 1,
+};
+
+enum ledc_channel_t
+{
+  LEDC_CHANNEL_0,
+  LEDC_CHANNEL_1,
+  LEDC_CHANNEL_2,
+  LEDC_CHANNEL_3,
+  LEDC_CHANNEL_4,
+  LEDC_CHANNEL_5,
+  LEDC_CHANNEL_6,
+  LEDC_CHANNEL_7,
+};
+
+enum ledc_fade_mode_t
+{
+  LEDC_FADE_NO_WAIT = 0,
+  LEDC_FADE_WAIT_DONE,
+};
+
+namespace SIM
+{
+
+/// \return whether ledc_fade_func_install() was called.
+inline std::atomic<bool> &ledcFadesInstalled()
+{
+  static std::atomic<bool> installed_(false);
+  return installed_;
+}
+
+/// \return the simulated channel of a mode and channel, nullptr if invalid.
+inline LedcChannel *ledcChannel(ledc_mode_t mode, ledc_channel_t channel)
+{
+  const unsigned index = static_cast<unsigned>(mode) * 8 + channel;
+  return index < LEDC_CHANNEL_COUNT ? &ledcChannels()[index] : nullptr;
+}
+
+} // namespace SIM
+
+inline esp_err_t ledc_fade_func_install(int)
+{
+  SIM::ledcFadesInstalled() = true;
+  return ESP_OK;
+}
+
+/// Sets up a fade to a duty, started by ledc_fade_start().
+inline esp_err_t ledc_set_fade_with_time(ledc_mode_t mode,
+                                         ledc_channel_t channel,
+                                         uint32_t target_duty,
+                                         int max_fade_time_ms)
+{
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  SIM::LedcChannel *state = SIM::ledcChannel(mode, channel);
+  if (!state || max_fade_time_ms < 0) return ESP_ERR_INVALID_ARG;
+  if (!SIM::ledcFadesInstalled()) return ESP_ERR_INVALID_STATE;
+
+  state->pending_target = target_duty;
+  state->pending_fade_ms = static_cast<uint32_t>(max_fade_time_ms);
+  return ESP_OK;
+}
+
+/// Starts the fade set up, from the current duty.
+inline esp_err_t ledc_fade_start(ledc_mode_t mode,
+                                 ledc_channel_t channel,
+                                 ledc_fade_mode_t fade_mode)
+{
+  uint32_t fade_ms;
+  {
+    std::lock_guard<std::mutex> lock(SIM::ledcLock());
+    SIM::LedcChannel *state = SIM::ledcChannel(mode, channel);
+    if (!state) return ESP_ERR_INVALID_ARG;
+    if (!SIM::ledcFadesInstalled()) return ESP_ERR_INVALID_STATE;
+
+    const uint32_t now = static_cast<uint32_t>(millis());
+    state->duty = SIM::ledcDutyAt(*state, now);
+    state->target = state->pending_target;
+    state->fade_start_ms = now;
+    state->fade_ms = state->pending_fade_ms;
+    state->writes++;
+    fade_ms = state->fade_ms;
+  }
+  if (fade_mode == LEDC_FADE_WAIT_DONE) delay(fade_ms);
+  return ESP_OK;
+}
+
+/// Stops a fade, keeping the duty it reached.
+inline esp_err_t ledc_fade_stop(ledc_mode_t mode, ledc_channel_t channel)
+{
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  SIM::LedcChannel *state = SIM::ledcChannel(mode, channel);
+  if (!state) return ESP_ERR_INVALID_ARG;
+
+  state->duty = SIM::ledcDutyAt(*state, static_cast<uint32_t>(millis()));
+  state->target = state->duty;
+  state->fade_ms = 0;
+  return ESP_OK;
+}
+
+inline uint32_t ledc_get_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+  std::lock_guard<std::mutex> lock(SIM::ledcLock());
+  const SIM::LedcChannel *state = SIM::ledcChannel(mode, channel);
+  return state ? SIM::ledcDutyAt(*state, static_cast<uint32_t>(millis())) : 0;
+}
+
+#endif // SIM_DRIVER_LEDC_H
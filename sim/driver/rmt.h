@@ -0,0 +1,247 @@
+//===-- sim/driver/rmt.h - Host simulation of the ESP-IDF RMT driver ------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the transmitting part of the
+/// (legacy) ESP-IDF RMT driver. A transmission takes the time of its symbols
+/// at the channel clock, and its items are read when it starts and again when
+/// it is waited for: the hardware reads them while it sends, so a buffer
+/// changed in between is counted as a torn frame.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_DRIVER_RMT_H
+#define SIM_DRIVER_RMT_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "../Arduino.h"
+#include "../esp_err.h"
+
+enum gpio_num_t
+{
+  GPIO_NUM_NC = -1,
+  GPIO_NUM_0 = 0,
+  GPIO_NUM_MAX = 40,
+};
+
+enum rmt_channel_t
+{
+  RMT_CHANNEL_0,
+  RMT_CHANNEL_1,
+  RMT_CHANNEL_2,
+  RMT_CHANNEL_3,
+  RMT_CHANNEL_4,
+  RMT_CHANNEL_5,
+  RMT_CHANNEL_6,
+  RMT_CHANNEL_7,
+  RMT_CHANNEL_MAX,
+};
+
+enum rmt_mode_t
+{
+  RMT_MODE_TX = 0,
+  RMT_MODE_RX,
+};
+
+enum rmt_idle_level_t
+{
+  RMT_IDLE_LEVEL_LOW = 0,
+  RMT_IDLE_LEVEL_HIGH,
+};
+
+/// A symbol: two levels with their durations in clock ticks, a zero duration
+/// ends the transmission.
+struct rmt_item32_t
+{
+  union
+  {
+    struct
+    {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+};
+
+struct rmt_tx_config_t
+{
+  uint32_t carrier_freq_hz;
+  uint32_t carrier_level;
+  rmt_idle_level_t idle_level;
+  uint8_t carrier_duty_percent;
+  uint32_t loop_count;
+  bool carrier_en;
+  bool loop_en;
+  bool idle_output_en;
+};
+
+struct rmt_config_t
+{
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  uint32_t flags;
+  rmt_tx_config_t tx_config;
+};
+
+namespace SIM
+{
+
+/// The source clock of the RMT channels.
+static constexpr uint32_t RMT_CLOCK_HZ = 80000000;
+
+/// A simulated RMT channel.
+struct RmtChannel
+{
+  bool configured = false;
+  bool installed = false;
+  int8_t pin = -1;
+  uint8_t clk_div = 1;
+  /// The transmission in flight, and a copy of its items.
+  const rmt_item32_t *sending = nullptr;
+  std::vector<rmt_item32_t> sent;
+  std::chrono::steady_clock::time_point done_at;
+  uint32_t transmissions = 0;
+  /// The transmissions whose items changed while sent.
+  uint32_t torn = 0;
+};
+
+/// \return the lock of the channels. The channels are never destroyed, so
+/// global strips can still wait for them at exit.
+inline std::mutex &rmtLock()
+{
+  static std::mutex *const lock_ = new std::mutex;
+  return *lock_;
+}
+
+/// \return the simulated channels (lock rmtLock() to access them).
+inline RmtChannel *rmtChannels()
+{
+  static RmtChannel *const channels_ = new RmtChannel[RMT_CHANNEL_MAX];
+  return channels_;
+}
+
+/// \return a copy of a channel, with the items of its last transmission.
+inline RmtChannel rmtChannel(rmt_channel_t channel)
+{
+  std::lock_guard<std::mutex> lock(rmtLock());
+  return rmtChannels()[channel];
+}
+
+/// Counts the transmission in flight as torn if its items changed (lock
+/// rmtLock()).
+inline void rmtCheck(RmtChannel &state)
+{
+  if (state.sending == nullptr) return;
+  if (std::memcmp(state.sending, state.sent.data(),
+                  state.sent.size() * sizeof(rmt_item32_t)) != 0)
+    state.torn++;
+}
+
+} // namespace SIM
+
+inline esp_err_t rmt_config(const rmt_config_t *config)
+{
+  if (config == nullptr || config->channel >= RMT_CHANNEL_MAX ||
+      config->rmt_mode != RMT_MODE_TX || config->clk_div == 0)
+    return ESP_ERR_INVALID_ARG;
+
+  std::lock_guard<std::mutex> lock(SIM::rmtLock());
+  SIM::RmtChannel &state = SIM::rmtChannels()[config->channel];
+  state.configured = true;
+  state.pin = static_cast<int8_t>(config->gpio_num);
+  state.clk_div = config->clk_div;
+  if (config->gpio_num >= 0 && config->gpio_num < SIM::PIN_COUNT)
+    SIM::pinModes()[config->gpio_num] = OUTPUT;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_install(rmt_channel_t channel, size_t, int)
+{
+  if (channel >= RMT_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(SIM::rmtLock());
+  SIM::RmtChannel &state = SIM::rmtChannels()[channel];
+  if (state.installed) return ESP_ERR_INVALID_STATE;
+  state.installed = true;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+  if (channel >= RMT_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(SIM::rmtLock());
+  SIM::rmtChannels()[channel] = SIM::RmtChannel();
+  return ESP_OK;
+}
+
+/// Waits for the transmission in flight to end.
+inline esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+  if (channel >= RMT_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  std::chrono::steady_clock::time_point done_at;
+  {
+    std::lock_guard<std::mutex> lock(SIM::rmtLock());
+    SIM::RmtChannel &state = SIM::rmtChannels()[channel];
+    if (!state.installed) return ESP_ERR_INVALID_STATE;
+    SIM::rmtCheck(state);
+    done_at = state.done_at;
+  }
+
+  if (wait_time != portMAX_DELAY &&
+      done_at > std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(wait_time * portTICK_PERIOD_MS))
+    return ESP_ERR_TIMEOUT;
+  std::this_thread::sleep_until(done_at);
+
+  std::lock_guard<std::mutex> lock(SIM::rmtLock());
+  SIM::rmtChannels()[channel].sending = nullptr;
+  return ESP_OK;
+}
+
+/// Starts sending items, which must stay unchanged until it ends.
+inline esp_err_t rmt_write_items(rmt_channel_t channel,
+                                 const rmt_item32_t *items, int item_num,
+                                 bool wait_tx_done)
+{
+  if (channel >= RMT_CHANNEL_MAX || items == nullptr || item_num <= 0)
+    return ESP_ERR_INVALID_ARG;
+
+  // A transmission waits for the one in flight.
+  const esp_err_t result = rmt_wait_tx_done(channel, portMAX_DELAY);
+  if (result != ESP_OK) return result;
+
+  {
+    std::lock_guard<std::mutex> lock(SIM::rmtLock());
+    SIM::RmtChannel &state = SIM::rmtChannels()[channel];
+    uint64_t ticks = 0;
+    for (int idx = 0; idx != item_num; idx++)
+    {
+      ticks += items[idx].duration0;
+      if (items[idx].duration0 == 0) break;
+      ticks += items[idx].duration1;
+      if (items[idx].duration1 == 0) break;
+    }
+    state.sending = items;
+    state.sent.assign(items, items + item_num);
+    state.done_at = std::chrono::steady_clock::now() +
+                    std::chrono::nanoseconds(ticks * state.clk_div *
+                                             1000000000ull /
+                                             SIM::RMT_CLOCK_HZ);
+    state.transmissions++;
+  }
+
+  return wait_tx_done ? rmt_wait_tx_done(channel, portMAX_DELAY) : ESP_OK;
+}
+
+#endif // SIM_DRIVER_RMT_H
@@ -0,0 +1,24 @@
+//===-- sim/esp_err.h - Host simulation of the ESP-IDF error codes --------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the ESP-IDF error codes used
+/// by the simulated drivers.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_ESP_ERR_H
+#define SIM_ESP_ERR_H
+
+using esp_err_t = int;
+inline constexpr esp_err_t ESP_OK = 0;
+inline constexpr esp_err_t ESP_FAIL = -1;
+inline constexpr esp_err_t ESP_ERR_INVALID_ARG = 0x102;
+inline constexpr esp_err_t ESP_ERR_INVALID_STATE = 0x103;
+inline constexpr esp_err_t ESP_ERR_TIMEOUT = 0x107;
+
+#endif // SIM_ESP_ERR_H
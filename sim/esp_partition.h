@@ -0,0 +1,131 @@
+//===-- sim/esp_partition.h - Host simulation of the ESP-IDF partitions ---===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the ESP-IDF partition API.
+/// A data partition is backed by the file "<label>.bin" of a host directory:
+/// ".pio/partitions", or the one in the PTS_SIM_PARTITIONS environment
+/// variable. Mapping a partition reads its file into memory once, then hands
+/// out views of it, like the flash cache does.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_ESP_PARTITION_H
+#define SIM_ESP_PARTITION_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "esp_err.h"
+
+enum esp_partition_type_t
+{
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+};
+
+enum esp_partition_subtype_t
+{
+  ESP_PARTITION_SUBTYPE_ANY = 0xff,
+};
+
+struct esp_partition_t
+{
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+  bool encrypted;
+};
+
+enum spi_flash_mmap_memory_t
+{
+  SPI_FLASH_MMAP_DATA,
+  SPI_FLASH_MMAP_INST,
+};
+
+using spi_flash_mmap_handle_t = uint32_t;
+
+namespace SIM
+{
+
+/// A partition backed by a host file.
+struct Partition
+{
+  esp_partition_t info;
+  std::vector<uint32_t> content;
+};
+
+inline std::map<std::string, std::unique_ptr<Partition>> &partitions()
+{
+  static std::map<std::string, std::unique_ptr<Partition>> instances;
+  return instances;
+}
+
+} // namespace SIM
+
+/// Finds a data partition by its label (the type and subtype are ignored).
+inline const esp_partition_t *esp_partition_find_first(
+  esp_partition_type_t type, esp_partition_subtype_t, const char *label)
+{
+  if (type != ESP_PARTITION_TYPE_DATA || !label) return nullptr;
+
+  auto &partition = SIM::partitions()[label];
+  if (!partition)
+  {
+    const char *root = std::getenv("PTS_SIM_PARTITIONS");
+    const std::string path =
+      std::string(root ? root : ".pio/partitions") + "/" + label + ".bin";
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) return nullptr;
+
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    for (size_t length; (length = std::fread(chunk, 1, sizeof(chunk), file));)
+      bytes.insert(bytes.end(), chunk, chunk + length);
+    std::fclose(file);
+
+    // Word aligned, like the mapped flash.
+    partition = std::make_unique<SIM::Partition>();
+    partition->content.resize((bytes.size() + 3) / 4);
+    std::memcpy(partition->content.data(), bytes.data(), bytes.size());
+    partition->info = esp_partition_t{ESP_PARTITION_TYPE_DATA,
+                                      ESP_PARTITION_SUBTYPE_ANY, 0,
+                                      static_cast<uint32_t>(bytes.size()),
+                                      {}, false};
+    std::strncpy(partition->info.label, label,
+                 sizeof(partition->info.label) - 1);
+  }
+  return &partition->info;
+}
+
+/// Maps a range of a partition into memory.
+inline esp_err_t esp_partition_mmap(const esp_partition_t *partition,
+                                    size_t offset, size_t size,
+                                    spi_flash_mmap_memory_t,
+                                    const void **out_ptr,
+                                    spi_flash_mmap_handle_t *out_handle)
+{
+  if (!partition || offset + size > partition->size || offset % 4 != 0)
+    return ESP_ERR_INVALID_ARG;
+
+  const auto &mapped = SIM::partitions()[partition->label];
+  *out_ptr = reinterpret_cast<const uint8_t*>(mapped->content.data()) + offset;
+  *out_handle = 0;
+  return ESP_OK;
+}
+
+/// Unmaps a mapped range (the views stay valid on the host).
+inline void spi_flash_munmap(spi_flash_mmap_handle_t) { }
+
+#endif // SIM_ESP_PARTITION_H
@@ -0,0 +1,222 @@
+//===-- sim/esp_timer.h - Host simulation of the ESP-IDF esp_timer --------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of the esp_timer API: a 64-bit
+/// microsecond clock, and timers whose callbacks are run by a single
+/// dispatching thread, like the esp_timer task. A periodic timer is re-armed
+/// from its previous alarm, not from the time its callback ran, so late
+/// callbacks don't shift the ones after them.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "esp_err.h"
+
+using esp_timer_cb_t = void (*)(void *arg);
+
+enum esp_timer_dispatch_t
+{
+  ESP_TIMER_TASK,
+  ESP_TIMER_MAX,
+};
+
+struct esp_timer_create_args_t
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+};
+
+/// A simulated timer. The timers are never freed, a deleted one may still be
+/// dispatched once.
+struct esp_timer
+{
+  esp_timer_cb_t callback = nullptr;
+  void *arg = nullptr;
+  bool skip_unhandled_events = false;
+  bool active = false;
+  int64_t alarm_us = 0;
+  /// 0 for a one-shot timer.
+  uint64_t period_us = 0;
+  /// The number of callbacks run.
+  uint32_t fired = 0;
+};
+
+using esp_timer_handle_t = esp_timer*;
+
+/// \return the time since the start of the simulation, in microseconds.
+inline int64_t esp_timer_get_time()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - SIM::epoch()).count();
+}
+
+namespace SIM
+{
+
+/// The timers of the dispatching thread.
+struct EspTimers
+{
+  std::mutex lock;
+  std::condition_variable changed;
+  std::vector<esp_timer*> armed;
+  bool dispatching = false;
+};
+
+/// \return the timers, never destroyed, so timers can still be stopped at
+/// exit.
+inline EspTimers &espTimers()
+{
+  static EspTimers *const timers_ = new EspTimers;
+  return *timers_;
+}
+
+/// Runs the callbacks of the timers as their alarms pass.
+inline void dispatchEspTimers()
+{
+  EspTimers &timers = espTimers();
+  std::unique_lock<std::mutex> lock(timers.lock);
+  for (;;)
+  {
+    esp_timer *next = nullptr;
+    for (esp_timer *timer : timers.armed)
+      if (!next || timer->alarm_us < next->alarm_us) next = timer;
+    if (!next)
+    {
+      timers.changed.wait(lock);
+      continue;
+    }
+
+    const int64_t now = esp_timer_get_time();
+    if (next->alarm_us > now)
+    {
+      timers.changed.wait_until(
+        lock, epoch() + std::chrono::microseconds(next->alarm_us));
+      continue;
+    }
+
+    if (next->period_us == 0)
+    {
+      next->active = false;
+      timers.armed.erase(std::find(timers.armed.begin(), timers.armed.end(),
+                                   next));
+    }
+    else
+    {
+      next->alarm_us += static_cast<int64_t>(next->period_us);
+      if (next->skip_unhandled_events && next->alarm_us <= now)
+        next->alarm_us = now + static_cast<int64_t>(next->period_us);
+    }
+    next->fired++;
+    const esp_timer_cb_t callback = next->callback;
+    void *const arg = next->arg;
+    // Run without the lock, the callback may start and stop timers.
+    lock.unlock();
+    callback(arg);
+    lock.lock();
+  }
+}
+
+/// Arms a timer (lock the timers).
+inline esp_err_t armEspTimer(esp_timer *timer, uint64_t timeout_us,
+                             uint64_t period_us)
+{
+  EspTimers &timers = espTimers();
+  if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+  if (timer->active) return ESP_ERR_INVALID_STATE;
+
+  timer->active = true;
+  timer->alarm_us = esp_timer_get_time() + static_cast<int64_t>(timeout_us);
+  timer->period_us = period_us;
+  timers.armed.push_back(timer);
+  if (!timers.dispatching)
+  {
+    timers.dispatching = true;
+    std::thread(dispatchEspTimers).detach();
+  }
+  timers.changed.notify_all();
+  return ESP_OK;
+}
+
+} // namespace SIM
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args,
+                                  esp_timer_handle_t *handle)
+{
+  if (args == nullptr || args->callback == nullptr || handle == nullptr ||
+      args->dispatch_method != ESP_TIMER_TASK)
+    return ESP_ERR_INVALID_ARG;
+
+  esp_timer *timer = new esp_timer();
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->skip_unhandled_events = args->skip_unhandled_events;
+  *handle = timer;
+  return ESP_OK;
+}
+
+/// Runs the callback once, timeout_us from now.
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer,
+                                      uint64_t timeout_us)
+{
+  std::lock_guard<std::mutex> lock(SIM::espTimers().lock);
+  return SIM::armEspTimer(timer, timeout_us, 0);
+}
+
+/// Runs the callback every period_us from now.
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer,
+                                          uint64_t period_us)
+{
+  if (period_us == 0) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(SIM::espTimers().lock);
+  return SIM::armEspTimer(timer, period_us, period_us);
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+  SIM::EspTimers &timers = SIM::espTimers();
+  std::lock_guard<std::mutex> lock(timers.lock);
+  if (!timer->active) return ESP_ERR_INVALID_STATE;
+
+  timer->active = false;
+  timers.armed.erase(std::find(timers.armed.begin(), timers.armed.end(),
+                               timer));
+  timers.changed.notify_all();
+  return ESP_OK;
+}
+
+/// Deletes a stopped timer.
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  if (timer == nullptr) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(SIM::espTimers().lock);
+  if (timer->active) return ESP_ERR_INVALID_STATE;
+  timer->callback = [](void*) { };
+  return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> lock(SIM::espTimers().lock);
+  return timer != nullptr && timer->active;
+}
+
+#endif // SIM_ESP_TIMER_H
@@ -0,0 +1,28 @@
+//===-- sim/soc/gpio_reg.h - Host simulation of the ESP32 GPIO registers --===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the addresses of the GPIO output registers of the
+/// ESP32, written with REG_WRITE() (see sim/soc/soc.h).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_SOC_GPIO_REG_H
+#define SIM_SOC_GPIO_REG_H
+
+#define DR_REG_GPIO_BASE 0x3ff44000
+/// Write 1 to set, and write 1 to clear the outputs of pins 0-31.
+#define GPIO_OUT_W1TS_REG (DR_REG_GPIO_BASE + 0x0008)
+#define GPIO_OUT_W1TC_REG (DR_REG_GPIO_BASE + 0x000c)
+/// The same for pins 32-39.
+#define GPIO_OUT1_W1TS_REG (DR_REG_GPIO_BASE + 0x0014)
+#define GPIO_OUT1_W1TC_REG (DR_REG_GPIO_BASE + 0x0018)
+/// The input levels of pins 0-31, and of pins 32-39.
+#define GPIO_IN_REG (DR_REG_GPIO_BASE + 0x003c)
+#define GPIO_IN1_REG (DR_REG_GPIO_BASE + 0x0040)
+
+#endif // SIM_SOC_GPIO_REG_H
@@ -0,0 +1,109 @@
+//===-- sim/soc/soc.h - Host simulation of the ESP32 register access ------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the host stand-in of REG_WRITE() and REG_READ().
+/// Writes to the GPIO set and clear registers change the simulated pin
+/// levels, and every register write is recorded, so tests can check which
+/// pins changed together. Reads of the GPIO input registers return the pin
+/// levels, and are counted.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SIM_SOC_SOC_H
+#define SIM_SOC_SOC_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "../Arduino.h"
+#include "gpio_reg.h"
+
+namespace SIM
+{
+
+/// A recorded register write.
+struct RegisterWrite
+{
+  uint32_t reg;
+  uint32_t value;
+};
+
+/// \return the lock of the recorded writes.
+inline std::mutex &registerLock()
+{
+  static std::mutex lock_;
+  return lock_;
+}
+
+/// \return the recorded writes (lock registerLock() to access them).
+inline std::vector<RegisterWrite> &registerWrites()
+{
+  static std::vector<RegisterWrite> writes_;
+  return writes_;
+}
+
+/// \return the writes recorded since the previous call.
+inline std::vector<RegisterWrite> takeRegisterWrites()
+{
+  std::lock_guard<std::mutex> lock(registerLock());
+  std::vector<RegisterWrite> writes;
+  writes.swap(registerWrites());
+  return writes;
+}
+
+/// Applies a register write to the simulated pins, and records it.
+inline void writeRegister(uint32_t reg, uint32_t value)
+{
+  uint8_t first_pin = 0;
+  uint8_t level = HIGH;
+  switch (reg)
+  {
+    case GPIO_OUT_W1TS_REG: break;
+    case GPIO_OUT_W1TC_REG: level = LOW; break;
+    case GPIO_OUT1_W1TS_REG: first_pin = 32; break;
+    case GPIO_OUT1_W1TC_REG: first_pin = 32; level = LOW; break;
+    default: return;
+  }
+
+  std::lock_guard<std::mutex> lock(registerLock());
+  for (uint8_t bit = 0; bit != 32 && first_pin + bit < PIN_COUNT; bit++)
+    if (value & (uint32_t(1) << bit)) pinLevels()[first_pin + bit] = level;
+  registerWrites().push_back(RegisterWrite{reg, value});
+}
+
+/// \return the number of register reads.
+inline std::atomic<uint32_t> &registerReads()
+{
+  static std::atomic<uint32_t> reads_(0);
+  return reads_;
+}
+
+/// \return the levels of the simulated pins, for the GPIO input registers.
+inline uint32_t readRegister(uint32_t reg)
+{
+  uint8_t first_pin = 0;
+  switch (reg)
+  {
+    case GPIO_IN_REG: break;
+    case GPIO_IN1_REG: first_pin = 32; break;
+    default: return 0;
+  }
+
+  registerReads()++;
+  uint32_t value = 0;
+  for (uint8_t bit = 0; bit != 32 && first_pin + bit < PIN_COUNT; bit++)
+    if (pinLevels()[first_pin + bit] != LOW) value |= uint32_t(1) << bit;
+  return value;
+}
+
+} // namespace SIM
+
+#define REG_WRITE(reg, value) SIM::writeRegister((reg), (value))
+#define REG_READ(reg) SIM::readRegister(reg)
+
+#endif // SIM_SOC_SOC_H
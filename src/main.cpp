@@ -13,21 +13,115 @@
 //===----------------------------------------------------------------------===//
 
 #include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_partition.h>
 #include "utils/sw/log.h" // Logging header
 #include "net/web_server.h" // WebServer header
-#include "modules/hw/keypad_module.h" // Keypad module
+#include "modules/game_config.h" // Game setup file parser
+#include "modules/game_image.h" // Compiled game reader
+#include "modules/module_factory.h" // Builds the modules of the game
+#include "modules/countdown_module.h" // The game clock
+#ifdef SCOREBOARD_FEED
+#include "net/scoreboard_feed.h" // Broadcasts the attributes to viewers
+#endif
 
 // Set up a web server and get its instance.
 const PTS::WebServer& web_server = PTS::WebServer::instance();
 
-// Create an instance of the keypad module, with the corresponding pins set.
-const PTS::Keypad<3, 4> keypad_module("keypad_module",
-                                      {25, 33, 32}, {35, 34, 39, 36},
-                                      std::array<std::array<char, 3>, 4>{
-                                        std::array<char, 3>{'1', '2', '3'},
-                                        std::array<char, 3>{'4', '5', '6'},
-                                        std::array<char, 3>{'7', '8', '9'},
-                                        std::array<char, 3>{'*', '0', '#'}});
+#ifdef SCOREBOARD_FEED
+// Broadcast the attributes to any number of scoreboard viewers on the network
+// (see tools/scoreboard_client.cpp), instead of each polling the web server.
+PTS::ScoreboardFeed<PTS::WebServer::Attributes>
+  scoreboard_feed(web_server.attributes());
+#endif
+
+// The partition of the compiled game, written with tools/game_compiler.cpp.
+constexpr const char *GAME_PARTITION_LABEL = "game";
+
+// The setup file of the game, uploaded with: pio run -t uploadfs
+constexpr const char *GAME_CONFIG_PATH = "/game.json";
+
+// The game used without a setup file: the keypad with its pins and characters.
+constexpr const char *DEFAULT_GAME_CONFIG = R"({
+  "name": "keypad_demo",
+  "modules": [
+    {"type": "keypad", "name": "keypad_module",
+     "cols": [25, 33, 32], "rows": [35, 34, 39, 36],
+     "keys": ["123", "456", "789", "*0#"]}]})";
+
+// The time to finish the game in, and the speed-up of every strike (percent).
+constexpr uint32_t GAME_DURATION_MS = 5 * 60 * 1000;
+constexpr uint32_t STRIKE_SPEEDUP = 25;
+
+// The description of the game, and the modules built from it.
+PTS::GameConfig game_config;
+PTS::ModuleFactory<> game_modules;
+const char *game_name = "";
+
+// The game clock, controlled with the commands of the module "countdown".
+const PTS::CountdownModule<> game_clock("countdown", GAME_DURATION_MS,
+                                        STRIKE_SPEEDUP);
+
+// Handles of the attributes updated by the clock and the loop, set in setup.
+PTS::AttributeHandle seconds_attribute;
+PTS::AttributeHandle keypad_attribute;
+// The keypad of the game, looked up once after the modules were built.
+PTS::ModuleHandle keypad;
+
+// Builds the compiled game, read in place from the mapped partition (which
+// stays mapped, the name of the game is viewed in it).
+// Returns false, if there is no valid compiled game.
+bool buildGameImage()
+{
+  const esp_partition_t *partition = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, GAME_PARTITION_LABEL);
+  const void *data = nullptr;
+  spi_flash_mmap_handle_t handle;
+  if (!partition ||
+      esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA,
+                         &data, &handle) != ESP_OK)
+    return false;
+
+  PTS::GameImage image;
+  if (const char *error = image.open(data, partition->size))
+  {
+    // An erased partition is no error, the game is just not compiled.
+    if (std::strcmp(error, "no game image") != 0)
+      PTS::LOG::E("Invalid game partition: %", error);
+    spi_flash_munmap(handle);
+    return false;
+  }
+
+  if (!game_modules.build(image.modules(), image.size()))
+  {
+    PTS::LOG::E("Building the compiled game failed: %", game_modules.error());
+    spi_flash_munmap(handle);
+    return false;
+  }
+  game_name = image.name();
+  return true;
+}
+
+// Reads the setup file of the game, or the default one without a (valid) file.
+void loadGameConfig()
+{
+  if (LittleFS.begin() && LittleFS.exists(GAME_CONFIG_PATH))
+  {
+    File file = LittleFS.open(GAME_CONFIG_PATH, "r");
+    PTS::GameConfigParser parser(game_config);
+    uint8_t chunk[64];
+    for (size_t length; (length = file.read(chunk, sizeof(chunk))) != 0;)
+      if (!parser.feed(reinterpret_cast<const char*>(chunk), length)) break;
+    file.close();
+
+    if (parser.finish()) return;
+    PTS::LOG::E("Invalid %: % (module %, offset %)", GAME_CONFIG_PATH,
+                parser.error(), parser.failedModule(), parser.offset());
+  }
+
+  PTS::LOG::W("Using the default game.");
+  PTS::GameConfigParser::parse(DEFAULT_GAME_CONFIG, game_config);
+}
 
 // Setup: the entry point of the application.
 void setup() {
@@ -39,38 +133,97 @@ void setup() {
   // Log that init started, this shows up on the serial monitor.
   PTS::LOG::D("Initializing started...");
 
-  // Use the webserver to register a new attribute to be displayed.
+  // Build the modules of the compiled game, or read the setup file of the
+  // game and build them from it.
+  const uint32_t config_start_us = micros();
+  if (!buildGameImage())
+  {
+    loadGameConfig();
+    if (!game_modules.build(game_config))
+      PTS::LOG::E("Building the game failed: %", game_modules.error());
+    game_name = game_config.name;
+  }
+  const uint32_t config_us = micros() - config_start_us;
+
+  // Use the webserver to register a new attribute to be displayed. Nothing
+  // on the board writes it, so the game master may set it remotely.
   web_server.registerAttribute("example_attribute",
                                "example_value",
-                               "This is an example attribute.");
+                               "This is an example attribute.",
+                               true);
 
-  // Setup the keypad and webserver module.
-  keypad_module.begin();
+  // Setup the game and webserver modules.
+  game_modules.begin();
+  game_clock.begin();
   web_server.begin();
+#ifdef SCOREBOARD_FEED
+  scoreboard_feed.begin(); // After the web server created the access point.
+#endif
 
-  // Register an attribute that will contain the data read by the keypad.
-  web_server.registerAttribute("keypad_buffer_content", "");
+  // Let the game master control the modules through "/api/commands".
+  web_server.onModuleCommand([](const char *module, PTS::ModuleCommand command)
+  {
+    if (std::strcmp(module, game_clock.getName().c_str()) == 0)
+      return game_clock.post(command);
+    return game_modules.post(module, command);
+  });
+
+  // Register the attributes updated by the clock and the loop. Updating
+  // through the returned handles is cheap, there is no lookup by name.
+  // The seconds are typed: the clock stores a number, which is only formatted
+  // when a client fetches it.
+  seconds_attribute = web_server.registerAttribute(
+    "seconds_left",
+    PTS::AttributeValue::fromInteger(
+      static_cast<int32_t>(GAME_DURATION_MS / 1000)),
+    "Seconds left of the game.");
+  // Its changes are kept for charting on /api/history?name=seconds_left.
+  web_server.enableHistory(seconds_attribute);
+  keypad_attribute = web_server.registerAttribute("keypad_buffer_content", "");
+
+  // The clock updates the seconds as they turn (faster after strikes), and
+  // at its pauses and strikes, nothing polls it.
+  game_clock.subscribe([](void*, const PTS::CountdownTime &time)
+  {
+    web_server.updateInteger(seconds_attribute,
+                             static_cast<int32_t>(time.seconds()));
+  }, nullptr, 1000, true);
+  game_clock.onExpiry([](void*) { PTS::LOG::W("The time is up."); }, nullptr);
 
-  // Start the modules on new threads.
-  keypad_module.start();
+  // Start the modules on new threads, the game is armed.
+  game_modules.start();
+  game_clock.start();
   web_server.start();
+#ifdef SCOREBOARD_FEED
+  scoreboard_feed.start();
+#endif
+
+  // The time from power on to the armed game, and the part of it spent on
+  // reading the game and building the modules.
+  const uint32_t armed_ms = millis();
+  web_server.registerAttribute("boot_to_armed_ms",
+                               PTS::AttributeValue::fromInteger(
+                                 static_cast<int32_t>(armed_ms)),
+                               "Milliseconds from power on to the armed game.");
+  keypad = game_modules.lookup("keypad_module", PTS::ModuleType::KEYPAD);
+  if (!keypad)
+    PTS::LOG::W("The game has no keypad \"keypad_module\", keys aren't read.");
+
+  PTS::LOG::I("Game \"%\" armed % ms after power on (% modules built in % us).",
+              game_name, armed_ms, game_modules.size(), config_us);
 
   PTS::LOG::I("Initializing finished.");
 }
 
 // Loop: run in succession after the setup function finished.
 void loop() {
-  // Update or register (the first time loop will run) attribute.
-  web_server.upsterAttribute("seconds",
-                             std::to_string(millis() / 1000),
-                             "Seconds since startup.");
-
   // Try to read a new value from the keypad. If successful, append it.
-  if (auto keypad_buffer = keypad_module.readOne(); keypad_buffer)
+  if (auto keypad_buffer = game_modules.readKey(keypad);
+      keypad_buffer)
   {
     // Read the value of the attribute.
     char buffer_value = keypad_buffer.value();
-    auto attribute = web_server.readAttribute("keypad_buffer_content").value();
+    auto attribute = web_server.readAttribute(keypad_attribute).value();
 
     switch (buffer_value)
     {
@@ -80,6 +233,10 @@ void loop() {
     }
 
     // Update the attribute.
-    web_server.updateAttribute("keypad_buffer_content", attribute);
+    web_server.updateAttribute(keypad_attribute, attribute);
   }
+  // The keys wait in the keypad's buffer, so sleep while there is none (and
+  // let the tasks of lower priority run).
+  else
+    delay(10);
 }
\ No newline at end of file
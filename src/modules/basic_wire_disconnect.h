@@ -11,71 +11,83 @@
 ///
 /// This file is also intended to be an example of how to write your own modules
 ///
-/// To complete the module, you must disconnect the wires in the order passed to
-/// the module's constructor. If all 3 wires have been disconnected, the module
-/// is passed. If a wire has been disconnected in the wrong order, the module is
-/// failed.
+/// To complete the module, you must disconnect the wires of every step of its
+/// order: the wires of a step in any order, after all the wires of the earlier
+/// steps (by default every wire but the forbidden ones is a step of its own,
+/// in the order passed to the module's constructor). Wires of no step can be
+/// cut anytime, cutting a wire too early or a forbidden wire fails the module.
+///
+/// The wires are a bitmask, a bit per wire: every tick reads all of them at
+/// once (see InputFrame), and every cut is checked against the masks of the
+/// rules, so the cost doesn't grow with the rules, and a module of 64 wires
+/// needs no more tasks than one of 3.
 ///
 //===----------------------------------------------------------------------===//
 
 #ifndef MODULES_BASIC_WIRE_DISCONNECT_H
 #define MODULES_BASIC_WIRE_DISCONNECT_H
 
+#include <array>
+#include <initializer_list>
+#include <utility>
 #include "module_base.h"
 #include "stateful_base.h"
-#include "utils/hw/button.h"
+#include "utils/hw/input_frame.h"
+#include "utils/hw/io_pin.h"
 #include "utils/hw/rgbled.h"
 
 namespace PTS
 {
 
 /// WireDisconnect class
+/// \tparam MAX_WIRES the maximum number of wires (up to 64).
+template<size_t MAX_WIRES = 3>
 class WireDisconnect : public Module<>, public Stateful
 {
-//===-- Instantiation specific functions ----------------------------------===//
+  static_assert(MAX_WIRES > 0 && MAX_WIRES <= 64, "A wire is a bit of 64.");
 
  public:
+  /// A set of wires, a bit per wire.
+  using Mask = uint64_t;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param wires the wires, a GPIO pin or a line of an I/O expander each.
+  /// \param count the number of wires.
+  /// \param steps the step of every wire in the order, from 1, 0 for none
+  /// (nullptr for a step per wire, in the order passed).
+  /// \param forbidden the wires failing the module when cut.
+  template<typename PIN>
   explicit WireDisconnect(const std::string &name,
-                          uint8_t wire_1, uint8_t wire_2, uint8_t wire_3,
+                          const PIN *wires, size_t count,
+                          const uint8_t *steps, Mask forbidden,
                           const RGBLED &led_ref)
   : Module(name),
     Stateful(),
-    c_wire_1(wire_1),
-    c_wire_2(wire_2),
-    c_wire_3(wire_3),
-    c_status_rgbled(led_ref)
-    { }
-  
-  /// Begin members and set callbacks.
+    c_wires(pins(wires, count, std::make_index_sequence<MAX_WIRES>())),
+    c_count(count < MAX_WIRES ? count : MAX_WIRES),
+    c_required(required(steps, c_count, forbidden)),
+    c_forbidden(forbidden & maskOf(c_count)),
+    c_before(before(steps, c_count, forbidden)),
+    c_status_rgbled(led_ref),
+    m_cut(0),
+    m_low(0),
+    m_connected(0)
+  { }
+
+  /// Wires to be disconnected in the order passed.
+  explicit WireDisconnect(const std::string &name,
+                          std::initializer_list<IoPin> wires,
+                          const RGBLED &led_ref)
+  : WireDisconnect(name, wires.begin(), wires.size(), nullptr, 0, led_ref)
+  { }
+
+  /// Begin members and make the module active.
   void begin() const override
   {
-    c_wire_1.begin();
-    c_wire_2.begin();
-    c_wire_3.begin();
+    for (size_t wire = 0; wire != c_count; wire++) c_wires[wire].mode(INPUT);
     c_status_rgbled.begin();
 
-    // If wire_1 is disconnected, accumulate and set the disconnected value to 1
-    c_wire_1.onFalling([](const WireDisconnect* obj_ptr) constexpr
-    {
-      Serial.println("Wire 1 disconnected!");
-      obj_ptr->m_accumulator++;
-      obj_ptr->m_disconnected = 1;
-    });
-    // If wire_2 is disconnected, accumulate and set the disconnected value to 2
-    c_wire_2.onFalling([](const WireDisconnect* obj_ptr) constexpr
-    {
-      Serial.println("Wire 2 disconnected!");
-      obj_ptr->m_accumulator++;
-      obj_ptr->m_disconnected = 2;
-    });
-    // If wire_3 is disconnected, accumulate and set the disconnected value to 3
-    c_wire_3.onFalling([](const WireDisconnect* obj_ptr) constexpr
-    {
-      Serial.println("Wire 3 disconnected!");
-      obj_ptr->m_accumulator++;
-      obj_ptr->m_disconnected = 3;
-    });
-    
     // Advance the module state from INVALID to ACTIVE
     this->passState();
     // Turn the status led on (blue color for live game)
@@ -85,33 +97,25 @@ class WireDisconnect : public Module<>, public Stateful
   /// Check for disconnected wires and run the game logic.
   void threadFunc() const override
   {
-    // update each wire
-    c_wire_1.update(this);
-    c_wire_2.update(this);
-    c_wire_3.update(this);
-
-    // Game logic: if the number of wires disconnected does not match the number
-    // of the currently disconnected one, fail
-    if (m_accumulator != m_disconnected)
-    {
-      this->failState();
-    }
-    // But if all 3 wires have been disconnected, pass
-    else if (m_disconnected == 3)
-    {
-      this->passState();
-    }
+    // Read every wire at once, a set bit for a disconnected one
+    InputFrame frame;
+    frame.capture();
+    Mask low = 0;
+    for (size_t wire = 0; wire != c_count; wire++)
+      if (frame.read(c_wires[wire]) == LOW) low |= Mask(1) << wire;
+
+    evaluate(low);
 
     // If it's in a passing state, turn the led green
     if (this->getState() == PASSED)
     {
-      Serial.println("Passed module!");
+      LOG::I("Module \"%\" passed.", getName().c_str());
       c_status_rgbled.green();
     }
     // If it's in a failing state, turn the led red
     else if (this->getState() == FAILED)
     {
-      Serial.println("Failed module!");
+      LOG::I("Module \"%\" failed.", getName().c_str());
       c_status_rgbled.red();
     }
 
@@ -122,17 +126,131 @@ class WireDisconnect : public Module<>, public Stateful
     }
   }
 
+  /// Re-arms the game: forgets the disconnected wires and makes the module
+  /// active again (the wires should be reconnected, and the finished module
+  /// started again).
+  void reset() const override
+  {
+    m_cut = 0;
+    m_low = 0;
+    m_connected = 0;
+    this->invalidateState();
+    this->passState();
+    c_status_rgbled.blue();
+  }
+
+//===-- Game logic --------------------------------------------------------===//
+
+  /// Runs the game logic on the wires read disconnected. A wire counts as
+  /// cut once it was read connected, then disconnected on two ticks in a row
+  /// (so contact bounces don't count), and stays cut until reset().
+  /// \param low the wires read disconnected, a bit per wire.
+  void evaluate(Mask low) const
+  {
+    low &= maskOf(c_count);
+    m_connected |= ~low & maskOf(c_count);
+    const Mask cut = low & m_low & m_connected & ~m_cut;
+    m_low = low;
+    if (cut == 0 || this->getState() != ACTIVE) return;
+
+    const Mask cut_before = m_cut;
+    m_cut |= cut;
+    if (cut & c_forbidden)
+    {
+      this->failState();
+      return;
+    }
+    // Every wire cut needs the wires of the earlier steps cut before it
+    for (Mask rest = cut; rest != 0; rest &= rest - 1)
+    {
+      const Mask before = c_before[__builtin_ctzll(rest)];
+      if ((cut_before & before) != before)
+      {
+        this->failState();
+        return;
+      }
+    }
+    if ((m_cut & c_required) == c_required) this->passState();
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the number of wires.
+  [[nodiscard]] size_t size() const { return c_count; }
+
+  /// \return the wires cut, a bit per wire.
+  [[nodiscard]] Mask cut() const { return m_cut; }
+
 //===-- Member variables --------------------------------------------------===//
 
  private:
-  const Button<100, void, const WireDisconnect*> c_wire_1; 
-  const Button<100, void, const WireDisconnect*> c_wire_2; 
-  const Button<100, void, const WireDisconnect*> c_wire_3; 
+  /// \return the mask of the first count wires.
+  static constexpr Mask maskOf(size_t count)
+  {
+    return count >= 64 ? ~Mask(0) : (Mask(1) << count) - 1;
+  }
+
+  /// \return the wires passed, the rest unused.
+  template<typename PIN, size_t... WIRE>
+  static std::array<IoPin, MAX_WIRES> pins(const PIN *wires, size_t count,
+                                           std::index_sequence<WIRE...>)
+  {
+    return {{(WIRE < count ? IoPin(wires[WIRE]) : IoPin(NO_PIN))...}};
+  }
+
+  /// \return the step of a wire, 0 for none (the forbidden wires have none,
+  /// in the order passed too).
+  static size_t stepOf(const uint8_t *steps, Mask forbidden, size_t wire)
+  {
+    if (forbidden & Mask(1) << wire) return 0;
+    return steps ? steps[wire] : wire + 1;
+  }
+
+  /// \return the wires of a step.
+  static Mask required(const uint8_t *steps, size_t count, Mask forbidden)
+  {
+    Mask mask = 0;
+    for (size_t wire = 0; wire != count; wire++)
+      if (stepOf(steps, forbidden, wire) != 0) mask |= Mask(1) << wire;
+    return mask;
+  }
+
+  /// \return the wires to be cut before every wire: those of earlier steps.
+  static std::array<Mask, MAX_WIRES> before(const uint8_t *steps,
+                                            size_t count, Mask forbidden)
+  {
+    std::array<Mask, MAX_WIRES> masks{};
+    for (size_t wire = 0; wire != count; wire++)
+    {
+      const size_t step = stepOf(steps, forbidden, wire);
+      for (size_t other = 0; other != count; other++)
+      {
+        const size_t other_step = stepOf(steps, forbidden, other);
+        if (other_step != 0 && other_step < step)
+          masks[wire] |= Mask(1) << other;
+      }
+    }
+    return masks;
+  }
+
+  /// The pin of the unused wires.
+  static constexpr uint8_t NO_PIN = 0xFF;
+
+  const std::array<IoPin, MAX_WIRES> c_wires;
+  const size_t c_count;
+  /// The wires of the steps, to be cut to pass.
+  const Mask c_required;
+  const Mask c_forbidden;
+  /// The wires to be cut before each wire.
+  const std::array<Mask, MAX_WIRES> c_before;
   const RGBLED &c_status_rgbled;
-  mutable size_t m_accumulator = 0;
-  mutable size_t m_disconnected = 0;
+  mutable Mask m_cut;
+  /// The wires read disconnected on the last tick.
+  mutable Mask m_low;
+  /// The wires read connected since the start.
+  mutable Mask m_connected;
 }; // class WireDisconnect
 
 } // namespace PTS
 
-#endif // MODULES_BASIC_WIRE_DISCONNECT_H
\ No newline at end of file
+#endif // MODULES_BASIC_WIRE_DISCONNECT_H
@@ -0,0 +1,477 @@
+//===-- modules/countdown_module.h - CountdownModule class definition -----===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the CountdownClock class, the
+/// time left of a game, and of the CountdownModule class, the game clock
+/// running it down.
+///
+/// The time left is never counted by ticks: it is kept as the time left at
+/// the last change (a start, a pause, a strike), and derived from the 64-bit
+/// microsecond clock of esp_timer at that rate. So the clock doesn't drift,
+/// however long the game and however late its tasks run, and the error of
+/// a strike speeding it up is below a microsecond.
+///
+/// A single esp_timer is armed for the next thing due: the expiry, or the
+/// next update of a consumer (see subscribe()). Each consumer is fed at its
+/// own rate, of real time (e.g. a display refreshing) or of game time (e.g.
+/// a display of seconds, updated as a second turns, faster after a strike),
+/// and on every change, so nothing polls the clock. The expiry callback is
+/// run at the exact time the clock reaches zero.
+///
+/// Consumers are fed on the esp_timer task: they should be short and never
+/// block, e.g. store a value or post to a module.
+///
+/// The CountdownModule class is threadsafe.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_COUNTDOWN_MODULE_H
+#define MODULES_COUNTDOWN_MODULE_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <esp_timer.h>
+#include "module_base.h"
+#include "stateful_base.h"
+
+namespace PTS
+{
+
+/// CountdownClock class, the time left of a countdown, running at a rate.
+class CountdownClock
+{
+ public:
+  /// The rate of the clock in percent, at which it runs with real time.
+  static constexpr uint32_t NORMAL_RATE = 100;
+  /// The time never reached by a clock that isn't running.
+  static constexpr int64_t NEVER = INT64_MAX;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// A stopped clock.
+  explicit constexpr CountdownClock(int64_t left_us = 0)
+  : m_anchor_us(0), m_anchor_left_us(left_us), m_rate(NORMAL_RATE),
+    m_running(false)
+  { }
+
+//===-- Modifier functions ------------------------------------------------===//
+
+  /// Starts running the clock down at a time.
+  constexpr void run(int64_t now_us)
+  {
+    if (m_running) return;
+    m_anchor_us = now_us;
+    m_running = true;
+  }
+
+  /// Stops the clock at a time.
+  constexpr void hold(int64_t now_us)
+  {
+    if (!m_running) return;
+    anchor(now_us);
+    m_running = false;
+  }
+
+  /// Changes the rate of the clock from a time on.
+  /// \param rate the rate in percent of real time.
+  constexpr void rate(uint32_t rate, int64_t now_us)
+  {
+    anchor(now_us);
+    m_rate = rate;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the time left at a time.
+  [[nodiscard]] constexpr int64_t left(int64_t now_us) const
+  {
+    if (!m_running) return m_anchor_left_us;
+    const int64_t left = m_anchor_left_us - (now_us - m_anchor_us) *
+                                            m_rate / NORMAL_RATE;
+    return left > 0 ? left : 0;
+  }
+
+  /// \return the first time the time left is at most left_us, NEVER if the
+  /// clock isn't running.
+  [[nodiscard]] constexpr int64_t when(int64_t left_us) const
+  {
+    if (!m_running || m_rate == 0) return NEVER;
+    if (left_us >= m_anchor_left_us) return m_anchor_us;
+    // Rounded up, the clock is never early.
+    const int64_t run_us = m_anchor_left_us - left_us;
+    return m_anchor_us + (run_us * NORMAL_RATE + m_rate - 1) / m_rate;
+  }
+
+  [[nodiscard]] constexpr uint32_t rate() const { return m_rate; }
+
+  [[nodiscard]] constexpr bool running() const { return m_running; }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  /// Moves the anchor to a time.
+  constexpr void anchor(int64_t now_us)
+  {
+    m_anchor_left_us = left(now_us);
+    m_anchor_us = now_us;
+  }
+
+  /// The time of the last change, and the time left then.
+  int64_t m_anchor_us;
+  int64_t m_anchor_left_us;
+  uint32_t m_rate;
+  bool m_running;
+}; // class CountdownClock
+
+/// The state of a countdown, as fed to its consumers.
+struct CountdownTime
+{
+  int64_t left_us;
+  uint32_t strikes;
+  /// The rate of the clock in percent of real time.
+  uint32_t rate;
+  bool running;
+  bool expired;
+
+  /// \return the seconds to show, rounded up: a display shows 0 at expiry.
+  [[nodiscard]] constexpr uint32_t seconds() const
+  {
+    return static_cast<uint32_t>((left_us + 999999) / 1000000);
+  }
+};
+
+/// CountdownModule class
+/// \tparam MAX_FEEDS the maximum number of consumers.
+template<size_t MAX_FEEDS = 4>
+class CountdownModule : public Module<>, public Stateful
+{
+ public:
+  /// A consumer, fed on the esp_timer task.
+  using Feed = void (*)(void *arg, const CountdownTime &time);
+  /// The expiry callback, run on the esp_timer task.
+  using Expiry = void (*)(void *arg);
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param duration_ms the time of the countdown.
+  /// \param speedup the rate added by every strike, in percent (e.g. 25 for
+  /// 1.25 times faster after the first strike, 1.5 times after the second).
+  explicit CountdownModule(const std::string &name, uint32_t duration_ms,
+                           uint32_t speedup = 25)
+  : Module(name),
+    Stateful(),
+    c_duration_us(static_cast<int64_t>(duration_ms) * 1000),
+    c_speedup(speedup),
+    m_lock(),
+    m_timer(nullptr),
+    m_clock(c_duration_us),
+    m_strikes(0),
+    m_paused(false),
+    m_held(true),
+    m_feeds(),
+    m_feed_count(0),
+    m_expiry(nullptr),
+    m_expiry_arg(nullptr),
+    m_armed_us(CountdownClock::NEVER)
+  { }
+
+  ~CountdownModule()
+  {
+    if (m_timer == nullptr) return;
+    esp_timer_stop(m_timer);
+    esp_timer_delete(m_timer);
+  }
+
+  /// Creates the timer, and makes the module active. The countdown starts
+  /// with the first tick of the module.
+  void begin() const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (m_timer != nullptr) return;
+
+      const esp_timer_create_args_t args = {
+        [](void *obj) { static_cast<const CountdownModule*>(obj)->update(); },
+        const_cast<CountdownModule*>(this), // the API needs void*
+        ESP_TIMER_TASK,
+        "countdown",
+        false,
+      };
+      if (esp_timer_create(&args, &m_timer) != ESP_OK)
+      {
+        m_timer = nullptr;
+        LOG::E("No timer for countdown \"%\", it never expires.",
+               getName().c_str());
+      }
+    }
+    this->makeActive();
+  }
+
+  /// Runs the countdown on (after start(), or a SUSPEND command).
+  void threadFunc() const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (!m_held) return;
+      m_held = false;
+    }
+    update(true);
+  }
+
+  /// Holds the countdown while the module isn't ticking.
+  void idle() const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_held = true;
+    }
+    update(true);
+  }
+
+  /// Starts the countdown over, with no strikes.
+  void reset() const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_clock = CountdownClock(c_duration_us);
+      m_strikes = 0;
+      this->invalidateState();
+      this->makeActive();
+    }
+    update(true);
+  }
+
+//===-- Game functions ----------------------------------------------------===//
+
+  /// Stops running the countdown down, e.g. the game is won.
+  void pause() const
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_paused = true;
+    }
+    update(true);
+  }
+
+  /// Runs a paused countdown down again.
+  void resume() const
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_paused = false;
+    }
+    update(true);
+  }
+
+  /// Counts a mistake, speeding the countdown up.
+  /// \return the number of strikes.
+  uint32_t strike() const
+  {
+    uint32_t strikes;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (this->getState() != ACTIVE) return m_strikes;
+      strikes = ++m_strikes;
+      m_clock.rate(CountdownClock::NORMAL_RATE + strikes * c_speedup,
+                   esp_timer_get_time());
+    }
+    update(true);
+    return strikes;
+  }
+
+  /// Feeds a consumer with the state of the countdown: at a period, and at
+  /// every change (a start, a pause, a strike, the expiry). It is fed from
+  /// the next change on.
+  /// \param period_ms the period of the updates, 0 for changes only.
+  /// \param game_time whether the period is of the time left, instead of
+  /// real time: the updates are as the time left passes its multiples.
+  /// \return false, if there are MAX_FEEDS consumers, true otherwise.
+  bool subscribe(Feed feed, void *arg, uint32_t period_ms,
+                 bool game_time = false) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_feed_count == MAX_FEEDS) return false;
+
+    Subscriber &subscriber = m_feeds[m_feed_count++];
+    subscriber = Subscriber{feed, arg, static_cast<int64_t>(period_ms) * 1000,
+                            0, game_time};
+    schedule(subscriber, esp_timer_get_time());
+    return true;
+  }
+
+  /// Sets the callback run as the countdown expires.
+  void onExpiry(Expiry expiry, void *arg) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_expiry = expiry;
+    m_expiry_arg = arg;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the state of the countdown now.
+  [[nodiscard]] CountdownTime time() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return timeAt(esp_timer_get_time());
+  }
+
+  /// \return the esp_timer time of the expiry, if nothing changes,
+  /// CountdownClock::NEVER if the countdown isn't running.
+  [[nodiscard]] int64_t deadline() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_clock.when(0);
+  }
+
+  [[nodiscard]] uint32_t strikes() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_strikes;
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// A consumer.
+  struct Subscriber
+  {
+    Feed feed;
+    void *arg;
+    int64_t period_us;
+    /// The time of the next update, or the time left at it.
+    int64_t next_us;
+    bool game_time;
+  };
+
+  /// The snapshot fed to the consumers (lock m_lock).
+  CountdownTime timeAt(int64_t now_us) const
+  {
+    return CountdownTime{m_clock.left(now_us), m_strikes, m_clock.rate(),
+                         m_clock.running(), this->getState() == FAILED};
+  }
+
+  /// Sets the next update of a consumer after one at a time (lock m_lock).
+  void schedule(Subscriber &subscriber, int64_t now_us) const
+  {
+    if (subscriber.period_us == 0)
+      subscriber.next_us = -1;
+    else if (subscriber.game_time)
+    {
+      // The next multiple of the period below the time left.
+      const int64_t left = m_clock.left(now_us);
+      subscriber.next_us =
+        left == 0 ? -1
+                  : (left - 1) / subscriber.period_us * subscriber.period_us;
+    }
+    else
+    {
+      // From the previous update, so late ones don't shift the rest.
+      subscriber.next_us += subscriber.period_us;
+      if (subscriber.next_us <= now_us)
+        subscriber.next_us = now_us + subscriber.period_us;
+    }
+  }
+
+  /// \return the esp_timer time of the next update (lock m_lock).
+  int64_t due(const Subscriber &subscriber) const
+  {
+    if (subscriber.next_us < 0 || !m_clock.running())
+      return CountdownClock::NEVER;
+    return subscriber.game_time ? m_clock.when(subscriber.next_us)
+                                : subscriber.next_us;
+  }
+
+  /// Brings the countdown up to date: runs or holds the clock, expires it,
+  /// feeds the consumers due (all of them, if changed), and arms the timer
+  /// for what comes next. Run on the esp_timer task, and by the changes.
+  void update(bool changed = false) const
+  {
+    std::array<Subscriber, MAX_FEEDS> fed;
+    size_t fed_count = 0;
+    Expiry expiry = nullptr;
+    void *expiry_arg = nullptr;
+    CountdownTime time;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      const int64_t now = esp_timer_get_time();
+      if (this->getState() == ACTIVE && !m_paused && !m_held)
+        m_clock.run(now);
+      else
+        m_clock.hold(now);
+
+      if (m_clock.running() && m_clock.left(now) == 0)
+      {
+        m_clock.hold(now);
+        this->failState();
+        LOG::I("Countdown \"%\" expired.", getName().c_str());
+        expiry = m_expiry;
+        expiry_arg = m_expiry_arg;
+        changed = true;
+      }
+
+      for (size_t idx = 0; idx != m_feed_count; idx++)
+      {
+        Subscriber &subscriber = m_feeds[idx];
+        const bool is_due = due(subscriber) <= now;
+        if (!changed && !is_due) continue;
+        fed[fed_count++] = subscriber;
+        // A change keeps the pace of real time updates.
+        if (is_due || subscriber.game_time) schedule(subscriber, now);
+      }
+      time = timeAt(now);
+      arm(now);
+    }
+
+    // Fed without the lock, consumers may read the countdown.
+    for (size_t idx = 0; idx != fed_count; idx++)
+      fed[idx].feed(fed[idx].arg, time);
+    if (expiry) expiry(expiry_arg);
+  }
+
+  /// Arms the timer for the next thing due (lock m_lock).
+  void arm(int64_t now_us) const
+  {
+    if (m_timer == nullptr) return;
+
+    int64_t next = m_clock.when(0);
+    for (size_t idx = 0; idx != m_feed_count; idx++)
+      if (due(m_feeds[idx]) < next) next = due(m_feeds[idx]);
+    if (next == m_armed_us && esp_timer_is_active(m_timer)) return;
+
+    esp_timer_stop(m_timer);
+    m_armed_us = next;
+    if (next == CountdownClock::NEVER) return;
+    esp_timer_start_once(m_timer, next > now_us ? next - now_us : 0);
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  const int64_t c_duration_us;
+  const uint32_t c_speedup;
+  /// Guards the clock and the consumers, changed by other tasks.
+  mutable std::mutex m_lock;
+  mutable esp_timer_handle_t m_timer;
+  mutable CountdownClock m_clock;
+  mutable uint32_t m_strikes;
+  /// Whether the countdown is paused by the game, or held while the module
+  /// isn't ticking.
+  mutable bool m_paused;
+  mutable bool m_held;
+  mutable std::array<Subscriber, MAX_FEEDS> m_feeds;
+  mutable size_t m_feed_count;
+  mutable Expiry m_expiry;
+  mutable void *m_expiry_arg;
+  /// The esp_timer time the timer is armed for.
+  mutable int64_t m_armed_us;
+}; // class CountdownModule
+
+} // namespace PTS
+
+#endif // MODULES_COUNTDOWN_MODULE_H
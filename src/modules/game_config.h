@@ -0,0 +1,614 @@
+//===-- modules/game_config.h - GameConfig definitions --------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the GameConfig structure,
+/// which describes the modules of a game, and the GameConfigParser class,
+/// which reads it from a JSON setup file:
+///
+///   {"name": "demo",
+///    "modules": [
+///      {"type": "keypad", "name": "keypad_module",
+///       "cols": [25, 33, 32], "rows": [35, 34, 39, 36],
+///       "keys": ["123", "456", "789", "*0#"]},
+///      {"type": "wire_disconnect", "name": "wires",
+///       "wires": [16, 17, 18, 5], "steps": [1, 2, 2, 0], "forbidden": [],
+///       "led": [19, 21, 22]},
+///      {"type": "blinker", "name": "blinker", "pin": 2,
+///       "on_ms": 100, "off_ms": 900},
+///      {"type": "buzzer", "name": "buzzer", "pin": 23, "tone_hz": 1000},
+///      {"type": "led", "name": "armed_led", "pin": 4, "on": true}]}
+///
+/// The steps of a wire disconnect give the order of its wires: the wires of a
+/// step are cut in any order, after those of the earlier steps, and wires of
+/// step 0 anytime (without steps the wires but the forbidden ones are cut in
+/// the order listed). The forbidden wires, by their index, fail the module
+/// when cut.
+///
+/// The parser is fed the file in chunks (see JsonParser), filling a fixed
+/// size GameConfig: reading a setup file takes no heap and a known amount of
+/// stack, however long the file is. Unknown keys are rejected, so typos
+/// don't go unnoticed, and the finished config is validated (see
+/// validateGameConfig()) before it's built by the ModuleFactory.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_GAME_CONFIG_H
+#define MODULES_GAME_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "utils/sw/json_parser.h"
+
+namespace PTS
+{
+
+/// The module types a game can be built from.
+enum class ModuleType : uint8_t
+{
+  NONE,
+  KEYPAD,
+  WIRE_DISCONNECT,
+  BLINKER,
+  BUZZER,
+  LED,
+};
+
+/// The description of a module of a game.
+struct ModuleConfig
+{
+  /// The size of a name (including the terminating zero).
+  static constexpr size_t NAME_SIZE = 24;
+  /// The maximum number of keypad columns and rows.
+  static constexpr size_t MAX_KEYPAD_LINES = 4;
+  /// The maximum number of wires of a wire disconnect module.
+  static constexpr size_t MAX_WIRES = 16;
+
+  ModuleType type;
+  char name[NAME_SIZE];
+  /// The pin of a blinker, buzzer or led.
+  uint8_t pin;
+  bool has_pin;
+  /// The powered column pins and the read row pins of a keypad.
+  uint8_t col_pins[MAX_KEYPAD_LINES];
+  uint8_t col_count;
+  uint8_t row_pins[MAX_KEYPAD_LINES];
+  uint8_t row_count;
+  /// The characters of the keypad keys, row by row.
+  char keys[MAX_KEYPAD_LINES][MAX_KEYPAD_LINES];
+  uint8_t key_row_count;
+  uint8_t key_counts[MAX_KEYPAD_LINES];
+  /// The wire pins of a wire disconnect module.
+  uint8_t wire_pins[MAX_WIRES];
+  uint8_t wire_count;
+  /// The step of every wire in the disconnection order (none for the order
+  /// of the pins).
+  uint8_t wire_steps[MAX_WIRES];
+  uint8_t wire_step_count;
+  /// The wires failing the module when cut, a bit per wire.
+  uint16_t forbidden_wires;
+  static_assert(MAX_WIRES <= 16, "The forbidden wires are 16 bits.");
+  /// The red, green and blue pins of the status led of a wire disconnect.
+  uint8_t led_pins[3];
+  uint8_t led_pin_count;
+  /// The timing of a blinker.
+  uint32_t on_ms;
+  uint32_t off_ms;
+  /// The tone of a buzzer.
+  uint32_t tone_hz;
+  /// Whether a led is lit when the game starts.
+  bool on;
+};
+
+/// The description of a game.
+struct GameConfig
+{
+  /// The maximum number of modules of a game.
+  static constexpr size_t MAX_MODULES = 8;
+
+  char name[ModuleConfig::NAME_SIZE];
+  ModuleConfig modules[MAX_MODULES];
+  uint8_t module_count;
+};
+
+//===-- Validation --------------------------------------------------------===//
+
+/// A keypad layout the ModuleFactory can build.
+struct KeypadLayout
+{
+  uint8_t cols;
+  uint8_t rows;
+};
+
+/// The keypad layouts the ModuleFactory can build (every layout is its own
+/// template instantiation, see ModuleFactory::buildKeypad()).
+inline constexpr KeypadLayout KEYPAD_LAYOUTS[] = {{3, 4}, {4, 4}};
+
+/// The number of GPIO pins of the ESP32.
+inline constexpr uint8_t GPIO_COUNT = 40;
+
+/// \return true, if a keypad layout can be built.
+inline bool isSupportedKeypad(uint8_t cols, uint8_t rows)
+{
+  for (const KeypadLayout &layout : KEYPAD_LAYOUTS)
+    if (layout.cols == cols && layout.rows == rows) return true;
+  return false;
+}
+
+/// \return true, if the pin can be used (6 to 11 are wired to the flash).
+inline bool isUsablePin(uint8_t pin)
+{
+  return pin < GPIO_COUNT && (pin < 6 || pin > 11);
+}
+
+/// \return true, if the pin can drive an output (34 and up are input only).
+inline bool isOutputPin(uint8_t pin)
+{
+  return isUsablePin(pin) && pin < 34;
+}
+
+/// Checks the rules of a wire disconnect module: a step for every wire (or
+/// none, the wires but the forbidden ones are cut in order then), forbidden
+/// wires among the wires and without a step, and a wire to be cut.
+/// \return the reason the rules are invalid, nullptr if they are valid.
+inline const char *validateWireRules(const ModuleConfig &module)
+{
+  const uint32_t wires = (uint32_t{1} << module.wire_count) - 1;
+  if (module.forbidden_wires & ~wires) return "forbidden wire out of range";
+  if (module.wire_step_count == 0)
+    return module.forbidden_wires == wires
+             ? "wire disconnect needs a wire to cut" : nullptr;
+  if (module.wire_step_count != module.wire_count)
+    return "wire steps don't match the wires";
+
+  bool stepped = false;
+  for (size_t wire = 0; wire != module.wire_count; wire++)
+  {
+    if (module.wire_steps[wire] == 0) continue;
+    if (module.forbidden_wires >> wire & 1u)
+      return "forbidden wire with a step";
+    stepped = true;
+  }
+  return stepped ? nullptr : "wire disconnect needs a wire to cut";
+}
+
+/// Checks that the modules of a game can be built: every module is complete,
+/// the names are unique, and every pin is usable for its role and used only
+/// once.
+/// \param modules the modules to check.
+/// \param module_count the number of modules.
+/// \param failed_module set to the index of the offending module (optional).
+/// \return the reason the game is invalid, nullptr if it is valid.
+inline const char *validateModules(const ModuleConfig *modules,
+                                   size_t module_count,
+                                   size_t *failed_module = nullptr)
+{
+  uint64_t used_pins = 0;
+  // Claims a pin for a module.
+  auto claim = [&used_pins](uint8_t pin, bool output) -> const char*
+  {
+    if (!isUsablePin(pin)) return "unusable pin";
+    if (output && !isOutputPin(pin)) return "input only pin used as output";
+    if (used_pins >> pin & 1u) return "pin used twice";
+    used_pins |= uint64_t{1} << pin;
+    return nullptr;
+  };
+
+  if (module_count == 0) return "no modules";
+  if (module_count > GameConfig::MAX_MODULES) return "too many modules";
+
+  for (size_t idx = 0; idx != module_count; idx++)
+  {
+    if (failed_module) *failed_module = idx;
+    const ModuleConfig &module = modules[idx];
+    if (module.name[0] == '\0' ||
+        std::memchr(module.name, '\0', ModuleConfig::NAME_SIZE) == nullptr)
+      return "module without name";
+    for (size_t other = 0; other != idx; other++)
+      if (std::strcmp(modules[other].name, module.name) == 0)
+        return "duplicate module name";
+
+    const char *error = nullptr;
+    switch (module.type)
+    {
+      case ModuleType::KEYPAD:
+        if (!isSupportedKeypad(module.col_count, module.row_count))
+          return "unsupported keypad layout";
+        if (module.key_row_count != module.row_count)
+          return "keypad keys don't match the rows";
+        for (size_t row = 0; row != module.row_count; row++)
+          if (module.key_counts[row] != module.col_count)
+            return "keypad keys don't match the columns";
+        for (size_t col = 0; col != module.col_count && !error; col++)
+          error = claim(module.col_pins[col], true);
+        for (size_t row = 0; row != module.row_count && !error; row++)
+          error = claim(module.row_pins[row], false);
+        break;
+      case ModuleType::WIRE_DISCONNECT:
+        if (module.wire_count == 0 ||
+            module.wire_count > ModuleConfig::MAX_WIRES)
+          return "wire disconnect needs 1 to 16 wires";
+        if (const char *rules = validateWireRules(module)) return rules;
+        if (module.led_pin_count != 3) return "wire disconnect needs a led";
+        for (size_t wire = 0; wire != module.wire_count && !error; wire++)
+          error = claim(module.wire_pins[wire], false);
+        for (size_t led = 0; led != 3 && !error; led++)
+          error = claim(module.led_pins[led], true);
+        break;
+      case ModuleType::BUZZER:
+        if (module.tone_hz == 0 || module.tone_hz > 20000)
+          return "buzzer needs a tone of 1 to 20000 Hz";
+        [[fallthrough]];
+      case ModuleType::BLINKER:
+      case ModuleType::LED:
+        if (!module.has_pin) return "module without pin";
+        error = claim(module.pin, true);
+        break;
+      default: return "module without type";
+    }
+    if (error) return error;
+  }
+
+  if (failed_module) *failed_module = module_count;
+  return nullptr;
+}
+
+/// Checks that a game can be built (see validateModules()).
+inline const char *validateGameConfig(const GameConfig &config,
+                                      size_t *failed_module = nullptr)
+{
+  return validateModules(config.modules, config.module_count, failed_module);
+}
+
+//===-- Parsing -----------------------------------------------------------===//
+
+/// GameConfigParser class, filling a GameConfig from a JSON setup file.
+class GameConfigParser
+{
+  /// The JSON parser, the longest token is a name or a number.
+  using Parser = JsonParser<GameConfigParser, ModuleConfig::NAME_SIZE, 4>;
+  friend Parser;
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param config the config to be filled, it is cleared.
+  explicit GameConfigParser(GameConfig &config)
+  : m_config(config),
+    m_parser(*this),
+    m_depth(0),
+    m_field(Field::NONE),
+    m_module(nullptr),
+    m_error(nullptr),
+    m_failed_module(0)
+  { clear(); }
+
+  /// Parses a whole setup file.
+  /// \return the reason of the failure, nullptr if the config is valid.
+  static const char *parse(const char *text, GameConfig &config)
+  {
+    GameConfigParser parser(config);
+    parser.feed(text, std::strlen(text));
+    parser.finish();
+    return parser.error();
+  }
+
+//===-- Parsing functions -------------------------------------------------===//
+
+  /// Parses the next chunk of the setup file.
+  /// \return false, if the parsing failed, true otherwise.
+  bool feed(const char *data, size_t length)
+  {
+    if (m_error) return false;
+    if (!m_parser.feed(data, length)) parseFailed();
+    return !m_error;
+  }
+
+  /// Ends the setup file, and validates the config.
+  /// \return false, if the parsing failed or the config is invalid, true
+  /// otherwise.
+  bool finish()
+  {
+    if (m_error) return false;
+    if (!m_parser.finish()) parseFailed();
+    else m_error = validateGameConfig(m_config, &m_failed_module);
+    return !m_error;
+  }
+
+  /// \return the reason of the failure, nullptr if there was none.
+  [[nodiscard]] const char *error() const { return m_error; }
+
+  /// \return the offset in the file the parsing stopped at.
+  [[nodiscard]] size_t offset() const { return m_parser.offset(); }
+
+  /// \return the index of the module the failure is about.
+  [[nodiscard]] size_t failedModule() const { return m_failed_module; }
+
+//===-- JSON events -------------------------------------------------------===//
+
+ private:
+  /// The keys of the setup file.
+  enum class Field : uint8_t
+  {
+    NONE,
+    GAME_NAME,
+    MODULES,
+    TYPE,
+    NAME,
+    PIN,
+    COLS,
+    ROWS,
+    KEYS,
+    WIRES,
+    STEPS,
+    FORBIDDEN,
+    LED,
+    ON_MS,
+    OFF_MS,
+    TONE_HZ,
+    ON,
+  };
+
+  /// The nesting depth of the game object, the module list, the module
+  /// objects and their arrays.
+  static constexpr size_t GAME_DEPTH = 1;
+  static constexpr size_t MODULES_DEPTH = 2;
+  static constexpr size_t MODULE_DEPTH = 3;
+  static constexpr size_t ARRAY_DEPTH = 4;
+
+  bool beginObject()
+  {
+    if (m_depth == 0)
+    {
+      m_depth++;
+      return true;
+    }
+    if (m_depth != MODULES_DEPTH) return reject("unexpected object");
+    if (m_config.module_count == GameConfig::MAX_MODULES)
+      return reject("too many modules");
+
+    m_module = &m_config.modules[m_config.module_count++];
+    m_failed_module = m_config.module_count - 1;
+    m_depth++;
+    return true;
+  }
+
+  bool endObject()
+  {
+    m_depth--;
+    m_field = Field::NONE;
+    return true;
+  }
+
+  bool beginArray()
+  {
+    const bool expected =
+      (m_depth == GAME_DEPTH && m_field == Field::MODULES) ||
+      (m_depth == MODULE_DEPTH &&
+       (m_field == Field::COLS || m_field == Field::ROWS ||
+        m_field == Field::KEYS || m_field == Field::WIRES ||
+        m_field == Field::STEPS || m_field == Field::FORBIDDEN ||
+        m_field == Field::LED));
+    if (!expected) return reject("unexpected array");
+
+    m_depth++;
+    return true;
+  }
+
+  bool endArray()
+  {
+    m_depth--;
+    return true;
+  }
+
+  bool key(const char *name, size_t)
+  {
+    static constexpr struct
+    {
+      const char *name;
+      Field field;
+    } MODULE_KEYS[] = {
+      {"type", Field::TYPE}, {"name", Field::NAME}, {"pin", Field::PIN},
+      {"cols", Field::COLS}, {"rows", Field::ROWS}, {"keys", Field::KEYS},
+      {"wires", Field::WIRES}, {"steps", Field::STEPS},
+      {"forbidden", Field::FORBIDDEN}, {"led", Field::LED},
+      {"on_ms", Field::ON_MS}, {"off_ms", Field::OFF_MS},
+      {"tone_hz", Field::TONE_HZ}, {"on", Field::ON}};
+
+    m_field = Field::NONE;
+    if (m_depth == GAME_DEPTH)
+    {
+      if (std::strcmp(name, "name") == 0) m_field = Field::GAME_NAME;
+      else if (std::strcmp(name, "modules") == 0) m_field = Field::MODULES;
+    }
+    else
+    {
+      for (const auto &module_key : MODULE_KEYS)
+        if (std::strcmp(name, module_key.name) == 0) m_field = module_key.field;
+    }
+    return m_field != Field::NONE || reject("unknown key");
+  }
+
+  bool string(const char *text, size_t length)
+  {
+    static constexpr struct
+    {
+      const char *name;
+      ModuleType type;
+    } TYPES[] = {
+      {"keypad", ModuleType::KEYPAD},
+      {"wire_disconnect", ModuleType::WIRE_DISCONNECT},
+      {"blinker", ModuleType::BLINKER}, {"buzzer", ModuleType::BUZZER},
+      {"led", ModuleType::LED}};
+
+    if (m_depth == GAME_DEPTH && m_field == Field::GAME_NAME)
+      return copyName(m_config.name, text, length);
+    if (m_depth == MODULE_DEPTH && m_field == Field::NAME)
+      return copyName(m_module->name, text, length);
+
+    if (m_depth == MODULE_DEPTH && m_field == Field::TYPE)
+    {
+      for (const auto &type : TYPES)
+        if (std::strcmp(text, type.name) == 0) m_module->type = type.type;
+      return m_module->type != ModuleType::NONE || reject("unknown type");
+    }
+
+    if (m_depth == ARRAY_DEPTH && m_field == Field::KEYS)
+    {
+      if (m_module->key_row_count == ModuleConfig::MAX_KEYPAD_LINES ||
+          length > ModuleConfig::MAX_KEYPAD_LINES)
+        return reject("too many keys");
+      const uint8_t row = m_module->key_row_count++;
+      std::memcpy(m_module->keys[row], text, length);
+      m_module->key_counts[row] = static_cast<uint8_t>(length);
+      return true;
+    }
+    return reject("unexpected string");
+  }
+
+  bool number(const char *text, size_t)
+  {
+    char *end;
+    const unsigned long long number = std::strtoull(text, &end, 10);
+    if (*end != '\0' || text[0] == '-' || number > UINT32_MAX)
+      return reject("expected an unsigned integer");
+    const uint32_t value = static_cast<uint32_t>(number);
+
+    if (m_depth == MODULE_DEPTH)
+    {
+      switch (m_field)
+      {
+        case Field::PIN:
+          m_module->has_pin = true;
+          return setPin(m_module->pin, value);
+        case Field::ON_MS: m_module->on_ms = value; return true;
+        case Field::OFF_MS: m_module->off_ms = value; return true;
+        case Field::TONE_HZ: m_module->tone_hz = value; return true;
+        default: return reject("unexpected number");
+      }
+    }
+
+    if (m_depth == ARRAY_DEPTH)
+    {
+      switch (m_field)
+      {
+        case Field::COLS:
+          return appendPin(m_module->col_pins, m_module->col_count,
+                           ModuleConfig::MAX_KEYPAD_LINES, value);
+        case Field::ROWS:
+          return appendPin(m_module->row_pins, m_module->row_count,
+                           ModuleConfig::MAX_KEYPAD_LINES, value);
+        case Field::WIRES:
+          return appendPin(m_module->wire_pins, m_module->wire_count,
+                           ModuleConfig::MAX_WIRES, value);
+        case Field::STEPS:
+          if (m_module->wire_step_count == ModuleConfig::MAX_WIRES)
+            return reject("too many wire steps");
+          if (value > UINT8_MAX) return reject("wire step too large");
+          m_module->wire_steps[m_module->wire_step_count++] =
+            static_cast<uint8_t>(value);
+          return true;
+        case Field::FORBIDDEN:
+          if (value >= ModuleConfig::MAX_WIRES)
+            return reject("forbidden wire out of range");
+          m_module->forbidden_wires |= static_cast<uint16_t>(1u << value);
+          return true;
+        case Field::LED:
+          return appendPin(m_module->led_pins, m_module->led_pin_count, 3,
+                           value);
+        default: break;
+      }
+    }
+    return reject("unexpected number");
+  }
+
+  bool boolean(bool flag)
+  {
+    if (m_depth != MODULE_DEPTH || m_field != Field::ON)
+      return reject("unexpected boolean");
+
+    m_module->on = flag;
+    return true;
+  }
+
+  bool null() { return reject("unexpected null"); }
+
+//===-- Internals ---------------------------------------------------------===//
+
+  /// Clears the config, setting the defaults of the optional fields.
+  void clear()
+  {
+    std::memset(&m_config, 0, sizeof(m_config));
+    for (ModuleConfig &module : m_config.modules)
+    {
+      module.on_ms = 500;
+      module.off_ms = 500;
+    }
+  }
+
+  bool copyName(char *out, const char *text, size_t length)
+  {
+    if (length >= ModuleConfig::NAME_SIZE) return reject("name too long");
+
+    std::memcpy(out, text, length + 1);
+    return true;
+  }
+
+  bool setPin(uint8_t &pin, uint32_t value)
+  {
+    if (value >= GPIO_COUNT) return reject("unusable pin");
+
+    pin = static_cast<uint8_t>(value);
+    return true;
+  }
+
+  bool appendPin(uint8_t *pins, uint8_t &count, size_t capacity,
+                 uint32_t value)
+  {
+    if (count == capacity) return reject("too many pins");
+    return setPin(pins[count++], value);
+  }
+
+  /// Stores the reason of the failure, and stops the parsing.
+  bool reject(const char *reason)
+  {
+    m_error = reason;
+    return false;
+  }
+
+  /// Stores the reason of a failure of the JSON parser.
+  void parseFailed()
+  {
+    if (m_error) return; // Rejected by the handler.
+
+    switch (m_parser.error())
+    {
+      case Parser::Error::TOO_DEEP: m_error = "nested too deep"; break;
+      case Parser::Error::TOO_LONG: m_error = "value too long"; break;
+      case Parser::Error::INCOMPLETE: m_error = "incomplete file"; break;
+      default: m_error = "invalid JSON"; break;
+    }
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  GameConfig &m_config;
+  Parser m_parser;
+  size_t m_depth;
+  /// The key of the value being parsed.
+  Field m_field;
+  /// The module being parsed.
+  ModuleConfig *m_module;
+  const char *m_error;
+  size_t m_failed_module;
+}; // class GameConfigParser
+
+} // namespace PTS
+
+#endif // MODULES_GAME_CONFIG_H
@@ -0,0 +1,179 @@
+//===-- modules/game_image.h - GameImage class definition -----------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the GameImage class, which
+/// reads a compiled game: the binary form of a GameConfig, written by the
+/// host side game compiler (tools/game_compiler.cpp) and flashed into the
+/// "game" partition (see partitions.csv).
+///
+/// The image is a header followed by the ModuleConfig records, exactly as
+/// they are laid out in memory (the records only have fixed width fields, and
+/// both the ESP32 and the hosts are little-endian). So the image is read in
+/// place from the memory mapped flash: opening it checks the header, the
+/// checksum and the modules, then the ModuleFactory builds straight from the
+/// records. Booting needs no parsing and no copy of the config.
+///
+/// The layout of ModuleConfig is part of the format: changing it needs a new
+/// GAME_IMAGE_VERSION (the static_asserts below are the reminder).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_GAME_IMAGE_H
+#define MODULES_GAME_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "modules/game_config.h"
+#include "utils/sw/hash.h"
+
+namespace PTS
+{
+
+/// The version of the image format, increased by every layout change.
+inline constexpr uint16_t GAME_IMAGE_VERSION = 2;
+
+static_assert(sizeof(ModuleConfig) == 116 &&
+              offsetof(ModuleConfig, on_ms) == 100 &&
+              offsetof(ModuleConfig, on) == 112,
+              "The ModuleConfig layout changed, bump GAME_IMAGE_VERSION.");
+
+/// The header of a game image.
+struct GameImageHeader
+{
+  /// "PTSG".
+  char magic[4];
+  uint16_t version;
+  /// The size of a module record.
+  uint16_t module_size;
+  /// The length of the whole image.
+  uint32_t length;
+  /// The FNV-1a hash of the rest of the image (from the name on).
+  uint32_t checksum;
+  char name[ModuleConfig::NAME_SIZE];
+  uint8_t module_count;
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(GameImageHeader) % alignof(ModuleConfig) == 0,
+              "The module records must stay aligned.");
+
+/// GameImage class, a view of a compiled game.
+class GameImage
+{
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit GameImage() : m_header(nullptr), m_modules(nullptr) { }
+
+  /// Checks an image, and views it if it is valid. Nothing is copied, the
+  /// image must outlive the views.
+  /// \param data the image (aligned to 4 bytes, e.g. mapped flash).
+  /// \param size the size of the memory holding the image (it may be longer).
+  /// \param failed_module set to the index of an invalid module (optional).
+  /// \return the reason the image is invalid, nullptr if it is valid.
+  const char *open(const void *data, size_t size,
+                   size_t *failed_module = nullptr)
+  {
+    m_header = nullptr;
+    m_modules = nullptr;
+
+    const auto header = static_cast<const GameImageHeader*>(data);
+    if (size < sizeof(GameImageHeader) ||
+        std::memcmp(header->magic, "PTSG", 4) != 0)
+      return "no game image";
+    if (header->version != GAME_IMAGE_VERSION ||
+        header->module_size != sizeof(ModuleConfig))
+      return "unsupported game image version";
+    if (header->module_count > GameConfig::MAX_MODULES ||
+        header->length != imageSize(header->module_count) ||
+        header->length > size)
+      return "truncated game image";
+
+    if (checksum(data, header->length) != header->checksum ||
+        std::memchr(header->name, '\0', sizeof(header->name)) == nullptr)
+      return "corrupt game image";
+
+    const auto modules = reinterpret_cast<const ModuleConfig*>(
+      static_cast<const char*>(data) + sizeof(*header));
+    if (const char *error =
+          validateModules(modules, header->module_count, failed_module))
+      return error;
+
+    m_header = header;
+    m_modules = modules;
+    return nullptr;
+  }
+
+  /// Writes the image of a game.
+  /// \param config the game, validated (see validateGameConfig()).
+  /// \param out the buffer receiving the image (aligned to 4 bytes).
+  /// \param out_size the size of the buffer.
+  /// \return the length of the image, 0 if it doesn't fit.
+  static size_t write(const GameConfig &config, void *out, size_t out_size)
+  {
+    const size_t length = imageSize(config.module_count);
+    if (length > out_size) return 0;
+
+    GameImageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "PTSG", 4);
+    header.version = GAME_IMAGE_VERSION;
+    header.module_size = sizeof(ModuleConfig);
+    header.length = static_cast<uint32_t>(length);
+    std::memcpy(header.name, config.name, sizeof(header.name));
+    header.module_count = config.module_count;
+
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(static_cast<char*>(out) + sizeof(header), config.modules,
+                config.module_count * sizeof(ModuleConfig));
+    header.checksum = checksum(out, length);
+    std::memcpy(out, &header, sizeof(header));
+    return length;
+  }
+
+  /// \return the length of the image of a game with the given modules.
+  static constexpr size_t imageSize(size_t module_count)
+  {
+    return sizeof(GameImageHeader) + module_count * sizeof(ModuleConfig);
+  }
+
+  /// \return the checksum of an image (see GameImageHeader::checksum).
+  static uint32_t checksum(const void *image, size_t length)
+  {
+    constexpr size_t start = offsetof(GameImageHeader, name);
+    return fnv1a(static_cast<const char*>(image) + start, length - start);
+  }
+
+//===-- Element access ----------------------------------------------------===//
+
+  /// \return true, if a valid image is open.
+  explicit operator bool() const { return m_header != nullptr; }
+
+  /// \return the name of the game.
+  [[nodiscard]] const char *name() const { return m_header->name; }
+
+  /// \return the number of modules.
+  [[nodiscard]] size_t size() const { return m_header->module_count; }
+
+  /// \return the module records, in place.
+  [[nodiscard]] const ModuleConfig *modules() const { return m_modules; }
+
+  [[nodiscard]] const ModuleConfig *begin() const { return m_modules; }
+  [[nodiscard]] const ModuleConfig *end() const { return m_modules + size(); }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  const GameImageHeader *m_header;
+  const ModuleConfig *m_modules;
+}; // class GameImage
+
+} // namespace PTS
+
+#endif // MODULES_GAME_IMAGE_H
@@ -0,0 +1,527 @@
+//===-- modules/hw/animator_module.h - AnimatorModule class definition ----===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the Timeline class, the
+/// keyframes of a light animation, and of the AnimatorModule class, a single
+/// task playing timelines on any number of LEDs, RGBLEDs and StatusBars.
+///
+/// The animator renders a frame of every playing timeline at its fixed
+/// FREQUENCY, and writes a light only if its frame differs from the previous
+/// one: a blinking LED is written twice per period, whatever the frame rate.
+/// An RGBLED is given a hardware fade per keyframe instead of a colour per
+/// frame. So a light costs a track of about 130 bytes instead of a task with
+/// its own stack, as a BlinkerModule does.
+///
+/// The RGBLED writes of a frame are queued, and issued after the tracks are
+/// unlocked: before IDF 5 a fade waits for the running one to end, which
+/// mustn't hold up the tasks playing, pausing or querying timelines.
+///
+/// The AnimatorModule class is threadsafe.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_HW_ANIMATOR_MODULE_H
+#define MODULES_HW_ANIMATOR_MODULE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "modules/module_base.h"
+#include "utils/hw/led.h"
+#include "utils/hw/output_frame.h"
+#include "utils/hw/rgbled.h"
+#include "utils/hw/status_bar.h"
+
+namespace PTS
+{
+
+/// A point of a timeline.
+struct Keyframe
+{
+  /// The time of the keyframe from the start of the timeline.
+  uint32_t at_ms;
+  Color color;
+  /// Whether the colour is reached linearly from the previous keyframe,
+  /// instead of at once.
+  bool ramp;
+};
+
+/// Timeline class, the keyframes of an animation. Single colour lights show
+/// its brightness, the largest component of the colour: an LED is on above
+/// half of it, a StatusBar fills up or moves a dot with it.
+class Timeline
+{
+ public:
+  static constexpr size_t MAX_KEYFRAMES = 8;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param loop whether the timeline repeats, or stays at its last keyframe.
+  explicit constexpr Timeline(bool loop = true)
+  : m_keyframes(), m_count(0), m_loop(loop)
+  { }
+
+  /// Adds a keyframe, after the previous ones (the first one is at 0).
+  /// \return the timeline, to chain the keyframes.
+  constexpr Timeline &add(uint32_t at_ms, Color color, bool ramp = false)
+  {
+    if (m_count == MAX_KEYFRAMES) return *this;
+
+    m_keyframes[m_count] = Keyframe{m_count == 0 ? 0 : at_ms, color, ramp};
+    m_count++;
+    return *this;
+  }
+
+  /// \return a light on for on_ms, then off for off_ms.
+  static constexpr Timeline blink(uint32_t on_ms, uint32_t off_ms,
+                                  Color color = COLOR::WHITE)
+  {
+    return Timeline().add(0, color).add(on_ms, COLOR::OFF).add(
+      on_ms + off_ms, COLOR::OFF);
+  }
+
+  /// \return a light fading in and out in a period.
+  static constexpr Timeline pulse(uint32_t period_ms,
+                                  Color color = COLOR::WHITE)
+  {
+    return Timeline().add(0, COLOR::OFF).add(period_ms / 2, color, true).add(
+      period_ms, COLOR::OFF, true);
+  }
+
+  /// \return a brightness rising through a period, e.g. a dot running along
+  /// a StatusBar.
+  static constexpr Timeline chase(uint32_t period_ms)
+  {
+    return Timeline().add(0, COLOR::OFF).add(period_ms, COLOR::WHITE, true);
+  }
+
+  /// \return a brightness rising once, e.g. a StatusBar filling up as a
+  /// countdown runs.
+  static constexpr Timeline fill(uint32_t duration_ms)
+  {
+    return Timeline(false).add(0, COLOR::OFF).add(duration_ms, COLOR::WHITE,
+                                                  true);
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the time of the last keyframe.
+  [[nodiscard]] constexpr uint32_t length() const
+  {
+    return m_count == 0 ? 0 : m_keyframes[m_count - 1].at_ms;
+  }
+
+  /// \return whether a timeline without loop has reached its end.
+  [[nodiscard]] constexpr bool finished(uint32_t elapsed_ms) const
+  {
+    return !m_loop && elapsed_ms >= length();
+  }
+
+  /// \return the time within the current period.
+  [[nodiscard]] constexpr uint32_t wrap(uint32_t elapsed_ms) const
+  {
+    if (!m_loop || length() == 0) return std::min(elapsed_ms, length());
+    return elapsed_ms % length();
+  }
+
+  /// \return the number of periods since the start.
+  [[nodiscard]] constexpr uint32_t cycle(uint32_t elapsed_ms) const
+  {
+    return m_loop && length() != 0 ? elapsed_ms / length() : 0;
+  }
+
+  /// \return the last keyframe at or before a time within the period.
+  [[nodiscard]] constexpr size_t segment(uint32_t time_ms) const
+  {
+    size_t idx = 0;
+    while (idx + 1 < m_count && m_keyframes[idx + 1].at_ms <= time_ms) idx++;
+    return idx;
+  }
+
+  /// \return the keyframe following a segment, nullptr after the last one.
+  [[nodiscard]] constexpr const Keyframe *next(size_t segment) const
+  {
+    return segment + 1 < m_count ? &m_keyframes[segment + 1] : nullptr;
+  }
+
+  /// \return the colour at a time from the start.
+  [[nodiscard]] constexpr Color at(uint32_t elapsed_ms) const
+  {
+    if (m_count == 0) return COLOR::OFF;
+
+    const uint32_t time_ms = wrap(elapsed_ms);
+    const size_t idx = segment(time_ms);
+    const Keyframe &from = m_keyframes[idx];
+    const Keyframe *to = next(idx);
+    if (!to || !to->ramp || to->at_ms == from.at_ms) return from.color;
+
+    const uint32_t span = to->at_ms - from.at_ms;
+    const uint32_t done = time_ms - from.at_ms;
+    auto blend = [span, done](uint8_t start, uint8_t end)
+    {
+      return static_cast<uint8_t>(
+        start + (static_cast<int32_t>(end) - start) *
+                static_cast<int32_t>(done) / static_cast<int32_t>(span));
+    };
+    return Color{blend(from.color.r, to->color.r),
+                 blend(from.color.g, to->color.g),
+                 blend(from.color.b, to->color.b)};
+  }
+
+  /// \return the brightness at a time from the start.
+  [[nodiscard]] constexpr uint8_t level(uint32_t elapsed_ms) const
+  {
+    const Color color = at(elapsed_ms);
+    return std::max(color.r, std::max(color.g, color.b));
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  std::array<Keyframe, MAX_KEYFRAMES> m_keyframes;
+  size_t m_count;
+  bool m_loop;
+}; // class Timeline
+
+/// The work done by an animator.
+struct AnimatorStats
+{
+  uint32_t frames;
+  /// The lights written, the rest of the rendered tracks were unchanged.
+  uint32_t writes;
+  uint32_t busy_us;
+};
+
+/// AnimatorModule class
+/// \tparam MAX_TRACKS the number of lights played at once.
+/// \tparam FREQUENCY the frame rate in HZ.
+template<size_t MAX_TRACKS = 16, uint32_t FREQUENCY = 50>
+class AnimatorModule : public Module<2*1024, tskIDLE_PRIORITY, FREQUENCY>
+{
+  using Base = Module<2*1024, tskIDLE_PRIORITY, FREQUENCY>;
+
+  /// The way a StatusBar shows the brightness.
+  enum class BarStyle : uint8_t { FILL, DOT };
+
+  /// A queued RGBLED write: a colour, then a fade from it if duration_ms
+  /// isn't 0.
+  struct Fade
+  {
+    const RGBLED *led;
+    Color color;
+    Color target;
+    uint32_t duration_ms;
+  };
+
+  /// The writes of a frame: the staged pins, and the queued RGBLED writes.
+  struct Frame
+  {
+    OutputFrame outputs;
+    std::array<Fade, MAX_TRACKS> fades;
+    size_t fade_count;
+  };
+
+  /// A timeline playing on a light.
+  struct Track
+  {
+    const void *light;
+    /// Renders a frame: the key of the output, and the write of it.
+    uint64_t (*key)(const Timeline &timeline, uint32_t elapsed_ms,
+                    bool moving);
+    void (*write)(const void *light, const Timeline &timeline,
+                  uint32_t elapsed_ms, bool moving, Frame &frame);
+    Timeline timeline;
+    uint32_t start_ms;
+    /// The time of the frozen frame of a paused track.
+    uint32_t paused_ms;
+    uint64_t last_key;
+    bool paused;
+  };
+
+  /// The key of a frame never written.
+  static constexpr uint64_t NO_KEY = ~uint64_t(0);
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit AnimatorModule(const std::string &name = "animator")
+  : Base(name), m_tracks(), m_count(0), m_frame(), m_lock(),
+    m_write_lock(), m_stats()
+  { }
+
+  /// Nothing to set up, the lights are set up by their owners.
+  void begin() const override { }
+
+  /// Restarts every timeline.
+  void reset() const override
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint32_t now = static_cast<uint32_t>(millis());
+    for (size_t idx = 0; idx != m_count; idx++)
+      restart(m_tracks[idx], now);
+  }
+
+//===-- Playing functions -------------------------------------------------===//
+
+  /// Plays a timeline on a light from its start, replacing the one playing
+  /// on it. The light is referenced until stop().
+  /// \return false, if there are MAX_TRACKS lights playing, true otherwise.
+  bool play(const LED &led, const Timeline &timeline) const
+  {
+    return add(&led, &levelKey, &writeLed, timeline);
+  }
+
+  bool play(const RGBLED &led, const Timeline &timeline) const
+  {
+    return add(&led, &fadeKey, &writeRgbled, timeline);
+  }
+
+  /// \param dot whether a single LED runs along the bar, instead of the bar
+  /// filling up.
+  template<size_t NUM>
+  bool play(const StatusBar<NUM> &bar, const Timeline &timeline,
+            bool dot = false) const
+  {
+    if (dot)
+      return add(&bar, &barKey<NUM, BarStyle::DOT>,
+                 &writeBar<NUM, BarStyle::DOT>, timeline);
+    return add(&bar, &barKey<NUM, BarStyle::FILL>,
+               &writeBar<NUM, BarStyle::FILL>, timeline);
+  }
+
+  /// Stops the timeline of a light, leaving it as it is. Waits for the
+  /// writes of a frame being rendered, so the light isn't written after.
+  template<typename LIGHT>
+  void stop(const LIGHT &light) const
+  {
+    std::lock_guard<std::mutex> write_lock(m_write_lock);
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (Track *track = find(&light)) *track = m_tracks[--m_count];
+  }
+
+  /// Freezes the timeline of a light at its current frame.
+  template<typename LIGHT>
+  void pause(const LIGHT &light) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    Track *track = find(&light);
+    if (!track || track->paused) return;
+
+    track->paused = true;
+    track->paused_ms = static_cast<uint32_t>(millis()) - track->start_ms;
+    // The next frame sets the frozen colour, stopping a running fade (before
+    // IDF 5, once the fade has ended).
+    track->last_key = NO_KEY;
+  }
+
+  /// Continues a frozen timeline from its frame.
+  template<typename LIGHT>
+  void resume(const LIGHT &light) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    Track *track = find(&light);
+    if (!track || !track->paused) return;
+
+    track->paused = false;
+    track->start_ms = static_cast<uint32_t>(millis()) - track->paused_ms;
+    track->last_key = NO_KEY;
+  }
+
+  /// Plays the timeline of a light from its start again.
+  template<typename LIGHT>
+  void restart(const LIGHT &light) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (Track *track = find(&light))
+      restart(*track, static_cast<uint32_t>(millis()));
+  }
+
+  /// \return whether a timeline plays on a light.
+  template<typename LIGHT>
+  [[nodiscard]] bool playing(const LIGHT &light) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return find(&light) != nullptr;
+  }
+
+  /// \return the number of lights played.
+  [[nodiscard]] size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_count;
+  }
+
+  /// \return the work done so far.
+  [[nodiscard]] AnimatorStats stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_stats;
+  }
+
+//===-- Threading specific functions --------------------------------------===//
+
+  /// Renders a frame of every track, writing the changed lights. The LEDs
+  /// and StatusBars of a frame change at once, the RGBLEDs are written after
+  /// the tracks are unlocked.
+  void threadFunc() const override
+  {
+    const uint32_t start_us = static_cast<uint32_t>(micros());
+    std::lock_guard<std::mutex> write_lock(m_write_lock);
+    m_frame.fade_count = 0;
+    uint32_t writes = 0;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      const uint32_t now = static_cast<uint32_t>(millis());
+      for (size_t idx = 0; idx != m_count; idx++)
+      {
+        Track &track = m_tracks[idx];
+        const uint32_t elapsed_ms =
+          track.paused ? track.paused_ms : now - track.start_ms;
+        const uint64_t key = track.key(track.timeline, elapsed_ms,
+                                       !track.paused);
+        if (key == track.last_key) continue;
+
+        track.write(track.light, track.timeline, elapsed_ms, !track.paused,
+                    m_frame);
+        track.last_key = key;
+        writes++;
+      }
+    }
+
+    m_frame.outputs.commit();
+    for (size_t idx = 0; idx != m_frame.fade_count; idx++)
+    {
+      const Fade &fade = m_frame.fades[idx];
+      fade.led->set(fade.color);
+      if (fade.duration_ms != 0) fade.led->fade(fade.target, fade.duration_ms);
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.writes += writes;
+    m_stats.frames++;
+    m_stats.busy_us += static_cast<uint32_t>(micros()) - start_us;
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  bool add(const void *light,
+           uint64_t (*key)(const Timeline&, uint32_t, bool),
+           void (*write)(const void*, const Timeline&, uint32_t, bool,
+                         Frame&),
+           const Timeline &timeline) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    Track *track = find(light);
+    if (!track)
+    {
+      if (m_count == MAX_TRACKS) return false;
+      track = &m_tracks[m_count++];
+    }
+
+    *track = Track{light, key, write, timeline, 0, 0, NO_KEY, false};
+    restart(*track, static_cast<uint32_t>(millis()));
+    return true;
+  }
+
+  static void restart(Track &track, uint32_t now)
+  {
+    track.start_ms = now;
+    track.paused_ms = 0;
+    track.last_key = NO_KEY;
+  }
+
+  Track *find(const void *light) const
+  {
+    for (size_t idx = 0; idx != m_count; idx++)
+      if (m_tracks[idx].light == light) return &m_tracks[idx];
+    return nullptr;
+  }
+
+  /// An LED is written when it turns on or off.
+  static uint64_t levelKey(const Timeline &timeline, uint32_t elapsed_ms,
+                           bool)
+  {
+    return timeline.level(elapsed_ms) > 127;
+  }
+
+  static void writeLed(const void *light, const Timeline &timeline,
+                       uint32_t elapsed_ms, bool, Frame &frame)
+  {
+    static_cast<const LED*>(light)->stage(frame.outputs,
+                                          timeline.level(elapsed_ms) > 127);
+  }
+
+  /// A moving RGBLED is written once per keyframe, a frozen one once.
+  static uint64_t fadeKey(const Timeline &timeline, uint32_t elapsed_ms,
+                          bool moving)
+  {
+    if (!moving) return timeline.at(elapsed_ms).rgb();
+    return uint64_t(1) << 63 |
+           (uint64_t(timeline.cycle(elapsed_ms)) * Timeline::MAX_KEYFRAMES +
+            timeline.segment(timeline.wrap(elapsed_ms)));
+  }
+
+  /// Queues the colour of the frame, then a fade to the next keyframe if it
+  /// ramps. A track is written once per frame, so the queue has room.
+  static void writeRgbled(const void *light, const Timeline &timeline,
+                          uint32_t elapsed_ms, bool moving, Frame &frame)
+  {
+    const uint32_t time_ms = timeline.wrap(elapsed_ms);
+    const Keyframe *next = timeline.next(timeline.segment(time_ms));
+    Fade &fade = frame.fades[frame.fade_count++];
+    fade = Fade{static_cast<const RGBLED*>(light), timeline.at(elapsed_ms),
+                COLOR::OFF, 0};
+    if (moving && next && next->ramp && !timeline.finished(elapsed_ms))
+    {
+      fade.target = next->color;
+      fade.duration_ms = next->at_ms - time_ms;
+    }
+  }
+
+  /// A StatusBar is written when its lit LEDs change.
+  template<size_t NUM, BarStyle STYLE>
+  static uint64_t barKey(const Timeline &timeline, uint32_t elapsed_ms, bool)
+  {
+    const uint32_t level = timeline.level(elapsed_ms);
+    if (STYLE == BarStyle::DOT) return std::min(level * NUM / 255, NUM - 1);
+    return level * NUM / 255;
+  }
+
+  template<size_t NUM, BarStyle STYLE>
+  static void writeBar(const void *light, const Timeline &timeline,
+                       uint32_t elapsed_ms, bool moving, Frame &frame)
+  {
+    const StatusBar<NUM> &bar = *static_cast<const StatusBar<NUM>*>(light);
+    const size_t value =
+      static_cast<size_t>(barKey<NUM, STYLE>(timeline, elapsed_ms, moving));
+    if (STYLE == BarStyle::DOT)
+      bar.dot(value, frame.outputs);
+    else
+      bar.fill(value, frame.outputs);
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  mutable std::array<Track, MAX_TRACKS> m_tracks;
+  mutable size_t m_count;
+  /// The writes of the frame being rendered, used by the animator task only.
+  mutable Frame m_frame;
+  /// Guards the tracks and the statistics.
+  mutable std::mutex m_lock;
+  /// Held by the animator task while it renders and writes a frame, taken
+  /// before m_lock.
+  mutable std::mutex m_write_lock;
+  mutable AnimatorStats m_stats;
+}; // class AnimatorModule
+
+} // namespace PTS
+
+#endif // MODULES_HW_ANIMATOR_MODULE_H
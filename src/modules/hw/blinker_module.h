@@ -20,13 +20,20 @@
 namespace PTS
 {
 
+/// BlinkerModule class
+/// \tparam BLINK_DURATION the default time the blinker is on (ms).
+/// \tparam BLINK_PAUSE the default time the blinker is off (ms).
 template<uint32_t BLINK_DURATION, uint32_t BLINK_PAUSE>
 class BlinkerModule : public Module<>
 {
 //===-- Instantiation specific functions and threading function -----------===//
  public:
-  explicit BlinkerModule(const std::string &name, const uint8_t pin)
-  : Module(name), blinker(pin)
+  /// \param duration the time the blinker is on (ms).
+  /// \param pause the time the blinker is off (ms).
+  explicit BlinkerModule(const std::string &name, const uint8_t pin,
+                         const uint32_t duration = BLINK_DURATION,
+                         const uint32_t pause = BLINK_PAUSE)
+  : Module(name), blinker(pin), c_duration(duration), c_pause(pause)
   { }
   
   /// Sets up blinker pin and makes the module active.
@@ -35,18 +42,22 @@ class BlinkerModule : public Module<>
     blinker.begin();
   }
 
-  /// Turns the blinker on and off at the set intervals.
+  /// Turns the blinker on and off at the set intervals. Each blinker holds a
+  /// task and its stack for it, an AnimatorModule blinks any number of leds
+  /// on a single one.
   void threadFunc() const override
   {
     blinker.on();
-    ::delay(BLINK_DURATION);
+    ::delay(c_duration);
     blinker.off();
-    ::delay(BLINK_PAUSE);
+    ::delay(c_pause);
   }
 
 //===-- Member variable ---------------------------------------------------===//
  private:
   const LED blinker;
+  const uint32_t c_duration;
+  const uint32_t c_pause;
 }; // class BlinkerModule
 
 } // namespace PTS
@@ -9,47 +9,328 @@
 /// \file This file contains the declarations of the BuzzerModule class, which
 /// is a wrapper class for simple buzzer hardware.
 ///
+/// The tone is a square wave generated by a channel of the LEDC peripheral,
+/// so it sounds on without the CPU. The module's thread is a sequencer,
+/// playing a continuous tone, a script of notes (see Note and MELODY), or the
+/// beeps of a countdown speeding up near its end. It only compares the time
+/// on its ticks, and changes the tone at the note boundaries.
+///
 //===----------------------------------------------------------------------===//
 
 #ifndef MODULES_HW_BUZZER_MODULE_H
 #define MODULES_HW_BUZZER_MODULE_H
 
+#include <cstdint>
+#include <mutex>
 #include "modules/module_base.h"
+#include "utils/hw/ledc.h"
 
 namespace PTS
 {
 
+/// A note of a script, 0 Hz for a rest.
+struct Note
+{
+  uint16_t hz;
+  uint16_t ms;
+};
+
+/// Scripts for the end of a game.
+namespace MELODY
+{
+
+inline constexpr Note DEFUSED[] = {{1047, 100}, {1319, 100}, {1568, 300}};
+inline constexpr Note EXPLODED[] = {{392, 300}, {0, 50}, {262, 800}};
+
+} // namespace MELODY
+
 /// BuzzerModule class
-/// \tparam BUZZER_TONE the desired tone in frequency (Hz). 
+/// \tparam BUZZER_TONE the default tone in frequency (Hz).
 template<uint32_t BUZZER_TONE>
-class BuzzerModule : public Module<>
+class BuzzerModule : public Module<1024, tskIDLE_PRIORITY, 100>
 {
+  /// The timer resolution of the tone (the duty is half of it).
+  static constexpr uint8_t RESOLUTION = 10;
+  /// The countdown beeps, every second, up to 10 per second at the end.
+  static constexpr uint32_t BEEP_MS = 60;
+  static constexpr uint32_t SLOWEST_BEEPS_MS = 1000;
+  static constexpr uint32_t FASTEST_BEEPS_MS = 100;
+  /// The tone of a finished countdown.
+  static constexpr uint32_t FINAL_MS = 1500;
+
+  /// What the sequencer plays.
+  enum class Mode : uint8_t { SILENCE, TONE, SCRIPT, COUNTDOWN };
+
 //===-- Instantiation specific functions and threading function -----------===//
  public:
-  explicit BuzzerModule(const std::string &name, const uint8_t pin)
-  : Module(name), c_buzzer_pin(pin)
+  /// \param tone the desired tone in frequency (Hz), played from start() on,
+  /// and by the countdown.
+  explicit BuzzerModule(const std::string &name, const uint8_t pin,
+                        const uint32_t tone = BUZZER_TONE)
+  : Module(name),
+    c_buzzer_pin(pin),
+    c_tone(tone),
+    m_channel(LEDC::NO_CHANNEL),
+    m_lock(),
+    m_mode(Mode::TONE),
+    m_tone(tone),
+    m_notes(nullptr),
+    m_note_count(0),
+    m_note(0),
+    m_loop(false),
+    m_deadline_ms(0),
+    m_beep_ms(0),
+    m_final(false),
+    m_boundary_ms(0),
+    m_timed(false),
+    m_due(true),
+    m_sounding(0),
+    m_changes(0)
   { }
 
-  /// Sets up buzzer pin and makes the module active.
+  ~BuzzerModule()
+  {
+    if (m_channel == LEDC::NO_CHANNEL) return;
+    ledcWriteTone(m_channel, 0);
+    ledcDetachPin(c_buzzer_pin);
+    LEDC::release(m_channel, 2);
+  }
+
+  /// Sets up the tone channel, with a timer of its own (a channel pair).
   void begin() const override
   {
-    pinMode(c_buzzer_pin, OUTPUT);
+    if (m_channel != LEDC::NO_CHANNEL) return;
+
+    m_channel = LEDC::allocate(2, 2);
+    if (m_channel == LEDC::NO_CHANNEL ||
+        !ledcSetup(m_channel, c_tone, RESOLUTION))
+    {
+      LEDC::release(m_channel, 2);
+      m_channel = LEDC::NO_CHANNEL;
+      LOG::E("No PWM channel for buzzer \"%\", it stays silent.",
+             getName().c_str());
+      return;
+    }
+    ledcAttachPin(c_buzzer_pin, m_channel);
+    ledcWriteTone(m_channel, 0);
   }
 
-  /// Sends power to the buzzer pin at the set regular intervals.
+  /// Plays the default tone again.
+  void reset() const override { tone(c_tone); }
+
+  /// Silences the buzzer while it isn't ticking, the sequence goes on with
+  /// the next tick.
+  void idle() const override
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    write(0);
+    m_due = true;
+  }
+
+  /// Changes the tone at the note boundaries.
   void threadFunc() const override
   {
-    digitalWrite(c_buzzer_pin, HIGH);
-    ::delayMicroseconds(/*1/f=*/ 1000000 / BUZZER_TONE);
-    digitalWrite(c_buzzer_pin, LOW);
-    ::delayMicroseconds(/*1/f=*/ 1000000 / BUZZER_TONE);
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint32_t now = static_cast<uint32_t>(millis());
+    if (!m_due && (!m_timed || !reached(now, m_boundary_ms))) return;
+
+    write(advance(now));
+    m_due = false;
   }
 
-//===-- Member variable ---------------------------------------------------===//
+//===-- Sequencer functions -----------------------------------------------===//
+
+  /// Plays a continuous tone.
+  /// \param hz the frequency, 0 for silence.
+  void tone(uint32_t hz) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_mode = hz == 0 ? Mode::SILENCE : Mode::TONE;
+    m_tone = hz;
+    m_due = true;
+  }
+
+  /// Stops the sound.
+  void silence() const { tone(0); }
+
+  /// Plays a script of notes.
+  /// \param notes the notes, referenced until the script ends (e.g. MELODY).
+  /// \param loop whether the script repeats, or ends in silence. A looping
+  /// script of no length is silence.
+  void play(const Note *notes, size_t count, bool loop = false) const
+  {
+    uint32_t length_ms = 0;
+    for (size_t idx = 0; idx != count; idx++) length_ms += notes[idx].ms;
+    if (loop && length_ms == 0)
+    {
+      LOG::W("Buzzer \"%\" can't loop a script of no length.",
+             getName().c_str());
+      count = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_mode = count == 0 ? Mode::SILENCE : Mode::SCRIPT;
+    m_notes = notes;
+    m_note_count = count;
+    m_note = 0;
+    m_loop = loop;
+    m_boundary_ms =
+      static_cast<uint32_t>(millis()) + (count != 0 ? notes[0].ms : 0);
+    m_due = true;
+  }
+
+  template<size_t COUNT>
+  void play(const Note (&notes)[COUNT], bool loop = false) const
+  {
+    play(notes, COUNT, loop);
+  }
+
+  /// Beeps until a deadline, more and more often as it comes near, then
+  /// plays a long tone.
+  void countdown(uint32_t duration_ms) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_mode = Mode::COUNTDOWN;
+    m_deadline_ms = static_cast<uint32_t>(millis()) + duration_ms;
+    m_beep_ms = static_cast<uint32_t>(millis());
+    m_final = false;
+    m_due = true;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return whether a tone, a script or a countdown plays.
+  [[nodiscard]] bool playing() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_mode != Mode::SILENCE;
+  }
+
+  /// \return the frequency sounding, 0 if silent.
+  [[nodiscard]] uint32_t sounding() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_sounding;
+  }
+
+  /// \return the number of tone changes written to the peripheral.
+  [[nodiscard]] uint32_t changes() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_changes;
+  }
+
+//===-- Internals ---------------------------------------------------------===//
  private:
+  static bool reached(uint32_t now, uint32_t at)
+  {
+    return static_cast<int32_t>(now - at) >= 0;
+  }
+
+  /// Moves the sequence to the current time (lock m_lock).
+  /// \return the frequency to sound.
+  uint32_t advance(uint32_t now) const
+  {
+    m_timed = m_mode == Mode::SCRIPT || m_mode == Mode::COUNTDOWN;
+    switch (m_mode)
+    {
+      case Mode::TONE: return m_tone;
+      case Mode::SCRIPT: return advanceScript(now);
+      case Mode::COUNTDOWN: return advanceCountdown(now);
+      default: return 0;
+    }
+  }
+
+  uint32_t advanceScript(uint32_t now) const
+  {
+    // The boundaries follow the script, not the ticks, so late ticks don't
+    // stretch it. A tick late by a whole loop starts the loop over, and the
+    // notes of no length are passed (a loop has a note with a length, see
+    // play()).
+    for (size_t skipped = 0; reached(now, m_boundary_ms); skipped++)
+    {
+      if (++m_note == m_note_count)
+      {
+        if (!m_loop)
+        {
+          m_mode = Mode::SILENCE;
+          m_timed = false;
+          return 0;
+        }
+        m_note = 0;
+      }
+      if (skipped == m_note_count) m_boundary_ms = now;
+      m_boundary_ms += m_notes[m_note].ms;
+    }
+    return m_notes[m_note].hz;
+  }
+
+  uint32_t advanceCountdown(uint32_t now) const
+  {
+    const int32_t remaining = static_cast<int32_t>(m_deadline_ms - now);
+    if (remaining <= 0)
+    {
+      if (m_final)
+      {
+        m_mode = Mode::SILENCE;
+        m_timed = false;
+        return 0;
+      }
+      m_final = true;
+      m_boundary_ms = now + FINAL_MS;
+      return c_tone;
+    }
+
+    // A beep, then a rest up to the next one, a tenth of the time left away.
+    if (reached(now, m_beep_ms))
+    {
+      uint32_t interval = static_cast<uint32_t>(remaining) / 10;
+      if (interval > SLOWEST_BEEPS_MS) interval = SLOWEST_BEEPS_MS;
+      if (interval < FASTEST_BEEPS_MS) interval = FASTEST_BEEPS_MS;
+      m_boundary_ms = now + BEEP_MS;
+      m_beep_ms = now + interval;
+      return c_tone;
+    }
+    m_boundary_ms = reached(m_beep_ms, m_deadline_ms) ? m_deadline_ms
+                                                      : m_beep_ms;
+    return 0;
+  }
+
+  /// Writes a frequency to the peripheral, if it isn't sounding yet.
+  void write(uint32_t hz) const
+  {
+    if (hz == m_sounding || m_channel == LEDC::NO_CHANNEL) return;
+    ledcWriteTone(m_channel, hz);
+    m_sounding = hz;
+    m_changes++;
+  }
+
+//===-- Member variable ---------------------------------------------------===//
+
   const uint8_t c_buzzer_pin;
+  const uint32_t c_tone;
+  mutable int8_t m_channel;
+  /// Guards the sequence, set by other tasks.
+  mutable std::mutex m_lock;
+  mutable Mode m_mode;
+  mutable uint32_t m_tone;
+  mutable const Note *m_notes;
+  mutable size_t m_note_count;
+  mutable size_t m_note;
+  mutable bool m_loop;
+  mutable uint32_t m_deadline_ms;
+  /// The time of the next countdown beep.
+  mutable uint32_t m_beep_ms;
+  mutable bool m_final;
+  /// The end of the current note, if the sequence is timed.
+  mutable uint32_t m_boundary_ms;
+  mutable bool m_timed;
+  /// Set when the sequence changed, it is applied on the next tick.
+  mutable bool m_due;
+  mutable uint32_t m_sounding;
+  mutable uint32_t m_changes;
 }; // class Buzzer
 
 } // namespace PTS
 
-#endif // MODULES_HW_BUZZER_MODULE_H
\ No newline at end of file
+#endif // MODULES_HW_BUZZER_MODULE_H
@@ -0,0 +1,96 @@
+//===-- modules/hw/io_scanner_module.h - IoScannerModule class definition -===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the IoScannerModule class,
+/// which scans pin backends (see utils/hw/io_pin.h) periodically, so that
+/// the buttons, LEDs and wires on their lines follow the chips.
+///
+/// A line is as recent as the last scan: at 100 Hz a button is read 10 ms
+/// late at most, well within its debounce delay.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_HW_IO_SCANNER_MODULE_H
+#define MODULES_HW_IO_SCANNER_MODULE_H
+
+#include <array>
+#include <mutex>
+#include "modules/module_base.h"
+#include "utils/hw/io_pin.h"
+
+namespace PTS
+{
+
+/// IoScannerModule class
+/// \tparam MAX_BACKENDS the number of backends that can be scanned.
+/// \tparam FREQUENCY the scans per second.
+template<size_t MAX_BACKENDS = 4, uint32_t FREQUENCY = 100>
+class IoScannerModule : public Module<1024, tskIDLE_PRIORITY, FREQUENCY>
+{
+  using Base = Module<1024, tskIDLE_PRIORITY, FREQUENCY>;
+
+//===-- Instantiation specific functions and threading function -----------===//
+ public:
+  explicit IoScannerModule(const std::string &name = "io_scanner")
+  : Base(name), m_backends(), m_count(0), m_lock(), m_scans(0)
+  { }
+
+  /// Sets up the backends added.
+  void begin() const override
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (size_t idx = 0; idx != m_count; idx++) m_backends[idx]->begin();
+  }
+
+  /// Scans every backend.
+  void threadFunc() const override
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (size_t idx = 0; idx != m_count; idx++) m_backends[idx]->scan();
+    m_scans++;
+  }
+
+//===-- Modifier functions ------------------------------------------------===//
+
+  /// Adds a backend to scan, referenced for the lifetime of the module.
+  /// \return false if there is no room for it.
+  bool add(const PinBackend &backend) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_count == MAX_BACKENDS) return false;
+    m_backends[m_count++] = &backend;
+    return true;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the number of backends scanned.
+  [[nodiscard]] size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_count;
+  }
+
+  /// \return the number of scans done.
+  [[nodiscard]] uint32_t scans() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_scans;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  mutable std::array<const PinBackend*, MAX_BACKENDS> m_backends;
+  mutable size_t m_count;
+  mutable std::mutex m_lock;
+  mutable uint32_t m_scans;
+}; // class IoScannerModule
+
+} // namespace PTS
+
+#endif // MODULES_HW_IO_SCANNER_MODULE_H
@@ -22,6 +22,7 @@
 #include <array>
 #include <initializer_list>
 #include <optional>
+#include <utility>
 #include "modules/module_base.h"
 #include "utils/hw/button.h"
 #include "utils/sw/circular_buffer.h"
@@ -85,6 +86,17 @@ class Keypad : public Module<2048>
                   std::initializer_list<uint8_t> col_pins,
                   std::initializer_list<uint8_t> row_pins,
                   std::array<std::array<char, COLS>, ROWS> &&char_set)
+  : Keypad(module_name, col_pins.begin(), row_pins.begin(),
+           std::move(char_set))
+  { }
+
+  /// Constructs the keypad from pin arrays (e.g. read from a config).
+  /// \param col_pins the COLS powered column pins.
+  /// \param row_pins the ROWS read row pins.
+  explicit Keypad(const std::string &module_name,
+                  const uint8_t *col_pins,
+                  const uint8_t *row_pins,
+                  std::array<std::array<char, COLS>, ROWS> &&char_set)
   : Module(module_name),
     m_buttons(),
     c_char_set(char_set),
@@ -101,8 +113,8 @@ class Keypad : public Module<2048>
         ::new (&m_buttons[row_num][col_num])
         PoweredButton(col_num,
               row_num,
-              *(col_pins.begin() + col_num),
-              *(row_pins.begin() + row_num));
+              col_pins[col_num],
+              row_pins[row_num]);
   }
 
   /// Sets up the buttons.
@@ -123,6 +135,13 @@ class Keypad : public Module<2048>
         m_buttons[row_num][col_num].update(this);
   }
 
+  /// Drops the unread input characters.
+  void reset() const override
+  {
+    std::lock_guard<std::mutex> lock(m_buffer_lock);
+
+    while (!m_input_buffer.empty()) m_input_buffer.pop();
+  }
 
   /// Reads one input character from the buffer.
   /// \return the next character as std::optional (empty if the buffer is too).
@@ -12,6 +12,11 @@
 /// Modules can start new threads that are bound to them, making the usage
 /// as robust as possible. Each object may have a single task running.
 ///
+/// Other tasks control a running module by posting commands (see post()) into
+/// its lock-free mailbox, which the thread drains before every tick. So the
+/// module is paused, reset or stopped between two ticks, never in the middle
+/// of one (e.g. holding a lock, or halfway through updating its state).
+///
 /// The Module class is threadsafe
 ///
 //===----------------------------------------------------------------------===//
@@ -21,7 +26,9 @@
 
 #include <mutex>
 #include <string>
+#include "modules/module_command.h"
 #include "utils/sw/log.h"
+#include "utils/sw/mpsc_queue.h"
 #include <Arduino.h>
 
 namespace PTS
@@ -36,6 +43,9 @@ template<uint32_t STACK_DEPTH = 1024,
          uint32_t FREQUENCY = 10>
 class Module
 {
+  /// The number of commands a module takes between two ticks.
+  static constexpr size_t MAILBOX_SIZE = 4;
+
 //===-- Instantiation specific functions ----------------------------------===//
 
  public:
@@ -43,7 +53,9 @@ class Module
   explicit Module(const std::string &module_name)
     : c_module_name(module_name),
       m_task_handle(nullptr),
-      m_handle_lock(/*default*/)
+      m_handle_lock(/*default*/),
+      m_mailbox(),
+      m_paused(false)
   { LOG::I("Module \"%\" constructed.", module_name.c_str()); }
   
   /// Virtual destructor.
@@ -59,25 +71,43 @@ class Module
   /// \return the module's name.
   [[nodiscard]] std::string getName() const { return c_module_name; }
 
+  /// Resets the game state of the module, e.g. to re-arm a finished game.
+  /// Called on the module's thread (see post()), or by the posting task if
+  /// the thread isn't running. Does nothing by default.
+  virtual void reset() const { }
+
+  /// Leaves the hardware at rest as the ticks stop (the module is paused by a
+  /// command, or destroyed), e.g. silences a tone that would play on. Called
+  /// on the module's thread, or by the task destroying it (not by suspend(),
+  /// the thread may be stopped holding a lock). Does nothing by default.
+  virtual void idle() const { }
+
 //===-- Threading specific functions --------------------------------------===//
 
   /// Thread worker function that gets executed in a loop as start() is called.
   virtual void threadFunc() const = 0;
 
-  /// Creates a thread for the object running threadFunc().
+  /// Creates a thread for the object running threadFunc(). The commands
+  /// left in the mailbox by the previous thread (e.g. posted after a STOP)
+  /// are dropped, the new thread starts afresh.
   void start() const
   {
     std::lock_guard<std::mutex> lock(m_handle_lock);
     // only start new thread if none exists yet
     if (!m_task_handle)
     {
+      // no thread consumes the mailbox, it's drained here
+      for (ModuleCommand command; m_mailbox.pop(command);) { }
+      m_paused = false;
       xTaskCreate(
         [](void *obj) constexpr // wrapper lambda
         {
           uint32_t last_tick = xTaskGetTickCount();
           for(;;) // runs the threadFunc() in an infinite loop
           {
-            static_cast<decltype(this)>(obj)->threadFunc();
+            // apply the posted commands, then tick unless paused
+            if (static_cast<decltype(this)>(obj)->drainMailbox())
+              static_cast<decltype(this)>(obj)->threadFunc();
             if (pdFALSE == xTaskDelayUntil(&last_tick, configTICK_RATE_HZ / FREQUENCY))
               LOG::W("Module \"%\" was not delayed (frequency set to %)!",
                      static_cast<decltype(this)>(obj)->c_module_name.c_str(),
@@ -130,25 +160,115 @@ class Module
     }
   }
 
-  /// Deletes the object's thread.
+  /// Deletes the object's thread. The module may delete its own thread, the
+  /// call doesn't return then.
   void destroy() const
+  {
+    TaskHandle_t task_handle;
+    {
+      std::lock_guard<std::mutex> lock(m_handle_lock);
+      task_handle = m_task_handle;
+      m_task_handle = nullptr;
+    }
+
+    // deleted without the lock, a deleted thread never releases it
+    if (!task_handle) return;
+
+    LOG::I("Module \"%\" destroyed.", c_module_name.c_str());
+    if (task_handle == xTaskGetCurrentTaskHandle())
+    {
+      // the module's own thread is between ticks, rest, then end
+      idle();
+      vTaskDelete(task_handle);
+    }
+    else
+    {
+      // the thread is stopped first, so no tick undoes the rest
+      vTaskDelete(task_handle);
+      idle();
+    }
+  }
+
+  /// \return true, if the module's thread is running (even if suspended or
+  /// paused).
+  [[nodiscard]] bool isRunning() const
   {
     std::lock_guard<std::mutex> lock(m_handle_lock);
+    return m_task_handle != nullptr;
+  }
 
-    if (m_task_handle)
+//===-- Command specific functions ----------------------------------------===//
+
+  /// Posts a command to the module, never waiting for its thread. Starting is
+  /// done right away, the rest is queued to the mailbox and applied before
+  /// the next tick, in the order of posting. A module without a thread is
+  /// reset right away.
+  /// \param command the command to be applied.
+  /// \return the result of posting (see CommandResult).
+  CommandResult post(ModuleCommand command) const
+  {
+    if (command == ModuleCommand::START)
     {
-      vTaskDelete(m_task_handle);
-      m_task_handle = nullptr;
-      LOG::I("Module \"%\" destroyed.", c_module_name.c_str());
+      start();
+      return CommandResult::APPLIED;
+    }
+
+    if (!isRunning())
+    {
+      switch (command)
+      {
+        case ModuleCommand::RESET: reset(); return CommandResult::APPLIED;
+        case ModuleCommand::STOP: return CommandResult::APPLIED;
+        default: return CommandResult::NOT_RUNNING;
+      }
     }
+
+    return m_mailbox.push(command) ? CommandResult::QUEUED
+                                   : CommandResult::MAILBOX_FULL;
   }
 
 //===-- Member variables --------------------------------------------------===//
 
  private:
+  /// Applies the posted commands (module thread only).
+  /// \return false, if the module is paused, true otherwise.
+  bool drainMailbox() const
+  {
+    ModuleCommand command;
+    while (m_mailbox.pop(command))
+    {
+      switch (command)
+      {
+        case ModuleCommand::SUSPEND:
+          if (!m_paused)
+          {
+            idle();
+            LOG::I("Module \"%\" paused.", c_module_name.c_str());
+          }
+          m_paused = true;
+          break;
+        case ModuleCommand::RESUME:
+          if (m_paused) LOG::I("Module \"%\" unpaused.", c_module_name.c_str());
+          m_paused = false;
+          break;
+        case ModuleCommand::RESET:
+          reset();
+          LOG::I("Module \"%\" reset.", c_module_name.c_str());
+          break;
+        case ModuleCommand::STOP: destroy(); break;
+        default: break;
+      }
+    }
+    return !m_paused;
+  }
+
   const std::string c_module_name;
   mutable TaskHandle_t m_task_handle;
   mutable std::mutex m_handle_lock;
+  MpscQueue<ModuleCommand, MAILBOX_SIZE> m_mailbox;
+  /// Whether the ticks are paused (only touched by the module's thread, and
+  /// by start() before there is one).
+  mutable bool m_paused;
 }; // class Module
 
 } // namespace PTS
@@ -0,0 +1,91 @@
+//===-- modules/module_command.h - Module command definitions -------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the commands other tasks can post to a module
+/// (see Module::post()), the results of posting them, and their names as
+/// used by the remote command endpoint of the WebServer.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_MODULE_COMMAND_H
+#define MODULES_MODULE_COMMAND_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace PTS
+{
+
+/// The commands of a module.
+enum class ModuleCommand : uint8_t
+{
+  START,   // Starts the thread (if it isn't running).
+  SUSPEND, // Pauses the ticks of the thread, between two ticks.
+  RESUME,  // Continues the paused ticks.
+  RESET,   // Resets the game state of the module (see Module::reset()).
+  STOP,    // Deletes the thread, between two ticks.
+};
+
+/// The results of posting a command.
+enum class CommandResult : uint8_t
+{
+  APPLIED,        // Done by the posting task.
+  QUEUED,         // In the mailbox, the module applies it on its next tick.
+  NOT_RUNNING,    // The module has no thread to apply it.
+  MAILBOX_FULL,   // The module hasn't drained its earlier commands yet.
+  UNKNOWN_MODULE, // No module has the name.
+  UNSUPPORTED,    // The target can't do it (e.g. a plain led).
+};
+
+namespace COMMAND
+{
+
+/// The names of the commands, in the order of ModuleCommand.
+inline constexpr const char *COMMAND_NAMES[] = {
+  "start", "suspend", "resume", "reset", "stop"};
+
+/// The names of the results, in the order of CommandResult.
+inline constexpr const char *RESULT_NAMES[] = {
+  "applied", "queued", "not running", "mailbox full", "unknown module",
+  "unsupported"};
+
+/// \return the name of a command.
+inline const char *name(ModuleCommand command)
+{
+  return COMMAND_NAMES[static_cast<uint8_t>(command)];
+}
+
+/// \return the name of a result.
+inline const char *name(CommandResult result)
+{
+  return RESULT_NAMES[static_cast<uint8_t>(result)];
+}
+
+/// Looks up a command by its name.
+/// \param text the name of the command.
+/// \param command receives the command.
+/// \return false, if there is no such command, true otherwise.
+inline bool parse(const char *text, ModuleCommand &command)
+{
+  for (uint8_t idx = 0; idx != sizeof(COMMAND_NAMES) / sizeof(*COMMAND_NAMES);
+       idx++)
+  {
+    if (std::strcmp(text, COMMAND_NAMES[idx]) == 0)
+    {
+      command = static_cast<ModuleCommand>(idx);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace COMMAND
+
+} // namespace PTS
+
+#endif // MODULES_MODULE_COMMAND_H
@@ -0,0 +1,498 @@
+//===-- modules/module_factory.h - ModuleFactory class definition ---------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ModuleFactory class, which
+/// builds the modules of a game from its GameConfig, so a game can be changed
+/// by editing its setup file instead of building a new firmware.
+///
+/// The objects are constructed into a fixed size arena within the factory,
+/// and are kept in a table of type erased entries (the modules have no common
+/// base, their thread settings are template arguments). The modules are then
+/// set up and started together, and can be looked up by their names (also to
+/// post commands to them, see Module::post()). A module used over and over
+/// is looked up once, its ModuleHandle is used without a search by name.
+///
+/// Modules with compile time parameters are built from a fixed set of
+/// instantiations: the keypads of KEYPAD_LAYOUTS, and the buzzers with their
+/// timing set per instance. Blinkers have no task of their own, they are
+/// played by the animator of the factory.
+///
+/// Building is NOT threadsafe, it is meant to be done in setup().
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef MODULES_MODULE_FACTORY_H
+#define MODULES_MODULE_FACTORY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <utility>
+#include "modules/basic_wire_disconnect.h"
+#include "modules/game_config.h"
+#include "modules/hw/animator_module.h"
+#include "modules/hw/buzzer_module.h"
+#include "modules/hw/keypad_module.h"
+#include "utils/hw/led.h"
+#include "utils/hw/rgbled.h"
+
+namespace PTS
+{
+
+/// ModuleHandle class, a reference to a built module. Handles of an earlier
+/// build stay invalid, even if a module of the same name is built again.
+class ModuleHandle
+{
+  template<size_t> friend class ModuleFactory;
+
+ public:
+  /// Constructs an invalid handle.
+  constexpr ModuleHandle() : m_index(INVALID), m_build(0) { }
+
+  /// \return true, if the handle refers to a built module.
+  explicit operator bool() const { return m_index != INVALID; }
+
+ private:
+  static constexpr uint8_t INVALID = 0xFF;
+
+  constexpr ModuleHandle(uint8_t index, uint32_t build)
+  : m_index(index), m_build(build)
+  { }
+
+  uint8_t m_index;
+  uint32_t m_build;
+}; // class ModuleHandle
+
+/// ModuleFactory class
+/// \tparam ARENA_SIZE the size of the memory the objects are built in.
+template<size_t ARENA_SIZE = 4 * 1024>
+class ModuleFactory
+{
+  /// The built buzzers, timed per instance.
+  using ConfiguredBuzzer = BuzzerModule<1000>;
+  /// The animator of the lights, a track per module at most.
+  using Animator = AnimatorModule<GameConfig::MAX_MODULES>;
+
+  /// The built wire disconnects, as many wires as a config has at most.
+  using ConfiguredWireDisconnect = WireDisconnect<ModuleConfig::MAX_WIRES>;
+
+  /// A wire disconnect module with the status led it references.
+  struct WireDisconnectUnit
+  {
+    WireDisconnectUnit(const ModuleConfig &config)
+    : led(config.led_pins[0], config.led_pins[1], config.led_pins[2]),
+      module(config.name, config.wire_pins, config.wire_count,
+             config.wire_step_count != 0 ? config.wire_steps : nullptr,
+             config.forbidden_wires, led)
+    { }
+
+    const RGBLED led;
+    const ConfiguredWireDisconnect module;
+  };
+
+  /// A blinking led, played by the animator.
+  struct AnimatedBlinker
+  {
+    const LED led;
+    const Timeline timeline;
+    const Animator &animator;
+  };
+
+  /// A plain led, lit at start if configured so.
+  struct IndicatorLed
+  {
+    const LED led;
+    const bool on;
+  };
+
+  /// A built object.
+  struct Entry
+  {
+    char name[ModuleConfig::NAME_SIZE];
+    ModuleType type;
+    void *object;
+    void (*begin)(const void *object);
+    void (*start)(const void *object);
+    /// Stops the thread and destructs the object.
+    void (*destroy)(void *object);
+    /// Reads a key of a keypad (nullptr for other types).
+    std::optional<char> (*read_key)(const void *object);
+    /// Reads the state of a stateful module (nullptr for other types).
+    Stateful::State (*state)(const void *object);
+    /// Posts a command to a module (nullptr for other types).
+    CommandResult (*post)(const void *object, ModuleCommand command);
+  };
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit ModuleFactory()
+  : m_arena(),
+    m_used(0),
+    m_entries(),
+    m_count(0),
+    m_error(nullptr),
+    m_build(0),
+    m_animator()
+  { }
+
+  ~ModuleFactory() { clear(); }
+
+  /// Deleted copy ctor and assignment operator - the modules are running.
+  ModuleFactory(const ModuleFactory&) = delete;
+  ModuleFactory& operator=(const ModuleFactory&) = delete;
+
+  /// Builds the modules of a game, replacing the built ones.
+  /// \param config the game, validated (see validateGameConfig()).
+  /// \return false, if a module couldn't be built (see error()), true
+  /// otherwise.
+  bool build(const GameConfig &config)
+  {
+    return build(config.modules, config.module_count);
+  }
+
+  /// Builds modules, replacing the built ones. The descriptions are only read
+  /// while building, they may be views into a GameImage.
+  /// \param modules the modules, validated (see validateModules()).
+  /// \param module_count the number of modules.
+  /// \return false, if a module couldn't be built (see error()), true
+  /// otherwise.
+  bool build(const ModuleConfig *modules, size_t module_count)
+  {
+    clear();
+    m_error = nullptr;
+
+    for (size_t idx = 0; idx != module_count && !m_error; idx++)
+    {
+      const ModuleConfig &module = modules[idx];
+      switch (module.type)
+      {
+        case ModuleType::KEYPAD: buildKeypad(module); break;
+        case ModuleType::WIRE_DISCONNECT: buildWireDisconnect(module); break;
+        case ModuleType::BLINKER: buildBlinker(module); break;
+        case ModuleType::BUZZER: buildBuzzer(module); break;
+        case ModuleType::LED: buildLed(module); break;
+        default: m_error = "module without type"; break;
+      }
+    }
+
+    if (m_error) clear();
+    return !m_error;
+  }
+
+  /// Stops and destructs every built object, invalidating their handles.
+  void clear()
+  {
+    m_build++;
+    while (m_count != 0)
+    {
+      Entry &entry = m_entries[--m_count];
+      entry.destroy(entry.object);
+    }
+    m_animator.destroy();
+    m_used = 0;
+  }
+
+//===-- Module functions --------------------------------------------------===//
+
+  /// Sets up every built object.
+  void begin() const
+  {
+    for (size_t idx = 0; idx != m_count; idx++)
+      m_entries[idx].begin(m_entries[idx].object);
+  }
+
+  /// Starts the threads of every built module (and lights the leds).
+  void start() const
+  {
+    for (size_t idx = 0; idx != m_count; idx++)
+      m_entries[idx].start(m_entries[idx].object);
+    if (m_animator.size() != 0) m_animator.start();
+  }
+
+  /// Looks up a built module once, for the calls taking a handle.
+  /// \param name the name of the module.
+  /// \param type the type the module must have.
+  /// \return the handle of the module, invalid if there is no such module.
+  ModuleHandle lookup(const char *name, ModuleType type) const
+  {
+    const Entry *entry = find(name);
+    if (!entry || entry->type != type) return ModuleHandle();
+
+    return ModuleHandle(static_cast<uint8_t>(entry - m_entries.data()),
+                        m_build);
+  }
+
+  /// \return true, if the handle refers to a module of the current build.
+  [[nodiscard]] bool built(ModuleHandle handle) const
+  {
+    return find(handle) != nullptr;
+  }
+
+  /// Reads a character from a keypad.
+  /// \param name the name of the keypad.
+  /// \return the next character, empty if there is none (or no such keypad).
+  std::optional<char> readKey(const char *name) const
+  {
+    return readKey(find(name));
+  }
+
+  /// \param keypad the handle of the keypad (see lookup()).
+  std::optional<char> readKey(ModuleHandle keypad) const
+  {
+    return readKey(find(keypad));
+  }
+
+  /// Returns the state of a stateful module (e.g. a wire disconnect).
+  /// \param name the name of the module.
+  /// \return the state, empty if there is no such stateful module.
+  std::optional<Stateful::State> state(const char *name) const
+  {
+    const Entry *entry = find(name);
+    if (!entry || !entry->state) return {};
+
+    return entry->state(entry->object);
+  }
+
+  /// Posts a command to a module (see Module::post()).
+  /// \param name the name of the module.
+  /// \param command the command to be applied.
+  /// \return the result of posting, UNKNOWN_MODULE if there is no such
+  /// object, UNSUPPORTED if it isn't a module.
+  CommandResult post(const char *name, ModuleCommand command) const
+  {
+    const Entry *entry = find(name);
+    if (!entry) return CommandResult::UNKNOWN_MODULE;
+    if (!entry->post) return CommandResult::UNSUPPORTED;
+
+    return entry->post(entry->object, command);
+  }
+
+  /// \return the number of built modules.
+  [[nodiscard]] size_t size() const { return m_count; }
+
+  /// \return the used bytes of the arena.
+  [[nodiscard]] size_t used() const { return m_used; }
+
+  /// \return the reason the last build failed, nullptr if it didn't.
+  [[nodiscard]] const char *error() const { return m_error; }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// Builds a keypad, if its layout is one of KEYPAD_LAYOUTS.
+  void buildKeypad(const ModuleConfig &config)
+  {
+    static_assert(sizeof(KEYPAD_LAYOUTS) / sizeof(KEYPAD_LAYOUTS[0]) == 2,
+                  "Every keypad layout needs its instantiation below.");
+
+    if (config.col_count == 3 && config.row_count == 4)
+      buildKeypad<3, 4>(config);
+    else if (config.col_count == 4 && config.row_count == 4)
+      buildKeypad<4, 4>(config);
+    else
+      m_error = "unsupported keypad layout";
+  }
+
+  template<size_t COLS, size_t ROWS>
+  void buildKeypad(const ModuleConfig &config)
+  {
+    using Type = Keypad<COLS, ROWS>;
+
+    std::array<std::array<char, COLS>, ROWS> char_set;
+    for (size_t row = 0; row != ROWS; row++)
+      for (size_t col = 0; col != COLS; col++)
+        char_set[row][col] = config.keys[row][col];
+
+    Entry *entry = emplace<Type>(config, config.name, config.col_pins,
+                                 config.row_pins, std::move(char_set));
+    if (!entry) return;
+
+    setModuleFunctions<Type>(*entry);
+    entry->read_key = [](const void *object)
+    { return static_cast<const Type*>(object)->readOne(); };
+  }
+
+  void buildWireDisconnect(const ModuleConfig &config)
+  {
+    Entry *entry = emplace<WireDisconnectUnit>(config, config);
+    if (!entry) return;
+
+    entry->begin = [](const void *object)
+    { static_cast<const WireDisconnectUnit*>(object)->module.begin(); };
+    entry->start = [](const void *object)
+    { static_cast<const WireDisconnectUnit*>(object)->module.start(); };
+    entry->destroy = [](void *object)
+    {
+      auto unit = static_cast<WireDisconnectUnit*>(object);
+      unit->module.destroy();
+      unit->~WireDisconnectUnit();
+    };
+    entry->state = [](const void *object)
+    {
+      return static_cast<const WireDisconnectUnit*>(object)->module.getState();
+    };
+    entry->post = [](const void *object, ModuleCommand command)
+    {
+      return static_cast<const WireDisconnectUnit*>(object)->module.post(
+        command);
+    };
+  }
+
+  void buildBlinker(const ModuleConfig &config)
+  {
+    Entry *entry = emplace<AnimatedBlinker>(
+      config, AnimatedBlinker{LED(config.pin),
+                              Timeline::blink(config.on_ms, config.off_ms),
+                              m_animator});
+    if (!entry) return;
+
+    entry->begin = [](const void *object)
+    { static_cast<const AnimatedBlinker*>(object)->led.begin(); };
+    entry->start = [](const void *object)
+    {
+      auto blinker = static_cast<const AnimatedBlinker*>(object);
+      blinker->animator.play(blinker->led, blinker->timeline);
+    };
+    entry->destroy = [](void *object)
+    {
+      auto blinker = static_cast<AnimatedBlinker*>(object);
+      blinker->animator.stop(blinker->led);
+      blinker->~AnimatedBlinker();
+    };
+    // The commands are applied to the track right away, the animator
+    // renders its next frame with them.
+    entry->post = [](const void *object, ModuleCommand command)
+    {
+      auto blinker = static_cast<const AnimatedBlinker*>(object);
+      const Animator &animator = blinker->animator;
+      switch (command)
+      {
+        case ModuleCommand::START:
+          if (!animator.playing(blinker->led))
+            animator.play(blinker->led, blinker->timeline);
+          animator.start();
+          break;
+        case ModuleCommand::STOP:
+          animator.stop(blinker->led);
+          blinker->led.off();
+          break;
+        case ModuleCommand::SUSPEND: animator.pause(blinker->led); break;
+        case ModuleCommand::RESUME: animator.resume(blinker->led); break;
+        case ModuleCommand::RESET: animator.restart(blinker->led); break;
+        default: return CommandResult::UNSUPPORTED;
+      }
+      return CommandResult::APPLIED;
+    };
+  }
+
+  void buildBuzzer(const ModuleConfig &config)
+  {
+    Entry *entry = emplace<ConfiguredBuzzer>(config, config.name, config.pin,
+                                             config.tone_hz);
+    if (entry) setModuleFunctions<ConfiguredBuzzer>(*entry);
+  }
+
+  void buildLed(const ModuleConfig &config)
+  {
+    Entry *entry =
+      emplace<IndicatorLed>(config, IndicatorLed{LED(config.pin), config.on});
+    if (!entry) return;
+
+    entry->begin = [](const void *object)
+    { static_cast<const IndicatorLed*>(object)->led.begin(); };
+    entry->start = [](const void *object)
+    {
+      auto indicator = static_cast<const IndicatorLed*>(object);
+      if (indicator->on) indicator->led.on();
+    };
+    entry->destroy = [](void *object)
+    { static_cast<IndicatorLed*>(object)->~IndicatorLed(); };
+  }
+
+  /// Sets the functions of a Module type.
+  template<typename TYPE>
+  static void setModuleFunctions(Entry &entry)
+  {
+    entry.begin = [](const void *object)
+    { static_cast<const TYPE*>(object)->begin(); };
+    entry.start = [](const void *object)
+    { static_cast<const TYPE*>(object)->start(); };
+    entry.destroy = [](void *object)
+    {
+      auto module = static_cast<TYPE*>(object);
+      module->destroy();
+      module->~TYPE();
+    };
+    entry.post = [](const void *object, ModuleCommand command)
+    { return static_cast<const TYPE*>(object)->post(command); };
+  }
+
+  /// Constructs an object in the arena, and adds its entry.
+  /// \return the entry of the object, nullptr if it doesn't fit.
+  template<typename TYPE, typename... ARGS>
+  Entry *emplace(const ModuleConfig &config, ARGS&&... args)
+  {
+    const size_t offset = (m_used + alignof(TYPE) - 1) & ~(alignof(TYPE) - 1);
+    if (offset + sizeof(TYPE) > ARENA_SIZE || m_count == m_entries.size())
+    {
+      m_error = "out of module memory";
+      return nullptr;
+    }
+
+    m_used = offset + sizeof(TYPE);
+    Entry &entry = m_entries[m_count++];
+    entry = Entry();
+    std::memcpy(entry.name, config.name, sizeof(entry.name));
+    entry.type = config.type;
+    entry.object = ::new (m_arena + offset) TYPE(std::forward<ARGS>(args)...);
+    return &entry;
+  }
+
+  /// \return the entry of the named object, nullptr if there is none.
+  const Entry *find(const char *name) const
+  {
+    for (size_t idx = 0; idx != m_count; idx++)
+      if (std::strcmp(m_entries[idx].name, name) == 0) return &m_entries[idx];
+    return nullptr;
+  }
+
+  /// \return the entry of a handle, nullptr if it is invalid.
+  const Entry *find(ModuleHandle handle) const
+  {
+    if (handle.m_build != m_build || handle.m_index >= m_count) return nullptr;
+    return &m_entries[handle.m_index];
+  }
+
+  /// \return the next character of a keypad, empty if there is none (or the
+  /// entry isn't a keypad).
+  static std::optional<char> readKey(const Entry *entry)
+  {
+    if (!entry || !entry->read_key) return {};
+
+    return entry->read_key(entry->object);
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  alignas(std::max_align_t) uint8_t m_arena[ARENA_SIZE];
+  size_t m_used;
+  std::array<Entry, GameConfig::MAX_MODULES> m_entries;
+  size_t m_count;
+  const char *m_error;
+  /// The number of the build, for telling the handles of earlier ones.
+  uint32_t m_build;
+  const Animator m_animator;
+}; // class ModuleFactory
+
+} // namespace PTS
+
+#endif // MODULES_MODULE_FACTORY_H
@@ -0,0 +1,738 @@
+//===-- net/attribute_store.h - AttributeStore class definition -----------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the AttributeStore class,
+/// which holds the attributes published by the WebServer in preallocated
+/// slots, and of the AttributeHandle class, which refers to one of them.
+///
+/// Registering an attribute returns a handle to its slot. Updating through
+/// the handle does no lookup, no allocation and takes no lock: every
+/// attribute has a single writer (the task feeding it, which is also the one
+/// to remove it), and every slot is guarded by a sequence lock. The writer
+/// makes the sequence odd, writes the value and makes it even again, while
+/// readers copy the slot and retry if the sequence changed meanwhile. Readers
+/// thus always get a consistent copy and never hold up the writer, which
+/// never waits for anyone.
+///
+/// Every modification increases a global version, which is also stored in
+/// the modified attribute, so readers can tell what changed since a version.
+/// Values, names and descriptions longer than their slots are truncated.
+///
+/// Besides text, attributes can be typed (see AttributeType). Typed updates
+/// only store the raw value, every reader formats the text into its own copy
+/// (readers never write the slots). Snapshots are shared between versions,
+/// so a value is formatted once per version for the snapshot renderers.
+/// Writing the value an attribute already has is skipped without touching
+/// the slot or the version.
+///
+/// Renderers that need the whole set at one version take a Snapshot: an
+/// immutable, reference counted copy, built by the reader from the slots and
+/// shared until the version changes, so taking one is O(1) between updates.
+/// Writers never see snapshots, a slow client holding one costs them nothing.
+///
+/// Updates by handle are wait-free as long as every attribute has a single
+/// writer, the name based functions are threadsafe.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_ATTRIBUTE_STORE_H
+#define NET_ATTRIBUTE_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "utils/sw/hash.h"
+
+namespace PTS
+{
+
+/// The types of the attribute values.
+enum class AttributeType : uint8_t
+{
+  TEXT,     // Zero terminated string.
+  INTEGER,  // Signed 32 bit integer.
+  FLOAT,    // Float, formatted with a fixed number of decimals.
+  BOOL,     // "true" or "false".
+  DURATION, // Milliseconds, formatted as [H:]MM:SS.
+  ENUM,     // Index into a table of names.
+};
+
+/// The type and the formatting of an attribute, with its initial value.
+struct AttributeValue
+{
+  AttributeType type;
+  /// The raw bits of the value (unused for text).
+  uint32_t raw;
+  /// The initial value of text attributes.
+  const char *text;
+  /// The number of decimals of floats.
+  uint8_t decimals;
+  /// The names of the enum values (must outlive the attribute).
+  const char *const *names;
+  /// The number of enum names.
+  uint8_t name_count;
+
+  static AttributeValue fromText(const char *value)
+  {
+    return {AttributeType::TEXT, 0, value, 0, nullptr, 0};
+  }
+
+  static AttributeValue fromInteger(int32_t value)
+  {
+    return {AttributeType::INTEGER, static_cast<uint32_t>(value), "", 0,
+            nullptr, 0};
+  }
+
+  static AttributeValue fromFloat(float value, uint8_t decimals = 2)
+  {
+    return {AttributeType::FLOAT, floatBits(value), "", decimals, nullptr, 0};
+  }
+
+  static AttributeValue fromBool(bool value)
+  {
+    return {AttributeType::BOOL, value, "", 0, nullptr, 0};
+  }
+
+  static AttributeValue fromDuration(uint32_t milliseconds)
+  {
+    return {AttributeType::DURATION, milliseconds, "", 0, nullptr, 0};
+  }
+
+  static AttributeValue fromEnum(uint8_t index,
+                                 const char *const *names,
+                                 uint8_t name_count)
+  {
+    return {AttributeType::ENUM, index, "", 0, names, name_count};
+  }
+
+  /// \return the bits of a float.
+  static uint32_t floatBits(float value)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+};
+
+/// AttributeHandle class, a reference to a registered attribute.
+/// Handles of deleted attributes stay invalid even if the slot is reused.
+class AttributeHandle
+{
+  template<size_t, size_t, size_t, size_t> friend class AttributeStore;
+
+ public:
+  /// Constructs an invalid handle.
+  constexpr AttributeHandle() : m_index(INVALID), m_generation(0) { }
+
+  /// \return true, if the handle refers to a registered attribute.
+  explicit operator bool() const { return m_index != INVALID; }
+
+  /// \return the slot of the attribute, for tables kept alongside the store.
+  [[nodiscard]] uint16_t index() const { return m_index; }
+
+ private:
+  static constexpr uint16_t INVALID = 0xFFFF;
+
+  constexpr AttributeHandle(uint16_t index, uint16_t generation)
+  : m_index(index), m_generation(generation)
+  { }
+
+  uint16_t m_index;
+  uint16_t m_generation;
+}; // class AttributeHandle
+
+/// AttributeStore class
+/// \tparam MAX_ATTRIBUTES the maximum number of attributes.
+/// \tparam NAME_SIZE the size of a name (including the terminating zero).
+/// \tparam VALUE_SIZE the size of a value (including the terminating zero).
+/// \tparam DESCRIPTION_SIZE the size of a description (including the
+/// terminating zero).
+template<size_t MAX_ATTRIBUTES,
+         size_t NAME_SIZE = 32,
+         size_t VALUE_SIZE = 48,
+         size_t DESCRIPTION_SIZE = 64>
+class AttributeStore
+{
+  static_assert(MAX_ATTRIBUTES < AttributeHandle::INVALID,
+                "Too many attributes for the handles.");
+
+  struct Frame;
+
+ public:
+  /// A consistent copy of an attribute.
+  struct View
+  {
+    char name[NAME_SIZE];
+    char value[VALUE_SIZE];
+    char description[DESCRIPTION_SIZE];
+    /// The global version at the attribute's last modification.
+    uint32_t version;
+    /// The index of the attribute's slot, its place in the iteration order.
+    uint16_t slot;
+  };
+
+  /// Snapshot class, a shared, immutable copy of every attribute at a
+  /// version. Copies share the frame, which is reused when the last one is
+  /// gone (the store keeps the newest frame for the next snapshot).
+  class Snapshot
+  {
+    friend class AttributeStore;
+
+   public:
+    Snapshot(const Snapshot &other) : m_frame(other.m_frame) { acquire(); }
+    ~Snapshot() { release(); }
+
+    Snapshot& operator=(const Snapshot &other)
+    {
+      if (m_frame != other.m_frame)
+      {
+        release();
+        m_frame = other.m_frame;
+        acquire();
+      }
+      return *this;
+    }
+
+    /// \return the global version the snapshot was taken at.
+    [[nodiscard]] uint32_t version() const { return m_frame->version; }
+
+    /// \return the version of the last deletion before the snapshot.
+    [[nodiscard]] uint32_t deletedVersion() const
+    {
+      return m_frame->deleted_version;
+    }
+
+    /// \return the number of attributes.
+    [[nodiscard]] size_t size() const { return m_frame->count; }
+
+    [[nodiscard]] const View *begin() const { return m_frame->views; }
+    [[nodiscard]] const View *end() const
+    {
+      return m_frame->views + m_frame->count;
+    }
+
+    /// Calls the visitor with every attribute modified after a version.
+    /// \tparam VISITOR a callable taking a const View&.
+    /// \param since the version to compare with, 0 for every attribute.
+    /// \param visitor the visitor to be called.
+    template<typename VISITOR>
+    void forEach(uint32_t since, VISITOR &&visitor) const
+    {
+      for (const View &view : *this)
+        if (view.version > since) visitor(view);
+    }
+
+    /// Calls the visitor with every attribute.
+    template<typename VISITOR>
+    void forEach(VISITOR &&visitor) const
+    {
+      forEach(0, visitor);
+    }
+
+   private:
+    explicit Snapshot(Frame *frame) : m_frame(frame) { acquire(); }
+
+    void acquire() { m_frame->references.fetch_add(1); }
+    void release() { m_frame->references.fetch_sub(1); }
+
+    Frame *m_frame;
+  }; // class Snapshot
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit AttributeStore()
+  : m_slots(),
+    m_version(0),
+    m_deleted_version(0),
+    m_registry_lock(),
+    m_frames(),
+    m_current_frame(&m_frames[0]),
+    m_snapshot_lock()
+  {
+    m_current_frame->references = 1; // Held by the store, empty at version 0.
+  }
+
+  /// Deleted copy ctor and assignment operator - handles refer to the slots.
+  AttributeStore(const AttributeStore&) = delete;
+  AttributeStore& operator=(const AttributeStore&) = delete;
+
+//===-- Registry functions ------------------------------------------------===//
+
+  /// Registers an attribute.
+  /// \param name the unique name of the attribute.
+  /// \param value the value of the attribute.
+  /// \param description the description of the attribute.
+  /// \return the handle of the attribute, invalid if the name is already
+  /// registered or there is no free slot.
+  AttributeHandle add(const char *name,
+                      const char *value,
+                      const char *description) const
+  {
+    return add(name, AttributeValue::fromText(value), description);
+  }
+
+  /// Registers a typed attribute.
+  /// \param name the unique name of the attribute.
+  /// \param value the type, the formatting and the initial value.
+  /// \param description the description of the attribute.
+  /// \return the handle of the attribute, invalid if the name is already
+  /// registered or there is no free slot.
+  AttributeHandle add(const char *name,
+                      const AttributeValue &value,
+                      const char *description) const
+  {
+    std::lock_guard<std::mutex> lock(m_registry_lock);
+
+    const uint32_t hash = fnv1a(name, std::strlen(name));
+    if (findLocked(name, hash)) return AttributeHandle();
+
+    for (size_t idx = 0; idx != MAX_ATTRIBUTES; idx++)
+    {
+      Slot &slot = m_slots[idx];
+      if (slot.active) continue;
+
+      const uint32_t sequence = beginWrite(slot);
+      slot.active = true;
+      slot.hash = hash;
+      slot.type = value.type;
+      slot.decimals = value.decimals;
+      slot.names = value.names;
+      slot.name_count = value.name_count;
+      slot.raw.store(value.raw, std::memory_order_relaxed);
+      copyText(slot.name, name, NAME_SIZE);
+      copyText(slot.value, value.text, VALUE_SIZE);
+      copyText(slot.description, description, DESCRIPTION_SIZE);
+      slot.version = nextVersion();
+      endWrite(slot, sequence);
+      return AttributeHandle(idx, slot.generation);
+    }
+    return AttributeHandle();
+  }
+
+  /// Looks up a registered attribute by name.
+  /// \param name the name of the attribute.
+  /// \return the handle of the attribute, invalid if it is not registered.
+  AttributeHandle find(const char *name) const
+  {
+    std::lock_guard<std::mutex> lock(m_registry_lock);
+    return findLocked(name, fnv1a(name, std::strlen(name)));
+  }
+
+  /// Deletes a registered attribute, invalidating its handles. Only the
+  /// writer of the attribute may delete it.
+  /// \param name the name of the attribute.
+  /// \return false, if the attribute does not exist, true otherwise.
+  bool remove(const char *name) const
+  {
+    std::lock_guard<std::mutex> lock(m_registry_lock);
+
+    const AttributeHandle handle =
+      findLocked(name, fnv1a(name, std::strlen(name)));
+    if (!handle) return false;
+
+    Slot &slot = m_slots[handle.m_index];
+    const uint32_t sequence = beginWrite(slot);
+    slot.active = false;
+    slot.generation++;
+    endWrite(slot, sequence);
+    // Delta readers older than this can't tell what was removed.
+    m_deleted_version.store(nextVersion());
+    return true;
+  }
+
+//===-- Value functions ---------------------------------------------------===//
+
+  /// Sets the value of a text attribute. Setting the current value returns
+  /// right away.
+  /// \param handle the handle of the attribute.
+  /// \param value the new value.
+  /// \return false, if the handle is invalid (or deleted) or the attribute
+  /// is typed, true otherwise.
+  bool update(AttributeHandle handle, const char *value) const
+  {
+    if (!handle || handle.m_index >= MAX_ATTRIBUTES) return false;
+
+    Slot &slot = m_slots[handle.m_index];
+    if (unchanged(slot, handle, AttributeType::TEXT, [value](const Slot &same)
+        { return std::strncmp(same.value, value, VALUE_SIZE - 1) == 0; }))
+      return true;
+
+    const uint32_t sequence = beginWrite(slot);
+    const bool valid = slot.active &&
+                       slot.generation == handle.m_generation &&
+                       slot.type == AttributeType::TEXT;
+    if (valid && std::strncmp(slot.value, value, VALUE_SIZE - 1) != 0)
+    {
+      copyText(slot.value, value, VALUE_SIZE);
+      slot.version = nextVersion();
+    }
+    endWrite(slot, sequence);
+    return valid;
+  }
+
+  /// Sets the raw value of a typed attribute. Setting the current value
+  /// returns right away.
+  /// \param handle the handle of the attribute.
+  /// \param type the type of the value (must match the registered one).
+  /// \param raw the raw bits of the value (see AttributeValue).
+  /// \param changed set to whether the value changed (optional).
+  /// \return false, if the handle is invalid (or deleted) or the type
+  /// doesn't match, true otherwise.
+  bool set(AttributeHandle handle,
+           AttributeType type,
+           uint32_t raw,
+           bool *changed = nullptr) const
+  {
+    if (changed) *changed = false;
+    if (!handle || handle.m_index >= MAX_ATTRIBUTES ||
+        type == AttributeType::TEXT)
+      return false;
+
+    Slot &slot = m_slots[handle.m_index];
+    if (unchanged(slot, handle, type, [raw](const Slot &same)
+        { return same.raw.load(std::memory_order_relaxed) == raw; }))
+      return true;
+
+    const uint32_t sequence = beginWrite(slot);
+    const bool valid = slot.active &&
+                       slot.generation == handle.m_generation &&
+                       slot.type == type;
+    if (valid && slot.raw.load(std::memory_order_relaxed) != raw)
+    {
+      slot.raw.store(raw, std::memory_order_relaxed);
+      slot.version = nextVersion();
+      if (changed) *changed = true;
+    }
+    endWrite(slot, sequence);
+    return valid;
+  }
+
+  /// Copies an attribute.
+  /// \param handle the handle of the attribute.
+  /// \param view the view receiving the copy.
+  /// \return false, if the handle is invalid (or deleted), true otherwise.
+  bool read(AttributeHandle handle, View &view) const
+  {
+    if (!handle || handle.m_index >= MAX_ATTRIBUTES) return false;
+
+    uint16_t generation = 0;
+    view.slot = handle.m_index;
+    return readSlot(m_slots[handle.m_index], 0, view, generation) &&
+           generation == handle.m_generation;
+  }
+
+  /// Calls the visitor with a consistent copy of every attribute modified
+  /// after a version, in the order of their slots. Only those are copied
+  /// (and formatted, if they are typed). Writers are never waited for.
+  /// \tparam VISITOR a callable taking a const View&.
+  /// \param since the version to compare with, 0 for every attribute.
+  /// \param visitor the visitor to be called.
+  template<typename VISITOR>
+  void forEach(uint32_t since, VISITOR &&visitor) const
+  {
+    View view;
+    uint16_t generation;
+    for (size_t idx = 0; idx != MAX_ATTRIBUTES; idx++)
+    {
+      view.slot = static_cast<uint16_t>(idx);
+      if (readSlot(m_slots[idx], since, view, generation)) visitor(view);
+    }
+  }
+
+  /// Calls the visitor with a consistent copy of every attribute.
+  template<typename VISITOR>
+  void forEach(VISITOR &&visitor) const
+  {
+    forEach(0, visitor);
+  }
+
+  /// Returns an immutable copy of every attribute. The newest copy is shared
+  /// while the version doesn't change, otherwise a new one is built from the
+  /// slots into a frame nobody holds (without ever waiting for writers).
+  /// Should every frame be held, the newest (older) copy is returned.
+  /// \return the snapshot.
+  Snapshot snapshot() const
+  {
+    std::lock_guard<std::mutex> lock(m_snapshot_lock);
+
+    Frame *current = m_current_frame;
+    if (current->version == version()) return Snapshot(current);
+
+    // A free frame, or the current one if only the store holds it.
+    Frame *frame = nullptr;
+    for (Frame &candidate : m_frames)
+      if (&candidate != current && candidate.references.load() == 0)
+        frame = &candidate;
+    if (!frame && current->references.load() == 1) frame = current;
+    if (!frame) return Snapshot(current);
+
+    fillFrame(*frame);
+    if (frame != current)
+    {
+      frame->references.fetch_add(1);
+      current->references.fetch_sub(1);
+      m_current_frame = frame;
+    }
+    return Snapshot(frame);
+  }
+
+//===-- Version functions -------------------------------------------------===//
+
+  /// \return the global version, increased by every modification.
+  [[nodiscard]] uint32_t version() const { return m_version.load(); }
+
+  /// \return the version of the last deletion.
+  [[nodiscard]] uint32_t deletedVersion() const
+  {
+    return m_deleted_version.load();
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// A preallocated attribute slot.
+  struct Slot
+  {
+    /// Odd while the slot is written (by its single writer).
+    std::atomic<uint32_t> sequence;
+    bool active;
+    /// Increased on deletion, so the handles of the old attribute are stale.
+    uint16_t generation;
+    uint32_t hash;
+    uint32_t version;
+    AttributeType type;
+    uint8_t decimals;
+    uint8_t name_count;
+    /// Atomic, so unchanged values can be detected without writing the slot.
+    std::atomic<uint32_t> raw;
+    const char *const *names;
+    char name[NAME_SIZE];
+    /// The value of text attributes.
+    char value[VALUE_SIZE];
+    char description[DESCRIPTION_SIZE];
+  };
+
+  /// The number of snapshot frames: the newest, and one being rendered.
+  static constexpr size_t FRAME_COUNT = 2;
+
+  /// The storage of a snapshot.
+  struct Frame
+  {
+    /// The number of snapshots (and the store, for the newest one) holding
+    /// the frame.
+    std::atomic<uint32_t> references;
+    uint32_t version;
+    uint32_t deleted_version;
+    size_t count;
+    View views[MAX_ATTRIBUTES];
+  };
+
+  /// The number of times a snapshot is retaken when the attributes are
+  /// modified meanwhile, before settling for a mixed one.
+  static constexpr size_t SNAPSHOT_RETRIES = 3;
+
+  /// Copies the active slots into a frame. The copy is retaken if the global
+  /// version changes meanwhile, so the snapshot is of a single version. If
+  /// it keeps changing, the snapshot reports the version it started at,
+  /// with some attributes newer than that (a delta from it resends them).
+  void fillFrame(Frame &frame) const
+  {
+    for (size_t attempt = 0; attempt != SNAPSHOT_RETRIES; attempt++)
+    {
+      frame.version = version();
+      frame.deleted_version = deletedVersion();
+      frame.count = 0;
+      uint16_t generation;
+      for (size_t idx = 0; idx != MAX_ATTRIBUTES; idx++)
+      {
+        View &view = frame.views[frame.count];
+        view.slot = static_cast<uint16_t>(idx);
+        if (readSlot(m_slots[idx], 0, view, generation)) frame.count++;
+      }
+
+      if (version() == frame.version) return;
+    }
+  }
+
+  /// Starts writing a slot, making its sequence odd. Slots have a single
+  /// writer (new ones the registering task), so there is nobody to wait for.
+  /// \return the sequence to be passed to endWrite().
+  static uint32_t beginWrite(Slot &slot)
+  {
+    const uint32_t sequence =
+      slot.sequence.load(std::memory_order_relaxed) + 1;
+    slot.sequence.store(sequence, std::memory_order_relaxed);
+
+    // Readers seeing any of the following writes also see the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+  }
+
+  /// Finishes writing a slot, making its sequence even again.
+  static void endWrite(Slot &slot, uint32_t sequence)
+  {
+    slot.sequence.store(sequence + 1, std::memory_order_release);
+  }
+
+  /// Tells whether a write leaves a slot as it is, reading the slot like a
+  /// reader would (without writing its sequence, so readers aren't retried).
+  /// \tparam SAME a callable taking the const Slot&, true if the value to be
+  /// written is the current one.
+  /// \return true, if the attribute of the handle is of the type and has the
+  /// value, false if it has to be written (or the write be rejected).
+  template<typename SAME>
+  static bool unchanged(const Slot &slot,
+                        AttributeHandle handle,
+                        AttributeType type,
+                        SAME &&same)
+  {
+    const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) || !slot.active ||
+        slot.generation != handle.m_generation || slot.type != type ||
+        !same(slot))
+      return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+  }
+
+  /// Copies an active slot, retrying while it is being written. The value of
+  /// a typed slot is formatted into the view from the raw value copied, the
+  /// slot is only ever read.
+  /// \param slot the slot to be copied.
+  /// \param since the version the slot must be newer than.
+  /// \param view the view receiving the copy.
+  /// \param generation receives the generation of the slot.
+  /// \return false, if the slot is not active or not newer, true otherwise.
+  static bool readSlot(const Slot &slot,
+                       uint32_t since,
+                       View &view,
+                       uint16_t &generation)
+  {
+    for (;;)
+    {
+      const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence & 1) continue;
+
+      const bool active = slot.active && slot.version > since;
+      AttributeType type = AttributeType::TEXT;
+      uint32_t raw = 0;
+      uint8_t decimals = 0;
+      const char *const *names = nullptr;
+      uint8_t name_count = 0;
+      if (active)
+      {
+        std::memcpy(view.name, slot.name, NAME_SIZE);
+        std::memcpy(view.description, slot.description, DESCRIPTION_SIZE);
+        view.version = slot.version;
+        generation = slot.generation;
+        type = slot.type;
+        if (type == AttributeType::TEXT)
+          std::memcpy(view.value, slot.value, VALUE_SIZE);
+        raw = slot.raw.load(std::memory_order_relaxed);
+        decimals = slot.decimals;
+        names = slot.names;
+        name_count = slot.name_count;
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+      if (active && type != AttributeType::TEXT)
+        formatValue(view.value, type, raw, decimals, names, name_count);
+      return active;
+    }
+  }
+
+  /// Formats a raw value.
+  /// \param out the buffer receiving the text (VALUE_SIZE bytes).
+  static void formatValue(char *out,
+                          AttributeType type,
+                          uint32_t raw,
+                          uint8_t decimals,
+                          const char *const *names,
+                          uint8_t name_count)
+  {
+    switch (type)
+    {
+      case AttributeType::INTEGER:
+        std::snprintf(out, VALUE_SIZE, "%ld",
+                      static_cast<long>(static_cast<int32_t>(raw)));
+        break;
+      case AttributeType::FLOAT:
+      {
+        float value;
+        std::memcpy(&value, &raw, sizeof(value));
+        std::snprintf(out, VALUE_SIZE, "%.*f", decimals,
+                      static_cast<double>(value));
+        break;
+      }
+      case AttributeType::BOOL:
+        copyText(out, raw ? "true" : "false", VALUE_SIZE);
+        break;
+      case AttributeType::DURATION:
+      {
+        const unsigned long seconds = raw / 1000;
+        if (seconds >= 3600)
+          std::snprintf(out, VALUE_SIZE, "%lu:%02lu:%02lu", seconds / 3600,
+                        seconds / 60 % 60, seconds % 60);
+        else
+          std::snprintf(out, VALUE_SIZE, "%02lu:%02lu", seconds / 60,
+                        seconds % 60);
+        break;
+      }
+      case AttributeType::ENUM:
+        copyText(out, raw < name_count ? names[raw] : "?", VALUE_SIZE);
+        break;
+      default: break;
+    }
+  }
+
+  /// Finds an active slot by name (call with the registry lock held).
+  AttributeHandle findLocked(const char *name, uint32_t hash) const
+  {
+    for (size_t idx = 0; idx != MAX_ATTRIBUTES; idx++)
+    {
+      const Slot &slot = m_slots[idx];
+      if (slot.active && slot.hash == hash &&
+          std::strncmp(slot.name, name, NAME_SIZE - 1) == 0)
+        return AttributeHandle(idx, slot.generation);
+    }
+    return AttributeHandle();
+  }
+
+  /// Copies a string, truncating and zero terminating it.
+  static void copyText(char *out, const char *text, size_t size)
+  {
+    size_t length = 0;
+    while (length != size - 1 && text[length]) length++;
+    std::memcpy(out, text, length);
+    out[length] = '\0';
+  }
+
+  /// \return the next global version.
+  uint32_t nextVersion() const { return ++m_version; }
+
+//===-- Member variables --------------------------------------------------===//
+
+  mutable Slot m_slots[MAX_ATTRIBUTES];
+  mutable std::atomic<uint32_t> m_version;
+  mutable std::atomic<uint32_t> m_deleted_version;
+  mutable std::mutex m_registry_lock;
+  mutable Frame m_frames[FRAME_COUNT];
+  mutable Frame *m_current_frame;
+  /// Serializes the snapshot builders (writers never take it).
+  mutable std::mutex m_snapshot_lock;
+}; // class AttributeStore
+
+} // namespace PTS
+
+#endif // NET_ATTRIBUTE_STORE_H
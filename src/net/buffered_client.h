@@ -0,0 +1,193 @@
+//===-- net/buffered_client.h - BufferedClient class definition -----------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the BufferedClient class, a
+/// WiFiClient whose writes never wait for the peer.
+///
+/// Every write is sent with MSG_DONTWAIT, and what the socket doesn't take
+/// is kept in a backlog of fixed size, sent with sendBacklog() once the
+/// socket has room again. Later writes queue up behind the backlog, so the
+/// bytes stay in order. A write that doesn't fit into the backlog fails, and
+/// the client is marked as overflowed: its output is incomplete, it should be
+/// closed. Constant bodies (e.g. files in flash) are never copied: what the
+/// socket doesn't take of them is sent from where they are stored.
+///
+/// Requests are peeked and only taken once answered (see peekNow() and
+/// discardNow()), so the ones behind an unfinished response wait in the
+/// socket.
+///
+/// The class is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_BUFFERED_CLIENT_H
+#define NET_BUFFERED_CLIENT_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+#include <WiFi.h>
+#include "utils/sw/byte_buffer.h"
+
+namespace PTS
+{
+
+/// Sends as much as a socket takes right away.
+/// \param fd the socket.
+/// \param data the bytes to send.
+/// \param length the number of bytes to send.
+/// \return the number of bytes sent (0 if the socket is full), -1 if the
+/// connection failed.
+inline ssize_t sendNow(int fd, const void *data, size_t length)
+{
+  if (length == 0) return 0;
+
+  const ssize_t sent = ::send(fd, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (sent >= 0) return sent;
+  return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+}
+
+/// Copies what arrived on a socket without taking it.
+/// \param fd the socket.
+/// \param data the buffer receiving the bytes.
+/// \param length the size of the buffer.
+/// \return the number of bytes copied (0 if none arrived), -1 if the
+/// connection was closed or failed.
+inline ssize_t peekNow(int fd, void *data, size_t length)
+{
+  const ssize_t received =
+    ::recv(fd, data, length, MSG_PEEK | MSG_DONTWAIT);
+  if (received > 0) return received;
+  return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+}
+
+/// Takes bytes that arrived on a socket (peeked before), dropping them.
+/// \param fd the socket.
+/// \param length the number of bytes to take.
+inline void discardNow(int fd, size_t length)
+{
+  char scratch[128];
+  while (length != 0)
+  {
+    const ssize_t received = ::recv(fd, scratch,
+      length < sizeof(scratch) ? length : sizeof(scratch), MSG_DONTWAIT);
+    if (received <= 0) return;
+    length -= static_cast<size_t>(received);
+  }
+}
+
+/// BufferedClient class
+/// \tparam BACKLOG_SIZE the number of bytes kept while the socket is full.
+template<size_t BACKLOG_SIZE>
+class BufferedClient : public WiFiClient
+{
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit BufferedClient()
+  : WiFiClient(), m_backlog(), m_constant(nullptr), m_constant_length(0)
+  { }
+
+  /// Takes over a connection, with an empty backlog.
+  BufferedClient &operator=(const WiFiClient &client)
+  {
+    WiFiClient::operator=(client);
+    m_backlog.clear();
+    m_constant = nullptr;
+    m_constant_length = 0;
+    return *this;
+  }
+
+//===-- Output functions --------------------------------------------------===//
+
+  /// Sends the bytes, or queues what the socket doesn't take.
+  /// \return the number of bytes accepted, 0 if the connection failed or the
+  /// backlog overflowed (nothing is accepted from then on).
+  size_t write(const uint8_t *data, size_t length) override
+  {
+    // Nothing is queued behind a constant body (see writeConstant()).
+    if (fd() < 0 || m_backlog.overflowed() || m_constant_length != 0)
+      return 0;
+
+    size_t sent = 0;
+    if (m_backlog.empty())
+    {
+      const ssize_t result = sendNow(fd(), data, length);
+      if (result < 0) return 0;
+      sent = static_cast<size_t>(result);
+    }
+    if (!m_backlog.write(reinterpret_cast<const char*>(data) + sent,
+                         length - sent))
+      return 0;
+    return length;
+  }
+
+  using WiFiClient::write;
+
+  /// Sends bytes that stay where they are until they are sent (e.g. a file
+  /// in flash) after the backlog. What the socket doesn't take is sent from
+  /// there by sendBacklog(), further writes are refused until then.
+  /// \return false, if the connection failed or a constant body is still
+  /// being sent, true otherwise.
+  bool writeConstant(const uint8_t *data, size_t length)
+  {
+    if (fd() < 0 || m_backlog.overflowed() || m_constant_length != 0)
+      return false;
+
+    m_constant = data;
+    m_constant_length = length;
+    return sendBacklog();
+  }
+
+  /// Sends as much of the backlog, then of the constant body, as the socket
+  /// takes.
+  /// \return false, if the connection failed, true otherwise.
+  bool sendBacklog()
+  {
+    if (!m_backlog.empty())
+    {
+      const ssize_t sent = sendNow(fd(), m_backlog.data(), m_backlog.size());
+      if (sent < 0) return false;
+
+      m_backlog.consume(static_cast<size_t>(sent));
+      if (!m_backlog.empty()) return true;
+    }
+    if (m_constant_length == 0) return true;
+
+    const ssize_t sent = sendNow(fd(), m_constant, m_constant_length);
+    if (sent < 0) return false;
+
+    m_constant += sent;
+    m_constant_length -= static_cast<size_t>(sent);
+    return true;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the number of bytes waiting for the socket.
+  [[nodiscard]] size_t pending() const
+  {
+    return m_backlog.size() + m_constant_length;
+  }
+
+  /// \return true, if a write didn't fit into the backlog.
+  [[nodiscard]] bool overflowed() const { return m_backlog.overflowed(); }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  ByteBuffer<BACKLOG_SIZE> m_backlog;
+  /// The unsent part of the constant body.
+  const uint8_t *m_constant;
+  size_t m_constant_length;
+}; // class BufferedClient
+
+} // namespace PTS
+
+#endif // NET_BUFFERED_CLIENT_H
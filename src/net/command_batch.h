@@ -0,0 +1,341 @@
+//===-- net/command_batch.h - CommandBatch class definition ---------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the CommandBatch and
+/// CommandBatchParser classes, the batch of remote commands posted to the
+/// WebServer's "/api/commands" in a single request, a JSON array such as:
+///
+///   [{"op": "reset", "module": "wires"},
+///    {"op": "start", "module": "wires"},
+///    {"op": "set", "attribute": "status", "value": "armed"}]
+///
+/// The "op" of a module is one of the ModuleCommand names ("start", "suspend",
+/// "resume", "reset" or "stop"), "set" updates an attribute with a string,
+/// number or boolean value. The whole batch is parsed and checked before any
+/// of it is applied, so a malformed request changes nothing.
+///
+/// The classes are NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_COMMAND_BATCH_H
+#define NET_COMMAND_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "modules/module_command.h"
+#include "utils/sw/json_parser.h"
+
+namespace PTS
+{
+
+/// A remote command.
+struct RemoteCommand
+{
+  /// The size of the name of the target (including the terminating zero).
+  static constexpr size_t TARGET_SIZE = 32;
+  /// The size of a text value (including the terminating zero).
+  static constexpr size_t TEXT_SIZE = 48;
+
+  /// What the command does.
+  enum class Kind : uint8_t
+  {
+    NONE,
+    MODULE, // Posts a ModuleCommand to the target module.
+    SET,    // Sets the target attribute.
+  };
+
+  /// The type of the value of a SET.
+  enum class Value : uint8_t
+  {
+    NONE,
+    TEXT,
+    NUMBER,
+    BOOL,
+  };
+
+  Kind kind;
+  ModuleCommand command;
+  Value value;
+  bool flag;
+  /// Whether the number is an integer (and fits 32 bits, signed or not).
+  bool integral;
+  double number;
+  char target[TARGET_SIZE];
+  char text[TEXT_SIZE];
+};
+
+/// A batch of remote commands.
+struct CommandBatch
+{
+  /// The maximum number of commands of a batch.
+  static constexpr size_t MAX_COMMANDS = 16;
+
+  RemoteCommand commands[MAX_COMMANDS];
+  size_t command_count;
+
+  [[nodiscard]] const RemoteCommand *begin() const { return commands; }
+  [[nodiscard]] const RemoteCommand *end() const
+  {
+    return commands + command_count;
+  }
+};
+
+/// CommandBatchParser class, filling a CommandBatch from a request body.
+class CommandBatchParser
+{
+  /// The JSON parser, the longest token is a text value.
+  using Parser = JsonParser<CommandBatchParser, RemoteCommand::TEXT_SIZE, 2>;
+  friend Parser;
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param batch the batch to be filled, it is cleared.
+  explicit CommandBatchParser(CommandBatch &batch)
+  : m_batch(batch),
+    m_parser(*this),
+    m_depth(0),
+    m_field(Field::NONE),
+    m_command(nullptr),
+    m_has_attribute(false),
+    m_error(nullptr)
+  { std::memset(&m_batch, 0, sizeof(m_batch)); }
+
+  /// Parses a whole batch.
+  /// \return the reason of the failure, nullptr if the batch is valid.
+  static const char *parse(const char *text, size_t length,
+                           CommandBatch &batch)
+  {
+    CommandBatchParser parser(batch);
+    parser.feed(text, length);
+    parser.finish();
+    return parser.error();
+  }
+
+//===-- Parsing functions -------------------------------------------------===//
+
+  /// Parses the next chunk of the batch.
+  /// \return false, if the parsing failed, true otherwise.
+  bool feed(const char *data, size_t length)
+  {
+    if (m_error) return false;
+    if (!m_parser.feed(data, length)) parseFailed();
+    return !m_error;
+  }
+
+  /// Ends the batch.
+  /// \return false, if the parsing failed, true otherwise.
+  bool finish()
+  {
+    if (m_error) return false;
+    if (!m_parser.finish()) parseFailed();
+    else if (m_batch.command_count == 0) m_error = "no commands";
+    return !m_error;
+  }
+
+  /// \return the reason of the failure, nullptr if there was none.
+  [[nodiscard]] const char *error() const { return m_error; }
+
+  /// \return the offset in the body the parsing stopped at.
+  [[nodiscard]] size_t offset() const { return m_parser.offset(); }
+
+//===-- JSON events -------------------------------------------------------===//
+
+ private:
+  /// The keys of a command.
+  enum class Field : uint8_t
+  {
+    NONE,
+    OP,
+    MODULE,
+    ATTRIBUTE,
+    VALUE,
+  };
+
+  /// The nesting depth of the command list and the command objects.
+  static constexpr size_t LIST_DEPTH = 1;
+  static constexpr size_t COMMAND_DEPTH = 2;
+
+  bool beginArray()
+  {
+    if (m_depth != 0) return reject("unexpected array");
+
+    m_depth++;
+    return true;
+  }
+
+  bool endArray()
+  {
+    m_depth--;
+    return true;
+  }
+
+  bool beginObject()
+  {
+    if (m_depth != LIST_DEPTH) return reject("expected a list of commands");
+    if (m_batch.command_count == CommandBatch::MAX_COMMANDS)
+      return reject("too many commands");
+
+    m_command = &m_batch.commands[m_batch.command_count++];
+    m_depth++;
+    return true;
+  }
+
+  bool endObject()
+  {
+    m_depth--;
+    m_field = Field::NONE;
+
+    switch (m_command->kind)
+    {
+      case RemoteCommand::Kind::NONE: return reject("command without op");
+      case RemoteCommand::Kind::MODULE:
+        if (m_command->target[0] == '\0' || m_has_attribute)
+          return reject("module command without module");
+        break;
+      case RemoteCommand::Kind::SET:
+        if (m_command->target[0] == '\0' || !m_has_attribute)
+          return reject("set without attribute");
+        if (m_command->value == RemoteCommand::Value::NONE)
+          return reject("set without value");
+        break;
+    }
+    m_has_attribute = false;
+    return true;
+  }
+
+  bool key(const char *name, size_t)
+  {
+    static constexpr struct
+    {
+      const char *name;
+      Field field;
+    } KEYS[] = {
+      {"op", Field::OP}, {"module", Field::MODULE},
+      {"attribute", Field::ATTRIBUTE}, {"value", Field::VALUE}};
+
+    m_field = Field::NONE;
+    for (const auto &command_key : KEYS)
+      if (std::strcmp(name, command_key.name) == 0) m_field = command_key.field;
+    return m_field != Field::NONE || reject("unknown key");
+  }
+
+  bool string(const char *text, size_t length)
+  {
+    if (m_depth != COMMAND_DEPTH) return reject("unexpected string");
+
+    switch (m_field)
+    {
+      case Field::OP:
+        if (std::strcmp(text, "set") == 0)
+          m_command->kind = RemoteCommand::Kind::SET;
+        else if (COMMAND::parse(text, m_command->command))
+          m_command->kind = RemoteCommand::Kind::MODULE;
+        else
+          return reject("unknown op");
+        return true;
+      case Field::MODULE:
+        return copyName(text, length);
+      case Field::ATTRIBUTE:
+        m_has_attribute = true;
+        return copyName(text, length);
+      case Field::VALUE:
+        m_command->value = RemoteCommand::Value::TEXT;
+        return copyText(m_command->text, RemoteCommand::TEXT_SIZE, text,
+                        length);
+      default: return reject("unexpected string");
+    }
+  }
+
+  bool number(const char *text, size_t)
+  {
+    if (m_depth != COMMAND_DEPTH || m_field != Field::VALUE)
+      return reject("unexpected number");
+
+    m_command->value = RemoteCommand::Value::NUMBER;
+    m_command->number = std::strtod(text, nullptr);
+    m_command->integral =
+      std::strpbrk(text, ".eE") == nullptr &&
+      m_command->number >= INT32_MIN && m_command->number <= UINT32_MAX;
+    return true;
+  }
+
+  bool boolean(bool flag)
+  {
+    if (m_depth != COMMAND_DEPTH || m_field != Field::VALUE)
+      return reject("unexpected boolean");
+
+    m_command->value = RemoteCommand::Value::BOOL;
+    m_command->flag = flag;
+    return true;
+  }
+
+  bool null() { return reject("unexpected null"); }
+
+//===-- Internals ---------------------------------------------------------===//
+
+  bool copyText(char *out, size_t size, const char *text, size_t length)
+  {
+    if (length >= size) return reject("text too long");
+
+    std::memcpy(out, text, length + 1);
+    return true;
+  }
+
+  /// Copies the name of the target. Names are printable, so the results
+  /// that echo them stay small (see WebServer::MAX_COMMAND_RESULTS).
+  bool copyName(const char *text, size_t length)
+  {
+    for (size_t idx = 0; idx != length; idx++)
+      if (static_cast<unsigned char>(text[idx]) < 0x20)
+        return reject("invalid name");
+
+    return copyText(m_command->target, RemoteCommand::TARGET_SIZE, text,
+                    length);
+  }
+
+  /// Stops the parsing with a reason.
+  /// \return false, to be returned to the parser.
+  bool reject(const char *reason)
+  {
+    m_error = reason;
+    return false;
+  }
+
+  /// Sets the reason of a failure reported by the parser.
+  void parseFailed()
+  {
+    if (m_error) return; // Rejected by a handler function.
+
+    switch (m_parser.error())
+    {
+      case Parser::Error::TOO_DEEP: m_error = "nested too deep"; break;
+      case Parser::Error::TOO_LONG: m_error = "text too long"; break;
+      case Parser::Error::INCOMPLETE: m_error = "incomplete JSON"; break;
+      default: m_error = "invalid JSON"; break;
+    }
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  CommandBatch &m_batch;
+  Parser m_parser;
+  size_t m_depth;
+  Field m_field;
+  RemoteCommand *m_command;
+  /// Whether the current command names an attribute (not a module).
+  bool m_has_attribute;
+  const char *m_error;
+}; // class CommandBatchParser
+
+} // namespace PTS
+
+#endif // NET_COMMAND_BATCH_H
@@ -0,0 +1,616 @@
+//===-- net/http_request.h - HTTP request parser definitions --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the HttpRequest class, which
+/// is a view of a parsed HTTP/1.x request, and the RequestParser class, which
+/// is an incremental parser filling it from a fixed size buffer.
+///
+/// The parser can be fed any fragmentation of the request, it never allocates.
+/// It keeps the method, the path, the query, the body and a preset selection
+/// of headers (see HttpHeader), every other header is skipped unstored.
+/// While parsing, the FNV-1a hash of the path is computed, so that routing
+/// doesn't need another pass over it.
+///
+/// The classes are NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_HTTP_REQUEST_H
+#define NET_HTTP_REQUEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "utils/sw/hash.h"
+
+namespace PTS
+{
+
+/// Request methods known by the parser.
+enum class HttpMethod : uint8_t
+{
+  GET,
+  HEAD,
+  POST,
+  PUT,
+  DELETE,
+  OPTIONS,
+  OTHER,
+};
+
+/// Request headers stored by the parser.
+enum class HttpHeader : uint8_t
+{
+  HOST,
+  CONNECTION,
+  CONTENT_LENGTH,
+  CONTENT_TYPE,
+  IF_NONE_MATCH,
+  ACCEPT_ENCODING,
+  LAST_EVENT_ID,
+  COUNT, // Number of stored headers, not a header.
+};
+
+/// HttpRequest class
+class HttpRequest
+{
+  template<size_t> friend class RequestParser;
+
+ public:
+  explicit HttpRequest() { clear(); }
+
+//===-- Accessors ---------------------------------------------------------===//
+
+  /// \return the method of the request.
+  [[nodiscard]] HttpMethod method() const { return m_method; }
+
+  /// \return the path of the request target (without the query).
+  [[nodiscard]] const char *path() const { return m_path; }
+
+  /// \return the FNV-1a hash of the path.
+  [[nodiscard]] uint32_t pathHash() const { return m_path_hash; }
+
+  /// \return the query of the request target (without '?', maybe empty).
+  [[nodiscard]] const char *query() const { return m_query; }
+
+  /// \return the minor version of the HTTP/1.x request.
+  [[nodiscard]] uint8_t minorVersion() const { return m_minor_version; }
+
+  /// \param header the header to return.
+  /// \return the value of the header, nullptr if it wasn't sent.
+  [[nodiscard]] const char *header(HttpHeader header) const
+  {
+    return m_headers[static_cast<size_t>(header)];
+  }
+
+  /// \return the body of the request (nullptr if there is none).
+  [[nodiscard]] const char *body() const { return m_body; }
+
+  /// \return the length of the body.
+  [[nodiscard]] size_t bodyLength() const { return m_body_length; }
+
+  /// \return true, if the connection should be kept open after the response.
+  [[nodiscard]] bool keepAlive() const
+  {
+    const char *connection = header(HttpHeader::CONNECTION);
+    if (m_minor_version == 0)
+      return connection && containsToken(connection, "keep-alive");
+    return !connection || !containsToken(connection, "close");
+  }
+
+  /// Finds and decodes a parameter of the query.
+  /// \param name the name of the parameter.
+  /// \param out the buffer receiving the zero terminated, decoded value.
+  /// \param out_size the size of the buffer.
+  /// \return false, if the parameter is missing or too long, true otherwise.
+  bool queryParam(const char *name, char *out, size_t out_size) const
+  {
+    const size_t name_length = std::strlen(name);
+    const char *param = m_query;
+    while (*param)
+    {
+      const char *end = param;
+      while (*end && *end != '&') end++;
+
+      if (std::strncmp(param, name, name_length) == 0 &&
+          (param[name_length] == '=' || param + name_length == end))
+      {
+        const char *value = param + name_length;
+        if (*value == '=') value++;
+        return decode(value, end, out, out_size);
+      }
+      param = *end ? end + 1 : end;
+    }
+    return false;
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// Resets every field.
+  void clear()
+  {
+    m_method = HttpMethod::OTHER;
+    m_minor_version = 1;
+    m_path = "";
+    m_path_hash = fnv1a("", 0);
+    m_query = "";
+    for (auto &header : m_headers) header = nullptr;
+    m_body = nullptr;
+    m_body_length = 0;
+  }
+
+  /// \return true, if the comma separated list contains the token.
+  static bool containsToken(const char *list, const char *token)
+  {
+    const size_t token_length = std::strlen(token);
+    while (*list)
+    {
+      while (*list == ' ' || *list == ',') list++;
+      size_t idx = 0;
+      while (idx != token_length && list[idx] &&
+             (list[idx] | 0x20) == token[idx])
+        idx++;
+      if (idx == token_length &&
+          (!list[idx] || list[idx] == ',' || list[idx] == ' '))
+        return true;
+      while (*list && *list != ',') list++;
+    }
+    return false;
+  }
+
+  /// Percent-decodes [begin, end) into out.
+  static bool decode(const char *begin, const char *end,
+                     char *out, size_t out_size)
+  {
+    size_t length = 0;
+    for (; begin != end; begin++)
+    {
+      if (length + 1 >= out_size) return false;
+
+      char character = *begin;
+      if (character == '+')
+      {
+        character = ' ';
+      }
+      else if (character == '%' && end - begin > 2 &&
+               hexValue(begin[1]) >= 0 && hexValue(begin[2]) >= 0)
+      {
+        character = static_cast<char>(hexValue(begin[1]) << 4 |
+                                      hexValue(begin[2]));
+        begin += 2;
+      }
+      out[length++] = character;
+    }
+    out[length] = '\0';
+    return true;
+  }
+
+  /// \return the value of a hexadecimal digit, -1 if it isn't one.
+  static int hexValue(char digit)
+  {
+    if (digit >= '0' && digit <= '9') return digit - '0';
+    if (digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'F') return digit - 'A' + 10;
+    return -1;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  HttpMethod m_method;
+  uint8_t m_minor_version;
+  const char *m_path;
+  uint32_t m_path_hash;
+  const char *m_query;
+  const char *m_headers[static_cast<size_t>(HttpHeader::COUNT)];
+  const char *m_body;
+  size_t m_body_length;
+}; // class HttpRequest
+
+/// RequestParser class
+/// \tparam BUFFER_SIZE the space for the path, query, headers and body.
+template<size_t BUFFER_SIZE = 1024>
+class RequestParser
+{
+  /// Lowercase names of the stored headers, in the order of HttpHeader.
+  static constexpr const char *HEADER_NAMES[] = {
+    "host",
+    "connection",
+    "content-length",
+    "content-type",
+    "if-none-match",
+    "accept-encoding",
+    "last-event-id",
+  };
+  static_assert(sizeof(HEADER_NAMES) / sizeof(HEADER_NAMES[0]) ==
+                static_cast<size_t>(HttpHeader::COUNT),
+                "Every stored header needs a name.");
+
+  /// The maximum length of a method or header name token.
+  static constexpr size_t TOKEN_SIZE = 32;
+  /// The maximum number of bytes of the request line and all headers.
+  static constexpr size_t MAX_HEAD_SIZE = 8 * 1024;
+
+  /// Enumerated values storing where the parser is inside the request.
+  enum Stage : uint8_t
+  {
+    METHOD,
+    PATH,
+    QUERY,
+    VERSION,
+    LINE_END,
+    HEADER_START,
+    HEADER_NAME,
+    HEADER_SPACE,
+    HEADER_VALUE,
+    HEADER_END,
+    HEAD_END,
+    BODY,
+    DONE,
+  };
+
+ public:
+  /// Enumerated values storing the result of feeding data to the parser.
+  enum Status : uint8_t
+  {
+    INCOMPLETE,  // More data is needed.
+    COMPLETE,    // The request is complete, see request().
+    BAD_REQUEST, // The request is malformed.
+    TOO_LARGE,   // The request doesn't fit into the buffer.
+  };
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit RequestParser() { reset(); }
+
+  /// Deleted copy ctor and assignment operator - the request points inside.
+  RequestParser(const RequestParser&) = delete;
+  RequestParser& operator=(const RequestParser&) = delete;
+
+  /// Prepares the parser for a new request.
+  void reset()
+  {
+    m_request.clear();
+    m_stage = METHOD;
+    m_status = INCOMPLETE;
+    m_length = 0;
+    m_head_size = 0;
+    m_token_length = 0;
+    m_stored_header = HttpHeader::COUNT;
+    m_value_start = 0;
+    m_body_remaining = 0;
+    m_path_hash = fnv1a("", 0);
+  }
+
+//===-- Parsing functions -------------------------------------------------===//
+
+  /// Feeds request data to the parser. Parsing stops at the end of the
+  /// request, so the bytes of a pipelined next request are not consumed.
+  /// \param data the next bytes of the request.
+  /// \param length the number of bytes.
+  /// \param consumed if not nullptr, receives the number of bytes used.
+  /// \return the status of the parsing.
+  Status feed(const char *data, size_t length, size_t *consumed = nullptr)
+  {
+    size_t idx = 0;
+    for (; idx != length && m_status == INCOMPLETE; idx++)
+    {
+      if (m_stage == BODY)
+      {
+        // Copy the body in one go.
+        const size_t part = length - idx < m_body_remaining
+                          ? length - idx : m_body_remaining;
+        std::memcpy(m_buffer + m_length, data + idx, part);
+        m_length += part;
+        m_body_remaining -= part;
+        idx += part - 1;
+        if (m_body_remaining == 0) finish();
+        continue;
+      }
+
+      if (++m_head_size > MAX_HEAD_SIZE)
+        m_status = TOO_LARGE;
+      else
+        parse(data[idx]);
+    }
+
+    if (consumed) *consumed = idx;
+    return m_status;
+  }
+
+  /// \return the status of the parsing.
+  [[nodiscard]] Status status() const { return m_status; }
+
+  /// \return the parsed request (only complete if the status is COMPLETE).
+  [[nodiscard]] const HttpRequest &request() const { return m_request; }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// Advances the state machine with a single character of the head.
+  void parse(char character)
+  {
+    switch (m_stage)
+    {
+      case METHOD:
+        if (character == ' ')
+        {
+          m_request.m_method = methodOf(m_token, m_token_length);
+          m_token_length = 0;
+          m_stage = PATH;
+        }
+        else if (!appendToken(character, false))
+        {
+          m_status = BAD_REQUEST;
+        }
+        break;
+
+      case PATH:
+        if (m_length == 0 && character != '/')
+        {
+          m_status = BAD_REQUEST;
+        }
+        else if (character == ' ' || character == '?')
+        {
+          terminate(m_request.m_path, 0);
+          m_request.m_path_hash = m_path_hash;
+          m_value_start = m_length;
+          if (character == ' ') m_stage = VERSION;
+          else m_stage = QUERY;
+        }
+        else if (store(character))
+        {
+          m_path_hash = (m_path_hash ^ static_cast<uint8_t>(character)) *
+                        16777619u;
+        }
+        break;
+
+      case QUERY:
+        if (character == ' ')
+        {
+          terminate(m_request.m_query, m_value_start);
+          m_stage = VERSION;
+        }
+        else
+        {
+          store(character);
+        }
+        break;
+
+      case VERSION:
+        if (character == '\r' || character == '\n')
+        {
+          if (m_token_length != 8 ||
+              std::strncmp(m_token, "HTTP/1.", 7) != 0 ||
+              m_token[7] < '0' || m_token[7] > '9')
+          {
+            m_status = BAD_REQUEST;
+            break;
+          }
+          m_request.m_minor_version = m_token[7] - '0';
+          m_token_length = 0;
+          m_stage = character == '\r' ? LINE_END : HEADER_START;
+        }
+        else if (!appendToken(character, false))
+        {
+          m_status = BAD_REQUEST;
+        }
+        break;
+
+      case LINE_END:
+      case HEADER_END:
+        if (character != '\n') m_status = BAD_REQUEST;
+        else m_stage = HEADER_START;
+        break;
+
+      case HEADER_START:
+        m_token_length = 0;
+        if (character == '\r')
+        {
+          m_stage = HEAD_END;
+          break;
+        }
+        if (character == '\n')
+        {
+          endHead();
+          break;
+        }
+        m_stage = HEADER_NAME;
+        [[fallthrough]];
+
+      case HEADER_NAME:
+        if (character == ':')
+        {
+          m_stored_header = headerOf(m_token, m_token_length);
+          m_value_start = m_length;
+          m_stage = HEADER_SPACE;
+        }
+        else if (character == '\r' || character == '\n')
+        {
+          m_status = BAD_REQUEST;
+        }
+        else
+        {
+          // Overlong names can't be stored headers, the token just saturates.
+          appendToken(character, true);
+        }
+        break;
+
+      case HEADER_SPACE:
+        if (character == ' ' || character == '\t') break;
+        m_stage = HEADER_VALUE;
+        [[fallthrough]];
+
+      case HEADER_VALUE:
+        if (character == '\r' || character == '\n')
+        {
+          if (m_stored_header != HttpHeader::COUNT)
+          {
+            // Trim the trailing whitespace.
+            while (m_length != m_value_start &&
+                   (m_buffer[m_length - 1] == ' ' ||
+                    m_buffer[m_length - 1] == '\t'))
+              m_length--;
+            terminate(m_request.m_headers[
+                        static_cast<size_t>(m_stored_header)],
+                      m_value_start);
+          }
+          m_stage = character == '\r' ? HEADER_END : HEADER_START;
+        }
+        else if (m_stored_header != HttpHeader::COUNT)
+        {
+          store(character);
+        }
+        break;
+
+      case HEAD_END:
+        if (character != '\n') m_status = BAD_REQUEST;
+        else endHead();
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  /// Called after the empty line ending the head.
+  void endHead()
+  {
+    const char *content_length = m_request.header(HttpHeader::CONTENT_LENGTH);
+    size_t body_length = 0;
+    if (content_length)
+    {
+      for (const char *digit = content_length; *digit; digit++)
+      {
+        if (*digit < '0' || *digit > '9' || body_length > BUFFER_SIZE)
+        {
+          m_status = *digit < '0' || *digit > '9' ? BAD_REQUEST : TOO_LARGE;
+          return;
+        }
+        body_length = body_length * 10 + (*digit - '0');
+      }
+    }
+
+    if (body_length == 0)
+    {
+      finish();
+    }
+    else if (body_length > BUFFER_SIZE - m_length)
+    {
+      m_status = TOO_LARGE;
+    }
+    else
+    {
+      m_request.m_body = m_buffer + m_length;
+      m_request.m_body_length = body_length;
+      m_body_remaining = body_length;
+      m_stage = BODY;
+    }
+  }
+
+  /// Marks the request as complete.
+  void finish()
+  {
+    m_stage = DONE;
+    m_status = COMPLETE;
+  }
+
+  /// Appends a character to the token, optionally lowercased.
+  /// \return false, if the token is full, true otherwise.
+  bool appendToken(char character, bool lowercase)
+  {
+    if (m_token_length == TOKEN_SIZE) return false;
+    if (lowercase && character >= 'A' && character <= 'Z')
+      character += 'a' - 'A';
+    m_token[m_token_length++] = character;
+    return true;
+  }
+
+  /// Stores a character in the buffer.
+  /// \return false, if the buffer is full (the status is set), true otherwise.
+  bool store(char character)
+  {
+    // Keep a byte for the terminating zero.
+    if (m_length + 1 >= BUFFER_SIZE)
+    {
+      m_status = TOO_LARGE;
+      return false;
+    }
+    m_buffer[m_length++] = character;
+    return true;
+  }
+
+  /// Zero terminates the stored field starting at start and points to it.
+  void terminate(const char *&field, size_t start)
+  {
+    if (m_length == BUFFER_SIZE)
+    {
+      m_status = TOO_LARGE;
+      return;
+    }
+    m_buffer[m_length++] = '\0';
+    field = m_buffer + start;
+  }
+
+  /// \return the method named by the token.
+  static HttpMethod methodOf(const char *token, size_t length)
+  {
+    static constexpr struct
+    {
+      const char *name;
+      HttpMethod method;
+    } METHODS[] = {
+      {"GET", HttpMethod::GET},
+      {"HEAD", HttpMethod::HEAD},
+      {"POST", HttpMethod::POST},
+      {"PUT", HttpMethod::PUT},
+      {"DELETE", HttpMethod::DELETE},
+      {"OPTIONS", HttpMethod::OPTIONS},
+    };
+    for (const auto &entry : METHODS)
+    {
+      if (std::strlen(entry.name) == length &&
+          std::strncmp(entry.name, token, length) == 0)
+        return entry.method;
+    }
+    return HttpMethod::OTHER;
+  }
+
+  /// \return the stored header named by the token, COUNT if not stored.
+  static HttpHeader headerOf(const char *token, size_t length)
+  {
+    for (size_t idx = 0; idx != static_cast<size_t>(HttpHeader::COUNT); idx++)
+    {
+      if (std::strlen(HEADER_NAMES[idx]) == length &&
+          std::strncmp(HEADER_NAMES[idx], token, length) == 0)
+        return static_cast<HttpHeader>(idx);
+    }
+    return HttpHeader::COUNT;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  HttpRequest m_request;
+  Stage m_stage;
+  Status m_status;
+  size_t m_length;
+  size_t m_head_size;
+  size_t m_token_length;
+  HttpHeader m_stored_header;
+  size_t m_value_start;
+  size_t m_body_remaining;
+  uint32_t m_path_hash;
+  char m_token[TOKEN_SIZE];
+  char m_buffer[BUFFER_SIZE];
+}; // class RequestParser
+
+} // namespace PTS
+
+#endif // NET_HTTP_REQUEST_H
@@ -0,0 +1,465 @@
+//===-- net/http_response.h - ResponseWriter class definition -------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ResponseWriter class, which
+/// assembles HTTP responses in a reusable fixed size buffer.
+///
+/// Headers and body are collected in memory and sent with as few writes as
+/// possible, each at most one TCP segment (MSS) long. If the whole body fits
+/// into the buffer, it is sent with a Content-Length header, otherwise the
+/// response switches to chunked transfer encoding, sending a chunk every time
+/// the buffer fills up. Large constant fragments (e.g. from flash) bypass the
+/// buffer and are written directly, as do constant bodies of known length
+/// (e.g. static files), which keep the Content-Length framing.
+///
+/// A chunked body can be suspended and resumed later, with other responses
+/// written in between, so large bodies are produced as the connection takes
+/// them instead of all at once.
+///
+/// The CLIENT type only needs a write(const uint8_t*, size_t) function, so the
+/// class can be used with any Arduino Client as well as on the host.
+///
+/// The class is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_HTTP_RESPONSE_H
+#define NET_HTTP_RESPONSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace PTS
+{
+
+/// ResponseWriter class
+/// \tparam CLIENT the type of the connection written to.
+/// \tparam BUFFER_SIZE the size of the body buffer in bytes.
+/// \tparam MSS the maximum size of a single write (lwIP default TCP_MSS).
+/// \tparam HEADER_SIZE the maximum size of the status line and headers.
+template<typename CLIENT,
+         size_t BUFFER_SIZE = 2048,
+         size_t MSS = 1436,
+         size_t HEADER_SIZE = 256>
+class ResponseWriter
+{
+  /// Space for the final header lines and a chunk size line.
+  static constexpr size_t FRAMING_SIZE = 64;
+  /// Space reserved in front of the body for the headers and chunk framing.
+  static constexpr size_t PREFIX_SIZE = HEADER_SIZE + FRAMING_SIZE;
+  /// Space reserved after the body for the chunk terminators ("\r\n0\r\n\r\n").
+  static constexpr size_t SUFFIX_SIZE = 7;
+
+ public:
+  /// The size of the body buffer, larger bodies are sent in chunks of it.
+  static constexpr size_t BODY_BUFFER_SIZE = BUFFER_SIZE;
+  /// The most the headers and the framing add to a buffered body.
+  static constexpr size_t MAX_OVERHEAD = PREFIX_SIZE + SUFFIX_SIZE;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit ResponseWriter()
+  : m_client(nullptr),
+    m_header_length(0),
+    m_body_length(0),
+    m_headers_sent(false),
+    m_chunked(true),
+    m_closes(false),
+    m_keep_alive(true),
+    m_failed(false),
+    m_write_count(0),
+    m_headers{0},
+    m_buffer{0}
+  { }
+
+  /// Deleted copy ctor and assignment operator - the buffer is large.
+  ResponseWriter(const ResponseWriter&) = delete;
+  ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+//===-- Header functions --------------------------------------------------===//
+
+  /// Starts a new response, discarding any unfinished previous one.
+  /// \param client the connection to write the response to.
+  /// \param status the status code and reason (e.g. "200 OK").
+  /// \param content_type the value of the Content-Type header (or nullptr).
+  /// \param chunked false, if the client can't handle chunked bodies (the
+  /// connection is then closed to mark the end of large bodies).
+  void begin(CLIENT &client,
+             const char *status,
+             const char *content_type = "text/html; charset=utf-8",
+             bool chunked = true)
+  {
+    m_client = &client;
+    m_header_length = 0;
+    m_body_length = 0;
+    m_headers_sent = false;
+    m_chunked = chunked;
+    m_closes = false;
+    m_failed = false;
+    m_write_count = 0;
+
+    appendHeaderText("HTTP/1.1 ");
+    appendHeaderText(status);
+    appendHeaderText("\r\n");
+    if (content_type) header("Content-Type", content_type);
+    if (!m_keep_alive) header("Connection", "close");
+  }
+
+  /// Sets whether the connection is kept open after the next responses,
+  /// the ones started while it is false announce that it will be closed.
+  /// \param keep_alive false, if the connection is closed after responses.
+  void setKeepAlive(bool keep_alive) { m_keep_alive = keep_alive; }
+
+  /// Adds a header line. Must be called before any body data is written.
+  /// \param name the name of the header.
+  /// \param value the value of the header.
+  void header(const char *name, const char *value)
+  {
+    appendHeaderText(name);
+    appendHeaderText(": ");
+    appendHeaderText(value);
+    appendHeaderText("\r\n");
+  }
+
+//===-- Body functions ----------------------------------------------------===//
+
+  /// Appends raw bytes to the body.
+  /// \param data the bytes to append.
+  /// \param length the number of bytes to append.
+  void write(const char *data, size_t length)
+  {
+    while (length != 0)
+    {
+      if (m_body_length == BUFFER_SIZE) sendChunk();
+
+      const size_t space = BUFFER_SIZE - m_body_length;
+      const size_t part = length < space ? length : space;
+      std::memcpy(body() + m_body_length, data, part);
+      m_body_length += part;
+      data += part;
+      length -= part;
+    }
+  }
+
+  /// Appends a constant fragment to the body. Fragments larger than the free
+  /// space of the buffer are written directly, without being copied.
+  /// \param data the fragment (can be stored in flash).
+  /// \param length the length of the fragment.
+  void writeStatic(const char *data, size_t length)
+  {
+    if (length <= BUFFER_SIZE - m_body_length)
+    {
+      write(data, length);
+      return;
+    }
+
+    // Send what is buffered, then frame the fragment as its own chunk.
+    sendChunk();
+    if (m_chunked)
+    {
+      char size_line[16];
+      const size_t size_length = formatChunkSize(size_line, length);
+      send(size_line, size_length);
+      send(data, length);
+      send("\r\n", 2);
+    }
+    else
+    {
+      send(data, length);
+    }
+  }
+
+  /// Appends a zero terminated string to the body.
+  void print(const char *text) { write(text, std::strlen(text)); }
+
+  /// Appends the decimal representation of a number to the body.
+  void print(uint32_t number)
+  {
+    char digits[10];
+    size_t length = 0;
+    do
+    {
+      digits[sizeof(digits) - ++length] = '0' + number % 10;
+      number /= 10;
+    } while (number != 0);
+    write(digits + sizeof(digits) - length, length);
+  }
+
+  /// Appends a string to the body, escaping the HTML special characters.
+  void printEscaped(const char *text)
+  {
+    const char *run = text;
+    for (; *text; text++)
+    {
+      const char *entity = nullptr;
+      switch (*text)
+      {
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '&': entity = "&amp;"; break;
+        case '"': entity = "&quot;"; break;
+        default: continue;
+      }
+      write(run, text - run);
+      print(entity);
+      run = text + 1;
+    }
+    write(run, text - run);
+  }
+
+  /// Finishes the response, sending everything still buffered.
+  /// \return false, if any write to the client failed, true otherwise.
+  bool end()
+  {
+    if (!m_headers_sent)
+    {
+      // The whole body is buffered, so its length is known.
+      sendWithLength(m_body_length);
+    }
+    else if (m_chunked)
+    {
+      // Send the rest of the body as a last chunk, then the terminating one.
+      char size_line[16];
+      size_t size_length = 0;
+      size_t length = m_body_length;
+      if (m_body_length != 0)
+      {
+        size_length = formatChunkSize(size_line, m_body_length);
+        std::memcpy(body() + length, "\r\n", 2);
+        length += 2;
+      }
+      std::memcpy(body() + length, "0\r\n\r\n", 5);
+      sendFramed(size_line, size_length, length + 5);
+    }
+    else
+    {
+      sendFramed("", 0, m_body_length);
+    }
+
+    m_body_length = 0;
+    m_client = nullptr;
+    return !m_failed;
+  }
+
+  /// Finishes the response with a constant body of known length, which is
+  /// sent straight from where it is stored (e.g. flash), without being
+  /// copied into the buffer.
+  /// \param data the body (must be the only one, nothing written before).
+  /// \param length the length of the body.
+  /// \return false, if any write to the client failed, true otherwise.
+  bool end(const uint8_t *data, size_t length)
+  {
+    const char *body_data = reinterpret_cast<const char*>(data);
+    if (m_headers_sent || m_body_length != 0)
+    {
+      writeStatic(body_data, length);
+      return end();
+    }
+
+    sendWithLength(length);
+    send(body_data, length);
+
+    m_client = nullptr;
+    return !m_failed;
+  }
+
+  /// Finishes the headers of a body of known length, which the caller sends
+  /// on its own (e.g. BufferedClient::writeConstant()).
+  /// \param length the length of the body (nothing written before).
+  /// \return false, if any write to the client failed, true otherwise.
+  bool endHeaders(size_t length)
+  {
+    sendWithLength(length);
+    m_client = nullptr;
+    return !m_failed;
+  }
+
+  /// Sends what is buffered of a chunked body and lets go of the client, so
+  /// other responses can be written until the body is continued with
+  /// resume().
+  /// \return false, if any write to the client failed, true otherwise.
+  bool suspend()
+  {
+    sendChunk();
+    m_client = nullptr;
+    return !m_failed;
+  }
+
+  /// Continues the chunked body of a suspended response (see suspend()).
+  /// \param client the connection of the suspended response.
+  void resume(CLIENT &client)
+  {
+    m_client = &client;
+    m_body_length = 0;
+    m_headers_sent = true;
+    m_chunked = true;
+    m_failed = false;
+  }
+
+//===-- Statistics --------------------------------------------------------===//
+
+  /// \return true, if the current (or last) response ends by closing the
+  /// connection (keep-alive is off, or the body outgrew the buffer without
+  /// chunked encoding).
+  [[nodiscard]] bool closesConnection() const
+  {
+    return m_closes || !m_keep_alive;
+  }
+
+  /// \return the number of writes issued for the current (or last) response.
+  [[nodiscard]] size_t writeCount() const { return m_write_count; }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// \return the start of the body inside the buffer.
+  char *body() { return m_buffer + PREFIX_SIZE; }
+
+  /// Appends text to the header block, dropping what doesn't fit.
+  void appendHeaderText(const char *text)
+  {
+    while (*text && m_header_length != HEADER_SIZE)
+      m_headers[m_header_length++] = *text++;
+  }
+
+  /// Sends the headers with a Content-Length header, and the buffered body.
+  void sendWithLength(size_t length)
+  {
+    char length_header[32] = "Content-Length: ";
+    const size_t offset = std::strlen(length_header);
+    const size_t digits = formatDecimal(length_header + offset, length);
+    std::memcpy(length_header + offset + digits, "\r\n\r\n", 4);
+    sendBuffered(length_header, offset + digits + 4, "", 0);
+  }
+
+  /// Sends the buffered body as a chunk, together with the headers if they
+  /// haven't been sent yet.
+  void sendChunk()
+  {
+    if (!m_headers_sent)
+    {
+      const char *framing = m_chunked ? "Transfer-Encoding: chunked\r\n\r\n"
+                          : m_keep_alive ? "Connection: close\r\n\r\n"
+                                         : "\r\n";
+      m_closes = m_keep_alive && !m_chunked;
+      char size_line[16];
+      const size_t size_length = m_chunked && m_body_length
+        ? formatChunkSize(size_line, m_body_length) : 0;
+      sendBuffered(framing, std::strlen(framing), size_line, size_length);
+    }
+    else if (m_body_length != 0)
+    {
+      char size_line[16];
+      size_t size_length = 0;
+      size_t length = m_body_length;
+      if (m_chunked)
+      {
+        size_length = formatChunkSize(size_line, m_body_length);
+        std::memcpy(body() + length, "\r\n", 2);
+        length += 2;
+      }
+      sendFramed(size_line, size_length, length);
+    }
+    m_body_length = 0;
+  }
+
+  /// Sends the headers, a closing header block, an optional chunk size line
+  /// and the buffered body in one contiguous run.
+  void sendBuffered(const char *closing, size_t closing_length,
+                    const char *size_line, size_t size_length)
+  {
+    const bool framed = size_length != 0;
+    if (framed) std::memcpy(body() + m_body_length, "\r\n", 2);
+
+    // Move the headers right in front of the (framed) body.
+    char *start = body() - size_length - closing_length - m_header_length;
+    std::memcpy(start, m_headers, m_header_length);
+    std::memcpy(start + m_header_length, closing, closing_length);
+    std::memcpy(body() - size_length, size_line, size_length);
+
+    m_headers_sent = true;
+    send(start, body() + m_body_length + (framed ? 2 : 0) - start);
+  }
+
+  /// Sends a chunk size line and the given number of bytes from the body.
+  void sendFramed(const char *size_line, size_t size_length, size_t length)
+  {
+    std::memcpy(body() - size_length, size_line, size_length);
+    send(body() - size_length, size_length + length);
+  }
+
+  /// Writes to the client in MSS sized pieces.
+  void send(const char *data, size_t length)
+  {
+    while (length != 0 && !m_failed)
+    {
+      const size_t part = length < MSS ? length : MSS;
+      const size_t written =
+        m_client->write(reinterpret_cast<const uint8_t*>(data), part);
+      m_write_count++;
+      if (written == 0) m_failed = true;
+      data += written;
+      length -= written;
+    }
+  }
+
+  /// Formats a number in decimal.
+  /// \return the number of characters written.
+  static size_t formatDecimal(char *out, size_t number)
+  {
+    char digits[20];
+    size_t length = 0;
+    do
+    {
+      digits[length++] = '0' + number % 10;
+      number /= 10;
+    } while (number != 0);
+    for (size_t idx = 0; idx != length; idx++)
+      out[idx] = digits[length - 1 - idx];
+    return length;
+  }
+
+  /// Formats a chunk size line ("<hex length>\r\n").
+  /// \return the number of characters written.
+  static size_t formatChunkSize(char *out, size_t length)
+  {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    char digits[16];
+    size_t count = 0;
+    do
+    {
+      digits[count++] = HEX_DIGITS[length & 0xF];
+      length >>= 4;
+    } while (length != 0);
+    for (size_t idx = 0; idx != count; idx++)
+      out[idx] = digits[count - 1 - idx];
+    out[count] = '\r';
+    out[count + 1] = '\n';
+    return count + 2;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  CLIENT *m_client;
+  size_t m_header_length;
+  size_t m_body_length;
+  bool m_headers_sent;
+  bool m_chunked;
+  bool m_closes;
+  bool m_keep_alive;
+  bool m_failed;
+  size_t m_write_count;
+  char m_headers[HEADER_SIZE];
+  char m_buffer[PREFIX_SIZE + BUFFER_SIZE + SUFFIX_SIZE];
+}; // class ResponseWriter
+
+} // namespace PTS
+
+#endif // NET_HTTP_RESPONSE_H
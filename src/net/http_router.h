@@ -0,0 +1,142 @@
+//===-- net/http_router.h - Router class definition -----------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the Router class, which maps
+/// request methods and paths to handler callbacks.
+///
+/// Routes are stored in a fixed size table. Exact paths are matched by their
+/// FNV-1a hash first (which the RequestParser computes while parsing), so the
+/// cost of dispatching doesn't grow with the length of the registered paths.
+/// Paths ending with '*' match every path starting with the rest of them.
+///
+/// Callbacks are function pointers with template argument types, like the
+/// callbacks of the Button class. Routes should be registered before the
+/// router is used, registering is NOT threadsafe.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_HTTP_ROUTER_H
+#define NET_HTTP_ROUTER_H
+
+#include <cstring>
+#include "net/http_request.h"
+
+namespace PTS
+{
+
+/// Router class
+/// \tparam MAX_ROUTES the maximum number of registered routes.
+/// \tparam ARG_TYPES (variadic) additional argument types of the callbacks.
+template<size_t MAX_ROUTES, typename... ARG_TYPES>
+class Router
+{
+ public:
+  /// Used to easily maintain the callback type within the class.
+  using CALLBACK_TYPE = void(*)(const HttpRequest&, ARG_TYPES...);
+
+  /// Enumerated values storing the result of a dispatch.
+  enum Result : uint8_t
+  {
+    HANDLED,            // A callback has been called.
+    NOT_FOUND,          // No route has the path.
+    METHOD_NOT_ALLOWED, // Routes have the path, but not with the method.
+  };
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit Router() : m_route_count(0), m_routes() { }
+
+  /// Registers a route.
+  /// \param method the method of the route.
+  /// \param path the path of the route (must outlive the router), a trailing
+  /// '*' makes it match every path with the same beginning.
+  /// \param callback the callback to be called for the matching requests.
+  /// \return false, if the routing table is full, true otherwise.
+  bool on(HttpMethod method, const char *path, CALLBACK_TYPE callback)
+  {
+    if (m_route_count == MAX_ROUTES) return false;
+
+    const size_t length = std::strlen(path);
+    const bool prefix = length != 0 && path[length - 1] == '*';
+    m_routes[m_route_count++] = Route{
+      method,
+      prefix,
+      path,
+      prefix ? length - 1 : length,
+      fnv1a(path, length),
+      callback
+    };
+    return true;
+  }
+
+//===-- Dispatching functions ---------------------------------------------===//
+
+  /// Calls the callback of the route matching the request.
+  /// \param request the parsed request.
+  /// \param args the additional arguments passed to the callback.
+  /// \return the result of the dispatch.
+  Result dispatch(const HttpRequest &request, ARG_TYPES... args) const
+  {
+    bool path_found = false;
+
+    // Exact routes, compared by hash (and confirmed by string on a match).
+    for (size_t idx = 0; idx != m_route_count; idx++)
+    {
+      const Route &route = m_routes[idx];
+      if (route.prefix || route.hash != request.pathHash() ||
+          std::strcmp(route.path, request.path()) != 0)
+        continue;
+
+      if (route.method == request.method())
+      {
+        route.callback(request, args...);
+        return HANDLED;
+      }
+      path_found = true;
+    }
+
+    // Prefix routes, in the order of registration.
+    for (size_t idx = 0; idx != m_route_count; idx++)
+    {
+      const Route &route = m_routes[idx];
+      if (!route.prefix ||
+          std::strncmp(route.path, request.path(), route.length) != 0)
+        continue;
+
+      if (route.method == request.method())
+      {
+        route.callback(request, args...);
+        return HANDLED;
+      }
+      path_found = true;
+    }
+
+    return path_found ? METHOD_NOT_ALLOWED : NOT_FOUND;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  /// A single entry of the routing table.
+  struct Route
+  {
+    HttpMethod method;
+    bool prefix;
+    const char *path;
+    size_t length;
+    uint32_t hash;
+    CALLBACK_TYPE callback;
+  };
+
+  size_t m_route_count;
+  Route m_routes[MAX_ROUTES];
+}; // class Router
+
+} // namespace PTS
+
+#endif // NET_HTTP_ROUTER_H
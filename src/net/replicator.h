@@ -0,0 +1,726 @@
+//===-- net/replicator.h - Replicator class definition --------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the Replicator class, which
+/// keeps selected typed values (integers, floats, bools, Stateful states and
+/// countdowns) the same on several boards of a game, over UDP.
+///
+/// The replicator holds the values itself and is bound to no attribute or
+/// module: the game copies them to and from its modules (e.g. a module's
+/// state after a change, or a countdown into its CountdownModule), and
+/// publishes them as attributes of its own if it wants, as the only writer of
+/// those attributes. The firmware in main.cpp doesn't start a replicator, as
+/// a game spanning several boards gives every board its own node id.
+///
+/// Every board registers the values it shares by name, in any order, and
+/// values only some of the boards know are ignored by the rest. Any board may
+/// write a value: every write is stamped with a Lamport clock and the id of
+/// the writing board, and the newest write wins everywhere. Countdowns are
+/// sent as their remaining time, and are kept on the local clock of every
+/// board, so the boards need no shared time.
+///
+/// Every board numbers its own writes (its stream version), and its packets
+/// only hold the writes the live peers haven't acknowledged yet: the delta
+/// from the lowest version acknowledged. The packets carry the
+/// acknowledgements of the peers' streams in return, and a new data packet is
+/// acknowledged on the next tick. A lost packet is covered by the next one
+/// (sent again after RESEND_MS if nothing new is written), and a keep-alive is
+/// sent every KEEP_ALIVE_MS. A new or restarted peer gets the whole state:
+/// every board sends it every value written so far, by whichever board, as
+/// the writer may be gone. The packets carry the Lamport clock of the sender
+/// too, so a restarted board stamps its writes after the ones it missed.
+///
+/// The packets are broadcast to the port of the replicator by default, or
+/// sent to the destinations given to addDestination() (several boards can
+/// run on one host that way). Every packet is little-endian:
+///   header: "PTSR", protocol version (u8), node (u8), entry count (u8),
+///           acknowledgement count (u8), session (u32), base version (u32),
+///           stream version (u32), Lamport clock (u32)
+///   acknowledgements: node (u8), version (u32) - the peer's stream version
+///           received completely
+///   entries: key (u32, FNV-1a of the name), clock (u32), writer (u8),
+///           type (u8), flags (u8, bit 0: running countdown), value (u32)
+///
+/// Values are registered before the thread is started, they are read and
+/// written from any task.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_REPLICATOR_H
+#define NET_REPLICATOR_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <WiFi.h>
+#include "modules/module_base.h"
+#include "modules/stateful_base.h"
+#include "utils/sw/hash.h"
+#include "utils/sw/log.h"
+
+namespace PTS
+{
+
+/// The types of the replicated values.
+enum class ReplicaType : uint8_t
+{
+  INTEGER,   // Signed 32 bit integer.
+  FLOAT,     // Float.
+  BOOL,      // Bool.
+  STATE,     // Stateful::State.
+  COUNTDOWN, // Remaining milliseconds, running or stopped.
+};
+
+/// ReplicaHandle class, a reference to a replicated value.
+class ReplicaHandle
+{
+  template<size_t, size_t> friend class Replicator;
+
+ public:
+  /// Constructs an invalid handle.
+  constexpr ReplicaHandle() : m_index(INVALID) { }
+
+  /// \return true, if the handle refers to a registered value.
+  explicit operator bool() const { return m_index != INVALID; }
+
+ private:
+  static constexpr uint8_t INVALID = 0xff;
+
+  explicit constexpr ReplicaHandle(uint8_t index) : m_index(index) { }
+
+  uint8_t m_index;
+};
+
+/// The traffic and the timing of a replicator.
+struct ReplicationStats
+{
+  uint32_t packets_sent;
+  uint32_t bytes_sent;
+  uint32_t packets_received;
+  uint32_t bytes_received;
+  /// The bytes sent and received in the last whole second.
+  uint32_t sent_bytes_per_s;
+  uint32_t received_bytes_per_s;
+  /// The values sent again, as a peer hadn't acknowledged them.
+  uint32_t resent_values;
+  /// The number of live peers.
+  uint8_t peers;
+  /// The time from a local write to its acknowledgement by every live peer,
+  /// of the last acknowledged write and the slowest one.
+  uint32_t convergence_ms;
+  uint32_t max_convergence_ms;
+  /// The number of acknowledged writes.
+  uint32_t converged_writes;
+};
+
+/// Replicator class
+/// \tparam MAX_VALUES the maximum number of replicated values.
+/// \tparam MAX_PEERS the maximum number of other boards.
+template<size_t MAX_VALUES = 16, size_t MAX_PEERS = 7>
+class Replicator : public Module<4*1024, tskIDLE_PRIORITY, 50>
+{
+  static_assert(MAX_VALUES < ReplicaHandle::INVALID && MAX_PEERS < 256,
+                "The counts are sent as bytes.");
+
+  /// The version of the packet format.
+  static constexpr uint8_t PROTOCOL_VERSION = 2;
+  /// The time after which a silent peer is no longer waited for.
+  static constexpr uint32_t PEER_TIMEOUT_MS = 3000;
+  /// The time after which unacknowledged writes are sent again.
+  static constexpr uint32_t RESEND_MS = 150;
+  /// The longest time between two packets.
+  static constexpr uint32_t KEEP_ALIVE_MS = 500;
+  /// The most packets handled per tick.
+  static constexpr size_t MAX_PACKETS_PER_TICK = 16;
+
+  static constexpr size_t HEADER_SIZE = 24;
+  static constexpr size_t ACK_SIZE = 5;
+  static constexpr size_t ENTRY_SIZE = 15;
+  static constexpr size_t PACKET_SIZE =
+    HEADER_SIZE + MAX_PEERS * ACK_SIZE + MAX_VALUES * ENTRY_SIZE;
+  static_assert(PACKET_SIZE <= 1400, "A packet must fit a single datagram.");
+
+  /// A replicated value.
+  struct Entry
+  {
+    uint32_t key;
+    ReplicaType type;
+    /// The raw bits, for countdowns the remaining milliseconds if stopped and
+    /// the local deadline if running.
+    uint32_t value;
+    bool running;
+    /// The Lamport clock and the writer of the last write.
+    uint32_t clock;
+    uint8_t writer;
+    /// The stream version the value was last sent in, 0 if it was only
+    /// received.
+    uint32_t version;
+    /// Whether the last local write is not acknowledged by every peer yet.
+    bool converging;
+    uint32_t written_ms;
+  };
+
+  /// Another board.
+  struct Peer
+  {
+    bool active;
+    uint8_t node;
+    uint32_t session;
+    uint32_t heard_ms;
+    /// The version of its stream received completely.
+    uint32_t received;
+    /// The version of our stream it has received completely.
+    uint32_t acknowledged;
+  };
+
+  /// An address the packets are sent to.
+  struct Destination
+  {
+    IPAddress ip;
+    uint16_t port;
+  };
+
+ public:
+  /// The default port of the replication.
+  static constexpr uint16_t DEFAULT_PORT = 4210;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param node the id of the board, unique within the game.
+  /// \param port the UDP port of the replication.
+  explicit Replicator(uint8_t node, uint16_t port = DEFAULT_PORT)
+    : Module("replicator"),
+      c_node(node),
+      c_port(port),
+      m_lock(),
+      m_entries(),
+      m_entry_count(0),
+      m_peers(),
+      m_destinations(),
+      m_destination_count(0),
+      m_session(0),
+      m_clock(0),
+      m_version(0),
+      m_sent_version(0),
+      m_sent_ms(0),
+      m_ack_due(false),
+      m_stats(),
+      m_window_ms(0),
+      m_window_sent(0),
+      m_window_received(0),
+      m_udp(),
+      m_packet()
+  { }
+
+  /// Registers a replicated value, before the thread is started.
+  /// \param name the name of the value, the same on every board.
+  /// \param type the type of the value.
+  /// \param initial the raw initial value, it isn't sent (any write wins
+  /// over it).
+  /// \return the handle of the value, invalid if there are MAX_VALUES.
+  ReplicaHandle add(const char *name, ReplicaType type, uint32_t initial = 0)
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (m_entry_count == MAX_VALUES) return ReplicaHandle();
+
+    Entry &entry = m_entries[m_entry_count];
+    entry = Entry();
+    entry.key = fnv1a(name, std::strlen(name));
+    entry.type = type;
+    entry.value = initial;
+    return ReplicaHandle(static_cast<uint8_t>(m_entry_count++));
+  }
+
+  /// Adds an address to send the packets to (instead of the broadcast), before
+  /// the thread is started.
+  /// \return false, if there are MAX_PEERS destinations already.
+  bool addDestination(IPAddress ip, uint16_t port)
+  {
+    if (m_destination_count == MAX_PEERS) return false;
+
+    m_destinations[m_destination_count++] = Destination{ip, port};
+    return true;
+  }
+
+  /// Opens the socket.
+  void begin() const override
+  {
+    m_session = esp_random();
+    m_window_ms = static_cast<uint32_t>(millis());
+    if (!m_udp.begin(c_port))
+      LOG::E("Replicator can't listen on port %.", c_port);
+    else
+      LOG::I("Replicator node % listening on port %.", c_node, c_port);
+  }
+
+//===-- Value functions ---------------------------------------------------===//
+
+  /// Writes a value (see the typed functions below).
+  /// \param handle the handle returned by add().
+  /// \param type the type of the value (must match the registered one).
+  /// \param raw the raw bits of the value.
+  /// \return false, if the handle is invalid or of another type, true
+  /// otherwise.
+  bool set(ReplicaHandle handle, ReplicaType type, uint32_t raw) const
+  {
+    return write(handle, type, raw, false);
+  }
+
+  /// \return the raw bits of a value, 0 for an invalid handle.
+  [[nodiscard]] uint32_t get(ReplicaHandle handle) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return valid(handle) ? m_entries[handle.m_index].value : 0;
+  }
+
+  bool setInteger(ReplicaHandle handle, int32_t value) const
+  {
+    return set(handle, ReplicaType::INTEGER, static_cast<uint32_t>(value));
+  }
+
+  [[nodiscard]] int32_t getInteger(ReplicaHandle handle) const
+  {
+    return static_cast<int32_t>(get(handle));
+  }
+
+  bool setFloat(ReplicaHandle handle, float value) const
+  {
+    uint32_t raw;
+    std::memcpy(&raw, &value, sizeof(raw));
+    return set(handle, ReplicaType::FLOAT, raw);
+  }
+
+  [[nodiscard]] float getFloat(ReplicaHandle handle) const
+  {
+    const uint32_t raw = get(handle);
+    float value;
+    std::memcpy(&value, &raw, sizeof(value));
+    return value;
+  }
+
+  bool setBool(ReplicaHandle handle, bool value) const
+  {
+    return set(handle, ReplicaType::BOOL, value);
+  }
+
+  [[nodiscard]] bool getBool(ReplicaHandle handle) const
+  {
+    return get(handle) != 0;
+  }
+
+  bool setState(ReplicaHandle handle, Stateful::State state) const
+  {
+    return set(handle, ReplicaType::STATE, state);
+  }
+
+  [[nodiscard]] Stateful::State getState(ReplicaHandle handle) const
+  {
+    return static_cast<Stateful::State>(get(handle) & 0b11);
+  }
+
+  /// Sets a countdown.
+  /// \param handle the handle of a COUNTDOWN value.
+  /// \param remaining_ms the remaining time.
+  /// \param running whether the countdown is running.
+  /// \return false, if the handle is invalid or of another type, true
+  /// otherwise.
+  bool setCountdown(ReplicaHandle handle,
+                    uint32_t remaining_ms,
+                    bool running) const
+  {
+    const uint32_t now = static_cast<uint32_t>(millis());
+    return write(handle, ReplicaType::COUNTDOWN,
+                 running ? now + remaining_ms : remaining_ms, running);
+  }
+
+  /// \return the remaining time of a countdown, 0 for an invalid handle.
+  [[nodiscard]] uint32_t remaining(ReplicaHandle handle) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!valid(handle)) return 0;
+
+    return remainingOf(m_entries[handle.m_index],
+                       static_cast<uint32_t>(millis()));
+  }
+
+  /// \return true, if a countdown is running (also if it has run out).
+  [[nodiscard]] bool countdownRunning(ReplicaHandle handle) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return valid(handle) && m_entries[handle.m_index].running;
+  }
+
+  /// \return the traffic and the timing of the replication.
+  [[nodiscard]] ReplicationStats stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_stats;
+  }
+
+//===-- Threading specific functions --------------------------------------===//
+
+ private:
+  void threadFunc() const override
+  {
+    const uint32_t now = static_cast<uint32_t>(millis());
+    receive(now);
+    send(now);
+    measure(now);
+  }
+
+  /// Handles the received packets.
+  void receive(uint32_t now) const
+  {
+    for (size_t idx = 0; idx != MAX_PACKETS_PER_TICK; idx++)
+    {
+      const int size = m_udp.parsePacket();
+      if (size <= 0) break;
+
+      // Longer datagrams are truncated, and dropped.
+      if (m_udp.read(m_packet, sizeof(m_packet)) == size)
+        handlePacket(static_cast<size_t>(size), now);
+    }
+  }
+
+  /// Applies a received packet in m_packet.
+  void handlePacket(size_t length, uint32_t now) const
+  {
+    const uint8_t *packet = m_packet;
+    if (length < HEADER_SIZE || std::memcmp(packet, "PTSR", 4) != 0 ||
+        packet[4] != PROTOCOL_VERSION || packet[5] == c_node)
+      return;
+
+    const uint8_t node = packet[5];
+    const size_t entry_count = packet[6];
+    const size_t ack_count = packet[7];
+    const uint32_t session = unpack(packet + 8);
+    const uint32_t base = unpack(packet + 12);
+    const uint32_t version = unpack(packet + 16);
+    const uint32_t clock = unpack(packet + 20);
+    if (length != HEADER_SIZE + ack_count * ACK_SIZE + entry_count * ENTRY_SIZE)
+      return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.packets_received++;
+    m_stats.bytes_received += length;
+    m_window_received += length;
+    // Local writes from here on are newer than every write the sender knows.
+    if (clock > m_clock) m_clock = clock;
+
+    Peer *peer = findPeer(node, now);
+    if (!peer) return;
+    if (peer->session != session)
+    {
+      // A new peer, or a restarted one: it starts from scratch, and gets
+      // every value written so far (whoever wrote it) as new versions of the
+      // stream.
+      peer->session = session;
+      peer->received = 0;
+      peer->acknowledged = 0;
+      for (size_t idx = 0; idx != m_entry_count; idx++)
+        if (m_entries[idx].clock != 0) m_entries[idx].version = ++m_version;
+    }
+    peer->heard_ms = now;
+
+    const uint8_t *ack = packet + HEADER_SIZE;
+    uint32_t acknowledged = 0;
+    for (size_t idx = 0; idx != ack_count; idx++, ack += ACK_SIZE)
+      if (ack[0] == c_node) acknowledged = unpack(ack + 1);
+    // Acknowledgements of an earlier session of ours are void.
+    peer->acknowledged = acknowledged <= m_version ? acknowledged : 0;
+
+    const uint8_t *record = ack;
+    for (size_t idx = 0; idx != entry_count; idx++, record += ENTRY_SIZE)
+      applyRecord(record, now);
+
+    // The stream is complete up to the version if nothing before the base
+    // was missed.
+    if (base <= peer->received && version > peer->received)
+    {
+      peer->received = version;
+      m_ack_due = true;
+    }
+  }
+
+  /// Applies a received value, if it is newer than the local one.
+  void applyRecord(const uint8_t *record, uint32_t now) const
+  {
+    const uint32_t key = unpack(record);
+    const uint32_t clock = unpack(record + 4);
+    const uint8_t writer = record[8];
+    const auto type = static_cast<ReplicaType>(record[9]);
+    const bool running = record[10] & 1;
+    const uint32_t value = unpack(record + 11);
+
+    for (size_t idx = 0; idx != m_entry_count; idx++)
+    {
+      Entry &entry = m_entries[idx];
+      if (entry.key != key || entry.type != type) continue;
+
+      if (clock < entry.clock ||
+          (clock == entry.clock && writer <= entry.writer))
+        return;
+
+      entry.value = running ? now + value : value;
+      entry.running = running;
+      entry.clock = clock;
+      entry.writer = writer;
+      entry.version = 0;
+      entry.converging = false;
+      return;
+    }
+  }
+
+  /// Sends the unacknowledged writes, the acknowledgements and the
+  /// keep-alives, when they are due.
+  void send(uint32_t now) const
+  {
+    size_t length;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      uint32_t base = m_version;
+      uint8_t peers = 0;
+      for (Peer &peer : m_peers)
+      {
+        if (!peer.active) continue;
+        if (now - peer.heard_ms >= PEER_TIMEOUT_MS)
+        {
+          peer.active = false;
+          LOG::W("Replication peer % lost.", peer.node);
+          continue;
+        }
+        peers++;
+        if (peer.acknowledged < base) base = peer.acknowledged;
+      }
+      m_stats.peers = peers;
+      if (peers == 0) base = 0; // Everything, for whoever starts listening.
+
+      const bool unsent = m_version > m_sent_version;
+      const bool unacknowledged =
+        peers != 0 && m_version > base && now - m_sent_ms >= RESEND_MS;
+      if (!unsent && !unacknowledged && !m_ack_due &&
+          now - m_sent_ms < KEEP_ALIVE_MS)
+        return;
+
+      length = writePacket(base, now);
+      m_ack_due = false;
+      m_sent_version = m_version;
+      m_sent_ms = now;
+    }
+
+    if (m_destination_count == 0)
+    {
+      sendPacket(IPAddress(255, 255, 255, 255), c_port, length);
+    }
+    else
+    {
+      for (size_t idx = 0; idx != m_destination_count; idx++)
+        sendPacket(m_destinations[idx].ip, m_destinations[idx].port, length);
+    }
+  }
+
+  /// Writes a packet with the writes after a version into m_packet.
+  /// \return the length of the packet.
+  size_t writePacket(uint32_t base, uint32_t now) const
+  {
+    uint8_t *out = m_packet + HEADER_SIZE;
+
+    uint8_t ack_count = 0;
+    for (const Peer &peer : m_peers)
+    {
+      if (!peer.active) continue;
+      out[0] = peer.node;
+      pack(out + 1, peer.received);
+      out += ACK_SIZE;
+      ack_count++;
+    }
+
+    uint8_t entry_count = 0;
+    for (size_t idx = 0; idx != m_entry_count; idx++)
+    {
+      const Entry &entry = m_entries[idx];
+      if (entry.version <= base) continue;
+
+      if (entry.version <= m_sent_version) m_stats.resent_values++;
+      pack(out, entry.key);
+      pack(out + 4, entry.clock);
+      out[8] = entry.writer;
+      out[9] = static_cast<uint8_t>(entry.type);
+      out[10] = entry.running ? 1 : 0;
+      pack(out + 11, entry.running ? remainingOf(entry, now) : entry.value);
+      out += ENTRY_SIZE;
+      entry_count++;
+    }
+
+    std::memcpy(m_packet, "PTSR", 4);
+    m_packet[4] = PROTOCOL_VERSION;
+    m_packet[5] = c_node;
+    m_packet[6] = entry_count;
+    m_packet[7] = ack_count;
+    pack(m_packet + 8, m_session);
+    pack(m_packet + 12, base);
+    pack(m_packet + 16, m_version);
+    pack(m_packet + 20, m_clock);
+    return static_cast<size_t>(out - m_packet);
+  }
+
+  void sendPacket(IPAddress ip, uint16_t port, size_t length) const
+  {
+    if (!m_udp.beginPacket(ip, port)) return;
+    m_udp.write(m_packet, length);
+    if (!m_udp.endPacket()) return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.packets_sent++;
+    m_stats.bytes_sent += length;
+    m_window_sent += length;
+  }
+
+  /// Records the converged writes, and the traffic of every second.
+  void measure(uint32_t now) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (m_stats.peers != 0)
+    {
+      uint32_t acknowledged = m_version;
+      for (const Peer &peer : m_peers)
+        if (peer.active && peer.acknowledged < acknowledged)
+          acknowledged = peer.acknowledged;
+
+      for (size_t idx = 0; idx != m_entry_count; idx++)
+      {
+        Entry &entry = m_entries[idx];
+        if (!entry.converging || entry.version > acknowledged) continue;
+
+        entry.converging = false;
+        m_stats.convergence_ms = now - entry.written_ms;
+        if (m_stats.convergence_ms > m_stats.max_convergence_ms)
+          m_stats.max_convergence_ms = m_stats.convergence_ms;
+        m_stats.converged_writes++;
+      }
+    }
+
+    const uint32_t window = now - m_window_ms;
+    if (window >= 1000)
+    {
+      m_stats.sent_bytes_per_s = m_window_sent * 1000 / window;
+      m_stats.received_bytes_per_s = m_window_received * 1000 / window;
+      m_window_ms = now;
+      m_window_sent = 0;
+      m_window_received = 0;
+    }
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+  /// Writes a value locally, as a new version of the stream.
+  bool write(ReplicaHandle handle,
+             ReplicaType type,
+             uint32_t value,
+             bool running) const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!valid(handle)) return false;
+
+    Entry &entry = m_entries[handle.m_index];
+    if (entry.type != type) return false;
+    if (entry.value == value && entry.running == running) return true;
+
+    entry.value = value;
+    entry.running = running;
+    entry.clock = ++m_clock;
+    entry.writer = c_node;
+    entry.version = ++m_version;
+    entry.converging = true;
+    entry.written_ms = static_cast<uint32_t>(millis());
+    return true;
+  }
+
+  bool valid(ReplicaHandle handle) const
+  {
+    return handle && handle.m_index < m_entry_count;
+  }
+
+  /// \return the remaining time of a countdown entry.
+  static uint32_t remainingOf(const Entry &entry, uint32_t now)
+  {
+    if (!entry.running) return entry.value;
+
+    const int32_t remaining = static_cast<int32_t>(entry.value - now);
+    return remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+  }
+
+  /// \return the peer with the id, taking a free slot for a new one
+  /// (nullptr if there is none).
+  Peer *findPeer(uint8_t node, uint32_t now) const
+  {
+    Peer *free = nullptr;
+    for (Peer &peer : m_peers)
+    {
+      if (peer.node == node && (peer.active || peer.session != 0))
+      {
+        if (!peer.active) LOG::I("Replication peer % back.", node);
+        peer.active = true;
+        return &peer;
+      }
+      if (!peer.active && !free) free = &peer;
+    }
+    if (!free) return nullptr;
+
+    LOG::I("Replication peer % joined.", node);
+    *free = Peer{true, node, 0, now, 0, 0};
+    return free;
+  }
+
+  static void pack(uint8_t *out, uint32_t value)
+  {
+    for (size_t idx = 0; idx != 4; idx++) out[idx] = value >> (8 * idx);
+  }
+
+  static uint32_t unpack(const uint8_t *in)
+  {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 |
+           static_cast<uint32_t>(in[3]) << 24;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  const uint8_t c_node;
+  const uint16_t c_port;
+  /// Guards the values, the peers and the statistics.
+  mutable std::mutex m_lock;
+  mutable std::array<Entry, MAX_VALUES> m_entries;
+  size_t m_entry_count;
+  mutable std::array<Peer, MAX_PEERS> m_peers;
+  std::array<Destination, MAX_PEERS> m_destinations;
+  size_t m_destination_count;
+  /// The random id of this run, telling the peers about restarts.
+  mutable uint32_t m_session;
+  /// The Lamport clock of the writes.
+  mutable uint32_t m_clock;
+  /// The stream version, the number of local writes.
+  mutable uint32_t m_version;
+  /// The stream version at the last packet sent.
+  mutable uint32_t m_sent_version;
+  mutable uint32_t m_sent_ms;
+  /// Whether a peer's stream advanced since the last packet sent.
+  mutable bool m_ack_due;
+  mutable ReplicationStats m_stats;
+  mutable uint32_t m_window_ms;
+  mutable uint32_t m_window_sent;
+  mutable uint32_t m_window_received;
+  mutable WiFiUDP m_udp;
+  mutable uint8_t m_packet[PACKET_SIZE];
+}; // class Replicator
+
+} // namespace PTS
+
+#endif // NET_REPLICATOR_H
@@ -0,0 +1,394 @@
+//===-- net/scoreboard_codec.h - Scoreboard feed packet coding ------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ScoreboardEncoder and
+/// ScoreboardView classes, the two ends of the scoreboard feed (see
+/// scoreboard_feed.h): the board encodes the attributes into datagrams, and
+/// every viewer decodes them into its own copy.
+///
+/// The feed is a series of frames, each of one or more datagrams. A keyframe
+/// holds every attribute with its name, a delta frame only the attributes
+/// modified since the previous frame, identified by the FNV-1a hash of their
+/// names. Every datagram is little-endian:
+///   header: "PTSS", format version (u8), flags (u8, see SCOREBOARD::Flags),
+///           sequence (u16, increased by every datagram), base version (u32,
+///           the version of the previous frame, 0 for keyframes), version
+///           (u32, the AttributeStore version of the frame)
+///   records: hash (u32), in keyframes the name length (u8) and the name, the
+///           value length (u8) and the value
+///
+/// Nothing is acknowledged. A viewer noticing a gap in the sequence keeps
+/// applying the values it receives, and is in sync again with the next
+/// complete keyframe, which also drops the deleted attributes.
+///
+/// Both classes are free of platform dependencies, so host tools decode the
+/// feed with the code of the firmware. They are NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_SCOREBOARD_CODEC_H
+#define NET_SCOREBOARD_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "utils/sw/hash.h"
+
+namespace PTS
+{
+
+namespace SCOREBOARD
+{
+
+/// The version of the packet format.
+inline constexpr uint8_t FORMAT_VERSION = 1;
+/// The size of the header of a datagram.
+inline constexpr size_t HEADER_SIZE = 16;
+/// The maximum size of a datagram, it must not be fragmented.
+inline constexpr size_t PACKET_SIZE = 1400;
+/// The longest name or value sent, longer ones are truncated.
+inline constexpr size_t MAX_TEXT_LENGTH = 255;
+
+/// The flags of a datagram.
+enum Flags : uint8_t
+{
+  KEYFRAME = 1, // Part of a keyframe.
+  FIRST = 2,    // The first datagram of its frame.
+  LAST = 4,     // The last datagram of its frame.
+};
+
+} // namespace SCOREBOARD
+
+/// ScoreboardEncoder class, splitting frames into datagrams.
+/// \tparam SINK a callable taking a const uint8_t* and a size_t, sending a
+/// datagram.
+template<typename SINK>
+class ScoreboardEncoder
+{
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param sink the sender of the datagrams.
+  explicit ScoreboardEncoder(SINK sink)
+  : m_sink(sink),
+    m_packet(),
+    m_length(0),
+    m_flags(0),
+    m_sequence(0)
+  { }
+
+//===-- Encoding functions ------------------------------------------------===//
+
+  /// Starts a frame.
+  /// \param keyframe whether the frame holds every attribute.
+  /// \param base the version of the previous frame (ignored for keyframes).
+  /// \param version the version of the frame.
+  void beginFrame(bool keyframe, uint32_t base, uint32_t version)
+  {
+    m_flags = SCOREBOARD::FIRST | (keyframe ? SCOREBOARD::KEYFRAME : 0);
+    std::memcpy(m_packet, "PTSS", 4);
+    m_packet[4] = SCOREBOARD::FORMAT_VERSION;
+    pack(m_packet + 8, keyframe ? 0 : base);
+    pack(m_packet + 12, version);
+    m_length = SCOREBOARD::HEADER_SIZE;
+  }
+
+  /// Adds an attribute to the frame, sending the datagram if it is full.
+  /// \param name the name of the attribute.
+  /// \param value the value of the attribute.
+  void add(const char *name, const char *value)
+  {
+    const size_t name_length = textLength(name);
+    const size_t value_length = textLength(value);
+    const bool keyframe = m_flags & SCOREBOARD::KEYFRAME;
+    const size_t size =
+      4 + (keyframe ? 1 + name_length : 0) + 1 + value_length;
+    if (m_length + size > SCOREBOARD::PACKET_SIZE) flush(false);
+
+    uint8_t *out = m_packet + m_length;
+    pack(out, fnv1a(name, std::strlen(name)));
+    out += 4;
+    if (keyframe) out = writeText(out, name, name_length);
+    writeText(out, value, value_length);
+    m_length += size;
+  }
+
+  /// Ends the frame, sending its last datagram.
+  void endFrame() { flush(true); }
+
+ private:
+//===-- Internals ---------------------------------------------------------===//
+
+  /// Sends the datagram, the next one continues the frame.
+  void flush(bool last)
+  {
+    m_packet[5] = m_flags | (last ? SCOREBOARD::LAST : 0);
+    m_packet[6] = static_cast<uint8_t>(m_sequence);
+    m_packet[7] = static_cast<uint8_t>(m_sequence >> 8);
+    m_sequence++;
+    m_sink(static_cast<const uint8_t*>(m_packet), m_length);
+
+    m_flags &= ~SCOREBOARD::FIRST;
+    m_length = SCOREBOARD::HEADER_SIZE;
+  }
+
+  static size_t textLength(const char *text)
+  {
+    const size_t length = std::strlen(text);
+    return length < SCOREBOARD::MAX_TEXT_LENGTH ? length
+                                                : SCOREBOARD::MAX_TEXT_LENGTH;
+  }
+
+  static uint8_t *writeText(uint8_t *out, const char *text, size_t length)
+  {
+    *out = static_cast<uint8_t>(length);
+    std::memcpy(out + 1, text, length);
+    return out + 1 + length;
+  }
+
+  static void pack(uint8_t *out, uint32_t value)
+  {
+    for (size_t idx = 0; idx != 4; idx++) out[idx] = value >> (8 * idx);
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  SINK m_sink;
+  uint8_t m_packet[SCOREBOARD::PACKET_SIZE];
+  size_t m_length;
+  /// The flags of the current datagram, without LAST.
+  uint8_t m_flags;
+  uint16_t m_sequence;
+}; // class ScoreboardEncoder
+
+/// ScoreboardView class, a viewer's copy of the attributes of a feed.
+/// \tparam MAX_ATTRIBUTES the maximum number of attributes.
+/// \tparam NAME_SIZE the size of a name (including the terminating zero).
+/// \tparam VALUE_SIZE the size of a value (including the terminating zero).
+template<size_t MAX_ATTRIBUTES = 32,
+         size_t NAME_SIZE = 32,
+         size_t VALUE_SIZE = 48>
+class ScoreboardView
+{
+ public:
+  /// An attribute of the feed.
+  struct Attribute
+  {
+    uint32_t hash;
+    char name[NAME_SIZE];
+    char value[VALUE_SIZE];
+    /// Whether it was in the keyframe being received.
+    bool seen;
+  };
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit ScoreboardView()
+  : m_attributes(),
+    m_count(0),
+    m_version(0),
+    m_sequence(0),
+    m_started(false),
+    m_synced(false),
+    m_in_keyframe(false),
+    m_packets(0),
+    m_lost(0)
+  { }
+
+//===-- Decoding functions ------------------------------------------------===//
+
+  /// Applies a datagram of the feed.
+  /// \return false, if it isn't a valid datagram (it is ignored then), true
+  /// otherwise.
+  bool receive(const uint8_t *packet, size_t length)
+  {
+    if (length < SCOREBOARD::HEADER_SIZE ||
+        std::memcmp(packet, "PTSS", 4) != 0 ||
+        packet[4] != SCOREBOARD::FORMAT_VERSION ||
+        !recordsValid(packet, length))
+      return false;
+
+    const uint8_t flags = packet[5];
+    const uint16_t sequence = static_cast<uint16_t>(packet[6] | packet[7] << 8);
+    const uint32_t base = unpack(packet + 8);
+    const uint32_t version = unpack(packet + 12);
+    const bool keyframe = flags & SCOREBOARD::KEYFRAME;
+    m_packets++;
+
+    // After a gap the frame in progress is incomplete.
+    if (m_started && sequence != static_cast<uint16_t>(m_sequence + 1))
+    {
+      m_lost += static_cast<uint16_t>(sequence - m_sequence - 1);
+      m_synced = false;
+      m_in_keyframe = false;
+    }
+    m_started = true;
+    m_sequence = sequence;
+
+    if (keyframe && (flags & SCOREBOARD::FIRST))
+    {
+      m_in_keyframe = true;
+      for (size_t idx = 0; idx != m_count; idx++)
+        m_attributes[idx].seen = false;
+    }
+
+    const uint8_t *in = packet + SCOREBOARD::HEADER_SIZE;
+    while (in != packet + length)
+    {
+      const uint32_t hash = unpack(in);
+      in += 4;
+      const char *name = nullptr;
+      size_t name_length = 0;
+      if (keyframe)
+      {
+        name_length = *in;
+        name = reinterpret_cast<const char*>(in + 1);
+        in += 1 + name_length;
+      }
+      const size_t value_length = *in;
+      apply(hash, name, name_length, reinterpret_cast<const char*>(in + 1),
+            value_length);
+      in += 1 + value_length;
+    }
+
+    if (flags & SCOREBOARD::LAST)
+    {
+      if (keyframe && m_in_keyframe)
+      {
+        removeUnseen();
+        m_synced = true;
+        m_version = version;
+      }
+      else if (!keyframe && m_synced)
+      {
+        if (base == m_version) m_version = version;
+        else m_synced = false;
+      }
+      m_in_keyframe = false;
+    }
+    return true;
+  }
+
+//===-- Access functions --------------------------------------------------===//
+
+  /// \return true, if the copy is complete at version().
+  [[nodiscard]] bool synced() const { return m_synced; }
+
+  /// \return the version of the last complete frame.
+  [[nodiscard]] uint32_t version() const { return m_version; }
+
+  /// \return the number of valid datagrams received.
+  [[nodiscard]] uint32_t packets() const { return m_packets; }
+
+  /// \return the number of datagrams missed.
+  [[nodiscard]] uint32_t lost() const { return m_lost; }
+
+  /// \return the number of attributes.
+  [[nodiscard]] size_t size() const { return m_count; }
+
+  [[nodiscard]] const Attribute *begin() const { return m_attributes; }
+  [[nodiscard]] const Attribute *end() const
+  {
+    return m_attributes + m_count;
+  }
+
+  /// \return the value of an attribute, nullptr if there is no such one.
+  [[nodiscard]] const char *value(const char *name) const
+  {
+    const uint32_t hash = fnv1a(name, std::strlen(name));
+    for (const Attribute &attribute : *this)
+      if (attribute.hash == hash) return attribute.value;
+    return nullptr;
+  }
+
+ private:
+//===-- Internals ---------------------------------------------------------===//
+
+  /// \return true, if the records end exactly at the end of the datagram.
+  static bool recordsValid(const uint8_t *packet, size_t length)
+  {
+    const bool keyframe = packet[5] & SCOREBOARD::KEYFRAME;
+    size_t offset = SCOREBOARD::HEADER_SIZE;
+    while (offset < length)
+    {
+      offset += 4;
+      if (keyframe)
+      {
+        if (offset >= length) return false;
+        offset += 1 + packet[offset];
+      }
+      if (offset >= length) return false;
+      offset += 1 + packet[offset];
+    }
+    return offset == length;
+  }
+
+  /// Stores a received value, adding the attribute if it comes with a name.
+  void apply(uint32_t hash,
+             const char *name,
+             size_t name_length,
+             const char *value,
+             size_t value_length)
+  {
+    Attribute *attribute = nullptr;
+    for (size_t idx = 0; idx != m_count && !attribute; idx++)
+      if (m_attributes[idx].hash == hash) attribute = &m_attributes[idx];
+
+    if (!attribute)
+    {
+      // Unknown attributes are learnt from the keyframes, with their names.
+      if (!name || m_count == MAX_ATTRIBUTES) return;
+      attribute = &m_attributes[m_count++];
+      attribute->hash = hash;
+      copyText(attribute->name, NAME_SIZE, name, name_length);
+    }
+    copyText(attribute->value, VALUE_SIZE, value, value_length);
+    attribute->seen = true;
+  }
+
+  /// Drops the attributes missing from the keyframe.
+  void removeUnseen()
+  {
+    size_t kept = 0;
+    for (size_t idx = 0; idx != m_count; idx++)
+      if (m_attributes[idx].seen) m_attributes[kept++] = m_attributes[idx];
+    m_count = kept;
+  }
+
+  static void copyText(char *out, size_t size, const char *text, size_t length)
+  {
+    if (length >= size) length = size - 1;
+    std::memcpy(out, text, length);
+    out[length] = '\0';
+  }
+
+  static uint32_t unpack(const uint8_t *in)
+  {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 |
+           static_cast<uint32_t>(in[3]) << 24;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  Attribute m_attributes[MAX_ATTRIBUTES];
+  size_t m_count;
+  uint32_t m_version;
+  uint16_t m_sequence;
+  /// Whether a datagram was received yet.
+  bool m_started;
+  bool m_synced;
+  /// Whether a keyframe is being received, without gaps so far.
+  bool m_in_keyframe;
+  uint32_t m_packets;
+  uint32_t m_lost;
+}; // class ScoreboardView
+
+} // namespace PTS
+
+#endif // NET_SCOREBOARD_CODEC_H
@@ -0,0 +1,182 @@
+//===-- net/scoreboard_feed.h - ScoreboardFeed class definition -----------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ScoreboardFeed class, a
+/// module broadcasting the attributes of an AttributeStore to any number of
+/// viewers over UDP, as an alternative to polling the WebServer.
+///
+/// On every tick the feed sends the attributes modified since its previous
+/// tick as a delta frame, or nothing if there were none, and every
+/// KEYFRAME_MS a keyframe of every attribute, so viewers joining late or
+/// missing datagrams catch up (see scoreboard_codec.h for the format). The
+/// datagrams go to the broadcast address or to a multicast group, so the
+/// cost of the board, its CPU time and its airtime, doesn't depend on the
+/// number of viewers: nobody connects, and nothing is acknowledged.
+///
+/// Viewers decode the feed with a ScoreboardView, tools/scoreboard_client.cpp
+/// is a reference client printing it on a host.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_SCOREBOARD_FEED_H
+#define NET_SCOREBOARD_FEED_H
+
+#include <cstdint>
+#include <mutex>
+#include <WiFi.h>
+#include "modules/module_base.h"
+#include "net/scoreboard_codec.h"
+#include "utils/sw/log.h"
+
+namespace PTS
+{
+
+/// The work done by a scoreboard feed.
+struct ScoreboardFeedStats
+{
+  uint32_t frames;
+  uint32_t keyframes;
+  uint32_t packets;
+  uint32_t bytes;
+  /// The time spent on the frames, and the part of it spent in the socket.
+  uint32_t busy_us;
+  uint32_t send_us;
+};
+
+/// ScoreboardFeed class
+/// \tparam STORE the type of the AttributeStore.
+/// \tparam FREQUENCY the frame rate in HZ.
+template<typename STORE, uint32_t FREQUENCY = 10>
+class ScoreboardFeed : public Module<3*1024, tskIDLE_PRIORITY, FREQUENCY>
+{
+  /// The maximum time between two keyframes.
+  static constexpr uint32_t KEYFRAME_MS = 2000;
+
+  using Base = Module<3*1024, tskIDLE_PRIORITY, FREQUENCY>;
+
+  /// Sends the datagrams of the encoder.
+  struct Sender
+  {
+    void operator()(const uint8_t *packet, size_t length) const
+    {
+      feed->send(packet, length);
+    }
+
+    const ScoreboardFeed *feed;
+  };
+
+ public:
+  /// The default port of the feed.
+  static constexpr uint16_t DEFAULT_PORT = 4211;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param store the attributes to be sent.
+  /// \param destination the broadcast address or a multicast group.
+  /// \param port the port of the viewers.
+  explicit ScoreboardFeed(const STORE &store,
+                          IPAddress destination = IPAddress(255, 255, 255, 255),
+                          uint16_t port = DEFAULT_PORT)
+    : Base("scoreboard_feed"),
+      c_store(store),
+      c_destination(destination),
+      c_port(port),
+      m_encoder(Sender{this}),
+      m_sent_version(0),
+      m_keyframe_ms(0),
+      m_keyframe_due(true),
+      m_lock(),
+      m_stats(),
+      m_udp()
+  { }
+
+  /// Opens the socket (on any port, the feed receives nothing).
+  void begin() const override
+  {
+    m_keyframe_due = true;
+    if (!m_udp.begin(0))
+      LOG::E("Scoreboard feed has no socket.");
+    else
+      LOG::I("Scoreboard feed sending to %:% at % Hz.", c_destination,
+             c_port, FREQUENCY);
+  }
+
+  /// \return the work done so far.
+  [[nodiscard]] ScoreboardFeedStats stats() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_stats;
+  }
+
+//===-- Threading specific functions --------------------------------------===//
+
+ private:
+  void threadFunc() const override
+  {
+    const uint32_t start_us = static_cast<uint32_t>(micros());
+    const uint32_t now = static_cast<uint32_t>(millis());
+    const uint32_t version = c_store.version();
+    // A deletion can only be told by a keyframe.
+    const bool keyframe = m_keyframe_due ||
+                          now - m_keyframe_ms >= KEYFRAME_MS ||
+                          c_store.deletedVersion() > m_sent_version;
+    if (!keyframe && version == m_sent_version) return;
+
+    m_encoder.beginFrame(keyframe, m_sent_version, version);
+    c_store.forEach(keyframe ? 0 : m_sent_version,
+                    [this](const typename STORE::View &view)
+                    { m_encoder.add(view.name, view.value); });
+    m_encoder.endFrame();
+
+    m_sent_version = version;
+    if (keyframe)
+    {
+      m_keyframe_ms = now;
+      m_keyframe_due = false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.frames++;
+    if (keyframe) m_stats.keyframes++;
+    m_stats.busy_us += static_cast<uint32_t>(micros()) - start_us;
+  }
+
+  void send(const uint8_t *packet, size_t length) const
+  {
+    const uint32_t start_us = static_cast<uint32_t>(micros());
+    if (!m_udp.beginPacket(c_destination, c_port)) return;
+    m_udp.write(packet, length);
+    const bool sent = m_udp.endPacket();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.send_us += static_cast<uint32_t>(micros()) - start_us;
+    if (!sent) return;
+    m_stats.packets++;
+    m_stats.bytes += length;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  const STORE &c_store;
+  const IPAddress c_destination;
+  const uint16_t c_port;
+  mutable ScoreboardEncoder<Sender> m_encoder;
+  /// The store version of the last frame sent.
+  mutable uint32_t m_sent_version;
+  mutable uint32_t m_keyframe_ms;
+  /// Set by begin(), the first frame is a keyframe.
+  mutable bool m_keyframe_due;
+  /// Guards the statistics.
+  mutable std::mutex m_lock;
+  mutable ScoreboardFeedStats m_stats;
+  mutable WiFiUDP m_udp;
+}; // class ScoreboardFeed
+
+} // namespace PTS
+
+#endif // NET_SCOREBOARD_FEED_H
@@ -0,0 +1,114 @@
+//===-- net/static_assets.h - StaticAsset definitions ---------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the StaticAsset structure,
+/// which describes a static web file embedded into the firmware, and the
+/// table of the embedded files.
+///
+/// The files in the web directory are gzipped at build time by
+/// scripts/pack_web_assets.py (a PlatformIO pre-build script), which writes
+/// them into net/web_assets.gen.h as constant arrays stored in flash. The
+/// generated header is not versioned, builds without it have no assets.
+///
+/// Every asset has a strong ETag (a hash of its compressed bytes), so it can
+/// be referenced with a versioned URL, cached for good by the browsers, and
+/// revalidated with a single 304 response.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_STATIC_ASSETS_H
+#define NET_STATIC_ASSETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "utils/sw/hash.h"
+
+#ifndef PROGMEM
+#define PROGMEM // Host builds keep the constants in read-only data anyway.
+#endif
+
+namespace PTS
+{
+
+/// An embedded, gzipped static file.
+struct StaticAsset
+{
+  /// The path the asset is served on (e.g. "/static/style.css").
+  const char *path;
+  /// The FNV-1a hash of the path.
+  uint32_t path_hash;
+  /// The value of the Content-Type header.
+  const char *content_type;
+  /// The strong ETag, quoted (e.g. "\"0123456789abcdef\"").
+  const char *etag;
+  /// The ETag without the quotes, used to version the URLs of the asset.
+  const char *version;
+  /// The gzipped content.
+  const uint8_t *data;
+  /// The length of the gzipped content.
+  size_t length;
+};
+
+/// Looks up an asset by its path.
+/// \param assets the table of the assets.
+/// \param count the number of assets in the table.
+/// \param path the path of the asset.
+/// \param path_hash the FNV-1a hash of the path.
+/// \return the asset, nullptr if there is none with the path.
+inline const StaticAsset *findAsset(const StaticAsset *assets,
+                                    size_t count,
+                                    const char *path,
+                                    uint32_t path_hash)
+{
+  for (size_t idx = 0; idx != count; idx++)
+    if (assets[idx].path_hash == path_hash &&
+        std::strcmp(assets[idx].path, path) == 0)
+      return &assets[idx];
+  return nullptr;
+}
+
+} // namespace PTS
+
+#if __has_include("net/web_assets.gen.h")
+#include "net/web_assets.gen.h"
+#else
+namespace PTS
+{
+
+namespace ASSETS
+{
+
+/// Built without the pre-build step, there are no embedded assets.
+inline constexpr const StaticAsset *WEB_ASSETS = nullptr;
+inline constexpr size_t WEB_ASSET_COUNT = 0;
+
+} // namespace ASSETS
+
+} // namespace PTS
+#endif
+
+namespace PTS
+{
+
+namespace ASSETS
+{
+
+/// Looks up an embedded asset by its path.
+/// \return the asset, nullptr if there is none with the path.
+inline const StaticAsset *find(const char *path)
+{
+  return findAsset(WEB_ASSETS, WEB_ASSET_COUNT, path,
+                   fnv1a(path, std::strlen(path)));
+}
+
+} // namespace ASSETS
+
+} // namespace PTS
+
+#endif // NET_STATIC_ASSETS_H
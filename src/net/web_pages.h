@@ -0,0 +1,179 @@
+//===-- net/web_pages.h - Web page definitions ----------------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the static fragments of the pages served by the
+/// WebServer and the functions rendering them into a ResponseWriter.
+///
+/// The fragments are constants stored in flash, they are never copied to RAM
+/// before being sent. The style sheet, the script and the icon are embedded
+/// assets (see static_assets.h), referenced with versioned URLs.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef NET_WEB_PAGES_H
+#define NET_WEB_PAGES_H
+
+#include <cstdint>
+#include "net/static_assets.h"
+
+namespace PTS
+{
+
+namespace PAGE
+{
+
+/// Attribute page fragment before the URL of the icon.
+static const char ATTRIBUTES_HEAD[] PROGMEM =
+  "<!DOCTYPE html><html>\n"
+  "<head>\n"
+  "<title>PTS Web Server</title>\n"
+  "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">\n"
+  "<link rel=\"icon\" href=\"";
+
+/// Attribute page fragment between the URLs of the icon and the style sheet.
+static const char ATTRIBUTES_STYLE[] PROGMEM =
+  "\">\n"
+  "<link rel=\"stylesheet\" href=\"";
+
+/// Attribute page fragment between the URLs of the style sheet and the
+/// script, which keeps the table up to date from the pushed deltas.
+static const char ATTRIBUTES_SCRIPT[] PROGMEM =
+  "\">\n"
+  "<script defer src=\"";
+
+/// Attribute page fragment between the URL of the script and the address of
+/// the client.
+static const char ATTRIBUTES_BODY[] PROGMEM =
+  "\"></script>\n"
+  "</head>\n"
+  "<body>\n"
+  "<h1>PTS Web Server</h1>\n"
+  "<p>You are connected on ";
+
+/// Attribute page fragment between the address of the client and the
+/// attribute version.
+static const char ATTRIBUTES_TABLE[] PROGMEM =
+  "</p>\n"
+  "<h2>Registered attributes:</h2>\n"
+  "<table id=\"attributes\" data-version=\"";
+
+/// Attribute page fragment between the attribute version and the rows.
+static const char ATTRIBUTES_ROWS[] PROGMEM =
+  "\">\n"
+  "<tr><th>Name</th><th>Value</th><th>Description</th></tr>\n";
+
+/// Attribute page fragment after the rows.
+static const char ATTRIBUTES_TAIL[] PROGMEM =
+  "</table>\n"
+  "<p><a href=\"/log\">Log</a> <a href=\"/log/stream\">Live log</a></p>\n"
+  "</body>\n"
+  "</html>\n";
+
+/// Writes a constant fragment to the response.
+/// \tparam WRITER the type of the ResponseWriter.
+/// \tparam LENGTH the size of the fragment (including the terminating zero).
+template<typename WRITER, size_t LENGTH>
+void writeFragment(WRITER &writer, const char (&fragment)[LENGTH])
+{
+  writer.writeStatic(fragment, LENGTH - 1);
+}
+
+/// Writes the URL of an embedded asset, versioned by its ETag so browsers
+/// can cache it for good.
+/// \tparam WRITER the type of the ResponseWriter.
+/// \param path the path of the asset.
+template<typename WRITER>
+void writeAssetUrl(WRITER &writer, const char *path)
+{
+  writer.print(path);
+  if (const StaticAsset *asset = ASSETS::find(path))
+  {
+    writer.print("?v=");
+    writer.print(asset->version);
+  }
+}
+
+/// Renders the attribute table page up to its first row.
+/// \tparam WRITER the type of the ResponseWriter.
+/// \param writer the writer of the already started response.
+/// \param version the version of the rows, the live updates continue from
+/// it.
+/// \param remote_address the address of the client.
+/// \param remote_port the port of the client.
+template<typename WRITER>
+void renderAttributesHead(WRITER &writer,
+                          uint32_t version,
+                          const char *remote_address,
+                          uint16_t remote_port)
+{
+  writeFragment(writer, ATTRIBUTES_HEAD);
+  writeAssetUrl(writer, "/static/favicon.svg");
+  writeFragment(writer, ATTRIBUTES_STYLE);
+  writeAssetUrl(writer, "/static/style.css");
+  writeFragment(writer, ATTRIBUTES_SCRIPT);
+  writeAssetUrl(writer, "/static/attributes.js");
+  writeFragment(writer, ATTRIBUTES_BODY);
+  writer.print(remote_address);
+  writer.print(":");
+  writer.print(static_cast<uint32_t>(remote_port));
+  writeFragment(writer, ATTRIBUTES_TABLE);
+  writer.print(version);
+  writeFragment(writer, ATTRIBUTES_ROWS);
+}
+
+/// Renders a row of the attribute table.
+/// \tparam WRITER the type of the ResponseWriter.
+/// \tparam VIEW an AttributeStore::View.
+template<typename WRITER, typename VIEW>
+void renderAttributeRow(WRITER &writer, const VIEW &attribute)
+{
+  writer.print("<tr data-name=\"");
+  writer.printEscaped(attribute.name);
+  writer.print("\"><td>");
+  writer.printEscaped(attribute.name);
+  writer.print("</td><td>");
+  writer.printEscaped(attribute.value);
+  writer.print("</td><td>");
+  writer.printEscaped(attribute.description);
+  writer.print("</td></tr>\n");
+}
+
+/// Renders the attribute table page after its last row.
+/// \tparam WRITER the type of the ResponseWriter.
+template<typename WRITER>
+void renderAttributesTail(WRITER &writer)
+{
+  writeFragment(writer, ATTRIBUTES_TAIL);
+}
+
+/// Renders the attribute table page.
+/// \tparam WRITER the type of the ResponseWriter.
+/// \tparam SNAPSHOT an AttributeStore::Snapshot.
+/// \param writer the writer of the already started response.
+/// \param attributes the attributes to be listed, the live updates continue
+/// from their version.
+/// \param remote_address the address of the client.
+/// \param remote_port the port of the client.
+template<typename WRITER, typename SNAPSHOT>
+void renderAttributes(WRITER &writer,
+                      const SNAPSHOT &attributes,
+                      const char *remote_address,
+                      uint16_t remote_port)
+{
+  renderAttributesHead(writer, attributes.version(),
+                       remote_address, remote_port);
+  for (const auto &attribute : attributes)
+    renderAttributeRow(writer, attribute);
+  renderAttributesTail(writer);
+}
+
+} // namespace PAGE
+
+} // namespace PTS
+
+#endif // NET_WEB_PAGES_H
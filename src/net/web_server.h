@@ -8,28 +8,261 @@
 ///
 /// \file This file contains the declarations of the WebServer class, which is
 /// a singleton wrapper for simple http web server functionality.
-/// The site rendered contains a table of name (key) - value - description (opt)
-/// with minimal styling.
+/// Requests are parsed by a RequestParser and dispatched to the handlers
+/// registered in a Router, new endpoints can be added with on().
+/// Attributes live in an AttributeStore: registering one returns a handle,
+/// and updates through the handle are wait-free (every attribute has a
+/// single writer), so publishing a value is cheap enough for every loop()
+/// pass. Typed attributes (integers, floats,
+/// durations...) store the raw value and are only formatted when fetched,
+/// rewriting the same value is free. Attributes are versioned: every
+/// modification increases a global version and stores it in the modified
+/// attribute. "/api/attributes" serves them as
+/// JSON, optionally only the ones modified since a given version.
+/// The site rendered on "/" contains a table of name (key) - value -
+/// description (opt) with minimal styling. Responses are assembled in a
+/// reusable ResponseWriter, so a page costs a handful of network writes instead
+/// of one per fragment.
+///
+/// The style sheet, the script and the icon of the site are gzipped at build
+/// time and embedded into the firmware (see static_assets.h), "/static/..."
+/// serves them straight from flash with strong ETags and long cache lifetimes.
+///
+/// Numeric attributes can keep a history (see enableHistory()): every change
+/// is recorded into a TimeSeries of fixed size, at full resolution and as one
+/// and ten second minimum/maximum/mean buckets, and "/api/history" serves it
+/// as CSV or packed binary for charting. The updating tasks only push the
+/// changes into a lock-free queue, the server task records them.
+///
+/// Game masters control the board remotely by posting a batch of commands to
+/// "/api/commands" (see command_batch.h): the module commands are posted into
+/// the mailboxes of the modules (see Module::post()), which apply them on
+/// their own next tick, and the attributes registered as remote are set
+/// right away (the server task is their only writer). The response holds
+/// the result of every command, so a single round trip re-arms a whole board.
+/// The modules are found by the handler given to onModuleCommand().
+///
+/// The recent log output is served from the in-memory log ring on "/log", and
+/// "/log/stream" keeps the connection open, sending new log lines as they are
+/// written. Every streaming client has its own read cursor, so a slow client
+/// only ever misses lines, it never stalls the logger. "/api/events" pushes
+/// the attribute changes as Server-Sent Events, queued per client.
+///
+/// Connections are served side by side from a fixed table: the task waits on
+/// every socket at once with select(), feeds whatever arrived to the parser
+/// of its connection, and keeps the connections open between requests
+/// (HTTP/1.1 keep-alive) until they idle out. Nothing is sent blocking: what
+/// the socket of a connection doesn't take waits in its backlog (see
+/// BufferedClient), and no further request of the connection is served
+/// until the backlog is sent. Large bodies (the page, the attributes, the log
+/// and the CSV histories) are written a part at a time, as the socket takes
+/// them, and the assets are sent from flash as they are, so the backlog only
+/// ever holds the last buffer of a response. A client whose backlog
+/// overflows, or doesn't drain for SEND_TIMEOUT_MS, is closed.
 ///
 //===----------------------------------------------------------------------===//
 
 #ifndef NET_WEB_SERVER_H
 #define NET_WEB_SERVER_H
 
-#include <mutex>
-#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <array>
+#include <atomic>
 #include <string>
 #include <optional>
+#include <cerrno>
+#include <sys/select.h>
+#include <sys/socket.h>
 #include <WiFi.h>
 #include "modules/module_base.h"
+#include "modules/module_command.h"
+#include "net/attribute_store.h"
+#include "net/buffered_client.h"
+#include "net/command_batch.h"
+#include "net/http_request.h"
+#include "net/http_response.h"
+#include "net/http_router.h"
+#include "net/static_assets.h"
+#include "net/web_pages.h"
+#include "utils/sw/byte_buffer.h"
+#include "utils/sw/json_writer.h"
 #include "utils/sw/log.h"
+#include "utils/sw/mpsc_queue.h"
+#include "utils/sw/time_series.h"
+
+#ifndef WEB_MAX_CONNECTIONS
+// Together with the streaming clients this stays within the 16 lwIP sockets.
+#define WEB_MAX_CONNECTIONS 6
+#endif
+
+#ifndef WEB_SEND_BACKLOG
+// The bytes of a response kept per connection beyond the socket's send
+// buffer. Large bodies wait for the socket instead, see WebServer::Body.
+#define WEB_SEND_BACKLOG 4096
+#endif
+
+#ifndef WEB_MAX_ATTRIBUTES
+#define WEB_MAX_ATTRIBUTES 32
+#endif
+
+#ifndef WEB_MAX_HISTORIES
+// Every history takes about 5.8 kB (see WebServer::History).
+#define WEB_MAX_HISTORIES 2
+#endif
 
 namespace PTS
 {
 
 /// WebServer singleton class
-class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 2>
+class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 10>
 {
+  /// The maximum number of connections served at the same time.
+  static constexpr size_t MAX_CONNECTIONS = WEB_MAX_CONNECTIONS;
+  /// The part of every 100 ms task period spent serving, the rest is left to
+  /// the Module's delay.
+  static constexpr uint32_t SERVE_BUDGET_MS = 80;
+  /// The longest wait for socket activity, new connections are noticed and
+  /// the streams are pumped at least this often.
+  static constexpr uint32_t POLL_MS = 5;
+  /// The time a kept-alive connection may wait for its next request.
+  static constexpr uint32_t IDLE_TIMEOUT_MS = 5000;
+  /// The time a started request may take to arrive completely.
+  static constexpr uint32_t REQUEST_TIMEOUT_MS = 3000;
+  /// The time a backlog may wait for the socket to take any of it.
+  static constexpr uint32_t SEND_TIMEOUT_MS = 3000;
+  /// The idle time after which a kept-alive connection may be closed to make
+  /// room for a waiting one.
+  static constexpr uint32_t EVICT_IDLE_MS = 500;
+  /// The maximum number of registered request handlers.
+  static constexpr size_t MAX_ROUTES = 16;
+  /// The client of a connection, sending without blocking.
+  using WebClient = BufferedClient<WEB_SEND_BACKLOG>;
+  /// The router type, passing the server and the client to the handlers.
+  using WebRouter = Router<MAX_ROUTES, const WebServer&, WebClient&>;
+  /// The maximum number of clients streaming the log at the same time.
+  static constexpr size_t MAX_LOG_CLIENTS = 4;
+  /// The maximum number of log bytes sent to a streaming client per tick.
+  static constexpr size_t LOG_CHUNK_SIZE = 1024;
+  /// The head of a log stream response.
+  static constexpr char LOG_STREAM_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; charset=utf-8\r\n"
+    "Cache-Control: no-store\r\n"
+    "X-Content-Type-Options: nosniff\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+  /// The maximum number of clients subscribed to attribute events.
+  static constexpr size_t MAX_EVENT_CLIENTS = 4;
+  /// The size of the outgoing queue of an event client, a client that falls
+  /// further behind is dropped.
+  static constexpr size_t EVENT_QUEUE_SIZE = 2048;
+  /// The minimum time between two event frames, changes within are coalesced.
+  static constexpr uint32_t EVENT_INTERVAL_MS = 250;
+  /// The time after which an idle event stream gets a keep-alive comment.
+  static constexpr uint32_t EVENT_KEEP_ALIVE_MS = 15000;
+  /// The caching of the embedded assets (their URLs are versioned).
+  static constexpr const char *ASSET_CACHE_CONTROL =
+    "public, max-age=31536000, immutable";
+
+  /// The history of an attribute: the last 120 changes, 2 minutes of one
+  /// second buckets and 30 minutes of ten second buckets, 5.8 kB in total.
+  using History = TimeSeries<120, 120, 180>;
+  /// The history slot of the attributes without one.
+  static constexpr int8_t NO_HISTORY = -1;
+  /// The version of the binary history format.
+  static constexpr uint8_t HISTORY_FORMAT_VERSION = 1;
+  /// The maximum number of attributes with a history.
+  static constexpr size_t MAX_HISTORIES = WEB_MAX_HISTORIES;
+  static_assert(MAX_HISTORIES < 128, "History slots are stored as int8_t.");
+  /// The number of changes queued to the server task between two passes.
+  static constexpr size_t HISTORY_QUEUE_SIZE = 64;
+
+  /// A change of an attribute with a history, on its way to the server task.
+  struct HistorySample
+  {
+    /// The slot of the history.
+    uint8_t history;
+    /// Whether the history is to be cleared (when it is enabled) instead.
+    bool reset;
+    uint32_t time_ms;
+    float value;
+  };
+
+  /// A body written a part at a time, whenever the socket of its connection
+  /// has taken everything before (see continueBody()).
+  struct Body
+  {
+    enum Kind : uint8_t
+    {
+      NONE,
+      PAGE,       // The rows of the attribute table page.
+      ATTRIBUTES, // The attributes of the JSON.
+      HISTORY,    // The lines of a CSV history.
+      LOG,        // The log ring, as far as it was at the time of the request.
+    };
+
+    Kind kind;
+    /// Whether the connection is kept open after the body.
+    bool keep_open;
+    /// Whether no attribute has been written yet.
+    bool first;
+    /// The slot of the next attribute.
+    uint16_t slot;
+    /// The version the attributes are newer than, 0 for every attribute.
+    uint32_t since;
+    uint8_t history;
+    History::Resolution resolution;
+    /// The time of the last history line written, and the number of lines
+    /// written at that time (0 for none at all).
+    uint32_t time_ms;
+    uint16_t at_time;
+    /// The time of the request, newer history entries are left out.
+    uint32_t end_ms;
+    /// The position in the log ring and the end of the log.
+    LOG::Ring::Cursor cursor;
+    LOG::Ring::Cursor end;
+  };
+
+  /// A connection receiving requests.
+  struct Connection
+  {
+    WebClient client;
+    RequestParser<> parser;
+    /// The body still being written, the next requests wait for it.
+    Body body;
+    /// The time of the last received request data, response or progress of
+    /// the backlog.
+    uint32_t active_ms;
+    /// Whether part of a request has been received.
+    bool receiving;
+    /// Whether the connection is closed once its backlog is sent.
+    bool closing;
+  };
+
+  /// A client streaming the log, with its own position in the log ring.
+  struct LogClient
+  {
+    WiFiClient client;
+    LOG::Ring::Cursor cursor;
+    /// The number of bytes of LOG_STREAM_HEADERS sent.
+    size_t headers_sent;
+  };
+
+  /// A client subscribed to attribute events.
+  struct EventClient
+  {
+    WiFiClient client;
+    /// The global attribute version the client has been sent (0 for none).
+    uint32_t version;
+    /// The time of the last frame queued to the client.
+    uint32_t queued_ms;
+    /// The frames not yet accepted by the socket.
+    ByteBuffer<EVENT_QUEUE_SIZE> queue;
+  };
+
  private:
   /// Private constructor to implement singleton behaviour.
   explicit WebServer()
@@ -37,10 +270,32 @@ class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 2>
       wifi_server(WiFiServer(80)),
       ip_address(),
       m_attributes(),
-      m_attributes_lock()
-  { }
+      m_connections(),
+      m_connections_waiting(false),
+      m_router(),
+      m_response(),
+      m_client_adopted(false),
+      m_body(),
+      m_log_clients(),
+      m_event_clients(),
+      m_event_frame(),
+      m_event_ms(0),
+      m_histories(),
+      m_history_slots(),
+      m_remote_slots(),
+      m_history_queue(),
+      m_command_batch(),
+      m_module_commands(nullptr)
+  {
+    for (auto &history_slot : m_history_slots) history_slot = NO_HISTORY;
+    for (auto &remote_slot : m_remote_slots) remote_slot = false;
+    registerHandlers();
+  }
 
  public:
+  /// The attribute storage.
+  using Attributes = AttributeStore<WEB_MAX_ATTRIBUTES>;
+
   /// Returns the static instance of the WebServer as a const reference.
   static const WebServer& instance()
   {
@@ -48,52 +303,161 @@ class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 2>
     return instance_;
   }
 
-  /// Registers an attribute to be displayed on the site.
+  /// Registers an attribute to be displayed on the site. Every attribute has
+  /// a single writer: the registering task (or the one it hands the handle
+  /// to), or the server task for the remote ones.
   /// \param name the unique name of the attribute.
   /// \param value the value of the attribute.
   /// \param description the description of the attribute.
-  /// \return false, if the attribute already exists, true otherwise.
-  bool registerAttribute(const std::string &name,
-                         const std::string &value = "nil",
-                         const std::string &description = "") const
+  /// \param remote whether the attribute is set with "/api/commands" only
+  /// (the others are read-only to the clients).
+  /// \return the handle of the attribute, invalid if it already exists (or
+  /// there are WEB_MAX_ATTRIBUTES already).
+  AttributeHandle registerAttribute(const std::string &name,
+                                    const std::string &value = "nil",
+                                    const std::string &description = "",
+                                    bool remote = false) const
+  {
+    return registerAttribute(name, AttributeValue::fromText(value.c_str()),
+                             description, remote);
+  }
+
+  /// Registers a typed attribute, see AttributeValue for the constructors.
+  /// \param name the unique name of the attribute.
+  /// \param value the type, the formatting and the initial value.
+  /// \param description the description of the attribute.
+  /// \param remote whether the attribute is set with "/api/commands" only.
+  /// \return the handle of the attribute, invalid if it already exists (or
+  /// there are WEB_MAX_ATTRIBUTES already).
+  AttributeHandle registerAttribute(const std::string &name,
+                                    const AttributeValue &value,
+                                    const std::string &description = "",
+                                    bool remote = false) const
   {
-    std::lock_guard<std::mutex> lock(m_attributes_lock);
+    const AttributeHandle handle =
+      m_attributes.add(name.c_str(), value, description.c_str());
+    if (handle) m_remote_slots[handle.index()] = remote;
+    return handle;
+  }
 
-    if (m_attributes.find(name) != m_attributes.end()) return false;
+  /// Updates a typed attribute, only storing the value (it is formatted when
+  /// a client fetches it). Updates to the current value are skipped.
+  /// \param handle the handle returned by registerAttribute().
+  /// \param value the value of the updated attribute.
+  /// \return false, if the handle is invalid or of another type, true
+  /// otherwise.
+  bool updateInteger(AttributeHandle handle, int32_t value) const
+  {
+    return setTyped(handle, AttributeType::INTEGER,
+                    static_cast<uint32_t>(value), static_cast<float>(value));
+  }
 
-    m_attributes[name] = std::make_pair(value, description);
-    return true;
+  /// Updates a float attribute (see above).
+  bool updateFloat(AttributeHandle handle, float value) const
+  {
+    return setTyped(handle, AttributeType::FLOAT,
+                    AttributeValue::floatBits(value), value);
+  }
+
+  /// Updates a bool attribute (see above).
+  bool updateBool(AttributeHandle handle, bool value) const
+  {
+    return setTyped(handle, AttributeType::BOOL, value, value ? 1.0f : 0.0f);
+  }
+
+  /// Updates a duration attribute (see above).
+  /// \param milliseconds the duration in milliseconds.
+  bool updateDuration(AttributeHandle handle, uint32_t milliseconds) const
+  {
+    return setTyped(handle, AttributeType::DURATION, milliseconds,
+                    static_cast<float>(milliseconds));
+  }
+
+  /// Updates an enum attribute (see above).
+  /// \param index the index of the name of the value.
+  bool updateEnum(AttributeHandle handle, uint8_t index) const
+  {
+    return setTyped(handle, AttributeType::ENUM, index,
+                    static_cast<float>(index));
   }
 
-  /// Updates a registered attribute.
+  /// Starts recording the changes of a typed attribute, served on
+  /// "/api/history?name=...". The history starts out empty, and is dropped
+  /// with the attribute. Text attributes are not recorded.
+  /// \param handle the handle returned by registerAttribute().
+  /// \return false, if the handle is invalid or every history is in use,
+  /// true otherwise (also if the attribute already has one).
+  bool enableHistory(AttributeHandle handle) const
+  {
+    if (!handle) return false;
+    if (m_history_slots[handle.index()] != NO_HISTORY) return true;
+
+    for (size_t history = 0; history != MAX_HISTORIES; history++)
+    {
+      const bool used = std::any_of(m_history_slots.begin(),
+                                    m_history_slots.end(),
+        [history](const std::atomic<int8_t> &history_slot)
+        { return history_slot == static_cast<int8_t>(history); });
+      if (used) continue;
+
+      // The reset goes through the queue, the server task owns the series.
+      if (!m_history_queue.push({static_cast<uint8_t>(history), true, 0, 0}))
+        return false;
+      m_history_slots[handle.index()] = static_cast<int8_t>(history);
+      return true;
+    }
+    return false;
+  }
+
+  /// Updates a registered attribute without any lookup, allocation or lock.
+  /// \param handle the handle returned by registerAttribute().
+  /// \param value the value of the updated attribute.
+  /// \return false, if the handle is invalid, true otherwise.
+  bool updateAttribute(AttributeHandle handle, const char *value) const
+  {
+    return m_attributes.update(handle, value);
+  }
+
+  /// Updates a registered attribute (see above).
+  bool updateAttribute(AttributeHandle handle, const std::string &value) const
+  {
+    return m_attributes.update(handle, value.c_str());
+  }
+
+  /// Updates a registered attribute, looked up by name.
   /// \param name the name of the attribute to be updated.
   /// \param value the value of the updated attribute.
   /// \return false, if the attribute does not exist, true otherwise.
   bool updateAttribute(const std::string &name,
                        const std::string &value) const
   {
-    std::lock_guard<std::mutex> lock(m_attributes_lock);
-
-    if (m_attributes.find(name) == m_attributes.end()) return false;
-
-    m_attributes[name] = std::make_pair(value, m_attributes[name].second);
-    return true;
+    return m_attributes.update(m_attributes.find(name.c_str()), value.c_str());
   }
 
   /// Updates an attribute if it exists, or registers it otherwise.
   /// \param name the name of the attribute.
   /// \param value the value of the attribute.
   /// \param description the description of the attribute (does not update).
-  void upsterAttribute(const std::string &name,
-                       const std::string &value,
-                       const std::string &description = "") const
-  {
-    std::lock_guard<std::mutex> lock(m_attributes_lock);
-    
-    if (m_attributes.find(name) == m_attributes.end())
-      m_attributes[name] = std::make_pair(value, description);
-    else
-      m_attributes[name] = std::make_pair(value, m_attributes[name].second);
+  /// \return the handle of the attribute, invalid if it couldn't be registered.
+  AttributeHandle upsterAttribute(const std::string &name,
+                                  const std::string &value,
+                                  const std::string &description = "") const
+  {
+    AttributeHandle handle = m_attributes.find(name.c_str());
+    if (handle && m_attributes.update(handle, value.c_str())) return handle;
+
+    return registerAttribute(name, value, description);
+  }
+
+  /// Returns the value of an attribute.
+  /// \param handle the handle of the attribute.
+  /// \return an optional storing the value, empty if the handle is invalid.
+  std::optional<std::string> readAttribute(AttributeHandle handle) const
+  {
+    Attributes::View view;
+    if (!m_attributes.read(handle, view)) return {};
+
+    return {view.value};
   }
 
   /// Returns the value of an attribute.
@@ -101,26 +465,34 @@ class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 2>
   /// \return an optional storing the value, empty if it is not registered.
   std::optional<std::string> readAttribute(const std::string &name) const
   {
-    std::lock_guard<std::mutex> lock(m_attributes_lock);
-
-    if (m_attributes.find(name) == m_attributes.end()) return {};
-
-    return {m_attributes[name].first};
+    return readAttribute(m_attributes.find(name.c_str()));
   }
 
-  /// Deletes a registered attribute.
+  /// Deletes a registered attribute, its handles become invalid. Only the
+  /// writer of the attribute may delete it.
   /// \param name the name of the attribute.
   /// \return false if the attribute does not exist, true otherwise. 
   bool deleteAttribute(const std::string &name) const
   {
-    std::lock_guard<std::mutex> lock(m_attributes_lock);
-
-    if (m_attributes.find(name) == m_attributes.end()) return false;
+    const AttributeHandle handle = m_attributes.find(name.c_str());
+    if (handle)
+    {
+      m_history_slots[handle.index()] = NO_HISTORY;
+      m_remote_slots[handle.index()] = false;
+    }
+    return m_attributes.remove(name.c_str());
+  }
 
-    m_attributes.erase(name);
-    return true;
+  /// \return the global attribute version, increased by every modification.
+  [[nodiscard]] uint32_t attributesVersion() const
+  {
+    return m_attributes.version();
   }
 
+  /// \return the attribute storage, for other publishers of the attributes
+  /// (see ScoreboardFeed).
+  [[nodiscard]] const Attributes &attributes() const { return m_attributes; }
+
   void begin() const override
   {
     LOG::I("Setting up AP...");
@@ -132,88 +504,1211 @@ class WebServer : public Module<4*1024, tskIDLE_PRIORITY, 2>
 
   void threadFunc() const override
   {
-    WiFiClient client = wifi_server.available();
-    
-    if (client)
+    const uint32_t start = millis();
+    do
+    {
+      recordHistories();
+      acceptConnections();
+      waitForActivity();
+      for (auto &connection : m_connections) serveConnection(connection);
+      pumpLogClients();
+      pumpEventClients();
+    } while (millis() - start < SERVE_BUDGET_MS);
+  }
+
+//===-- Routing specific functions ----------------------------------------===//
+
+  /// Handler callback type, receiving the request, the server and the client.
+  using Handler = WebRouter::CALLBACK_TYPE;
+
+  /// Registers a handler for the given method and path (see Router::on()).
+  /// Handlers should be registered before the server is started.
+  /// \return false, if the routing table is full, true otherwise.
+  bool on(HttpMethod method, const char *path, Handler handler) const
+  {
+    return m_router.on(method, path, handler);
+  }
+
+  /// \return the reusable response writer, handlers should respond with it.
+  ResponseWriter<WiFiClient> &response() const { return m_response; }
+
+  /// Module command handler type, posting a command to the named module.
+  using ModuleCommandHandler = CommandResult(*)(const char *module,
+                                                ModuleCommand command);
+
+  /// Sets the handler of the module commands of "/api/commands" (without
+  /// one, every module is unknown). It should be set before the server is
+  /// started, it is called by the server task.
+  void onModuleCommand(ModuleCommandHandler handler) const
+  {
+    m_module_commands = handler;
+  }
+
+//===-- Connection specific functions -------------------------------------===//
+
+ private:
+  /// Moves the waiting connections into free slots. When every slot is taken,
+  /// the longest idle kept-alive connection is closed to make room if it has
+  /// been idle for EVICT_IDLE_MS, otherwise the busy connections are closed
+  /// after their next response (see respond()).
+  void acceptConnections() const
+  {
+    m_connections_waiting = false;
+    while (wifi_server.hasClient())
+    {
+      const uint32_t now = millis();
+      Connection *slot = nullptr;
+      for (auto &connection : m_connections)
+      {
+        if (connection.client.fd() < 0)
+        {
+          slot = &connection;
+          break;
+        }
+        if (!connection.receiving && connection.client.pending() == 0 &&
+            connection.body.kind == Body::NONE &&
+            now - connection.active_ms >= EVICT_IDLE_MS &&
+            (!slot || static_cast<int32_t>(connection.active_ms -
+                                           slot->active_ms) < 0))
+          slot = &connection;
+      }
+      if (!slot)
+      {
+        m_connections_waiting = true;
+        return;
+      }
+
+      if (slot->client.fd() >= 0) closeConnection(*slot);
+
+      slot->client = wifi_server.accept();
+      if (slot->client.fd() < 0) return;
+
+      slot->client.setNoDelay(true);
+      slot->parser.reset();
+      slot->active_ms = millis();
+      slot->receiving = false;
+      slot->closing = false;
+      slot->body.kind = Body::NONE;
+      LOG::D("New client connected @ %:%",
+             slot->client.remoteIP(), slot->client.remotePort());
+    }
+  }
+
+  /// Waits until a connection has data, a backlog (or the next part of a
+  /// body) can be sent or POLL_MS passes.
+  void waitForActivity() const
+  {
+    fd_set readable;
+    fd_set writable;
+    FD_ZERO(&readable);
+    FD_ZERO(&writable);
+    int max_fd = -1;
+    for (auto &connection : m_connections)
+    {
+      const int fd = connection.client.fd();
+      if (fd < 0) continue;
+      // A connection with a backlog is not read until it is sent.
+      const bool sending = connection.client.pending() != 0 ||
+                           connection.body.kind != Body::NONE;
+      FD_SET(fd, sending ? &writable : &readable);
+      max_fd = std::max(max_fd, fd);
+    }
+
+    if (max_fd < 0)
+    {
+      delay(POLL_MS);
+      return;
+    }
+
+    timeval timeout{0, static_cast<long>(POLL_MS) * 1000};
+    select(max_fd + 1, &readable, &writable, nullptr, &timeout);
+  }
+
+  /// Sends the backlog of a connection and continues its body, then reads
+  /// what arrived on it and responds to the completed requests (pipelined
+  /// ones included), or closes it if it timed out. The requests behind a
+  /// body that doesn't fit into the socket are left in it, until the body is
+  /// finished.
+  /// \param connection the connection to serve.
+  void serveConnection(Connection &connection) const
+  {
+    if (connection.client.fd() < 0) return;
+
+    const size_t pending = connection.client.pending();
+    if (!connection.client.sendBacklog())
+    {
+      closeConnection(connection);
+      return;
+    }
+    if (connection.client.pending() != 0)
+    {
+      if (connection.client.pending() != pending)
+        connection.active_ms = millis();
+      else if (millis() - connection.active_ms >= SEND_TIMEOUT_MS)
+        dropConnection(connection);
+      return;
+    }
+    if (connection.body.kind != Body::NONE)
+    {
+      connection.active_ms = millis();
+      m_response.resume(connection.client);
+      if (!continueBody(connection)) return;
+      if (connection.client.overflowed())
+      {
+        dropConnection(connection);
+        return;
+      }
+      if (!connection.body.keep_open)
+      {
+        finishConnection(connection);
+        return;
+      }
+    }
+    if (connection.closing)
+    {
+      closeConnection(connection);
+      return;
+    }
+
+    const int fd = connection.client.fd();
+    char buffer[512];
+    const ssize_t length = peekNow(fd, buffer, sizeof(buffer));
+    if (length <= 0)
+    {
+      const uint32_t idle = millis() - connection.active_ms;
+      if (length < 0)
+      {
+        closeConnection(connection);
+      }
+      else if (connection.receiving && idle >= REQUEST_TIMEOUT_MS)
+      {
+        sendError(connection.client, "408 Request Timeout", true);
+        finishConnection(connection);
+      }
+      else if (!connection.receiving && idle >= IDLE_TIMEOUT_MS)
+      {
+        closeConnection(connection);
+      }
+      return;
+    }
+
+    connection.active_ms = millis();
+    size_t offset = 0;
+    while (offset != static_cast<size_t>(length))
+    {
+      size_t consumed = 0;
+      const auto status = connection.parser.feed(buffer + offset,
+        static_cast<size_t>(length) - offset, &consumed);
+      offset += consumed;
+      if (status == RequestParser<>::INCOMPLETE)
+      {
+        connection.receiving = true;
+        break;
+      }
+
+      const bool keep_open = respond(connection, status);
+      if (connection.client.overflowed())
+      {
+        dropConnection(connection);
+        return;
+      }
+      if (!keep_open)
+      {
+        // Unread requests would reset the connection instead of closing it.
+        discardNow(fd, static_cast<size_t>(length));
+        // Clients handed over to the log or event pump are kept open.
+        if (m_client_adopted) connection.client = WiFiClient();
+        else finishConnection(connection);
+        return;
+      }
+      connection.parser.reset();
+      connection.receiving = false;
+      connection.active_ms = millis();
+      if (connection.body.kind != Body::NONE) break;
+    }
+    discardNow(fd, offset);
+  }
+
+  /// Responds to the request received on a connection.
+  /// \param connection the connection with the finished request.
+  /// \param status the status of its parser.
+  /// \return true, if the connection should be kept open for the next request.
+  bool respond(Connection &connection, RequestParser<>::Status status) const
+  {
+    m_client_adopted = false;
+    switch (status)
+    {
+      case RequestParser<>::COMPLETE:
+      {
+        // Busy connections take turns with the waiting ones.
+        const HttpRequest &request = connection.parser.request();
+        m_response.setKeepAlive(request.keepAlive() &&
+                                request.minorVersion() != 0 &&
+                                !m_connections_waiting);
+        m_body.kind = Body::NONE;
+        handleRequest(request, connection.client);
+        const bool keep_open =
+          !m_client_adopted && !m_response.closesConnection();
+        if (m_body.kind == Body::NONE) return keep_open;
+
+        // The connection is closed once the body is finished, if at all.
+        connection.body = m_body;
+        connection.body.keep_open = keep_open;
+        return !continueBody(connection) || keep_open;
+      }
+      case RequestParser<>::BAD_REQUEST:
+        sendError(connection.client, "400 Bad Request", true);
+        return false;
+      case RequestParser<>::TOO_LARGE:
+        sendError(connection.client, "413 Payload Too Large", true);
+        return false;
+      default: return false;
+    }
+  }
+
+  /// Closes a connection, freeing its slot.
+  /// \param connection the connection to close.
+  static void closeConnection(Connection &connection)
+  {
+    connection.client.stop();
+    connection.client = WiFiClient();
+    connection.body.kind = Body::NONE;
+    LOG::D("Client disconnected.");
+  }
+
+  /// Closes a connection once its backlog is sent (see serveConnection()).
+  /// \param connection the connection to close.
+  static void finishConnection(Connection &connection)
+  {
+    if (connection.client.pending() == 0)
+    {
+      closeConnection(connection);
+      return;
+    }
+    connection.closing = true;
+    connection.active_ms = millis();
+  }
+
+  /// Closes a connection that doesn't take its responses.
+  /// \param connection the connection to close.
+  static void dropConnection(Connection &connection)
+  {
+    LOG::W("Dropping slow client @ %:%",
+           connection.client.remoteIP(), connection.client.remotePort());
+    closeConnection(connection);
+  }
+
+//===-- Request handling functions ----------------------------------------===//
+
+  /// Dispatches a parsed request to the matching handler.
+  /// \param request the parsed request.
+  /// \param client the client that sent the request.
+  void handleRequest(const HttpRequest &request, WebClient &client) const
+  {
+    LOG::D("Request for %", request.path());
+
+    switch (m_router.dispatch(request, *this, client))
+    {
+      case WebRouter::HANDLED: break;
+      case WebRouter::NOT_FOUND:
+        sendError(client, "404 Not Found");
+        break;
+      case WebRouter::METHOD_NOT_ALLOWED:
+        sendError(client, "405 Method Not Allowed");
+        break;
+    }
+  }
+
+  /// Sends a response without a body.
+  /// \param client the client to send the response to.
+  /// \param status the status code and reason.
+  /// \param close whether the connection is closed after the response.
+  void sendError(WiFiClient &client,
+                 const char *status,
+                 bool close = false) const
+  {
+    if (close) m_response.setKeepAlive(false);
+    m_response.begin(client, status, nullptr);
+    m_response.end();
+  }
+
+  /// Refuses a request for lack of room, closing the connection.
+  /// \param client the client to send the response to.
+  void sendUnavailable(WiFiClient &client) const
+  {
+    m_response.setKeepAlive(false);
+    m_response.begin(client, "503 Service Unavailable", nullptr);
+    m_response.header("Retry-After", "10");
+    m_response.end();
+  }
+
+  /// Registers the built-in handlers.
+  void registerHandlers() const
+  {
+    on(HttpMethod::GET, "/",
+       [](const HttpRequest&, const WebServer &server, WebClient &client)
+       { server.sendPage(client); });
+    on(HttpMethod::GET, "/api/attributes",
+       [](const HttpRequest &request, const WebServer &server,
+          WebClient &client)
+       { server.sendAttributesJson(request, client); });
+    on(HttpMethod::GET, "/log",
+       [](const HttpRequest&, const WebServer &server, WebClient &client)
+       { server.sendLog(client); });
+    on(HttpMethod::GET, "/log/stream",
+       [](const HttpRequest&, const WebServer &server, WebClient &client)
+       { server.m_client_adopted = server.startLogStream(client); });
+    on(HttpMethod::GET, "/api/events",
+       [](const HttpRequest &request, const WebServer &server,
+          WebClient &client)
+       { server.m_client_adopted = server.startEventStream(request, client); });
+    on(HttpMethod::GET, "/api/history",
+       [](const HttpRequest &request, const WebServer &server,
+          WebClient &client)
+       { server.sendHistory(request, client); });
+    on(HttpMethod::POST, "/api/commands",
+       [](const HttpRequest &request, const WebServer &server,
+          WebClient &client)
+       { server.runCommands(request, client); });
+    on(HttpMethod::GET, "/static/*",
+       [](const HttpRequest &request, const WebServer &server,
+          WebClient &client)
+       { server.sendAsset(request, client); });
+  }
+
+  /// Runs a batch of commands (see command_batch.h), in order. A batch that
+  /// fails to parse is answered with a 400 and {"error": "..."}, nothing of
+  /// it is run. Otherwise the response is {"results": [...]}, an object with
+  /// the "op", the target and the "result" for every command: a CommandResult
+  /// name for the module commands, and "applied", "unknown attribute",
+  /// "read-only" or "wrong type" for the attributes.
+  /// \param request the request of the client.
+  /// \param client the client to send the results to.
+  void runCommands(const HttpRequest &request, WiFiClient &client) const
+  {
+    using Json = JsonWriter<ResponseWriter<WiFiClient>>;
+
+    const char *body = request.body() ? request.body() : "";
+    if (const char *error = CommandBatchParser::parse(
+          body, request.bodyLength(), m_command_batch))
+    {
+      m_response.begin(client, "400 Bad Request", "application/json");
+      Json(m_response).beginObject().key("error").value(error).endObject();
+      m_response.end();
+      return;
+    }
+
+    m_response.begin(client, "200 OK", "application/json");
+    m_response.header("Cache-Control", "no-store");
+    Json json(m_response);
+    json.beginObject().key("results").beginArray();
+    for (const RemoteCommand &command : m_command_batch)
+    {
+      const bool set = command.kind == RemoteCommand::Kind::SET;
+      json.beginObject()
+          .key("op").value(set ? "set" : COMMAND::name(command.command))
+          .key(set ? "attribute" : "module").value(command.target)
+          .key("result").value(runCommand(command))
+          .endObject();
+    }
+    json.endArray().endObject();
+    m_response.end();
+  }
+
+  /// Runs a command of a batch.
+  /// \return the name of the result.
+  const char *runCommand(const RemoteCommand &command) const
+  {
+    if (command.kind == RemoteCommand::Kind::MODULE)
+    {
+      return COMMAND::name(m_module_commands
+        ? m_module_commands(command.target, command.command)
+        : CommandResult::UNKNOWN_MODULE);
+    }
+
+    const AttributeHandle handle = m_attributes.find(command.target);
+    if (!handle) return "unknown attribute";
+    // The other attributes have a writer of their own (see AttributeStore).
+    if (!m_remote_slots[handle.index()]) return "read-only";
+
+    // Numbers are tried as the types they fit, the store checks the type.
+    const double number = command.number;
+    const bool integral = command.integral;
+    bool set = false;
+    switch (command.value)
+    {
+      case RemoteCommand::Value::TEXT:
+        set = updateAttribute(handle, command.text);
+        break;
+      case RemoteCommand::Value::BOOL:
+        set = updateBool(handle, command.flag);
+        break;
+      case RemoteCommand::Value::NUMBER:
+        set = (integral && number <= INT32_MAX &&
+               updateInteger(handle, static_cast<int32_t>(number))) ||
+              (integral && number >= 0 &&
+               updateDuration(handle, static_cast<uint32_t>(number))) ||
+              (integral && number >= 0 && number <= UINT8_MAX &&
+               updateEnum(handle, static_cast<uint8_t>(number))) ||
+              updateFloat(handle, static_cast<float>(number));
+        break;
+      default: break;
+    }
+    return set ? "applied" : "wrong type";
+  }
+
+  /// Sends an embedded asset straight from flash, still gzipped, as the
+  /// socket takes it (see BufferedClient::writeConstant()). The URLs are
+  /// versioned, so the responses are cached for a year, and revalidation
+  /// with the (strong) ETag is answered with a 304.
+  /// \param request the request of the client.
+  /// \param client the client to send the asset to.
+  void sendAsset(const HttpRequest &request, WebClient &client) const
+  {
+    const StaticAsset *asset =
+      findAsset(ASSETS::WEB_ASSETS, ASSETS::WEB_ASSET_COUNT, request.path(),
+                request.pathHash());
+    if (!asset)
+    {
+      sendError(client, "404 Not Found");
+      return;
+    }
+
+    const char *if_none_match = request.header(HttpHeader::IF_NONE_MATCH);
+    if (if_none_match && std::strcmp(if_none_match, asset->etag) == 0)
+    {
+      m_response.begin(client, "304 Not Modified", nullptr);
+      m_response.header("ETag", asset->etag);
+      m_response.header("Cache-Control", ASSET_CACHE_CONTROL);
+      m_response.end();
+      return;
+    }
+
+    // Every browser takes gzip, the device has no time to decompress.
+    const char *accept_encoding = request.header(HttpHeader::ACCEPT_ENCODING);
+    if (!accept_encoding || !std::strstr(accept_encoding, "gzip"))
+    {
+      sendError(client, "406 Not Acceptable");
+      return;
+    }
+
+    m_response.begin(client, "200 OK", asset->content_type);
+    m_response.header("Content-Encoding", "gzip");
+    m_response.header("ETag", asset->etag);
+    m_response.header("Cache-Control", ASSET_CACHE_CONTROL);
+    if (m_response.endHeaders(asset->length))
+      client.writeConstant(asset->data, asset->length);
+  }
+
+  /// Sends the history of an attribute. The query parameters are "name",
+  /// "resolution" ("raw", "1s" (default) or "10s") and "format" ("csv"
+  /// (default) or "binary").
+  /// The CSV has a "time_ms,value" header for the raw samples and a
+  /// "time_ms,min,max,mean" header for the buckets. The binary format is a
+  /// 12 byte header ("PTSH", format version, resolution, record size, record
+  /// count) followed by the records: uint32 time_ms and float32 value(s), all
+  /// little-endian. The CSV is written as the socket takes it, the binary
+  /// format at once (its record count is that of the request's time).
+  /// \param request the request of the client.
+  /// \param client the client to send the history to.
+  void sendHistory(const HttpRequest &request, WiFiClient &client) const
+  {
+    char name[sizeof(Attributes::View::name)];
+    char resolution_text[4] = "1s";
+    char format[8] = "csv";
+    request.queryParam("resolution", resolution_text, sizeof(resolution_text));
+    request.queryParam("format", format, sizeof(format));
+
+    const AttributeHandle handle =
+      request.queryParam("name", name, sizeof(name))
+        ? m_attributes.find(name) : AttributeHandle();
+    const int8_t history =
+      handle ? m_history_slots[handle.index()].load() : NO_HISTORY;
+    if (history == NO_HISTORY)
+    {
+      sendError(client, "404 Not Found");
+      return;
+    }
+
+    History::Resolution resolution;
+    if (std::strcmp(resolution_text, "raw") == 0)
+      resolution = History::RAW;
+    else if (std::strcmp(resolution_text, "1s") == 0)
+      resolution = History::SECOND;
+    else if (std::strcmp(resolution_text, "10s") == 0)
+      resolution = History::TEN_SECONDS;
+    else
+    {
+      sendError(client, "400 Bad Request");
+      return;
+    }
+
+    // Samples queued before the request are part of the answer.
+    recordHistories();
+    const History &series = m_histories[history];
+    if (std::strcmp(format, "binary") == 0)
+    {
+      m_response.begin(client, "200 OK", "application/octet-stream");
+      m_response.header("Cache-Control", "no-store");
+      writeHistoryBinary(series, resolution);
+    }
+    else if (std::strcmp(format, "csv") == 0)
+    {
+      m_response.begin(client, "200 OK", "text/csv; charset=utf-8");
+      m_response.header("Cache-Control", "no-store");
+      m_response.print(resolution == History::RAW ? "time_ms,value\n"
+                                                  : "time_ms,min,max,mean\n");
+      m_body = Body();
+      m_body.kind = Body::HISTORY;
+      m_body.history = static_cast<uint8_t>(history);
+      m_body.resolution = resolution;
+      m_body.end_ms = millis();
+      return;
+    }
+    else
+    {
+      sendError(client, "400 Bad Request");
+      return;
+    }
+    m_response.end();
+  }
+
+  /// Writes the next lines of a CSV history while the socket takes them,
+  /// see sendHistory(). The lines are found again by their time, the series
+  /// may have moved on meanwhile.
+  /// \return true, if the history is finished, false otherwise.
+  bool continueHistory(Connection &connection) const
+  {
+    Body &body = connection.body;
+    const uint32_t after_ms = body.time_ms;
+    const uint16_t after_count = body.at_time;
+    uint16_t skipped = 0;
+    bool finished = true;
+    char line[64];
+    m_histories[body.history].forEachBucket(body.resolution,
+      [&](const History::Bucket &bucket)
+    {
+      if (!finished) return;
+      // Skip what was written before, and what came after the request.
+      const int32_t age = static_cast<int32_t>(bucket.time_ms - after_ms);
+      if (after_count != 0 && (age < 0 || (age == 0 &&
+                                           skipped++ < after_count)))
+        return;
+      if (static_cast<int32_t>(bucket.time_ms - body.end_ms) > 0) return;
+      if (connection.client.pending() != 0)
+      {
+        finished = false;
+        return;
+      }
+
+      if (body.at_time != 0 && bucket.time_ms == body.time_ms)
+        body.at_time++;
+      else
+      {
+        body.time_ms = bucket.time_ms;
+        body.at_time = 1;
+      }
+      if (body.resolution == History::RAW)
+        std::snprintf(line, sizeof(line), "%lu,%g\n",
+                      static_cast<unsigned long>(bucket.time_ms),
+                      static_cast<double>(bucket.min));
+      else
+        std::snprintf(line, sizeof(line), "%lu,%g,%g,%g\n",
+                      static_cast<unsigned long>(bucket.time_ms),
+                      static_cast<double>(bucket.min),
+                      static_cast<double>(bucket.max),
+                      static_cast<double>(bucket.mean));
+      m_response.print(line);
+    });
+    return finished;
+  }
+
+  /// Writes a history in the packed binary format into the response, see
+  /// sendHistory().
+  void writeHistoryBinary(const History &series,
+                          History::Resolution resolution) const
+  {
+    const bool raw = resolution == History::RAW;
+    const uint32_t count = series.size(resolution);
+    const uint8_t header[12] = {'P', 'T', 'S', 'H',
+                                HISTORY_FORMAT_VERSION,
+                                static_cast<uint8_t>(resolution),
+                                static_cast<uint8_t>(raw ? 8 : 16), 0,
+                                static_cast<uint8_t>(count),
+                                static_cast<uint8_t>(count >> 8),
+                                static_cast<uint8_t>(count >> 16),
+                                static_cast<uint8_t>(count >> 24)};
+    m_response.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    if (raw)
+    {
+      series.forEachSample([&](const History::Sample &sample)
+      {
+        char record[8];
+        packLittleEndian(record, sample.time_ms);
+        packLittleEndian(record + 4, AttributeValue::floatBits(sample.value));
+        m_response.write(record, sizeof(record));
+      });
+      return;
+    }
+
+    series.forEachBucket(resolution, [&](const History::Bucket &bucket)
+    {
+      char record[16];
+      packLittleEndian(record, bucket.time_ms);
+      packLittleEndian(record + 4, AttributeValue::floatBits(bucket.min));
+      packLittleEndian(record + 8, AttributeValue::floatBits(bucket.max));
+      packLittleEndian(record + 12, AttributeValue::floatBits(bucket.mean));
+      m_response.write(record, sizeof(record));
+    });
+  }
+
+  /// Stores a 32 bit value little-endian.
+  static void packLittleEndian(char *out, uint32_t value)
+  {
+    for (size_t idx = 0; idx != 4; idx++)
+      out[idx] = static_cast<char>(value >> (8 * idx));
+  }
+
+  /// Sends the attribute table page, its rows as the socket takes them.
+  /// \param client the client to send the page to.
+  void sendPage(WiFiClient &client) const
+  {
+    m_response.begin(client, "200 OK");
+    // The rows are at least as new as the snapshot (see continueBody()).
+    PAGE::renderAttributesHead(m_response, m_attributes.snapshot().version(),
+                               client.remoteIP().toString().c_str(),
+                               client.remotePort());
+    m_body = Body();
+    m_body.kind = Body::PAGE;
+  }
+
+  /// Sends the attributes as JSON, only the ones modified after the version
+  /// given in the "since" query parameter if there is one:
+  /// {"version":V,"full":F,"attributes":{"name":{"value":"...",
+  /// "description":"...","version":N},...}}
+  /// If "full" is false, the attributes are a delta to the previous fetch.
+  /// The ETag is the global version, unchanged polls get a 304 response.
+  /// \param request the request of the client.
+  /// \param client the client to send the attributes to.
+  void sendAttributesJson(const HttpRequest &request, WiFiClient &client) const
+  {
+    char since_text[12];
+    const bool delta =
+      request.queryParam("since", since_text, sizeof(since_text));
+    const uint32_t since = delta ? std::strtoul(since_text, nullptr, 10) : 0;
+
+    // Answering an unchanged poll needs no rendering (and the snapshot of an
+    // unchanged version is shared).
+    const Attributes::Snapshot snapshot = m_attributes.snapshot();
+    const uint32_t version = snapshot.version();
+    char etag[16];
+    formatETag(etag, version);
+    const char *if_none_match = request.header(HttpHeader::IF_NONE_MATCH);
+    if ((if_none_match && std::strcmp(if_none_match, etag) == 0) ||
+        (delta && since == version))
+    {
+      m_response.begin(client, "304 Not Modified", nullptr);
+      m_response.header("ETag", etag);
+      m_response.end();
+      return;
+    }
+
+    m_response.begin(client, "200 OK", "application/json");
+    m_response.header("ETag", etag);
+    m_response.header("Cache-Control", "no-cache");
+    m_body = Body();
+    m_body.kind = Body::ATTRIBUTES;
+    m_body.first = true;
+    m_body.since = writeAttributesHead(m_response, snapshot,
+                                       delta ? since : 0);
+  }
+
+  /// Writes the attributes of a snapshot modified after a version as JSON,
+  /// see sendAttributesJson() for the format.
+  /// \tparam TARGET the type of the target written to.
+  /// \param target the target to write the JSON to.
+  /// \param snapshot the attributes to be written.
+  /// \param since the version of the previous fetch, 0 for every attribute.
+  /// \param descriptions whether delta entries have descriptions (the full
+  /// ones always do).
+  template<typename TARGET>
+  static void writeAttributesJson(TARGET &target,
+                                  const Attributes::Snapshot &snapshot,
+                                  uint32_t since,
+                                  bool descriptions)
+  {
+    const uint32_t newer = writeAttributesHead(target, snapshot, since);
+    bool first = true;
+    snapshot.forEach(newer, [&](const Attributes::View &attribute)
+    {
+      writeAttribute(target, attribute, first, newer == 0 || descriptions);
+      first = false;
+    });
+    target.write("}}", 2);
+  }
+
+  /// Writes the JSON of the attributes up to the first attribute, see
+  /// writeAttributesJson().
+  /// \return the version the attributes to be written are newer than, 0 for
+  /// every attribute (if the JSON is full).
+  template<typename TARGET>
+  static uint32_t writeAttributesHead(TARGET &target,
+                                      const Attributes::Snapshot &snapshot,
+                                      uint32_t since)
+  {
+    const uint32_t version = snapshot.version();
+    const bool full = since == 0 || since < snapshot.deletedVersion() ||
+                      since > version;
+
+    JsonWriter<TARGET> json(target);
+    json.beginObject()
+        .key("version").value(version)
+        .key("full").value(full)
+        .key("attributes").beginObject();
+    return full ? 0 : since;
+  }
+
+  /// Writes an attribute of the JSON of the attributes (the JSON is closed
+  /// with "}}" after the last one).
+  /// \param first whether it is the first attribute written.
+  /// \param description whether the description is written.
+  template<typename TARGET>
+  static void writeAttribute(TARGET &target,
+                             const Attributes::View &attribute,
+                             bool first,
+                             bool description)
+  {
+    if (!first) target.write(",", 1);
+    JsonWriter<TARGET> json(target);
+    json.key(attribute.name).beginObject()
+        .key("value").value(attribute.value);
+    if (description) json.key("description").value(attribute.description);
+    json.key("version").value(attribute.version)
+        .endObject();
+  }
+
+  /// Writes the next rows of the page or attributes of the JSON while the
+  /// socket takes them. Every pass reads a fresh snapshot, continuing at the
+  /// next slot: the attributes are at least as new as the version the body
+  /// announced, so a delta from it misses nothing.
+  /// \return true, if every attribute is written, false otherwise.
+  bool continueAttributes(Connection &connection) const
+  {
+    Body &body = connection.body;
+    bool finished = true;
+    m_attributes.snapshot().forEach(body.since,
+      [&](const Attributes::View &attribute)
+    {
+      if (!finished || attribute.slot < body.slot) return;
+      if (connection.client.pending() != 0)
+      {
+        finished = false;
+        return;
+      }
+
+      body.slot = attribute.slot + 1;
+      if (body.kind == Body::PAGE)
+        PAGE::renderAttributeRow(m_response, attribute);
+      else
+        writeAttribute(m_response, attribute, body.first, true);
+      body.first = false;
+    });
+    return finished;
+  }
+
+  /// Writes the next parts of the body of a connection while its socket
+  /// takes them right away, then finishes the response, or suspends it
+  /// until the socket has taken what is sent (see serveConnection()). A part
+  /// fills the writer's buffer at most once, so the backlog never holds more
+  /// than a flushed buffer and a part (see MAX_BODY_PART).
+  /// \param connection the connection, its response is the current one of
+  /// the writer (started or resumed).
+  /// \return true, if the body is finished, false otherwise.
+  bool continueBody(Connection &connection) const
+  {
+    Body &body = connection.body;
+    bool finished = true;
+    switch (body.kind)
+    {
+      case Body::PAGE:
+      case Body::ATTRIBUTES:
+        finished = continueAttributes(connection);
+        break;
+      case Body::HISTORY: finished = continueHistory(connection); break;
+      case Body::LOG: finished = continueLog(connection); break;
+      default: break;
+    }
+    // The end waits for room too, the backlog holds one flush at most.
+    if (!finished || connection.client.pending() != 0)
+    {
+      m_response.suspend();
+      return false;
+    }
+
+    if (body.kind == Body::PAGE) PAGE::renderAttributesTail(m_response);
+    if (body.kind == Body::ATTRIBUTES) m_response.print("}}");
+    m_response.end();
+    body.kind = Body::NONE;
+    return true;
+  }
+
+  /// Stores a typed value, and queues it to the history of the attribute if
+  /// it changed and has one.
+  /// \return false, if the handle is invalid or of another type, true
+  /// otherwise.
+  bool setTyped(AttributeHandle handle,
+                AttributeType type,
+                uint32_t raw,
+                float value) const
+  {
+    bool changed;
+    if (!m_attributes.set(handle, type, raw, &changed)) return false;
+
+    if (changed)
+    {
+      const int8_t history = m_history_slots[handle.index()];
+      // A full queue loses the sample, the updating task never waits.
+      if (history != NO_HISTORY)
+        m_history_queue.push({static_cast<uint8_t>(history), false,
+                              static_cast<uint32_t>(millis()), value});
+    }
+    return true;
+  }
+
+  /// Records the queued samples into the histories (server task only).
+  void recordHistories() const
+  {
+    HistorySample sample;
+    while (m_history_queue.pop(sample))
+    {
+      History &series = m_histories[sample.history];
+      if (sample.reset)
+        series.clear();
+      else
+        series.add(sample.time_ms, sample.value);
+    }
+  }
+
+  /// Formats the ETag of an attribute version.
+  /// \param out the buffer receiving the zero terminated ETag (16 bytes).
+  /// \param version the attribute version.
+  static void formatETag(char *out, uint32_t version)
+  {
+    std::snprintf(out, 16, "\"%lu\"", static_cast<unsigned long>(version));
+  }
+
+  /// Sends the whole content of the log ring, as the socket takes it.
+  /// \param client the client to send the log to.
+  void sendLog(WiFiClient &client) const
+  {
+    m_response.begin(client, "200 OK", "text/plain; charset=utf-8");
+    m_response.header("Cache-Control", "no-store");
+    m_body = Body();
+    m_body.kind = Body::LOG;
+    m_body.cursor = LOG::ring().tail(LOG_RING_SIZE);
+    // Only send what was there at the time of the request.
+    m_body.end = LOG::ring().newest();
+  }
+
+  /// Writes the next chunks of the log while the socket takes them, see
+  /// sendLog(). The part the ring has overwritten meanwhile is left out.
+  /// \return true, if the log is finished, false otherwise.
+  bool continueLog(Connection &connection) const
+  {
+    Body &body = connection.body;
+    char buffer[LOG_CHUNK_SIZE];
+    while (static_cast<LOG::Ring::Cursor>(body.end - body.cursor) != 0 &&
+           static_cast<LOG::Ring::Cursor>(body.end - body.cursor) <=
+             LOG_RING_SIZE)
+    {
+      if (connection.client.pending() != 0) return false;
+
+      const size_t max_length = std::min<size_t>(sizeof(buffer),
+        static_cast<LOG::Ring::Cursor>(body.end - body.cursor));
+      const size_t length = LOG::ring().read(body.cursor, buffer, max_length);
+      m_response.write(buffer, length);
+    }
+    return true;
+  }
+
+  /// Hands a client over to the log pump, starting from the recent output.
+  /// The headers are sent by the pump too.
+  /// \param client the client to stream the log to.
+  /// \return false, if there are too many streaming clients (or responses
+  /// to the client are still waiting), true otherwise.
+  bool startLogStream(WebClient &client) const
+  {
+    // A stream takes the socket over, responses waiting for it would be lost.
+    for (auto &log_client : m_log_clients)
+    {
+      if (client.pending() == 0 && !log_client.client.connected())
+      {
+        log_client.client.stop();
+        log_client.client = client;
+        log_client.cursor = LOG::ring().tail(LOG_RING_SIZE);
+        log_client.headers_sent = 0;
+        LOG::D("Client streaming the log @ %:%",
+               client.remoteIP(), client.remotePort());
+        return true;
+      }
+    }
+
+    sendUnavailable(client);
+    return false;
+  }
+
+  /// Sends the new log output to every streaming client, as far as their
+  /// sockets take it right away. What a socket doesn't take is read from the
+  /// ring again on the next pass (or missed, if the ring moved past it).
+  void pumpLogClients() const
+  {
+    char buffer[LOG_CHUNK_SIZE];
+    for (auto &log_client : m_log_clients)
     {
-      LOG::D("New client connected @ %:%", client.remoteIP(), client.remotePort());
-      String current_line = "";
+      if (!log_client.client.connected())
+      {
+        log_client.client.stop();
+        continue;
+      }
 
-      while (client.connected())
+      const int fd = log_client.client.fd();
+      const size_t headers_length = sizeof(LOG_STREAM_HEADERS) - 1;
+      if (log_client.headers_sent != headers_length)
       {
-        if (client.available())
+        const ssize_t sent =
+          sendNow(fd, LOG_STREAM_HEADERS + log_client.headers_sent,
+                  headers_length - log_client.headers_sent);
+        if (sent < 0) log_client.client.stop();
+        else log_client.headers_sent += static_cast<size_t>(sent);
+        continue;
+      }
+
+      const size_t length =
+        LOG::ring().read(log_client.cursor, buffer, sizeof(buffer));
+      const ssize_t sent = sendNow(fd, buffer, length);
+      if (sent < 0)
+        log_client.client.stop();
+      else
+        log_client.cursor -= static_cast<LOG::Ring::Cursor>(
+          length - static_cast<size_t>(sent));
+    }
+  }
+
+  /// Hands a client over to the event pump. The stream resumes after the
+  /// version in the Last-Event-ID header or the "since" query parameter, and
+  /// starts with every attribute without either.
+  /// \param request the request of the client.
+  /// \param client the client to send the events to.
+  /// \return false, if there are too many subscribed clients (or responses
+  /// to the client are still waiting, or its connection failed), true
+  /// otherwise.
+  bool startEventStream(const HttpRequest &request, WebClient &client) const
+  {
+    static constexpr char HEADERS[] = "HTTP/1.1 200 OK\r\n"
+                                      "Content-Type: text/event-stream\r\n"
+                                      "Cache-Control: no-store\r\n"
+                                      "Connection: close\r\n"
+                                      "\r\n"
+                                      "retry: 2000\n\n";
+
+    char since_text[12] = "0";
+    const char *last_event_id = request.header(HttpHeader::LAST_EVENT_ID);
+    if (last_event_id)
+      std::snprintf(since_text, sizeof(since_text), "%s", last_event_id);
+    else
+      request.queryParam("since", since_text, sizeof(since_text));
+
+    // A stream takes the socket over, responses waiting for it would be lost.
+    for (auto &event_client : m_event_clients)
+    {
+      if (client.pending() == 0 && !event_client.client.connected())
+      {
+        event_client.client.stop();
+        // The part of the headers the socket doesn't take leads the queue.
+        const size_t length = sizeof(HEADERS) - 1;
+        const ssize_t sent = sendNow(client.fd(), HEADERS, length);
+        // A failed connection is refused (and closed) like a surplus one.
+        if (sent < 0) break;
+        event_client.client = client;
+        event_client.version = std::strtoul(since_text, nullptr, 10);
+        event_client.queued_ms = millis();
+        event_client.queue.clear();
+        event_client.queue.write(HEADERS + sent,
+                                 length - static_cast<size_t>(sent));
+        LOG::D("Client subscribed to events @ %:%",
+               client.remoteIP(), client.remotePort());
+        // The first frame goes out right away.
+        m_event_ms = millis() - EVENT_INTERVAL_MS;
+        return true;
+      }
+    }
+
+    sendUnavailable(client);
+    return false;
+  }
+
+  /// Queues the attribute changes to every subscribed client once per
+  /// interval, and sends as much of the queues as the sockets take without
+  /// blocking. All the changes within an interval go out as one frame.
+  void pumpEventClients() const
+  {
+    const uint32_t now = millis();
+    if (now - m_event_ms >= EVENT_INTERVAL_MS)
+    {
+      m_event_ms = now;
+      queueEvents(now);
+    }
+
+    for (auto &event_client : m_event_clients)
+    {
+      if (!event_client.client.connected())
+      {
+        event_client.client.stop();
+        continue;
+      }
+      if (!flushEvents(event_client)) dropEventClient(event_client);
+    }
+  }
+
+  /// Queues a frame to every client behind the current version. Clients at
+  /// the same version share the rendered frame.
+  /// \param now the current time in milliseconds.
+  void queueEvents(uint32_t now) const
+  {
+    const Attributes::Snapshot snapshot = m_attributes.snapshot();
+    const uint32_t version = snapshot.version();
+    for (size_t idx = 0; idx != MAX_EVENT_CLIENTS; idx++)
+    {
+      EventClient &event_client = m_event_clients[idx];
+      if (!event_client.client.connected()) continue;
+
+      if (event_client.version == version)
+      {
+        if (now - event_client.queued_ms >= EVENT_KEEP_ALIVE_MS)
         {
-          char c = client.read();
-
-          if (c == '\n')
-          {
-            if (current_line.length() == 0) {
-            std::lock_guard<std::mutex> lock(m_attributes_lock);
-
-              client.println("HTTP/1.1 200 OK");
-              client.println("Content-type:text/html");
-              client.println("Connection: close");
-              client.println();
-
-              client.println("<!DOCTYPE html><html>");
-              client.println("<head>");
-              client.println("<title>Title of the document</title>");
-              client.println("<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">");
-              client.println("<style>body{font-family:Arial;background-color:#2c3e50;color:#ecf0f1;}table{font-size:3vw;text-align:center;}th{font-weight:bold;}td{font-weight:normal;padding:1vw;border-top:solid#ecf0f1;}</style>");
-              client.println("</head>");
-              client.println("<body>");
-              client.println("<h1>PTS Web Server</h1>");
-              client.print("<p>You are connected on ");
-              client.print(client.remoteIP());
-              client.print(":");
-              client.print( client.remotePort());
-              client.println("</p>");
-              client.print("<h2>Registered attributes:<h2>");
-              client.println("<table>");
-              client.println("<tr><th>Name</th><th>Value</th><th>Description</th></tr>");
-              for (auto attribute : m_attributes)
-              {
-                client.print("<tr>");
-                client.print("<td>");
-                client.print(attribute.first.c_str());
-                client.print("</td>");
-                client.print("<td>");
-                client.print(attribute.second.first.c_str());
-                client.print("</td>");
-                client.print("<td>");
-                client.print(attribute.second.second.c_str());
-                client.print("</td>");
-                client.println("</tr>");
-              }
-              client.println("</table>");
-              client.println("</body>");
-              client.println("</html>");
-              client.println();
-
-              break;
-            }
-            else 
-            {
-              current_line = "";
-            }
-          }
-          else if (c != '\r')
-          {
-            current_line += c;
-          }
+          event_client.queued_ms = now;
+          if (!event_client.queue.print(": keep-alive\n\n"))
+            dropEventClient(event_client);
         }
+        continue;
       }
 
-      client.stop();
-      LOG::D("Client disconnected.");
+      const uint32_t since = event_client.version;
+      renderEvent(snapshot, since);
+      for (size_t other = idx; other != MAX_EVENT_CLIENTS; other++)
+      {
+        EventClient &receiver = m_event_clients[other];
+        if (!receiver.client.connected() || receiver.version != since)
+          continue;
+
+        receiver.version = version;
+        receiver.queued_ms = now;
+        if (!receiver.queue.write(m_event_frame.data(), m_event_frame.size()))
+          dropEventClient(receiver);
+      }
     }
   }
 
+  /// Renders the frame of the attributes modified after a version into the
+  /// shared frame buffer: "id: V\ndata: {JSON}\n\n". If the attributes don't
+  /// fit, a "reset" event tells the client to fetch them from /api/attributes.
+  /// \param snapshot the attributes to be sent.
+  /// \param since the version the client has been sent.
+  void renderEvent(const Attributes::Snapshot &snapshot, uint32_t since) const
+  {
+    char id[24];
+    std::snprintf(id, sizeof(id), "id: %lu\n",
+                  static_cast<unsigned long>(snapshot.version()));
+
+    m_event_frame.clear();
+    m_event_frame.print(id);
+    m_event_frame.print("data: ");
+    writeAttributesJson(m_event_frame, snapshot, since, false);
+    m_event_frame.print("\n\n");
+
+    if (m_event_frame.overflowed())
+    {
+      m_event_frame.clear();
+      m_event_frame.print(id);
+      m_event_frame.print("event: reset\ndata: {}\n\n");
+    }
+  }
+
+  /// Sends the queue of a client as far as the socket takes it right away.
+  /// \param event_client the client to send the queued frames to.
+  /// \return false, if the connection failed, true otherwise.
+  static bool flushEvents(EventClient &event_client)
+  {
+    const ssize_t sent = sendNow(event_client.client.fd(),
+                                 event_client.queue.data(),
+                                 event_client.queue.size());
+    if (sent < 0) return false;
+
+    event_client.queue.consume(static_cast<size_t>(sent));
+    return true;
+  }
+
+  /// Disconnects a client that fell behind or failed.
+  /// \param event_client the client to disconnect.
+  static void dropEventClient(EventClient &event_client)
+  {
+    LOG::W("Dropping slow event client @ %:%",
+           event_client.client.remoteIP(), event_client.client.remotePort());
+    event_client.client.stop();
+    event_client.queue.clear();
+  }
+
+//===-- Send budget -------------------------------------------------------===//
+
+  /// The response writer of the server.
+  using Response = ResponseWriter<WiFiClient>;
+  /// The most a part of a body written as the socket takes it adds to the
+  /// response: a log chunk, or a row of the page with every character
+  /// escaped (to an entity of up to 6 characters).
+  static constexpr size_t MAX_BODY_PART = std::max<size_t>(LOG_CHUNK_SIZE,
+    6 * (2 * sizeof(Attributes::View::name) +
+         sizeof(Attributes::View::value) +
+         sizeof(Attributes::View::description)) + 64);
+  static_assert(Response::BODY_BUFFER_SIZE + Response::MAX_OVERHEAD +
+                MAX_BODY_PART <= WEB_SEND_BACKLOG,
+                "A flushed buffer and a part of a body must fit the backlog.");
+  /// The longest binary history, written at once (see writeHistoryBinary()).
+  static constexpr size_t MAX_HISTORY_BINARY = 12 + 16 * History::MAX_ENTRIES;
+  /// The longest results of "/api/commands", written at once: the target is
+  /// the only text of a result that isn't constant, and is escaped to twice
+  /// its length at most (see CommandBatchParser).
+  static constexpr size_t MAX_COMMAND_RESULTS =
+    32 + CommandBatch::MAX_COMMANDS * (64 + 2 * RemoteCommand::TARGET_SIZE);
+  static_assert(std::max(MAX_HISTORY_BINARY, MAX_COMMAND_RESULTS) +
+                2 * Response::MAX_OVERHEAD <= WEB_SEND_BACKLOG,
+                "The bodies written at once must fit into the backlog.");
+
  private:
   mutable WiFiServer wifi_server;
   mutable IPAddress ip_address;
-  mutable std::map<std::string, std::pair<std::string, std::string>> m_attributes;
-  mutable std::mutex m_attributes_lock;
+  mutable Attributes m_attributes;
+  mutable std::array<Connection, MAX_CONNECTIONS> m_connections;
+  mutable bool m_connections_waiting;
+  mutable WebRouter m_router;
+  mutable ResponseWriter<WiFiClient> m_response;
+  mutable bool m_client_adopted;
+  /// The body started by the handler of the current request.
+  mutable Body m_body;
+  mutable std::array<LogClient, MAX_LOG_CLIENTS> m_log_clients;
+  mutable std::array<EventClient, MAX_EVENT_CLIENTS> m_event_clients;
+  mutable ByteBuffer<EVENT_QUEUE_SIZE> m_event_frame;
+  mutable uint32_t m_event_ms;
+  mutable std::array<History, MAX_HISTORIES> m_histories;
+  /// The history slot of every attribute slot, NO_HISTORY for none.
+  mutable std::array<std::atomic<int8_t>, WEB_MAX_ATTRIBUTES> m_history_slots;
+  /// Whether every attribute slot is set with "/api/commands" (see
+  /// registerAttribute()).
+  mutable std::array<std::atomic<bool>, WEB_MAX_ATTRIBUTES> m_remote_slots;
+  mutable MpscQueue<HistorySample, HISTORY_QUEUE_SIZE> m_history_queue;
+  /// The batch of the running "/api/commands" request.
+  mutable CommandBatch m_command_batch;
+  mutable ModuleCommandHandler m_module_commands;
 }; // class WebServer
 
 } // namesapce PTS
@@ -19,6 +19,7 @@
 
 #include <Arduino.h>
 #include <optional>
+#include "io_pin.h"
 
 namespace PTS
 {
@@ -48,7 +49,9 @@ class Button
 
 //===-- Instantiation specific functions ----------------------------------===//
 
-  explicit Button(const uint8_t pin)
+  /// \param pin a GPIO pin, or a line of an I/O expander (read by its last
+  /// scan).
+  explicit Button(const IoPin pin)
   : c_pin(pin),
     m_state(LOW),
     m_delay_until(0),
@@ -61,7 +64,7 @@ class Button
   /// Sets up the communication pin and reads the beginning state.
   void begin() const
   {
-    pinMode(c_pin, INPUT);
+    c_pin.mode(INPUT);
     readNewState();
   }
   
@@ -73,7 +76,7 @@ class Button
   uint8_t readNewState() const
   {
     if (::millis() >= m_delay_until)
-      m_state = digitalRead(c_pin);
+      m_state = c_pin.read();
 
     return m_state;
   }
@@ -154,8 +157,8 @@ class Button
 //===-- Member variables --------------------------------------------------===//
 
  private:
-  /// The connected gpio pin.
-  const uint8_t c_pin;
+  /// The connected gpio pin or expander line.
+  const IoPin c_pin;
   /// The buttons state.
   mutable uint8_t m_state;
   /// The time until the software delay should last.
@@ -0,0 +1,74 @@
+//===-- utils/hw/input_frame.h - InputFrame class definition --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the InputFrame class, which
+/// captures the levels of every input pin at once, the counterpart of
+/// OutputFrame.
+///
+/// A capture reads the two GPIO input registers (pins 0-31 and 32-39), so
+/// any number of pins is read with two loads instead of a digitalRead() per
+/// pin, and all of them at the same instant. The lines of I/O expanders are
+/// read from their backend's last scan (see io_pin.h), which is batched
+/// already.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_INPUT_FRAME_H
+#define UTILS_HW_INPUT_FRAME_H
+
+#include <cstdint>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+#include "io_pin.h"
+
+namespace PTS
+{
+
+/// InputFrame class
+class InputFrame
+{
+ public:
+  /// The number of GPIO pins.
+  static constexpr uint8_t PIN_COUNT = 40;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit constexpr InputFrame() : m_levels(0) { }
+
+//===-- Modifier functions ------------------------------------------------===//
+
+  /// Reads the levels of every GPIO pin.
+  void capture()
+  {
+    m_levels = REG_READ(GPIO_IN_REG) |
+               static_cast<uint64_t>(REG_READ(GPIO_IN1_REG) & 0xFF) << 32;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the level of a pin at the capture, or of an expander line at
+  /// its backend's last scan.
+  [[nodiscard]] int read(const IoPin &pin) const
+  {
+    if (!pin.native()) return pin.read();
+    if (pin.line() >= PIN_COUNT) return LOW;
+    return (m_levels >> pin.line()) & 1 ? HIGH : LOW;
+  }
+
+  /// \return the levels captured, a bit per pin.
+  [[nodiscard]] uint64_t levels() const { return m_levels; }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  uint64_t m_levels;
+}; // class InputFrame
+
+} // namespace PTS
+
+#endif // UTILS_HW_INPUT_FRAME_H
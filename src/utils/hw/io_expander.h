@@ -0,0 +1,298 @@
+//===-- utils/hw/io_expander.h - I/O expander class definitions -----------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ShiftRegisterChain and
+/// Mcp23017 classes, which are pin backends (see io_pin.h) for I/O expander
+/// chips, to have more lines than the GPIO of the ESP32.
+///
+/// ShiftRegisterChain drives 74HC165 (input) and 74HC595 (output) chains on
+/// an SPI bus, both shifted by the same transfer. Mcp23017 drives an MCP23017
+/// 16 line expander on an I2C bus, reading its ports with one transaction,
+/// and writing its output latches with one more when they change.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_IO_EXPANDER_H
+#define UTILS_HW_IO_EXPANDER_H
+
+#include <array>
+#include <mutex>
+#include <SPI.h>
+#include <Wire.h>
+#include "io_pin.h"
+#include "utils/sw/log.h"
+
+namespace PTS
+{
+
+/// ShiftRegisterChain class
+/// Input line i is pin D(i % 8) of the (i / 8)th 74HC165 from MISO, output
+/// line i is pin Q(i % 8) of the (i / 8)th 74HC595 from MOSI. The modes of
+/// the lines are fixed.
+/// \tparam INPUT_BYTES the number of 74HC165s.
+/// \tparam OUTPUT_BYTES the number of 74HC595s.
+template<size_t INPUT_BYTES, size_t OUTPUT_BYTES>
+class ShiftRegisterChain : public PinBackend
+{
+  static_assert(INPUT_BYTES + OUTPUT_BYTES != 0, "An empty chain.");
+  static_assert(INPUT_BYTES * 8 <= 256 && OUTPUT_BYTES * 8 <= 256,
+                "Lines are numbered with a byte.");
+
+  /// The bytes of a scan, the longer chain is shifted through.
+  static constexpr size_t LENGTH =
+    INPUT_BYTES > OUTPUT_BYTES ? INPUT_BYTES : OUTPUT_BYTES;
+
+//===-- Instantiation specific functions ----------------------------------===//
+ public:
+  /// \param load_pin the SH/LD pin of the 74HC165s (loading while low).
+  /// \param latch_pin the RCLK pin of the 74HC595s (latching on rising).
+  /// \param clock_hz the SPI clock.
+  explicit ShiftRegisterChain(SPIClass &spi, uint8_t load_pin,
+                              uint8_t latch_pin, uint32_t clock_hz = 5000000)
+  : c_spi(spi),
+    c_load_pin(load_pin),
+    c_latch_pin(latch_pin),
+    c_clock_hz(clock_hz),
+    m_lock(),
+    m_inputs(),
+    m_outputs(),
+    m_dirty(true)
+  { }
+
+  /// Sets up the control pins and scans the chain (clearing the outputs).
+  void begin() const override
+  {
+    pinMode(c_load_pin, OUTPUT);
+    digitalWrite(c_load_pin, HIGH);
+    pinMode(c_latch_pin, OUTPUT);
+    digitalWrite(c_latch_pin, LOW);
+    scan();
+  }
+
+//===-- Pin backend functions ---------------------------------------------===//
+
+  /// Shifts the outputs in and the inputs out with a single transfer, or
+  /// does nothing for an output only chain without changes.
+  void scan() const override
+  {
+    std::array<uint8_t, LENGTH> out{};
+    std::array<uint8_t, LENGTH> in{};
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (INPUT_BYTES == 0 && !m_dirty) return;
+      // The first bytes sent pass through the chain, the last stays nearest.
+      for (size_t reg = 0; reg != OUTPUT_BYTES; reg++)
+        out[LENGTH - 1 - reg] = m_outputs[reg];
+      m_dirty = false;
+    }
+
+    digitalWrite(c_load_pin, LOW);
+    digitalWrite(c_load_pin, HIGH);
+    c_spi.beginTransaction(SPISettings(c_clock_hz, SPI_MSBFIRST, SPI_MODE0));
+    c_spi.transferBytes(out.data(), in.data(), LENGTH);
+    c_spi.endTransaction();
+    digitalWrite(c_latch_pin, HIGH);
+    digitalWrite(c_latch_pin, LOW);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (size_t reg = 0; reg != INPUT_BYTES; reg++) m_inputs[reg] = in[reg];
+  }
+
+  /// The lines are inputs or outputs by the chip.
+  void mode(uint8_t, uint8_t) const override { }
+
+  [[nodiscard]] int read(uint8_t line) const override
+  {
+    if (line >= INPUT_BYTES * 8) return LOW;
+    std::lock_guard<std::mutex> lock(m_lock);
+    return (m_inputs[line / 8] >> (line % 8)) & 1 ? HIGH : LOW;
+  }
+
+  void write(uint8_t line, uint8_t level) const override
+  {
+    if (line >= OUTPUT_BYTES * 8) return;
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint8_t bit = static_cast<uint8_t>(1 << (line % 8));
+    const uint8_t old = m_outputs[line / 8];
+    m_outputs[line / 8] = level ? old | bit : old & ~bit;
+    m_dirty |= m_outputs[line / 8] != old;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  SPIClass &c_spi;
+  const uint8_t c_load_pin;
+  const uint8_t c_latch_pin;
+  const uint32_t c_clock_hz;
+  /// Guards the images, used by other tasks between scans.
+  mutable std::mutex m_lock;
+  mutable std::array<uint8_t, INPUT_BYTES> m_inputs;
+  mutable std::array<uint8_t, OUTPUT_BYTES> m_outputs;
+  /// Set when the outputs changed since the last scan.
+  mutable bool m_dirty;
+}; // class ShiftRegisterChain
+
+/// Mcp23017 class
+/// Lines 0 to 7 are port A, lines 8 to 15 port B. The lines are inputs
+/// until set up otherwise.
+class Mcp23017 : public PinBackend
+{
+  /// The registers used, in the default (IOCON.BANK = 0) layout.
+  static constexpr uint8_t IODIRA = 0x00;
+  static constexpr uint8_t GPPUA = 0x0C;
+  static constexpr uint8_t GPIOA = 0x12;
+  static constexpr uint8_t OLATA = 0x14;
+
+//===-- Instantiation specific functions ----------------------------------===//
+ public:
+  static constexpr uint8_t LINE_COUNT = 16;
+
+  /// \param address the address of the chip, 0x20 to 0x27 by its pins.
+  explicit Mcp23017(TwoWire &wire, uint8_t address = 0x20)
+  : c_wire(wire),
+    c_address(address),
+    m_lock(),
+    m_directions(0xFFFF),
+    m_pullups(0),
+    m_inputs(0),
+    m_outputs(0),
+    m_dirty_modes(true),
+    m_dirty_outputs(true),
+    m_present(true)
+  { }
+
+  /// Sets up the chip and scans it.
+  void begin() const override
+  {
+    scan();
+    if (!present())
+      LOG::E("No MCP23017 at address %, its lines read low.", c_address);
+  }
+
+//===-- Pin backend functions ---------------------------------------------===//
+
+  /// Writes the modes and the output latches if they changed, then reads
+  /// both ports with one transaction (a repeated start between the register
+  /// pointer and the data).
+  void scan() const override
+  {
+    uint16_t directions, pullups, outputs;
+    bool dirty_modes, dirty_outputs;
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      directions = m_directions;
+      pullups = m_pullups;
+      outputs = m_outputs;
+      dirty_modes = m_dirty_modes;
+      dirty_outputs = m_dirty_outputs;
+      m_dirty_modes = false;
+      m_dirty_outputs = false;
+    }
+
+    bool present = true;
+    // The latches first, so new outputs start with their staged levels.
+    if (dirty_modes || dirty_outputs) present &= writeWord(OLATA, outputs);
+    if (dirty_modes)
+    {
+      present &= writeWord(GPPUA, pullups);
+      present &= writeWord(IODIRA, directions);
+    }
+
+    uint16_t inputs = 0;
+    if (directions != 0)
+    {
+      c_wire.beginTransmission(c_address);
+      c_wire.write(GPIOA);
+      present &= c_wire.endTransmission(false) == 0 &&
+                 c_wire.requestFrom(c_address, uint8_t(2)) == 2;
+      if (present)
+      {
+        inputs = static_cast<uint16_t>(c_wire.read());
+        inputs |= static_cast<uint16_t>(c_wire.read() << 8);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (present) m_inputs = inputs;
+    // Written again by the next scan, if the chip didn't answer.
+    m_dirty_modes |= dirty_modes && !present;
+    m_dirty_outputs |= dirty_outputs && !present;
+    m_present = present;
+  }
+
+  void mode(uint8_t line, uint8_t mode) const override
+  {
+    if (line >= LINE_COUNT) return;
+    const uint16_t bit = static_cast<uint16_t>(1 << line);
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint16_t directions = m_directions;
+    const uint16_t pullups = m_pullups;
+    if (mode == OUTPUT) m_directions &= ~bit;
+    else m_directions |= bit;
+    if (mode == INPUT_PULLUP) m_pullups |= bit;
+    else m_pullups &= ~bit;
+    m_dirty_modes |= directions != m_directions || pullups != m_pullups;
+  }
+
+  [[nodiscard]] int read(uint8_t line) const override
+  {
+    if (line >= LINE_COUNT) return LOW;
+    std::lock_guard<std::mutex> lock(m_lock);
+    return (m_inputs >> line) & 1 ? HIGH : LOW;
+  }
+
+  void write(uint8_t line, uint8_t level) const override
+  {
+    if (line >= LINE_COUNT) return;
+    const uint16_t bit = static_cast<uint16_t>(1 << line);
+    std::lock_guard<std::mutex> lock(m_lock);
+    const uint16_t outputs = m_outputs;
+    if (level) m_outputs |= bit;
+    else m_outputs &= ~bit;
+    m_dirty_outputs |= outputs != m_outputs;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return whether the chip answered the last scan.
+  [[nodiscard]] bool present() const
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_present;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  /// Writes a register pair, port A first.
+  /// \return whether the chip acknowledged.
+  bool writeWord(uint8_t reg, uint16_t value) const
+  {
+    c_wire.beginTransmission(c_address);
+    c_wire.write(reg);
+    c_wire.write(static_cast<uint8_t>(value));
+    c_wire.write(static_cast<uint8_t>(value >> 8));
+    return c_wire.endTransmission() == 0;
+  }
+
+  TwoWire &c_wire;
+  const uint8_t c_address;
+  /// Guards the images, used by other tasks between scans.
+  mutable std::mutex m_lock;
+  /// The IODIR bits, set for inputs.
+  mutable uint16_t m_directions;
+  mutable uint16_t m_pullups;
+  mutable uint16_t m_inputs;
+  mutable uint16_t m_outputs;
+  mutable bool m_dirty_modes;
+  mutable bool m_dirty_outputs;
+  mutable bool m_present;
+}; // class Mcp23017
+
+} // namespace PTS
+
+#endif // UTILS_HW_IO_EXPANDER_H
@@ -0,0 +1,100 @@
+//===-- utils/hw/io_pin.h - IoPin and PinBackend class definitions --------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the IoPin class, which is a
+/// digital pin either on the GPIO of the ESP32 or on a pin backend, and of
+/// the PinBackend interface of the latter (e.g. ShiftRegisterChain and
+/// Mcp23017 in io_expander.h).
+///
+/// A backend keeps an image of its lines: reads return the levels of the
+/// last scan, writes are staged, and scan() exchanges both with the chips in
+/// a single bus transaction. Backends are scanned periodically by an
+/// IoScannerModule.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_IO_PIN_H
+#define UTILS_HW_IO_PIN_H
+
+#include <Arduino.h>
+
+namespace PTS
+{
+
+/// PinBackend interface
+class PinBackend
+{
+ public:
+  virtual ~PinBackend() = default;
+
+  /// Sets up the chips and the bus, scanning the inputs.
+  virtual void begin() const = 0;
+
+  /// Exchanges the staged outputs and the inputs with the chips.
+  virtual void scan() const = 0;
+
+  /// Sets the mode of a line (INPUT, INPUT_PULLUP or OUTPUT), applied by the
+  /// next scan, if the chip can change it.
+  virtual void mode(uint8_t line, uint8_t mode) const = 0;
+
+  /// \return the level of an input line at the last scan.
+  virtual int read(uint8_t line) const = 0;
+
+  /// Stages the level of an output line for the next scan.
+  virtual void write(uint8_t line, uint8_t level) const = 0;
+}; // class PinBackend
+
+/// IoPin class
+class IoPin
+{
+//===-- Instantiation specific functions ----------------------------------===//
+ public:
+  /// A GPIO pin (so that pin numbers convert implicitly).
+  constexpr IoPin(const uint8_t pin) : c_backend(nullptr), c_line(pin) { }
+
+  /// A line of a backend, referenced for the lifetime of the pin.
+  constexpr IoPin(const PinBackend &backend, const uint8_t line)
+  : c_backend(&backend), c_line(line)
+  { }
+
+//===-- Pin functions -----------------------------------------------------===//
+
+  void mode(uint8_t mode) const
+  {
+    if (c_backend == nullptr) pinMode(c_line, mode);
+    else c_backend->mode(c_line, mode);
+  }
+
+  [[nodiscard]] int read() const
+  {
+    return c_backend == nullptr ? digitalRead(c_line) : c_backend->read(c_line);
+  }
+
+  void write(uint8_t level) const
+  {
+    if (c_backend == nullptr) digitalWrite(c_line, level);
+    else c_backend->write(c_line, level);
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return whether the pin is on the GPIO of the ESP32.
+  [[nodiscard]] constexpr bool native() const { return c_backend == nullptr; }
+
+  /// \return the GPIO pin number, or the line of the backend.
+  [[nodiscard]] constexpr uint8_t line() const { return c_line; }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  const PinBackend *const c_backend;
+  const uint8_t c_line;
+}; // class IoPin
+
+} // namespace PTS
+
+#endif // UTILS_HW_IO_PIN_H
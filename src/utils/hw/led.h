@@ -15,6 +15,8 @@
 #define UTILS_HW_LED_H
 
 #include <Arduino.h>
+#include "utils/hw/io_pin.h"
+#include "utils/hw/output_frame.h"
 
 namespace PTS
 {
@@ -24,22 +26,32 @@ class LED
 {
 //===-- Instantiation specific functions ----------------------------------===//
  public:
-  explicit LED(const uint8_t pin) : c_pin(pin) { }
+  /// \param pin a GPIO pin, or a line of an I/O expander (written by its
+  /// next scan).
+  explicit LED(const IoPin pin) : c_pin(pin) { }
 
   /// Sets up the communication pin.
-  void begin() const { pinMode(c_pin, OUTPUT); }
+  void begin() const { c_pin.mode(OUTPUT); }
 
 //===-- Modifier functions ------------------------------------------------===//
 
   /// Turns the LED on.
-  void on() const { digitalWrite(c_pin, HIGH); }
+  void on() const { c_pin.write(HIGH); }
 
   /// Turns the LED off.
-  void off() const { digitalWrite(c_pin, LOW); }
+  void off() const { c_pin.write(LOW); }
+
+  /// Stages the LED on or off in a frame, to be committed with other pins.
+  /// The lines of an I/O expander are staged by their backend instead.
+  void stage(OutputFrame &frame, bool on) const
+  {
+    if (c_pin.native()) frame.set(c_pin.line(), on);
+    else c_pin.write(on ? HIGH : LOW);
+  }
 
 //===-- Member variables --------------------------------------------------===//
  private:
-  const uint8_t c_pin;
+  const IoPin c_pin;
 }; // class LED
 
 } // namespace PTS
@@ -0,0 +1,273 @@
+//===-- utils/hw/led_strip.h - LedStrip class definition ------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the LedStrip class, which is a
+/// utility class for WS2812 style addressable LED strips, sent by a channel
+/// of the RMT peripheral.
+///
+/// The pixels are encoded into RMT symbols (one per bit) by lookup tables: a
+/// level table for the brightness and gamma of a colour component, and a
+/// symbol table for every nibble. The symbols are double buffered: a frame is
+/// encoded while the previous one is sent, and only the pixels changed since
+/// the buffer was last encoded are encoded again.
+///
+/// A strip holds two symbol buffers of 96 bytes per pixel (about 56 kB for
+/// 300 pixels), so it should be a global object, not on a task's stack.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_LED_STRIP_H
+#define UTILS_HW_LED_STRIP_H
+
+#include <array>
+#include <bitset>
+#include <driver/rmt.h>
+#include "rgbled.h"
+#include "utils/sw/log.h"
+
+namespace PTS
+{
+
+/// The timing of a WS2812, in ticks of the RMT channel.
+namespace WS2812
+{
+
+/// The RMT channel clock: 80 MHz / 2, a tick is 25 ns.
+inline constexpr uint8_t CLOCK_DIVIDER = 2;
+/// A 0 bit is high for 0.4 us then low for 0.85 us, a 1 bit high for 0.8 us
+/// then low for 0.45 us.
+inline constexpr uint32_t T0H = 16;
+inline constexpr uint32_t T0L = 34;
+inline constexpr uint32_t T1H = 32;
+inline constexpr uint32_t T1L = 18;
+/// The low time latching a frame (50 us by the datasheet, more for clones).
+inline constexpr uint32_t RESET = 3200;
+
+/// \return the symbol of a bit.
+constexpr uint32_t symbol(bool bit)
+{
+  // duration0 in bits 0-14, level0 in bit 15, duration1 in bits 16-30, and
+  // level1 in bit 31.
+  return bit ? T1H | 1u << 15 | T1L << 16 : T0H | 1u << 15 | T0L << 16;
+}
+
+/// The symbols of every nibble, the most significant bit first.
+using NibbleTable = std::array<std::array<uint32_t, 4>, 16>;
+
+constexpr NibbleTable makeNibbleTable()
+{
+  NibbleTable table{};
+  for (uint32_t nibble = 0; nibble != 16; nibble++)
+    for (uint32_t bit = 0; bit != 4; bit++)
+      table[nibble][bit] = symbol((nibble >> (3 - bit)) & 1);
+  return table;
+}
+
+inline constexpr NibbleTable NIBBLE_SYMBOLS = makeNibbleTable();
+
+/// Encodes bytes into symbols, 8 per byte.
+inline void encode(const uint8_t *bytes, size_t count, rmt_item32_t *items)
+{
+  for (size_t idx = 0; idx != count; idx++, items += 8)
+  {
+    const std::array<uint32_t, 4> &high = NIBBLE_SYMBOLS[bytes[idx] >> 4];
+    const std::array<uint32_t, 4> &low = NIBBLE_SYMBOLS[bytes[idx] & 0x0F];
+    for (size_t bit = 0; bit != 4; bit++)
+    {
+      items[bit].val = high[bit];
+      items[4 + bit].val = low[bit];
+    }
+  }
+}
+
+} // namespace WS2812
+
+/// LedStrip class
+/// \tparam PIXELS the number of pixels on the strip.
+template<size_t PIXELS>
+class LedStrip
+{
+ public:
+  /// The symbols of a frame: 24 per pixel (green, red, blue) and the reset.
+  static constexpr size_t ITEMS = PIXELS * 24 + 1;
+  /// The RMT memory blocks of the channel (the next channel's block is used
+  /// too), to ride out interrupt latency while refilling it.
+  static constexpr uint8_t MEM_BLOCKS = 2;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  /// \param channel the RMT channel (0 to 6, the next one is taken too).
+  explicit LedStrip(const uint8_t pin, const uint8_t channel = 0)
+  : c_pin(pin),
+    c_channel(static_cast<rmt_channel_t>(channel)),
+    m_began(false),
+    m_pixels(),
+    m_levels(),
+    m_items(),
+    m_stale(),
+    m_back(0),
+    m_dirty(true),
+    m_brightness(255),
+    m_frames(0)
+  {
+    brightness(255);
+    m_stale[0].set();
+    m_stale[1].set();
+    // The reset ends both buffers.
+    m_items[0][ITEMS - 1].val = WS2812::RESET;
+    m_items[1][ITEMS - 1].val = WS2812::RESET;
+  }
+
+  /// The strip owns its RMT channel and the buffer being sent.
+  LedStrip(const LedStrip &) = delete;
+  LedStrip &operator=(const LedStrip &) = delete;
+
+  ~LedStrip()
+  {
+    if (!m_began) return;
+    rmt_wait_tx_done(c_channel, portMAX_DELAY);
+    rmt_driver_uninstall(c_channel);
+  }
+
+  /// Sets up the RMT channel, the pixels stay as they are until show().
+  void begin() const
+  {
+    if (m_began) return;
+
+    rmt_config_t config = {};
+    config.rmt_mode = RMT_MODE_TX;
+    config.channel = c_channel;
+    config.gpio_num = static_cast<gpio_num_t>(c_pin);
+    config.clk_div = WS2812::CLOCK_DIVIDER;
+    config.mem_block_num = MEM_BLOCKS;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+    config.tx_config.idle_output_en = true;
+    if (rmt_config(&config) != ESP_OK ||
+        rmt_driver_install(c_channel, 0, 0) != ESP_OK)
+    {
+      LOG::E("No RMT channel % for the LED strip, it stays dark.",
+             static_cast<unsigned>(c_channel));
+      return;
+    }
+    m_began = true;
+  }
+
+//===-- Pixel functions ---------------------------------------------------===//
+
+  /// Sets the colour of a pixel, shown by the next show().
+  void set(size_t index, Color color) const
+  {
+    if (index >= PIXELS || m_pixels[index] == color) return;
+    m_pixels[index] = color;
+    m_stale[0].set(index);
+    m_stale[1].set(index);
+    m_dirty = true;
+  }
+
+  /// Sets the colour of every pixel.
+  void fill(Color color) const
+  {
+    for (size_t idx = 0; idx != PIXELS; idx++) set(idx, color);
+  }
+
+  /// Lights the first count pixels in a colour and the rest off, as a bar.
+  void bar(size_t count, Color color) const
+  {
+    for (size_t idx = 0; idx != PIXELS; idx++)
+      set(idx, idx < count ? color : COLOR::OFF);
+  }
+
+  /// Turns every pixel off.
+  void clear() const { fill(COLOR::OFF); }
+
+  /// Scales every pixel, after gamma correction.
+  /// \param level from 0 (off) to 255 (full).
+  void brightness(uint8_t level) const
+  {
+    for (size_t value = 0; value != 256; value++)
+      m_levels[value] = static_cast<uint8_t>(
+        (RGBLED::gamma(static_cast<uint8_t>(value)) * level +
+         RGBLED::MAX_DUTY / 2) / RGBLED::MAX_DUTY);
+    if (level == m_brightness) return;
+    m_brightness = level;
+    m_stale[0].set();
+    m_stale[1].set();
+    m_dirty = true;
+  }
+
+  /// Encodes the changed pixels into the back buffer, while the previous
+  /// frame is being sent, then sends it when that one is done.
+  /// \return false if there was nothing new to show.
+  bool show() const
+  {
+    if (!m_dirty) return false;
+
+    std::array<rmt_item32_t, ITEMS> &items = m_items[m_back];
+    std::bitset<PIXELS> &stale = m_stale[m_back];
+    for (size_t idx = 0; idx != PIXELS; idx++)
+      if (stale[idx]) encodePixel(m_pixels[idx], &items[idx * 24]);
+    stale.reset();
+    m_dirty = false;
+
+    if (!m_began) return true;
+    rmt_write_items(c_channel, items.data(), ITEMS, false);
+    m_back ^= 1;
+    m_frames++;
+    return true;
+  }
+
+  /// Waits until the frame being sent is out.
+  void wait() const
+  {
+    if (m_began) rmt_wait_tx_done(c_channel, portMAX_DELAY);
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  [[nodiscard]] static constexpr size_t size() { return PIXELS; }
+
+  /// \return the colour set for a pixel.
+  [[nodiscard]] Color pixel(size_t index) const
+  {
+    return index < PIXELS ? m_pixels[index] : COLOR::OFF;
+  }
+
+  /// \return the number of frames sent.
+  [[nodiscard]] uint32_t frames() const { return m_frames; }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  /// Encodes a pixel into its 24 symbols, in the green, red, blue order of
+  /// the WS2812.
+  void encodePixel(Color color, rmt_item32_t *items) const
+  {
+    const uint8_t bytes[3] = {m_levels[color.g], m_levels[color.r],
+                              m_levels[color.b]};
+    WS2812::encode(bytes, 3, items);
+  }
+
+  const uint8_t c_pin;
+  const rmt_channel_t c_channel;
+  mutable bool m_began;
+  mutable std::array<Color, PIXELS> m_pixels;
+  /// The level sent for a colour component.
+  mutable std::array<uint8_t, 256> m_levels;
+  /// The front buffer (being sent) and the back buffer.
+  mutable std::array<rmt_item32_t, ITEMS> m_items[2];
+  /// The pixels changed since a buffer was last encoded.
+  mutable std::bitset<PIXELS> m_stale[2];
+  mutable uint8_t m_back;
+  /// Set when a pixel changed since the last show().
+  mutable bool m_dirty;
+  mutable uint8_t m_brightness;
+  mutable uint32_t m_frames;
+}; // class LedStrip
+
+} // namespace PTS
+
+#endif // UTILS_HW_LED_STRIP_H
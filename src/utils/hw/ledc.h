@@ -0,0 +1,107 @@
+//===-- utils/hw/ledc.h - LEDC channel utility definitions ----------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the bookkeeping of the 16 PWM channels of the
+/// ESP32 LEDC peripheral, shared by every user of PWM: channels are taken
+/// from a common pool, and the driver of the hardware fades is installed
+/// once. Two neighbouring channels share a timer (and so a frequency), users
+/// changing the frequency take a whole pair.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_LEDC_H
+#define UTILS_HW_LEDC_H
+
+#include <atomic>
+#include <cstdint>
+#include <Arduino.h>
+#include <driver/ledc.h>
+
+namespace PTS
+{
+
+namespace LEDC
+{
+
+/// The number of channels.
+inline constexpr uint8_t CHANNEL_COUNT = 16;
+/// The channel value of no channel.
+inline constexpr int8_t NO_CHANNEL = -1;
+
+/// \return the channels in use, a bit per channel.
+inline std::atomic<uint16_t> &usedChannels()
+{
+  static std::atomic<uint16_t> used_(0);
+  return used_;
+}
+
+/// Takes consecutive free channels.
+/// \param count the number of channels.
+/// \param alignment the first channel is a multiple of it (2 for a timer of
+/// its own).
+/// \return the first channel, NO_CHANNEL if there are not enough free ones.
+inline int8_t allocate(uint8_t count, uint8_t alignment = 1)
+{
+  const uint16_t mask = static_cast<uint16_t>((1u << count) - 1);
+  uint16_t used = usedChannels().load();
+  for (uint8_t first = 0; first + count <= CHANNEL_COUNT; first += alignment)
+  {
+    const uint16_t channels = static_cast<uint16_t>(mask << first);
+    // Retried from the same channel if another task took one meanwhile.
+    while (!(used & channels))
+    {
+      if (usedChannels().compare_exchange_weak(used, used | channels))
+        return static_cast<int8_t>(first);
+    }
+  }
+  return NO_CHANNEL;
+}
+
+/// Gives allocated channels back.
+inline void release(int8_t first, uint8_t count)
+{
+  if (first == NO_CHANNEL) return;
+  usedChannels().fetch_and(
+    static_cast<uint16_t>(~(((1u << count) - 1) << first)));
+}
+
+/// Installs the driver of the hardware fades, once.
+inline void installFades()
+{
+  static std::atomic<bool> installed_(false);
+  if (!installed_.exchange(true)) ledc_fade_func_install(0);
+}
+
+/// \return the driver mode of a channel (0-7 high, 8-15 low speed).
+inline ledc_mode_t mode(uint8_t channel)
+{
+  return static_cast<ledc_mode_t>(channel / 8);
+}
+
+/// \return the driver channel of a channel within its mode.
+inline ledc_channel_t channel(uint8_t channel)
+{
+  return static_cast<ledc_channel_t>(channel % 8);
+}
+
+/// Stops a running fade, keeping the duty it reached. Fades can't be stopped
+/// before IDF 5, there the next fade waits for the end of the running one.
+inline void stopFade(uint8_t channel)
+{
+#if defined(ESP_IDF_VERSION_MAJOR) && ESP_IDF_VERSION_MAJOR < 5
+  (void)channel;
+#else
+  ledc_fade_stop(mode(channel), LEDC::channel(channel));
+#endif
+}
+
+} // namespace LEDC
+
+} // namespace PTS
+
+#endif // UTILS_HW_LEDC_H
@@ -0,0 +1,100 @@
+//===-- utils/hw/output_frame.h - OutputFrame class definition ------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the OutputFrame class, which
+/// stages the levels of output pins and commits them together.
+///
+/// A commit writes the pins to set to the W1TS (write 1 to set) register,
+/// and the pins to clear to the W1TC (write 1 to clear) register, a register
+/// pair per bank of 32 pins. So the pins of a bank change at once (set ones
+/// a cycle before cleared ones), without glitches in between, and the cost
+/// doesn't depend on the number of pins.
+///
+/// The pins must be set up as outputs (e.g. by LED::begin()).
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_HW_OUTPUT_FRAME_H
+#define UTILS_HW_OUTPUT_FRAME_H
+
+#include <cstdint>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+
+namespace PTS
+{
+
+/// OutputFrame class
+class OutputFrame
+{
+ public:
+  /// The number of GPIO pins.
+  static constexpr uint8_t PIN_COUNT = 40;
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit constexpr OutputFrame() : m_set(0), m_clear(0) { }
+
+//===-- Modifier functions ------------------------------------------------===//
+
+  /// Stages the level of a pin, replacing the one staged before.
+  void set(uint8_t pin, bool level)
+  {
+    if (pin >= PIN_COUNT) return;
+
+    const uint64_t bit = uint64_t(1) << pin;
+    if (level)
+    {
+      m_set |= bit;
+      m_clear &= ~bit;
+    }
+    else
+    {
+      m_clear |= bit;
+      m_set &= ~bit;
+    }
+  }
+
+  /// Writes the staged levels, and empties the frame.
+  void commit()
+  {
+    write(GPIO_OUT_W1TS_REG, static_cast<uint32_t>(m_set));
+    write(GPIO_OUT_W1TC_REG, static_cast<uint32_t>(m_clear));
+    write(GPIO_OUT1_W1TS_REG, static_cast<uint32_t>(m_set >> 32));
+    write(GPIO_OUT1_W1TC_REG, static_cast<uint32_t>(m_clear >> 32));
+    m_set = 0;
+    m_clear = 0;
+  }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return whether no level is staged.
+  [[nodiscard]] bool empty() const { return (m_set | m_clear) == 0; }
+
+  /// \return the pins staged high, a bit per pin.
+  [[nodiscard]] uint64_t setMask() const { return m_set; }
+
+  /// \return the pins staged low, a bit per pin.
+  [[nodiscard]] uint64_t clearMask() const { return m_clear; }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  /// Writes a register, unless there is nothing to write.
+  static void write(uint32_t reg, uint32_t mask)
+  {
+    if (mask != 0) REG_WRITE(reg, mask);
+  }
+
+  uint64_t m_set;
+  uint64_t m_clear;
+}; // class OutputFrame
+
+} // namespace PTS
+
+#endif // UTILS_HW_OUTPUT_FRAME_H
@@ -10,6 +10,12 @@
 /// utility class for working with 3 + 1 legged RGB LEDs, where the 3 legs
 /// represent red, green and blue.
 ///
+/// The legs are driven by three channels of the LEDC PWM peripheral, so the
+/// LED shows any 24-bit colour, gamma corrected to look linear to the eye,
+/// and fades between colours in hardware: a fade is started by one call and
+/// costs no CPU while it runs. If no PWM channel is left, the LED falls back
+/// to the 8 on/off colours.
+///
 /// Load balancing is your responsibility!
 /// R : G : B resistors *should* be around 18 : 4 : 3
 ///
@@ -18,107 +24,246 @@
 #ifndef UTILS_HW_RGBLED_H
 #define UTILS_HW_RGBLED_H
 
+#include <array>
+#include <cstdint>
 #include <Arduino.h>
+#include "utils/hw/ledc.h"
+#include "utils/hw/output_frame.h"
+#include "utils/sw/log.h"
 
 namespace PTS
 {
 
+/// A 24-bit colour.
+struct Color
+{
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  /// \return the colour of a 0xRRGGBB value.
+  static constexpr Color fromRgb(uint32_t rgb)
+  {
+    return Color{static_cast<uint8_t>(rgb >> 16),
+                 static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb)};
+  }
+
+  /// \return the 0xRRGGBB value of the colour.
+  constexpr uint32_t rgb() const
+  {
+    return static_cast<uint32_t>(r) << 16 | static_cast<uint32_t>(g) << 8 | b;
+  }
+
+  constexpr bool operator==(const Color &other) const
+  {
+    return r == other.r && g == other.g && b == other.b;
+  }
+
+  constexpr bool operator!=(const Color &other) const
+  {
+    return !(*this == other);
+  }
+}; // struct Color
+
+namespace COLOR
+{
+
+inline constexpr Color RED{255, 0, 0};
+inline constexpr Color GREEN{0, 255, 0};
+inline constexpr Color BLUE{0, 0, 255};
+inline constexpr Color CYAN{0, 255, 255};
+inline constexpr Color YELLOW{255, 255, 0};
+inline constexpr Color MAGENTA{255, 0, 255};
+inline constexpr Color WHITE{255, 255, 255};
+inline constexpr Color OFF{0, 0, 0};
+
+} // namespace COLOR
+
 /// RGBLED class
 class RGBLED
 {
-//===-- Instantiation specific functions ----------------------------------===//
  public:
+  /// The PWM resolution in bits, and the PWM frequency: high enough not to
+  /// flicker, low enough for the resolution (see LEDC_CLOCK_HZ).
+  static constexpr uint8_t RESOLUTION = 12;
+  static constexpr uint32_t FREQUENCY = 5000;
+  static constexpr uint32_t MAX_DUTY = (1u << RESOLUTION) - 1;
+
+  /// The gamma correction table, mapping a colour component to its duty.
+  using GammaTable = std::array<uint16_t, 256>;
+
+  /// \return the duty of a colour component, perceived linearly.
+  static constexpr uint32_t gamma(uint8_t component)
+  {
+    return c_gamma_table[component];
+  }
+
+//===-- Instantiation specific functions ----------------------------------===//
+
   explicit RGBLED(
     const uint8_t red_pin,
     const uint8_t green_pin,
     const uint8_t blue_pin
   )
-  : c_red_pin(red_pin),
-    c_green_pin(green_pin),
-    c_blue_pin(blue_pin)
+  : c_pins{red_pin, green_pin, blue_pin},
+    m_channel(LEDC::NO_CHANNEL),
+    m_began(false),
+    m_color(COLOR::OFF)
   { }
 
-  /// Sets up the communication pins.
+  /// The LED owns its PWM channels.
+  RGBLED(const RGBLED &) = delete;
+  RGBLED &operator=(const RGBLED &) = delete;
+
+  ~RGBLED()
+  {
+    if (m_channel == LEDC::NO_CHANNEL) return;
+    for (uint8_t pin : c_pins) ledcDetachPin(pin);
+    LEDC::release(m_channel, LEG_COUNT);
+  }
+
+  /// Sets up the PWM channels of the legs, or the pins if there are none
+  /// left. Calling it again does nothing.
   void begin() const
   {
-    pinMode(c_red_pin, OUTPUT);
-    pinMode(c_green_pin, OUTPUT);
-    pinMode(c_blue_pin, OUTPUT);
+    if (m_began) return;
+    m_began = true;
+
+    m_channel = LEDC::allocate(LEG_COUNT);
+    if (m_channel != LEDC::NO_CHANNEL)
+    {
+      LEDC::installFades();
+      for (uint8_t leg = 0; leg != LEG_COUNT; leg++)
+      {
+        if (!ledcSetup(m_channel + leg, FREQUENCY, RESOLUTION))
+        {
+          LOG::E("RGB LED PWM setup failed, using on/off colours.");
+          LEDC::release(m_channel, LEG_COUNT);
+          m_channel = LEDC::NO_CHANNEL;
+          break;
+        }
+        ledcAttachPin(c_pins[leg], m_channel + leg);
+      }
+    }
+    else
+      LOG::W("No PWM channels left for an RGB LED, using on/off colours.");
+
+    if (m_channel == LEDC::NO_CHANNEL)
+      for (uint8_t pin : c_pins) pinMode(pin, OUTPUT);
+    set(m_color);
   }
 
 //===-- Modifier functions ------------------------------------------------===//
 
-  /// Sets the color red.
-  void red() const
+  /// Sets a colour, stopping a running fade.
+  void set(Color color) const { fade(color, 0); }
+
+  /// Fades from the current colour to another in hardware, returning at
+  /// once. Before IDF 5 a running fade can't be stopped, and the call waits
+  /// for its end.
+  /// \param duration_ms the length of the fade, 0 to set the colour at once.
+  void fade(Color color, uint32_t duration_ms) const
   {
-    digitalWrite(c_red_pin, HIGH);
-    digitalWrite(c_green_pin, LOW);
-    digitalWrite(c_blue_pin, LOW);
+    m_color = color;
+    if (!m_began) return;
+
+    const uint8_t components[LEG_COUNT] = {color.r, color.g, color.b};
+    if (m_channel == LEDC::NO_CHANNEL)
+    {
+      // The legs change at once, without a wrong colour in between.
+      OutputFrame frame;
+      for (uint8_t leg = 0; leg != LEG_COUNT; leg++)
+        frame.set(c_pins[leg], components[leg] > 127);
+      frame.commit();
+      return;
+    }
+
+    for (uint8_t leg = 0; leg != LEG_COUNT; leg++)
+    {
+      const uint8_t channel = static_cast<uint8_t>(m_channel + leg);
+      LEDC::stopFade(channel);
+      ledc_set_fade_with_time(LEDC::mode(channel), LEDC::channel(channel),
+                              gamma(components[leg]),
+                              static_cast<int>(duration_ms));
+      ledc_fade_start(LEDC::mode(channel), LEDC::channel(channel),
+                      LEDC_FADE_NO_WAIT);
+    }
   }
 
+  /// Sets the color red.
+  void red() const { set(COLOR::RED); }
+
   /// Sets the color green.
-  void green() const
-  {
-    digitalWrite(c_red_pin, LOW);
-    digitalWrite(c_green_pin, HIGH);
-    digitalWrite(c_blue_pin, LOW);
-  }
+  void green() const { set(COLOR::GREEN); }
 
   /// Sets the color blue.
-  void blue() const
-  {
-    digitalWrite(c_red_pin, LOW);
-    digitalWrite(c_green_pin, LOW);
-    digitalWrite(c_blue_pin, HIGH);
-  }
+  void blue() const { set(COLOR::BLUE); }
 
   /// Sets the color cyan.
-  void cyan() const
-  {
-    digitalWrite(c_red_pin, LOW);
-    digitalWrite(c_green_pin, HIGH);
-    digitalWrite(c_blue_pin, HIGH);
-  }
+  void cyan() const { set(COLOR::CYAN); }
 
   /// Sets the color yellow.
-  void yellow() const
-  {
-    digitalWrite(c_red_pin, HIGH);
-    digitalWrite(c_green_pin, HIGH);
-    digitalWrite(c_blue_pin, LOW);
-  }
+  void yellow() const { set(COLOR::YELLOW); }
 
   /// Sets the color magenta.
-  void magenta() const
-  {
-    digitalWrite(c_red_pin, HIGH);
-    digitalWrite(c_green_pin, LOW);
-    digitalWrite(c_blue_pin, HIGH);
-  }
+  void magenta() const { set(COLOR::MAGENTA); }
 
   /// Sets the color white by turning all LEDs on.
-  void white() const
+  void white() const { set(COLOR::WHITE); }
+
+  /// Turns the LED off.
+  void off() const { set(COLOR::OFF); }
+
+//===-- Getter functions --------------------------------------------------===//
+
+  /// \return the colour set last, the end of a running fade.
+  [[nodiscard]] Color color() const { return m_color; }
+
+  /// \return the first of the 3 PWM channels, LEDC::NO_CHANNEL if there are
+  /// none.
+  [[nodiscard]] int8_t channel() const { return m_channel; }
+
+//===-- Member variables --------------------------------------------------===//
+ private:
+  static constexpr uint8_t LEG_COUNT = 3;
+
+  /// \return x^(1/5) for x in [0, 1], by Newton's method.
+  static constexpr double fifthRoot(double x)
   {
-    digitalWrite(c_red_pin, HIGH);
-    digitalWrite(c_green_pin, HIGH);
-    digitalWrite(c_blue_pin, HIGH);
+    double root = 1.0;
+    for (int step = 0; step != 40; step++)
+    {
+      const double square = root * root;
+      root = (4.0 * root + x / (square * square)) / 5.0;
+    }
+    return root;
   }
 
-  /// Turns the LED off.
-  void off() const
+  /// \return the table of component^2.2, scaled to MAX_DUTY and rounded.
+  static constexpr GammaTable makeGammaTable()
   {
-    digitalWrite(c_red_pin, LOW);
-    digitalWrite(c_green_pin, LOW);
-    digitalWrite(c_blue_pin, LOW);
+    GammaTable table{};
+    table[0] = 0;
+    for (size_t idx = 1; idx != table.size(); idx++)
+    {
+      const double x = static_cast<double>(idx) / 255.0;
+      table[idx] =
+        static_cast<uint16_t>(x * x * fifthRoot(x) * MAX_DUTY + 0.5);
+    }
+    return table;
   }
 
-//===-- Member variables --------------------------------------------------===//
- private:
-  const uint8_t c_red_pin;
-  const uint8_t c_green_pin;
-  const uint8_t c_blue_pin;
+  static const GammaTable c_gamma_table;
+
+  const uint8_t c_pins[LEG_COUNT];
+  mutable int8_t m_channel;
+  mutable bool m_began;
+  mutable Color m_color;
 }; // class RGBLED
 
+inline constexpr RGBLED::GammaTable RGBLED::c_gamma_table =
+  RGBLED::makeGammaTable();
+
 } // namespace PTS
 
 #endif // UTILS_HW_RGBLED_H
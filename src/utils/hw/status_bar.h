@@ -15,7 +15,9 @@
 #define UTILS_HW_STATUS_BAR_H
 
 #include <array>
+#include <bitset>
 #include "led.h"
+#include "output_frame.h"
 
 namespace PTS {
 
@@ -26,13 +28,13 @@ class StatusBar {
 //===-- Instantiation specific functions ----------------------------------===//
  public:
   explicit StatusBar(std::array<LED, NUM> &&led_array)
-  : m_set_led(0), c_led_array(led_array)
+  : m_set_led(0), m_lit(), c_led_array(led_array)
   { }
 
   /// Sets up the LEDs in the array.
   void begin() const
   {
-    for (auto led : c_led_array) led.begin();
+    for (const LED &led : c_led_array) led.begin();
   }
 
 //===-- LED manipulation functions ----------------------------------------===//
@@ -42,24 +44,74 @@ class StatusBar {
   {
     if (m_set_led < NUM)
     {
+      m_lit.set(m_set_led);
       c_led_array[m_set_led++].on();
     }
   }
 
-  /// Turns all LEDs in the array off.
+  /// Turns all LEDs in the array off, at once.
   void clear() const
   {
-    for (auto led : c_led_array) led.off();
+    OutputFrame frame;
+    for (const LED &led : c_led_array) led.stage(frame, false);
+    frame.commit();
+    m_lit.reset();
     m_set_led = 0;
   }
 
+  /// Turns the first count LEDs on and the rest off at once, writing only the
+  /// LEDs that change.
+  void fill(size_t count) const
+  {
+    OutputFrame frame;
+    fill(count, frame);
+    frame.commit();
+  }
+
+  /// Stages the first count LEDs on and the rest off in a frame.
+  void fill(size_t count, OutputFrame &frame) const
+  {
+    std::bitset<NUM> lit;
+    for (size_t idx = 0; idx != count && idx != NUM; idx++) lit.set(idx);
+    stage(lit, frame);
+    m_set_led = count < NUM ? count : NUM;
+  }
+
+  /// Turns a single LED on and the rest off at once, writing only the LEDs
+  /// that change.
+  void dot(size_t index) const
+  {
+    OutputFrame frame;
+    dot(index, frame);
+    frame.commit();
+  }
+
+  /// Stages a single LED on and the rest off in a frame.
+  void dot(size_t index, OutputFrame &frame) const
+  {
+    std::bitset<NUM> lit;
+    if (index < NUM) lit.set(index);
+    stage(lit, frame);
+    m_set_led = index < NUM ? index + 1 : NUM;
+  }
+
 //===-- Member variables --------------------------------------------------===//
 
  private:
+  /// Stages the LEDs that change (they are counted as lit from then on).
+  void stage(const std::bitset<NUM> &lit, OutputFrame &frame) const
+  {
+    for (size_t idx = 0; idx != NUM; idx++)
+      if (lit[idx] != m_lit[idx]) c_led_array[idx].stage(frame, lit[idx]);
+    m_lit = lit;
+  }
+
   mutable size_t m_set_led;
+  /// The LEDs turned on.
+  mutable std::bitset<NUM> m_lit;
   const std::array<LED, NUM> c_led_array;
 }; // class StatusBar
 
 } // namespace PTS
 
-#endif // UTILS_HW_STATUS_BAR_H
\ No newline at end of file
+#endif // UTILS_HW_STATUS_BAR_H
@@ -0,0 +1,106 @@
+//===-- utils/sw/byte_buffer.h - ByteBuffer class definition --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the ByteBuffer class, which is
+/// a fixed capacity byte container for assembling and queueing messages.
+///
+/// Writes that don't fit are rejected as a whole and mark the buffer as
+/// overflowed, so a message is either stored completely or not at all.
+///
+/// The container is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_BYTE_BUFFER_H
+#define UTILS_SW_BYTE_BUFFER_H
+
+#include <cstddef>
+#include <cstring>
+
+namespace PTS
+{
+
+/// ByteBuffer class
+/// \tparam SIZE the capacity of the buffer in bytes.
+template<size_t SIZE>
+class ByteBuffer
+{
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit ByteBuffer() : m_length(0), m_overflowed(false), m_data{0} { }
+
+//===-- Element access ----------------------------------------------------===//
+
+  /// \return the stored bytes.
+  [[nodiscard]] const char *data() const { return m_data; }
+
+  /// \return the number of stored bytes.
+  [[nodiscard]] size_t size() const { return m_length; }
+
+  /// \return the number of bytes that can still be stored.
+  [[nodiscard]] size_t space() const { return SIZE - m_length; }
+
+  /// \return true, if the buffer is empty.
+  [[nodiscard]] bool empty() const { return m_length == 0; }
+
+  /// \return true, if a write has been rejected since the last clear().
+  [[nodiscard]] bool overflowed() const { return m_overflowed; }
+
+//===-- Modifiers ---------------------------------------------------------===//
+
+  /// Appends bytes, if all of them fit.
+  /// \param data the bytes to append.
+  /// \param length the number of bytes to append.
+  /// \return false, if the bytes don't fit (nothing is stored), true otherwise.
+  bool write(const char *data, size_t length)
+  {
+    if (length > SIZE - m_length)
+    {
+      m_overflowed = true;
+      return false;
+    }
+    std::memcpy(m_data + m_length, data, length);
+    m_length += length;
+    return true;
+  }
+
+  /// Appends a zero terminated string, if it fits.
+  bool print(const char *text) { return write(text, std::strlen(text)); }
+
+  /// Removes bytes from the front (e.g. after they were sent).
+  /// \param length the number of bytes to remove.
+  void consume(size_t length)
+  {
+    if (length >= m_length)
+    {
+      m_length = 0;
+      return;
+    }
+    std::memmove(m_data, m_data + length, m_length - length);
+    m_length -= length;
+  }
+
+  /// Removes every byte and resets the overflow flag.
+  void clear()
+  {
+    m_length = 0;
+    m_overflowed = false;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  size_t m_length;
+  bool m_overflowed;
+  char m_data[SIZE];
+}; // class ByteBuffer
+
+} // namespace PTS
+
+#endif // UTILS_SW_BYTE_BUFFER_H
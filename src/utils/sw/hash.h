@@ -0,0 +1,36 @@
+//===-- utils/sw/hash.h - Hash function definitions -----------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the hash functions used for fast string lookups.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_HASH_H
+#define UTILS_SW_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PTS
+{
+
+/// Computes the FNV-1a hash of a string.
+/// \param text the string to hash.
+/// \param length the length of the string.
+/// \return the hash.
+constexpr uint32_t fnv1a(const char *text, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t idx = 0; idx != length; idx++)
+    hash = (hash ^ static_cast<uint8_t>(text[idx])) * 16777619u;
+  return hash;
+}
+
+} // namespace PTS
+
+#endif // UTILS_SW_HASH_H
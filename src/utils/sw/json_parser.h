@@ -0,0 +1,465 @@
+//===-- utils/sw/json_parser.h - JsonParser class definition --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the JsonParser class, which is
+/// a streaming (SAX-style) JSON parser.
+///
+/// The input can be fed in chunks of any size, even a character at a time,
+/// and every structure, key and value is reported to the handler as soon as
+/// it is complete, nothing is built in memory. The only state is a token
+/// buffer (the longest string or number accepted) and a bit per nesting level,
+/// both sized by the template arguments: parsing never allocates.
+///
+/// The HANDLER type receives the events, every function returns false to stop
+/// the parsing:
+///   bool beginObject(); bool endObject(); bool beginArray(); bool endArray();
+///   bool key(const char *name, size_t length);
+///   bool string(const char *text, size_t length);
+///   bool number(const char *text, size_t length);
+///   bool boolean(bool flag); bool null();
+/// The texts are zero terminated and only valid during the call. Numbers are
+/// passed as written, the handler converts them as it needs.
+///
+/// The class is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_JSON_PARSER_H
+#define UTILS_SW_JSON_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace PTS
+{
+
+/// JsonParser class
+/// \tparam HANDLER the type of the handler receiving the events.
+/// \tparam TOKEN_SIZE the size of the token buffer (the longest string or
+/// number accepted, including the terminating zero).
+/// \tparam MAX_DEPTH the maximum nesting depth of objects and arrays.
+template<typename HANDLER, size_t TOKEN_SIZE = 64, size_t MAX_DEPTH = 16>
+class JsonParser
+{
+  static_assert(MAX_DEPTH <= 32, "The nesting is stored in 32 bits.");
+
+ public:
+  /// The reasons of failed parsing.
+  enum class Error : uint8_t
+  {
+    NONE,
+    /// The input is not valid JSON.
+    SYNTAX,
+    /// The input is nested deeper than MAX_DEPTH.
+    TOO_DEEP,
+    /// A string or number is longer than the token buffer.
+    TOO_LONG,
+    /// The handler stopped the parsing.
+    ABORTED,
+    /// The input ended before the value was complete.
+    INCOMPLETE,
+  };
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit JsonParser(HANDLER &handler)
+  : m_handler(handler),
+    m_state(State::VALUE),
+    m_error(Error::NONE),
+    m_depth(0),
+    m_in_object(0),
+    m_after_open(false),
+    m_string_is_key(false),
+    m_token(),
+    m_length(0),
+    m_literal(nullptr),
+    m_code_point(0),
+    m_unicode_digits(0),
+    m_offset(0)
+  { }
+
+  /// Resets the parser to take a new document.
+  void reset()
+  {
+    m_state = State::VALUE;
+    m_error = Error::NONE;
+    m_depth = 0;
+    m_in_object = 0;
+    m_after_open = false;
+    m_length = 0;
+    m_offset = 0;
+  }
+
+//===-- Parsing functions -------------------------------------------------===//
+
+  /// Parses the next chunk of the input.
+  /// \param data the chunk.
+  /// \param length the length of the chunk.
+  /// \return false, if the parsing failed (now or earlier), true otherwise.
+  bool feed(const char *data, size_t length)
+  {
+    for (size_t idx = 0; idx != length && m_error == Error::NONE; idx++)
+    {
+      consume(data[idx]);
+      if (m_error == Error::NONE) m_offset++;
+    }
+    return m_error == Error::NONE;
+  }
+
+  /// Ends the input.
+  /// \return false, if the parsing failed or the document is incomplete, true
+  /// otherwise.
+  bool finish()
+  {
+    // A number only ends at the next character, or here.
+    if (m_error == Error::NONE && m_state == State::NUMBER) endNumber();
+    if (m_error == Error::NONE && m_state != State::DONE)
+      m_error = Error::INCOMPLETE;
+    return m_error == Error::NONE;
+  }
+
+  /// \return the reason of the failure, NONE if there was none.
+  [[nodiscard]] Error error() const { return m_error; }
+
+  /// \return the offset of the failing (or the next) character.
+  [[nodiscard]] size_t offset() const { return m_offset; }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// What the next character may be.
+  enum class State : uint8_t
+  {
+    /// A value, or the end of an empty array.
+    VALUE,
+    /// A key, or the end of an empty object.
+    KEY,
+    /// The colon after a key.
+    COLON,
+    /// A comma or the end of the array or object.
+    AFTER_VALUE,
+    STRING,
+    STRING_ESCAPE,
+    STRING_UNICODE,
+    NUMBER,
+    /// The rest of true, false or null.
+    LITERAL,
+    /// Only whitespace, the document is complete.
+    DONE,
+  };
+
+  static bool isWhitespace(char character)
+  {
+    return character == ' ' || character == '\t' || character == '\n' ||
+           character == '\r';
+  }
+
+  static bool isNumberCharacter(char character)
+  {
+    return (character >= '0' && character <= '9') || character == '-' ||
+           character == '+' || character == '.' || character == 'e' ||
+           character == 'E';
+  }
+
+  /// Processes a character of the input.
+  void consume(char character)
+  {
+    switch (m_state)
+    {
+      case State::VALUE: consumeValue(character); break;
+      case State::KEY:
+        if (isWhitespace(character)) break;
+        if (character == '"') beginString(true);
+        else if (character == '}' && m_after_open) close(true);
+        else fail(Error::SYNTAX);
+        break;
+      case State::COLON:
+        if (isWhitespace(character)) break;
+        if (character == ':') m_state = State::VALUE;
+        else fail(Error::SYNTAX);
+        break;
+      case State::AFTER_VALUE: consumeAfterValue(character); break;
+      case State::STRING: consumeString(character); break;
+      case State::STRING_ESCAPE: consumeEscape(character); break;
+      case State::STRING_UNICODE: consumeUnicode(character); break;
+      case State::NUMBER:
+        if (isNumberCharacter(character))
+        {
+          append(character);
+          break;
+        }
+        endNumber();
+        if (m_error == Error::NONE) consume(character);
+        break;
+      case State::LITERAL:
+        if (character != *m_literal++) fail(Error::SYNTAX);
+        else if (*m_literal == '\0') endLiteral();
+        break;
+      case State::DONE:
+        if (!isWhitespace(character)) fail(Error::SYNTAX);
+        break;
+    }
+  }
+
+  /// Processes the first character of a value.
+  void consumeValue(char character)
+  {
+    if (isWhitespace(character)) return;
+
+    switch (character)
+    {
+      case '{': open(true); return;
+      case '[': open(false); return;
+      case '"': beginString(false); return;
+      case 't': beginLiteral("rue"); return;
+      case 'f': beginLiteral("alse"); return;
+      case 'n': beginLiteral("ull"); return;
+      case ']':
+        if (m_after_open && m_depth != 0 && !inObject()) close(false);
+        else fail(Error::SYNTAX);
+        return;
+      default: break;
+    }
+
+    if (character != '-' && (character < '0' || character > '9'))
+    {
+      fail(Error::SYNTAX);
+      return;
+    }
+    m_length = 0;
+    append(character);
+    m_state = State::NUMBER;
+  }
+
+  /// Processes the character after a value.
+  void consumeAfterValue(char character)
+  {
+    if (isWhitespace(character)) return;
+
+    if (character == ',')
+    {
+      m_state = inObject() ? State::KEY : State::VALUE;
+      m_after_open = false;
+    }
+    else if (character == (inObject() ? '}' : ']'))
+    {
+      close(inObject());
+    }
+    else
+    {
+      fail(Error::SYNTAX);
+    }
+  }
+
+  /// Processes a character of a string.
+  void consumeString(char character)
+  {
+    if (character == '"')
+    {
+      m_token[m_length] = '\0';
+      if (m_string_is_key)
+      {
+        report(m_handler.key(m_token, m_length));
+        m_state = State::COLON;
+      }
+      else
+      {
+        report(m_handler.string(m_token, m_length));
+        endValue();
+      }
+    }
+    else if (character == '\\')
+    {
+      m_state = State::STRING_ESCAPE;
+    }
+    else if (static_cast<unsigned char>(character) < 0x20)
+    {
+      fail(Error::SYNTAX);
+    }
+    else
+    {
+      append(character);
+    }
+  }
+
+  /// Processes the character after a backslash.
+  void consumeEscape(char character)
+  {
+    m_state = State::STRING;
+    switch (character)
+    {
+      case '"': case '\\': case '/': append(character); break;
+      case 'b': append('\b'); break;
+      case 'f': append('\f'); break;
+      case 'n': append('\n'); break;
+      case 'r': append('\r'); break;
+      case 't': append('\t'); break;
+      case 'u':
+        m_code_point = 0;
+        m_unicode_digits = 0;
+        m_state = State::STRING_UNICODE;
+        break;
+      default: fail(Error::SYNTAX); break;
+    }
+  }
+
+  /// Processes a hex digit of a \u escape, appending the character as UTF-8
+  /// (surrogate pairs are not combined).
+  void consumeUnicode(char character)
+  {
+    uint32_t digit;
+    if (character >= '0' && character <= '9') digit = character - '0';
+    else if (character >= 'a' && character <= 'f') digit = character - 'a' + 10;
+    else if (character >= 'A' && character <= 'F') digit = character - 'A' + 10;
+    else
+    {
+      fail(Error::SYNTAX);
+      return;
+    }
+
+    m_code_point = m_code_point << 4 | digit;
+    if (++m_unicode_digits != 4) return;
+
+    m_state = State::STRING;
+    if (m_code_point < 0x80)
+    {
+      append(static_cast<char>(m_code_point));
+    }
+    else if (m_code_point < 0x800)
+    {
+      append(static_cast<char>(0xc0 | m_code_point >> 6));
+      append(static_cast<char>(0x80 | (m_code_point & 0x3f)));
+    }
+    else
+    {
+      append(static_cast<char>(0xe0 | m_code_point >> 12));
+      append(static_cast<char>(0x80 | (m_code_point >> 6 & 0x3f)));
+      append(static_cast<char>(0x80 | (m_code_point & 0x3f)));
+    }
+  }
+
+  /// Reports the finished number token.
+  void endNumber()
+  {
+    m_token[m_length] = '\0';
+    char *end;
+    std::strtod(m_token, &end);
+    if (end != m_token + m_length)
+    {
+      fail(Error::SYNTAX);
+      return;
+    }
+    report(m_handler.number(m_token, m_length));
+    endValue();
+  }
+
+  /// Reports the finished true, false or null (told apart by the end of the
+  /// matched rest: "rue", "alse" or "ull").
+  void endLiteral()
+  {
+    if (m_literal[-1] == 'l') report(m_handler.null());
+    else report(m_handler.boolean(m_literal[-2] == 'u'));
+    endValue();
+  }
+
+  void beginString(bool is_key)
+  {
+    m_length = 0;
+    m_string_is_key = is_key;
+    m_state = State::STRING;
+  }
+
+  void beginLiteral(const char *rest)
+  {
+    m_literal = rest;
+    m_state = State::LITERAL;
+  }
+
+  /// Opens an object or an array.
+  void open(bool object)
+  {
+    if (m_depth == MAX_DEPTH)
+    {
+      fail(Error::TOO_DEEP);
+      return;
+    }
+
+    const uint32_t level_bit = 1u << m_depth++;
+    if (object) m_in_object |= level_bit;
+    else m_in_object &= ~level_bit;
+    report(object ? m_handler.beginObject() : m_handler.beginArray());
+    m_state = object ? State::KEY : State::VALUE;
+    m_after_open = true;
+  }
+
+  /// Closes the innermost object or array.
+  void close(bool object)
+  {
+    m_depth--;
+    report(object ? m_handler.endObject() : m_handler.endArray());
+    endValue();
+  }
+
+  /// Moves on after a complete value.
+  void endValue()
+  {
+    if (m_error != Error::NONE) return;
+
+    m_state = m_depth == 0 ? State::DONE : State::AFTER_VALUE;
+    m_after_open = false;
+  }
+
+  /// \return true, if the innermost level is an object.
+  [[nodiscard]] bool inObject() const
+  {
+    return m_depth != 0 && (m_in_object >> (m_depth - 1) & 1u);
+  }
+
+  void append(char character)
+  {
+    if (m_length == TOKEN_SIZE - 1) fail(Error::TOO_LONG);
+    else m_token[m_length++] = character;
+  }
+
+  void report(bool accepted)
+  {
+    if (!accepted) fail(Error::ABORTED);
+  }
+
+  void fail(Error error)
+  {
+    if (m_error == Error::NONE) m_error = error;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  HANDLER &m_handler;
+  State m_state;
+  Error m_error;
+  /// The number of open objects and arrays.
+  size_t m_depth;
+  /// A bit per nesting level, set for objects.
+  uint32_t m_in_object;
+  /// Whether nothing has been read since the last bracket.
+  bool m_after_open;
+  /// Whether the current string is a key.
+  bool m_string_is_key;
+  char m_token[TOKEN_SIZE];
+  size_t m_length;
+  /// The expected rest of a literal.
+  const char *m_literal;
+  uint32_t m_code_point;
+  uint8_t m_unicode_digits;
+  /// The number of characters consumed.
+  size_t m_offset;
+}; // class JsonParser
+
+} // namespace PTS
+
+#endif // UTILS_SW_JSON_PARSER_H
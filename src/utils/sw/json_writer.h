@@ -0,0 +1,229 @@
+//===-- utils/sw/json_writer.h - JsonWriter class definition --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the JsonWriter class, which is
+/// a streaming JSON serializer.
+///
+/// Values are written straight to the output as they are added, nothing is
+/// built in memory. Separators are inserted automatically, keeping track of
+/// the nesting with a bit per level.
+///
+/// The TARGET type only needs a write(const char*, size_t) function, such as
+/// the ResponseWriter.
+///
+/// The class is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_JSON_WRITER_H
+#define UTILS_SW_JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace PTS
+{
+
+/// JsonWriter class
+/// \tparam TARGET the type of the target written to.
+template<typename TARGET>
+class JsonWriter
+{
+  /// The maximum nesting depth of objects and arrays.
+  static constexpr size_t MAX_DEPTH = 32;
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit JsonWriter(TARGET &output)
+  : m_output(output), m_depth(0), m_has_items(0), m_after_key(false)
+  { }
+
+//===-- Structure functions -----------------------------------------------===//
+
+  /// Opens an object.
+  JsonWriter &beginObject() { return open('{'); }
+
+  /// Closes the innermost object.
+  JsonWriter &endObject() { return close('}'); }
+
+  /// Opens an array.
+  JsonWriter &beginArray() { return open('['); }
+
+  /// Closes the innermost array.
+  JsonWriter &endArray() { return close(']'); }
+
+  /// Writes the key of the next member of an object.
+  /// \param name the key.
+  JsonWriter &key(const char *name)
+  {
+    separate();
+    writeString(name, std::strlen(name));
+    m_output.write(":", 1);
+    m_after_key = true;
+    return *this;
+  }
+
+//===-- Value functions ---------------------------------------------------===//
+
+  /// Writes a string value.
+  JsonWriter &value(const char *text)
+  {
+    return value(text, std::strlen(text));
+  }
+
+  /// Writes a string value of the given length.
+  JsonWriter &value(const char *text, size_t length)
+  {
+    separate();
+    writeString(text, length);
+    return *this;
+  }
+
+  /// Writes an unsigned integer value.
+  JsonWriter &value(uint32_t number)
+  {
+    separate();
+    char digits[10];
+    size_t length = 0;
+    do
+    {
+      digits[sizeof(digits) - ++length] = '0' + number % 10;
+      number /= 10;
+    } while (number != 0);
+    m_output.write(digits + sizeof(digits) - length, length);
+    return *this;
+  }
+
+  /// Writes a signed integer value.
+  JsonWriter &value(int32_t number)
+  {
+    if (number >= 0) return value(static_cast<uint32_t>(number));
+
+    separate();
+    m_output.write("-", 1);
+    m_after_key = true; // The digits follow without a separator.
+    return value(static_cast<uint32_t>(0u - static_cast<uint32_t>(number)));
+  }
+
+  /// Writes a floating point value (null if it is not finite).
+  JsonWriter &value(double number)
+  {
+    if (number != number || number - number != 0) return null();
+
+    separate();
+    char text[24];
+    const int length = std::snprintf(text, sizeof(text), "%.6g", number);
+    m_output.write(text, static_cast<size_t>(length));
+    return *this;
+  }
+
+  /// Writes a boolean value.
+  JsonWriter &value(bool flag)
+  {
+    separate();
+    if (flag) m_output.write("true", 4);
+    else m_output.write("false", 5);
+    return *this;
+  }
+
+  /// Writes a null value.
+  JsonWriter &null()
+  {
+    separate();
+    m_output.write("null", 4);
+    return *this;
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// Writes the separator needed before the next item.
+  void separate()
+  {
+    if (m_after_key)
+    {
+      m_after_key = false;
+      return;
+    }
+    if (m_depth == 0) return;
+
+    const uint32_t level_bit = 1u << (m_depth - 1);
+    if (m_has_items & level_bit) m_output.write(",", 1);
+    m_has_items |= level_bit;
+  }
+
+  /// Opens a nesting level.
+  JsonWriter &open(char bracket)
+  {
+    separate();
+    m_output.write(&bracket, 1);
+    if (m_depth != MAX_DEPTH) m_depth++;
+    m_has_items &= ~(1u << (m_depth - 1));
+    return *this;
+  }
+
+  /// Closes a nesting level.
+  JsonWriter &close(char bracket)
+  {
+    if (m_depth != 0) m_depth--;
+    m_output.write(&bracket, 1);
+    return *this;
+  }
+
+  /// Writes a quoted string, escaping it in runs.
+  void writeString(const char *text, size_t length)
+  {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    m_output.write("\"", 1);
+    size_t run = 0;
+    for (size_t idx = 0; idx != length; idx++)
+    {
+      const unsigned char character = static_cast<unsigned char>(text[idx]);
+      if (character >= 0x20 && character != '"' && character != '\\')
+        continue;
+
+      m_output.write(text + run, idx - run);
+      run = idx + 1;
+      switch (character)
+      {
+        case '"': m_output.write("\\\"", 2); break;
+        case '\\': m_output.write("\\\\", 2); break;
+        case '\n': m_output.write("\\n", 2); break;
+        case '\r': m_output.write("\\r", 2); break;
+        case '\t': m_output.write("\\t", 2); break;
+        default:
+        {
+          const char escaped[6] = {
+            '\\', 'u', '0', '0',
+            HEX_DIGITS[character >> 4], HEX_DIGITS[character & 0xF]
+          };
+          m_output.write(escaped, sizeof(escaped));
+          break;
+        }
+      }
+    }
+    m_output.write(text + run, length - run);
+    m_output.write("\"", 1);
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  TARGET &m_output;
+  size_t m_depth;
+  uint32_t m_has_items;
+  bool m_after_key;
+}; // class JsonWriter
+
+} // namespace PTS
+
+#endif // UTILS_SW_JSON_WRITER_H
@@ -16,6 +16,8 @@
 ///   - Error (E)
 ///
 /// It uses the Serial interface from the Arduino library for communication.
+/// Every logged byte is also kept in an in-memory LogRing (of LOG_RING_SIZE
+/// bytes), so that the recent output can be read without a serial connection.
 ///
 //===----------------------------------------------------------------------===//
 
@@ -23,6 +25,7 @@
 #define UTILS_SW_LOG_H
 
 #include <Arduino.h>
+#include "utils/sw/log_ring.h"
 
 namespace PTS
 {
@@ -39,6 +42,65 @@ namespace LOG
 #define LOGLVL DEBUG
 #endif
 
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 4096
+#endif
+
+/// The type of the in-memory ring storing the most recent log output.
+using Ring = LogRing<LOG_RING_SIZE>;
+
+/// \return the in-memory ring of the most recent log output.
+inline const Ring& ring()
+{
+  static Ring ring_;
+  return ring_;
+}
+
+/// Print implementation that forwards everything to the serial monitor and
+/// copies it into the in-memory ring (without the console styling sequences).
+class LogSink : public Print
+{
+ public:
+  size_t write(uint8_t byte) override
+  {
+    return write(&byte, 1);
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    // Copy the plain text in runs between escape sequences ("\033[...m").
+    // Every sequence is printed within a single call (see LOG_SRC()), so
+    // tasks logging at once share no state.
+    const char *text = reinterpret_cast<const char*>(buffer);
+    bool in_escape = false;
+    size_t run_start = 0;
+    for (size_t idx = 0; idx != size; idx++)
+    {
+      if (in_escape)
+      {
+        in_escape = text[idx] != 'm';
+        run_start = idx + 1;
+      }
+      else if (text[idx] == '\033')
+      {
+        ring().write(text + run_start, idx - run_start);
+        in_escape = true;
+      }
+    }
+    if (!in_escape)
+      ring().write(text + run_start, size - run_start);
+
+    return Serial.write(buffer, size);
+  }
+}; // class LogSink
+
+/// \return the sink every log call prints to.
+inline LogSink& sink()
+{
+  static LogSink sink_;
+  return sink_;
+}
+
 /// Constexpr implementation of the strlen function
 /// \param string the string (C-style char*) thats length should be determined.
 /// \param length accumulator for length, should not be modified.
@@ -50,11 +112,11 @@ constexpr size_t constexpr_strlen(const char *string, const size_t length = 0)
     : constexpr_strlen(string + 1, length + 1);
 }
 
-/// Prints the given argument to the serial monitor.
+/// Prints the given argument to the serial monitor (and the in-memory ring).
 /// \tparam TYPE the type of the argument to be printed.
 /// \param arg the argument to be printed.
 template<typename TYPE>
-constexpr void LOG(TYPE arg) { Serial.print(arg); }
+constexpr void LOG(TYPE arg) { sink().print(arg); }
 
 /// Prints the given format to the console.
 /// '\\' works as an escape character.
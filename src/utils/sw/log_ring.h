@@ -0,0 +1,177 @@
+//===-- utils/sw/log_ring.h - LogRing class definition --------------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the LogRing class, which is a
+/// fixed size in-memory ring of the most recent log output.
+///
+/// The ring is written by the logger and read by any number of readers, each
+/// of which keeps its own Cursor (an absolute byte position). Readers never
+/// block the writer: if a reader falls more than SIZE bytes behind, its cursor
+/// is moved forward to the oldest byte still stored.
+///
+/// Writing is threadsafe, reading is lock-free.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_LOG_RING_H
+#define UTILS_SW_LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace PTS
+{
+
+/// LogRing class
+/// \tparam SIZE the number of bytes of log output kept in memory.
+template<size_t SIZE>
+class LogRing
+{
+ public:
+  /// Absolute byte position in the log output (wraps around after 4 GiB).
+  using Cursor = uint32_t;
+
+  // Power of two sizes keep positions continuous when the Cursor wraps.
+  static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0 && SIZE < (1UL << 31),
+                "The ring size must be a power of two below 2 GiB.");
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit LogRing()
+  : m_reserved(0), m_head(0), m_buffer{0}, m_write_lock()
+  { }
+
+  /// Deleted copy ctor and assignment operator - readers hold raw positions.
+  LogRing(const LogRing&) = delete;
+  LogRing& operator=(const LogRing&) = delete;
+
+//===-- Writer functions --------------------------------------------------===//
+
+  /// Appends data to the ring, overwriting the oldest bytes if necessary.
+  /// \param data the bytes to append.
+  /// \param length the number of bytes to append.
+  void write(const char *data, size_t length) const
+  {
+    if (length == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_write_lock);
+
+    Cursor head = m_head.load(std::memory_order_relaxed);
+    // Only the tail end of oversized writes would survive anyway.
+    if (length > SIZE)
+    {
+      head += length - SIZE;
+      data += length - SIZE;
+      length = SIZE;
+    }
+
+    // Announce the overwritten region before touching it, so that concurrent
+    // readers can detect that their copy may be torn.
+    m_reserved.store(head + length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t idx = 0; idx != length; idx++)
+      m_buffer[(head + idx) % SIZE] = data[idx];
+
+    m_head.store(head + length, std::memory_order_release);
+  }
+
+//===-- Reader functions --------------------------------------------------===//
+
+  /// \return the cursor pointing after the newest byte.
+  [[nodiscard]] Cursor newest() const
+  {
+    return m_head.load(std::memory_order_acquire);
+  }
+
+  /// \return the cursor pointing at the oldest byte still stored.
+  [[nodiscard]] Cursor oldest() const
+  {
+    const Cursor head = newest();
+    return head > SIZE ? head - SIZE : 0;
+  }
+
+  /// Returns a cursor at most max_bytes behind the newest byte, moved forward
+  /// to the start of the next full line if possible.
+  /// \param max_bytes the maximum number of bytes behind the newest byte.
+  /// \return the cursor to start reading from.
+  [[nodiscard]] Cursor tail(size_t max_bytes) const
+  {
+    const Cursor head = newest();
+    const size_t stored = head > SIZE ? SIZE : head;
+    const size_t length = max_bytes < stored ? max_bytes : stored;
+    Cursor cursor = head - length;
+
+    // A cursor at the very beginning of the output is already a line start.
+    if (cursor == 0) return cursor;
+
+    char line_buffer[32];
+    Cursor probe = cursor - 1;
+    size_t read_length;
+    while ((read_length = read(probe, line_buffer, sizeof(line_buffer))) != 0)
+    {
+      for (size_t idx = 0; idx != read_length; idx++)
+      {
+        if (line_buffer[idx] == '\n')
+          return probe - read_length + idx + 1;
+      }
+    }
+    return cursor;
+  }
+
+  /// Copies bytes from the position of the cursor and advances it.
+  /// If the cursor fell behind the stored region, it is moved to the oldest
+  /// stored byte first (the skipped bytes are lost for this reader).
+  /// \param cursor the reader's own cursor.
+  /// \param out the output buffer.
+  /// \param max_length the size of the output buffer.
+  /// \return the number of bytes copied (0 if there is nothing new).
+  size_t read(Cursor &cursor, char *out, size_t max_length) const
+  {
+    for (;;)
+    {
+      const Cursor head = m_head.load(std::memory_order_acquire);
+      if (static_cast<Cursor>(head - cursor) > SIZE)
+        cursor = head - SIZE;
+
+      const size_t available = static_cast<Cursor>(head - cursor);
+      const size_t length = available < max_length ? available : max_length;
+
+      for (size_t idx = 0; idx != length; idx++)
+        out[idx] = m_buffer[(cursor + idx) % SIZE];
+
+      // If the writer reserved a region that overlaps the copied one while
+      // copying, the copy might be torn: retry from the new oldest position.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const Cursor reserved = m_reserved.load(std::memory_order_relaxed);
+      if (static_cast<Cursor>(reserved - cursor) <= SIZE)
+      {
+        cursor += length;
+        return length;
+      }
+    }
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  /// The position the writer is currently writing up to.
+  mutable std::atomic<Cursor> m_reserved;
+  /// The position after the newest fully written byte.
+  mutable std::atomic<Cursor> m_head;
+  /// The stored bytes.
+  mutable char m_buffer[SIZE];
+  /// Mutex serializing concurrent writers.
+  mutable std::mutex m_write_lock;
+}; // class LogRing
+
+} // namespace PTS
+
+#endif // UTILS_SW_LOG_RING_H
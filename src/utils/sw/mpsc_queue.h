@@ -0,0 +1,129 @@
+//===-- utils/sw/mpsc_queue.h - MpscQueue class definition ----------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the MpscQueue class, which is a
+/// fixed capacity, lock-free FIFO queue for passing small values from any
+/// number of producer tasks to a single consumer task.
+///
+/// Every cell carries a sequence number telling whether it is free for the
+/// producer of a given position or holds the value for the consumer of it
+/// (D. Vyukov's bounded queue). Producers claim a position with a single
+/// compare-and-swap, so they never wait for each other or for the consumer:
+/// pushing to a full queue fails right away.
+///
+/// Pushing is threadsafe and lock-free, popping must be done by one task.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_MPSC_QUEUE_H
+#define UTILS_SW_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace PTS
+{
+
+/// MpscQueue class
+/// \tparam TYPE the type of the values (should be trivially copyable).
+/// \tparam SIZE the capacity of the queue, a power of two.
+template<typename TYPE, size_t SIZE>
+class MpscQueue
+{
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0,
+                "The queue size must be a power of two.");
+
+ public:
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit MpscQueue() : m_cells(), m_enqueue_position(0), m_dequeue_position(0)
+  {
+    for (size_t idx = 0; idx != SIZE; idx++)
+      m_cells[idx].sequence.store(idx, std::memory_order_relaxed);
+  }
+
+  /// Deleted copy ctor and assignment operator - producers hold positions.
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+//===-- Producer functions ------------------------------------------------===//
+
+  /// Appends a value to the queue.
+  /// \param value the value to append.
+  /// \return false, if the queue is full (nothing is appended), true
+  /// otherwise.
+  bool push(const TYPE &value) const
+  {
+    size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Cell &cell = m_cells[position & (SIZE - 1)];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const intptr_t difference =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+      if (difference == 0)
+      {
+        // The cell is free for this position, try to claim it.
+        if (m_enqueue_position.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed))
+        {
+          cell.value = value;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+      {
+        return false; // The consumer hasn't freed the cell yet: full.
+      }
+      else
+      {
+        position = m_enqueue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+//===-- Consumer functions ------------------------------------------------===//
+
+  /// Removes the oldest value from the queue.
+  /// \param value receives the removed value.
+  /// \return false, if the queue is empty, true otherwise.
+  bool pop(TYPE &value) const
+  {
+    const size_t position = m_dequeue_position;
+    Cell &cell = m_cells[position & (SIZE - 1)];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1) return false;
+
+    value = cell.value;
+    cell.sequence.store(position + SIZE, std::memory_order_release);
+    m_dequeue_position = position + 1;
+    return true;
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+ private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    TYPE value;
+  };
+
+  mutable Cell m_cells[SIZE];
+  /// The next position to be claimed by a producer.
+  mutable std::atomic<size_t> m_enqueue_position;
+  /// The next position to be popped (only touched by the consumer).
+  mutable size_t m_dequeue_position;
+}; // class MpscQueue
+
+} // namespace PTS
+
+#endif // UTILS_SW_MPSC_QUEUE_H
@@ -0,0 +1,271 @@
+//===-- utils/sw/time_series.h - TimeSeries class definition --------------===//
+//
+// Project-Thunderstrike (PTS) collection header file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the declarations of the TimeSeries class, which
+/// keeps the recent history of a numeric value at three resolutions.
+///
+/// Every sample goes into a ring of raw samples, and is folded into the
+/// bucket of its second. Finished second buckets (minimum, maximum and mean)
+/// go into a ring of their own, and are folded into ten second buckets in
+/// turn. Every ring overwrites its oldest entries, so the memory use is fixed
+/// by the template arguments, however long the series runs: the raw ring
+/// covers the last few changes, the coarser rings minutes to hours.
+///
+/// Buckets only exist for the periods that had samples, a value that didn't
+/// change for a while leaves a gap (the value of the gap is the one before).
+///
+/// The container is NOT threadsafe!
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef UTILS_SW_TIME_SERIES_H
+#define UTILS_SW_TIME_SERIES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PTS
+{
+
+/// TimeSeries class
+/// \tparam RAW_SIZE the number of raw samples kept.
+/// \tparam SECOND_SIZE the number of one second buckets kept.
+/// \tparam TEN_SECOND_SIZE the number of ten second buckets kept.
+template<size_t RAW_SIZE, size_t SECOND_SIZE, size_t TEN_SECOND_SIZE>
+class TimeSeries
+{
+ public:
+  /// The most entries a resolution has: the raw samples, or the buckets with
+  /// the unfinished ones (up to two ten second buckets, see forEachBucket()).
+  static constexpr size_t MAX_ENTRIES =
+    RAW_SIZE > SECOND_SIZE + 1
+      ? (RAW_SIZE > TEN_SECOND_SIZE + 2 ? RAW_SIZE : TEN_SECOND_SIZE + 2)
+      : (SECOND_SIZE > TEN_SECOND_SIZE ? SECOND_SIZE + 1 : TEN_SECOND_SIZE + 2);
+
+  /// The resolutions the series is kept at.
+  enum Resolution : uint8_t
+  {
+    RAW,
+    SECOND,
+    TEN_SECONDS,
+  };
+
+  /// A raw sample, as stored.
+  struct Sample
+  {
+    uint32_t time_ms;
+    float value;
+  };
+
+  /// The aggregate of the samples of a period, as stored.
+  struct Bucket
+  {
+    /// The start of the period.
+    uint32_t time_ms;
+    float min;
+    float max;
+    float mean;
+  };
+
+//===-- Instantiation specific functions ----------------------------------===//
+
+  explicit TimeSeries()
+  : m_raw(), m_seconds(), m_ten_seconds(), m_second(), m_ten_second()
+  { }
+
+  /// Removes every sample.
+  void clear()
+  {
+    m_raw.clear();
+    m_seconds.clear();
+    m_ten_seconds.clear();
+    m_second = Accumulator();
+    m_ten_second = Accumulator();
+  }
+
+//===-- Modifiers ---------------------------------------------------------===//
+
+  /// Adds a sample. Samples older than the previous one are recorded at the
+  /// time of the previous one.
+  /// \param time_ms the time of the sample in milliseconds.
+  /// \param value the value of the sample.
+  void add(uint32_t time_ms, float value)
+  {
+    if (!m_raw.empty() &&
+        static_cast<int32_t>(time_ms - m_raw.back().time_ms) < 0)
+      time_ms = m_raw.back().time_ms;
+
+    m_raw.push({time_ms, value});
+
+    const uint32_t second = time_ms - time_ms % 1000;
+    if (m_second.count != 0 && m_second.start != second) closeSecond();
+    m_second.add(second, value, value, value, 1);
+  }
+
+//===-- Element access ----------------------------------------------------===//
+
+  /// \return the number of entries kept at a resolution (including the
+  /// unfinished bucket).
+  [[nodiscard]] size_t size(Resolution resolution) const
+  {
+    if (resolution == RAW) return m_raw.size();
+
+    size_t count = 0;
+    forEachBucket(resolution, [&count](const Bucket&) { count++; });
+    return count;
+  }
+
+  /// Calls the visitor with the raw samples, oldest first.
+  /// \tparam VISITOR a callable taking a const Sample&.
+  template<typename VISITOR>
+  void forEachSample(VISITOR &&visitor) const
+  {
+    for (size_t idx = 0; idx != m_raw.size(); idx++) visitor(m_raw[idx]);
+  }
+
+  /// Calls the visitor with the buckets of a resolution, oldest first. The
+  /// raw samples are passed as buckets of a single sample, the unfinished
+  /// buckets come last.
+  /// \tparam VISITOR a callable taking a const Bucket&.
+  template<typename VISITOR>
+  void forEachBucket(Resolution resolution, VISITOR &&visitor) const
+  {
+    switch (resolution)
+    {
+      case RAW:
+        forEachSample([&visitor](const Sample &sample)
+        {
+          visitor(Bucket{sample.time_ms, sample.value, sample.value,
+                         sample.value});
+        });
+        break;
+      case SECOND:
+        for (size_t idx = 0; idx != m_seconds.size(); idx++)
+          visitor(m_seconds[idx]);
+        if (m_second.count != 0) visitor(m_second.bucket());
+        break;
+      default:
+      {
+        for (size_t idx = 0; idx != m_ten_seconds.size(); idx++)
+          visitor(m_ten_seconds[idx]);
+        // The open ten second bucket, with the open second folded in.
+        Accumulator open = m_ten_second;
+        if (m_second.count != 0)
+        {
+          const uint32_t start = m_second.start - m_second.start % 10000;
+          if (open.count != 0 && open.start != start)
+          {
+            visitor(open.bucket());
+            open = Accumulator();
+          }
+          open.add(start, m_second.min, m_second.max, m_second.sum,
+                   m_second.count);
+        }
+        if (open.count != 0) visitor(open.bucket());
+        break;
+      }
+    }
+  }
+
+//===-- Internals ---------------------------------------------------------===//
+
+ private:
+  /// Fixed size ring overwriting its oldest entries.
+  template<typename TYPE, size_t SIZE>
+  class Ring
+  {
+   public:
+    explicit Ring() : m_entries(), m_next(0), m_count(0) { }
+
+    void push(const TYPE &entry)
+    {
+      m_entries[m_next] = entry;
+      m_next = (m_next + 1) % SIZE;
+      if (m_count != SIZE) m_count++;
+    }
+
+    void clear() { m_next = m_count = 0; }
+
+    [[nodiscard]] size_t size() const { return m_count; }
+    [[nodiscard]] bool empty() const { return m_count == 0; }
+
+    /// \return the entry at an index, 0 being the oldest.
+    const TYPE &operator[](size_t idx) const
+    {
+      return m_entries[(m_next + SIZE - m_count + idx) % SIZE];
+    }
+
+    [[nodiscard]] const TYPE &back() const { return (*this)[m_count - 1]; }
+
+   private:
+    TYPE m_entries[SIZE];
+    size_t m_next;
+    size_t m_count;
+  };
+
+  /// The aggregate of an unfinished bucket.
+  struct Accumulator
+  {
+    uint32_t start = 0;
+    float min = 0;
+    float max = 0;
+    float sum = 0;
+    uint32_t count = 0;
+
+    void add(uint32_t bucket_start, float bucket_min, float bucket_max,
+             float bucket_sum, uint32_t bucket_count)
+    {
+      if (count == 0)
+      {
+        start = bucket_start;
+        min = bucket_min;
+        max = bucket_max;
+      }
+      else
+      {
+        if (bucket_min < min) min = bucket_min;
+        if (bucket_max > max) max = bucket_max;
+      }
+      sum += bucket_sum;
+      count += bucket_count;
+    }
+
+    [[nodiscard]] Bucket bucket() const
+    {
+      return {start, min, max, sum / count};
+    }
+  };
+
+  /// Stores the finished second, and folds it into its ten second bucket.
+  void closeSecond()
+  {
+    m_seconds.push(m_second.bucket());
+
+    const uint32_t start = m_second.start - m_second.start % 10000;
+    if (m_ten_second.count != 0 && m_ten_second.start != start)
+    {
+      m_ten_seconds.push(m_ten_second.bucket());
+      m_ten_second = Accumulator();
+    }
+    m_ten_second.add(start, m_second.min, m_second.max, m_second.sum,
+                     m_second.count);
+    m_second = Accumulator();
+  }
+
+//===-- Member variables --------------------------------------------------===//
+
+  Ring<Sample, RAW_SIZE> m_raw;
+  Ring<Bucket, SECOND_SIZE> m_seconds;
+  Ring<Bucket, TEN_SECOND_SIZE> m_ten_seconds;
+  Accumulator m_second;
+  Accumulator m_ten_second;
+}; // class TimeSeries
+
+} // namespace PTS
+
+#endif // UTILS_SW_TIME_SERIES_H
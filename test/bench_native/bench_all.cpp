@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+#include "bench_http_request.h"
+#include "bench_response.h"
+#include "bench_attribute_store.h"
+#include "bench_web_server.h"
+#include "bench_web_load.h"
+#include "bench_game_config.h"
+#include "bench_replicator.h"
+#include "bench_scoreboard_feed.h"
+#include "bench_animator.h"
+#include "bench_io_expander.h"
+#include "bench_led_strip.h"
+#include "bench_countdown.h"
+
+// Every benchmark prints a single JSON line starting with "BENCH ", so the
+// results can be collected with: pio test -e native_bench -v | grep BENCH
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "modules/hw/animator_module.h"
+#include "modules/hw/blinker_module.h"
+#include "utils/hw/led.h"
+
+#pragma once
+
+namespace bench_animator
+{
+
+using Blinker = PTS::BlinkerModule<100, 100>;
+using Animator = PTS::AnimatorModule<32>;
+
+/// The time measured for every number of leds.
+constexpr int RUN_MS = 2000;
+/// The stack depths the modules are started with.
+constexpr uint32_t BLINKER_STACK = 1024;
+constexpr uint32_t ANIMATOR_STACK = 2 * 1024;
+
+/// \return the CPU time of the process so far.
+uint64_t cpuMicros()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+           1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/// Prints the cost of blinking the leds for RUN_MS.
+void print(const char *engine, size_t led_count, size_t tasks,
+           size_t stack_words, size_t object_bytes, uint64_t cpu_us,
+           uint32_t writes)
+{
+  const double seconds = RUN_MS / 1000.0;
+  std::printf("BENCH {\"bench\":\"animator\",\"engine\":\"%s\","
+              "\"leds\":%zu,\"tasks\":%zu,\"stack_words\":%zu,"
+              "\"object_bytes\":%zu,\"cpu_us_per_s\":%.0f,"
+              "\"writes_per_s\":%.1f}\n",
+              engine, led_count, tasks, stack_words, object_bytes,
+              cpu_us / seconds, writes / seconds);
+}
+
+/// Blinks the leds with a BlinkerModule each.
+void runBlinkers(size_t led_count)
+{
+  std::unique_ptr<std::unique_ptr<Blinker>[]> blinkers(
+    new std::unique_ptr<Blinker>[led_count]);
+  for (size_t idx = 0; idx != led_count; idx++)
+  {
+    blinkers[idx].reset(new Blinker("blinker_" + std::to_string(idx),
+                                    static_cast<uint8_t>(idx)));
+    blinkers[idx]->begin();
+  }
+
+  const uint64_t cpu_start = cpuMicros();
+  for (size_t idx = 0; idx != led_count; idx++) blinkers[idx]->start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(RUN_MS));
+  const uint64_t cpu_us = cpuMicros() - cpu_start;
+
+  for (size_t idx = 0; idx != led_count; idx++) blinkers[idx]->destroy();
+  // The blinkers end at their next delay.
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  // A blinker writes on every change, 2 per period.
+  print("blinker_module", led_count, led_count, led_count * BLINKER_STACK,
+        led_count * sizeof(Blinker), cpu_us,
+        static_cast<uint32_t>(led_count * RUN_MS / 100));
+}
+
+/// Blinks the leds with a single AnimatorModule.
+void runAnimator(size_t led_count)
+{
+  std::vector<PTS::LED> leds;
+  leds.reserve(led_count); // The animator references them.
+  Animator animator;
+  for (size_t idx = 0; idx != led_count; idx++)
+  {
+    leds.emplace_back(static_cast<uint8_t>(idx));
+    leds[idx].begin();
+    ASSERT_TRUE(animator.play(leds[idx], PTS::Timeline::blink(100, 100)));
+  }
+
+  const uint64_t cpu_start = cpuMicros();
+  animator.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(RUN_MS));
+  const uint64_t cpu_us = cpuMicros() - cpu_start;
+  animator.destroy();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  print("animator_module", led_count, 1, ANIMATOR_STACK,
+        sizeof(Animator) + led_count * sizeof(PTS::LED), cpu_us,
+        animator.stats().writes);
+}
+
+}
+
+TEST(AnimatorBench, against_blinkers)
+{
+  SIM::serialEnabled() = false;
+  for (size_t leds : {1, 8, 32})
+  {
+    bench_animator::runBlinkers(leds);
+    bench_animator::runAnimator(leds);
+  }
+  SIM::serialEnabled() = true;
+}
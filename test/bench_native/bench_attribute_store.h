@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include "net/attribute_store.h"
+
+#pragma once
+
+namespace bench_attribute_store
+{
+
+/// The attribute updates as they used to be: a string keyed map behind a
+/// mutex, looked up twice and rebuilt on every update.
+struct MapStore
+{
+  struct Attribute
+  {
+    std::string value;
+    std::string description;
+    uint32_t version;
+  };
+
+  bool update(const std::string &name, const std::string &value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (attributes.find(name) == attributes.end()) return false;
+    attributes[name] = Attribute{value, attributes[name].description,
+                                 ++version};
+    return true;
+  }
+
+  std::map<std::string, Attribute> attributes;
+  std::mutex mutex;
+  uint32_t version = 0;
+};
+
+/// Runs the update for the given time and prints the cost per update.
+template<typename UPDATE>
+void run(const char *name, UPDATE update)
+{
+  size_t updates = 0;
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed{};
+  while (elapsed.count() < 0.5)
+  {
+    for (size_t idx = 0; idx != 10000; idx++, updates++) update(idx);
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  std::printf("BENCH {\"bench\":\"%s\",\"ns_per_update\":%.1f}\n",
+              name, elapsed.count() * 1e9 / updates);
+}
+
+}
+
+TEST(AttributeStoreBench, update)
+{
+  static bench_attribute_store::MapStore map_store;
+  static PTS::AttributeStore<32> store;
+  static PTS::AttributeHandle handle;
+
+  for (size_t idx = 0; idx != 16; idx++)
+  {
+    const std::string name = "attribute_" + std::to_string(idx);
+    map_store.attributes[name] = {"0", "Benchmark attribute.", 0};
+    handle = store.add(name.c_str(), "0", "Benchmark attribute.");
+  }
+
+  // The values are formatted up front, only the updates are measured.
+  static const char *const VALUES[] = {"10", "11", "12", "13", "14", "15"};
+  static const std::string VALUE_STRINGS[] = {"10", "11", "12", "13", "14",
+                                              "15"};
+
+  bench_attribute_store::run("attribute_update_map", [](size_t idx)
+  {
+    map_store.update("attribute_15", VALUE_STRINGS[idx % 6]);
+  });
+  bench_attribute_store::run("attribute_update_by_name", [](size_t idx)
+  {
+    store.update(store.find("attribute_15"), VALUES[idx % 6]);
+  });
+  bench_attribute_store::run("attribute_update_by_handle", [](size_t idx)
+  {
+    store.update(handle, VALUES[idx % 6]);
+  });
+}
+
+TEST(AttributeStoreBench, typed_update)
+{
+  static PTS::AttributeStore<32> store;
+  static const PTS::AttributeHandle text = store.add("text", "0", "");
+  static const PTS::AttributeHandle typed =
+    store.add("typed", PTS::AttributeValue::fromInteger(0), "");
+
+  // The loop() publishing the seconds since startup, formatted every pass
+  // as it used to, or stored raw (then most passes rewrite the same value).
+  bench_attribute_store::run("attribute_update_formatted", [](size_t idx)
+  {
+    store.update(text, std::to_string(idx / 1000).c_str());
+  });
+  bench_attribute_store::run("attribute_update_typed", [](size_t idx)
+  {
+    store.set(typed, PTS::AttributeType::INTEGER, idx);
+  });
+  bench_attribute_store::run("attribute_update_typed_unchanged", [](size_t idx)
+  {
+    store.set(typed, PTS::AttributeType::INTEGER, idx / 1000);
+  });
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "modules/countdown_module.h"
+
+#pragma once
+
+namespace bench_countdown
+{
+
+/// The time of every countdown, and the period of its display.
+constexpr uint32_t RUN_MS = 2000;
+constexpr uint32_t PERIOD_MS = 10;
+
+/// The times the display was fed.
+struct Display
+{
+  std::mutex lock;
+  std::vector<int64_t> at_us;
+
+  static void feed(void *arg, const PTS::CountdownTime&)
+  {
+    Display &display = *static_cast<Display*>(arg);
+    std::lock_guard<std::mutex> guard(display.lock);
+    display.at_us.push_back(esp_timer_get_time());
+  }
+};
+
+std::atomic<int64_t> expired_at{0};
+
+/// Spins on twice as many threads as there are cores, while it lives.
+class Load
+{
+ public:
+  explicit Load(bool enabled) : m_stop(false)
+  {
+    if (!enabled) return;
+    const unsigned count =
+      2 * std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned idx = 0; idx != count; idx++)
+      m_threads.emplace_back([this]()
+      {
+        volatile uint64_t spin = 0;
+        while (!m_stop.load(std::memory_order_relaxed)) spin = spin + 1;
+      });
+  }
+
+  ~Load()
+  {
+    m_stop = true;
+    for (std::thread &thread : m_threads) thread.join();
+  }
+
+ private:
+  std::atomic<bool> m_stop;
+  std::vector<std::thread> m_threads;
+};
+
+/// \return a percentile of sorted values.
+int64_t percentile(const std::vector<int64_t> &sorted, double fraction)
+{
+  if (sorted.empty()) return 0;
+  return sorted[static_cast<size_t>(fraction * (sorted.size() - 1))];
+}
+
+/// Runs a countdown with a display fed every PERIOD_MS, and a clock counting
+/// the ticks of a task delayed by PERIOD_MS, as a loop would. Prints how late
+/// the display and the expiry were, and how far the counted ticks drifted.
+void run(bool loaded)
+{
+  PTS::CountdownModule<> countdown("countdown", RUN_MS);
+  Display display;
+  const int64_t subscribed_us = esp_timer_get_time();
+  countdown.subscribe(&Display::feed, &display, PERIOD_MS);
+  countdown.onExpiry([](void*) { expired_at = esp_timer_get_time(); },
+                     nullptr);
+  countdown.begin();
+
+  int64_t deadline;
+  int64_t counted_ms = 0;
+  int64_t elapsed_us;
+  {
+    const Load load(loaded);
+    countdown.threadFunc();
+    deadline = countdown.deadline();
+    const int64_t start = esp_timer_get_time();
+    while (esp_timer_get_time() < deadline)
+    {
+      vTaskDelay(pdMS_TO_TICKS(PERIOD_MS));
+      counted_ms += PERIOD_MS;
+    }
+    elapsed_us = esp_timer_get_time() - start;
+    while (countdown.getState() == PTS::Stateful::ACTIVE) vTaskDelay(1);
+  }
+
+  // The lateness of the periodic feeds from their schedule, without those
+  // of the start and the expiry.
+  std::vector<int64_t> late;
+  {
+    std::lock_guard<std::mutex> guard(display.lock);
+    const int64_t period_us = PERIOD_MS * 1000;
+    for (size_t idx = 1; idx + 1 < display.at_us.size(); idx++)
+      late.push_back((display.at_us[idx] - subscribed_us) % period_us);
+  }
+  std::sort(late.begin(), late.end());
+
+  std::printf("BENCH {\"bench\":\"countdown\",\"load\":%s,\"run_ms\":%u,"
+              "\"feeds\":%zu,\"feed_late_p50_us\":%lld,"
+              "\"feed_late_p99_us\":%lld,\"feed_late_max_us\":%lld,"
+              "\"expiry_late_us\":%lld,\"tick_count_drift_ms\":%lld}\n",
+              loaded ? "true" : "false", RUN_MS, late.size(),
+              static_cast<long long>(percentile(late, 0.5)),
+              static_cast<long long>(percentile(late, 0.99)),
+              static_cast<long long>(late.empty() ? 0 : late.back()),
+              static_cast<long long>(expired_at - deadline),
+              static_cast<long long>(elapsed_us / 1000 - counted_ms));
+}
+
+}
+
+TEST(CountdownBench, accuracy_under_load)
+{
+  SIM::serialEnabled() = false;
+  bench_countdown::run(false);
+  bench_countdown::run(true);
+  SIM::serialEnabled() = true;
+}
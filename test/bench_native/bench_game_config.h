@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "modules/game_config.h"
+#include "modules/game_image.h"
+#include "modules/module_factory.h"
+
+#pragma once
+
+namespace bench_game_config
+{
+
+/// A game using every module type.
+const char *const GAME = R"({
+  "name": "bench",
+  "modules": [
+    {"type": "keypad", "name": "keypad", "cols": [25, 33, 32],
+     "rows": [35, 34, 39, 36], "keys": ["123", "456", "789", "*0#"]},
+    {"type": "keypad", "name": "keypad_4x4", "cols": [12, 13, 14, 15],
+     "rows": [26, 27, 5, 0], "keys": ["123A", "456B", "789C", "*0#D"]},
+    {"type": "wire_disconnect", "name": "wires", "wires": [16, 17, 18],
+     "led": [19, 21, 22]},
+    {"type": "blinker", "name": "blinker", "pin": 2, "on_ms": 100,
+     "off_ms": 900},
+    {"type": "buzzer", "name": "buzzer", "pin": 23, "tone_hz": 1000},
+    {"type": "led", "name": "armed", "pin": 4, "on": true}]})";
+
+/// Runs the step for the given time.
+/// \return the cost of a step in microseconds.
+template<typename STEP>
+double run(STEP step)
+{
+  size_t steps = 0;
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed{};
+  while (elapsed.count() < 0.5)
+  {
+    for (size_t idx = 0; idx != 100; idx++, steps++) step();
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+  return elapsed.count() * 1e6 / steps;
+}
+
+}
+
+TEST(GameConfigBench, boot_to_armed)
+{
+  using namespace bench_game_config;
+  SIM::serialEnabled() = false; // The modules log their construction.
+
+  static PTS::GameConfig config;
+  static PTS::ModuleFactory<> factory;
+
+  // Reading the setup file in the 64 byte chunks of a LittleFS file.
+  const double parse_us = run([]()
+  {
+    PTS::GameConfigParser parser(config);
+    const size_t length = std::strlen(GAME);
+    for (size_t offset = 0; offset < length; offset += 64)
+      parser.feed(GAME + offset, std::min<size_t>(64, length - offset));
+    parser.finish();
+  });
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(GAME, config));
+
+  // Building and setting up the modules (the threads are not started).
+  const double build_us = run([]()
+  {
+    factory.build(config);
+    factory.begin();
+  });
+  ASSERT_EQ(6u, factory.size());
+
+  std::printf("BENCH {\"bench\":\"game_config_json\",\"bytes\":%zu,"
+              "\"config_bytes\":%zu,\"parse_us\":%.2f,\"build_us\":%.2f,"
+              "\"arena_bytes\":%zu,\"boot_to_armed_us\":%.2f}\n",
+              std::strlen(GAME), sizeof(config), parse_us, build_us,
+              factory.used(), parse_us + build_us);
+  factory.clear();
+}
+
+TEST(GameConfigBench, boot_to_armed_from_image)
+{
+  using namespace bench_game_config;
+  SIM::serialEnabled() = false;
+
+  static PTS::GameConfig config;
+  static PTS::ModuleFactory<> factory;
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(GAME, config));
+
+  // The compiled game, as mapped from its partition.
+  alignas(PTS::ModuleConfig) static uint8_t image[
+    PTS::GameImage::imageSize(PTS::GameConfig::MAX_MODULES)];
+  const size_t length = PTS::GameImage::write(config, image, sizeof(image));
+  ASSERT_NE(0u, length);
+
+  // Checking the image, then building in place (as the json bench builds).
+  const double open_us = run([]()
+  {
+    PTS::GameImage game;
+    game.open(image, sizeof(image));
+  });
+  const double build_us = run([]()
+  {
+    PTS::GameImage game;
+    game.open(image, sizeof(image));
+    factory.build(game.modules(), game.size());
+    factory.begin();
+  });
+  ASSERT_EQ(6u, factory.size());
+
+  std::printf("BENCH {\"bench\":\"game_config_image\",\"bytes\":%zu,"
+              "\"open_us\":%.2f,\"build_us\":%.2f,"
+              "\"arena_bytes\":%zu,\"boot_to_armed_us\":%.2f}\n",
+              length, open_us, build_us - open_us, factory.used(), build_us);
+  factory.clear();
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "net/http_request.h"
+#include "net/http_router.h"
+
+#pragma once
+
+namespace bench_http_request
+{
+
+/// A typical request of a mobile browser.
+const char REQUEST[] =
+  "GET /api/attributes?since=1234 HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "Connection: keep-alive\r\n"
+  "User-Agent: Mozilla/5.0 (Linux; Android 14; Pixel 8) AppleWebKit/537.36 "
+  "(KHTML, like Gecko) Chrome/126.0.0.0 Mobile Safari/537.36\r\n"
+  "Accept: application/json,text/html;q=0.9,*/*;q=0.8\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "Accept-Language: en-US,en;q=0.9,hu;q=0.8\r\n"
+  "If-None-Match: \"v1234\"\r\n"
+  "\r\n";
+
+/// Parses (and optionally routes) the request fed in pieces of the given size.
+void run(const char *name, size_t piece_size, bool route)
+{
+  static PTS::RequestParser<> parser;
+  static PTS::Router<16, int&> router;
+  static bool routes_registered = false;
+  if (!routes_registered)
+  {
+    static const char *const PATHS[] = {
+      "/", "/log", "/log/stream", "/api/events", "/api/history",
+      "/api/commands", "/api/attributes", "/assets/*",
+    };
+    for (const char *path : PATHS)
+      router.on(PTS::HttpMethod::GET, path,
+                [](const PTS::HttpRequest&, int &handled) { handled++; });
+    routes_registered = true;
+  }
+
+  const size_t length = std::strlen(REQUEST);
+  size_t requests = 0;
+  int handled = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed{};
+  while (elapsed.count() < 0.5)
+  {
+    for (size_t idx = 0; idx != 1000; idx++, requests++)
+    {
+      parser.reset();
+      for (size_t offset = 0; offset < length; offset += piece_size)
+        parser.feed(REQUEST + offset,
+                    std::min(piece_size, length - offset));
+      if (route) router.dispatch(parser.request(), handled);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE, parser.status());
+  std::printf("BENCH {\"bench\":\"%s\",\"piece_size\":%zu,"
+              "\"requests_per_second\":%.0f,\"megabytes_per_second\":%.1f}\n",
+              name, piece_size, requests / elapsed.count(),
+              requests * length / elapsed.count() / 1e6);
+}
+
+}
+
+TEST(RequestParserBench, parse)
+{
+  bench_http_request::run("parse", 1, false);
+  bench_http_request::run("parse", 64, false);
+  bench_http_request::run("parse", 1460, false);
+  bench_http_request::run("parse_and_route", 1460, true);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <SPI.h>
+#include <Wire.h>
+#include "utils/hw/io_expander.h"
+
+#pragma once
+
+namespace bench_io_expander
+{
+
+/// The scans measured for every setup.
+constexpr uint32_t SCANS = 20000;
+/// The bus clocks the time on the wire is counted at.
+constexpr uint32_t SPI_HZ = 8000000;
+constexpr uint32_t I2C_HZ = 400000;
+
+/// Prints the cost of a scan, with an output changing on every one.
+void print(const char *backend, size_t lines, size_t chips, double host_ns,
+           const SIM::BusStats &stats)
+{
+  std::printf("BENCH {\"bench\":\"io_expander\",\"backend\":\"%s\","
+              "\"lines\":%zu,\"chips\":%zu,\"host_ns_per_scan\":%.0f,"
+              "\"transactions_per_scan\":%.2f,\"bus_bytes_per_scan\":%.1f,"
+              "\"bus_us_per_scan\":%.1f}\n",
+              backend, lines, chips, host_ns,
+              double(stats.transactions) / SCANS, double(stats.bytes) / SCANS,
+              stats.bus_ns / 1000.0 / SCANS);
+}
+
+/// Scans a 74HC165 and 74HC595 chain, half of the lines each.
+template<size_t LINES>
+void runShiftRegisters()
+{
+  constexpr size_t BYTES = LINES / 16;
+  SIM::ShiftRegisterChain chips(BYTES, BYTES);
+  SPIClass spi;
+  spi.sim_device = &chips;
+  PTS::ShiftRegisterChain<BYTES, BYTES> chain(spi, 25, 26, SPI_HZ);
+  chain.begin();
+  spi.sim_stats = {};
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t scan = 0; scan != SCANS; scan++)
+  {
+    // Every output line flips every other round.
+    chain.write(static_cast<uint8_t>(scan % (LINES / 2)),
+                (scan / (LINES / 2)) & 1);
+    chain.scan();
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  print("74hc165_74hc595", LINES, 2 * BYTES, elapsed.count() / SCANS,
+        spi.sim_stats);
+}
+
+/// Scans MCP23017s, half of the lines of each input and half output.
+template<size_t LINES>
+void runMcp23017()
+{
+  constexpr size_t CHIPS = LINES / PTS::Mcp23017::LINE_COUNT;
+  static_assert(CHIPS <= 8, "The MCP23017 has 8 addresses.");
+  std::unique_ptr<SIM::Mcp23017[]> chips(new SIM::Mcp23017[CHIPS]);
+  TwoWire wire;
+  wire.setClock(I2C_HZ);
+  std::unique_ptr<std::unique_ptr<PTS::Mcp23017>[]> expanders(
+    new std::unique_ptr<PTS::Mcp23017>[CHIPS]);
+  for (size_t idx = 0; idx != CHIPS; idx++)
+  {
+    const uint8_t address = static_cast<uint8_t>(0x20 + idx);
+    wire.sim_devices[address] = &chips[idx];
+    expanders[idx].reset(new PTS::Mcp23017(wire, address));
+    for (uint8_t line = 8; line != 16; line++)
+      expanders[idx]->mode(line, OUTPUT);
+    expanders[idx]->begin();
+  }
+  wire.sim_stats = {};
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t scan = 0; scan != SCANS; scan++)
+  {
+    expanders[scan % CHIPS]->write(static_cast<uint8_t>(8 + scan % 8),
+                                   (scan / 8) & 1);
+    for (size_t idx = 0; idx != CHIPS; idx++) expanders[idx]->scan();
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  print("mcp23017", LINES, CHIPS, elapsed.count() / SCANS, wire.sim_stats);
+}
+
+}
+
+TEST(IoExpanderBench, scans)
+{
+  SIM::serialEnabled() = false;
+  bench_io_expander::runShiftRegisters<64>();
+  bench_io_expander::runShiftRegisters<128>();
+  bench_io_expander::runMcp23017<64>();
+  bench_io_expander::runMcp23017<128>();
+  SIM::serialEnabled() = true;
+}
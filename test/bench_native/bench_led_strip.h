@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include "utils/hw/led_strip.h"
+
+#pragma once
+
+namespace bench_led_strip
+{
+
+constexpr size_t PIXELS = 300;
+using Strip = PTS::LedStrip<PIXELS>;
+/// The frames measured for every case.
+constexpr uint32_t FRAMES = 200;
+
+using Clock = std::chrono::steady_clock;
+
+double micros(Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+/// A rainbow moving by a pixel every frame, every pixel changes.
+PTS::Color rainbow(size_t pixel, uint32_t frame)
+{
+  const uint8_t hue = static_cast<uint8_t>((pixel + frame) * 256 / PIXELS);
+  return PTS::Color{hue, static_cast<uint8_t>(255 - hue),
+                    static_cast<uint8_t>(hue * 2)};
+}
+
+/// Encodes a frame bit by bit, scaling every component on the way, as a
+/// driver without tables would.
+void encodeNaively(const PTS::Color *pixels, uint8_t brightness,
+                   rmt_item32_t *items)
+{
+  for (size_t idx = 0; idx != PIXELS; idx++)
+  {
+    const uint8_t components[3] = {pixels[idx].g, pixels[idx].r,
+                                   pixels[idx].b};
+    for (uint8_t component : components)
+    {
+      const uint32_t level =
+        (PTS::RGBLED::gamma(component) * brightness +
+         PTS::RGBLED::MAX_DUTY / 2) / PTS::RGBLED::MAX_DUTY;
+      for (int bit = 7; bit >= 0; bit--)
+        (items++)->val = PTS::WS2812::symbol((level >> bit) & 1);
+    }
+  }
+}
+
+/// Prints a row, without the frame rate if fps is negative (the encoding
+/// alone, nothing sent).
+void print(const char *encoder, const char *change, double encode_us,
+           double fps = -1)
+{
+  std::printf("BENCH {\"bench\":\"led_strip\",\"pixels\":%zu,"
+              "\"encoder\":\"%s\",\"change\":\"%s\","
+              "\"encode_us_per_frame\":%.1f",
+              PIXELS, encoder, change, encode_us);
+  if (fps >= 0) std::printf(",\"fps\":%.1f", fps);
+  std::printf("}\n");
+}
+
+/// The frames per second of a strip sending, with all or a single pixel
+/// changing every frame, and the CPU time of setting and encoding them.
+void runStrip(bool all)
+{
+  static Strip strip(18, 0);
+  strip.begin();
+  strip.show();
+  strip.wait();
+
+  // A frame is rendered while the previous one is sent.
+  const Clock::time_point start = Clock::now();
+  for (uint32_t frame = 0; frame != FRAMES; frame++)
+  {
+    if (all)
+      for (size_t idx = 0; idx != PIXELS; idx++)
+        strip.set(idx, rainbow(idx, frame));
+    else
+      strip.bar(frame % PIXELS + 1, PTS::COLOR::RED);
+    strip.show();
+  }
+  strip.wait();
+  const double elapsed_us = micros(Clock::now() - start);
+
+  // The encoding alone, without sending.
+  static Strip offline(18, 1);
+  Clock::duration encode{};
+  for (uint32_t frame = 0; frame != FRAMES; frame++)
+  {
+    if (all)
+      for (size_t idx = 0; idx != PIXELS; idx++)
+        offline.set(idx, rainbow(idx, frame));
+    else
+      offline.bar(frame % PIXELS + 1, PTS::COLOR::RED);
+    const Clock::time_point before = Clock::now();
+    offline.show();
+    encode += Clock::now() - before;
+  }
+
+  print("tables", all ? "all" : "one", micros(encode) / FRAMES,
+        FRAMES / (elapsed_us / 1e6));
+}
+
+/// The encoding of a frame without the tables, for comparison.
+void runNaive()
+{
+  std::unique_ptr<PTS::Color[]> pixels(new PTS::Color[PIXELS]);
+  std::unique_ptr<rmt_item32_t[]> items(new rmt_item32_t[Strip::ITEMS]);
+  Clock::duration encode{};
+  uint32_t checksum = 0;
+  for (uint32_t frame = 0; frame != FRAMES; frame++)
+  {
+    for (size_t idx = 0; idx != PIXELS; idx++)
+      pixels[idx] = rainbow(idx, frame);
+    const Clock::time_point before = Clock::now();
+    encodeNaively(pixels.get(), 255, items.get());
+    encode += Clock::now() - before;
+    checksum += items[frame % (Strip::ITEMS - 1)].val;
+  }
+  ASSERT_NE(0u, checksum);
+  print("naive", "all", micros(encode) / FRAMES);
+}
+
+}
+
+TEST(LedStripBench, frames_per_second)
+{
+  SIM::serialEnabled() = false;
+  bench_led_strip::runStrip(true);
+  bench_led_strip::runStrip(false);
+  bench_led_strip::runNaive();
+  SIM::serialEnabled() = true;
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "net/replicator.h"
+
+#pragma once
+
+namespace bench_replicator
+{
+
+using Board = PTS::Replicator<>;
+
+constexpr size_t BOARD_COUNT = 4;
+/// The number of writes of a run, one every WRITE_MS.
+constexpr int32_t WRITES = 40;
+constexpr int WRITE_MS = 50;
+
+/// Four boards on the loopback, every one sending to the other three.
+struct Game
+{
+  explicit Game(uint16_t base_port)
+    : boards{Board(0, base_port), Board(1, base_port + 1),
+             Board(2, base_port + 2), Board(3, base_port + 3)}
+  {
+    for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+    {
+      Board &board = boards[idx];
+      score[idx] = board.add("score", PTS::ReplicaType::INTEGER);
+      board.add("wires", PTS::ReplicaType::STATE);
+      board.add("countdown", PTS::ReplicaType::COUNTDOWN);
+      for (size_t peer = 0; peer != BOARD_COUNT; peer++)
+        if (peer != idx)
+          board.addDestination(IPAddress(127, 0, 0, 1), base_port + peer);
+      board.begin();
+      board.start();
+    }
+  }
+
+  /// \return true, if every board has the score.
+  bool scoreIs(int32_t value) const
+  {
+    for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+      if (boards[idx].getInteger(score[idx]) != value) return false;
+    return true;
+  }
+
+  Board boards[BOARD_COUNT];
+  PTS::ReplicaHandle score[BOARD_COUNT];
+};
+
+/// Writes a score on every board in turn, each time waiting for every board to
+/// have it, then prints the traffic and the latency.
+void run(Game &game, uint8_t loss_percent)
+{
+  using Clock = std::chrono::steady_clock;
+  SIM::udpLossPercent() = loss_percent;
+
+  // The peers find each other first.
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  PTS::ReplicationStats before[BOARD_COUNT];
+  for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+    before[idx] = game.boards[idx].stats();
+
+  double total_ms = 0;
+  double max_ms = 0;
+  const auto start = Clock::now();
+  for (int32_t score = 1; score <= WRITES; score++)
+  {
+    const size_t writer = score % BOARD_COUNT;
+    const auto written = Clock::now();
+    game.boards[writer].setInteger(game.score[writer], score);
+    while (!game.scoreIs(score) &&
+           Clock::now() - written < std::chrono::seconds(5))
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_TRUE(game.scoreIs(score));
+
+    const double ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - written).count();
+    total_ms += ms;
+    if (ms > max_ms) max_ms = ms;
+    std::this_thread::sleep_until(written +
+                                  std::chrono::milliseconds(WRITE_MS));
+  }
+  const double seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  SIM::udpLossPercent() = 0;
+
+  uint32_t bytes = 0;
+  uint32_t packets = 0;
+  uint32_t resent = 0;
+  uint32_t acknowledged_ms = 0;
+  for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+  {
+    const PTS::ReplicationStats stats = game.boards[idx].stats();
+    bytes += stats.bytes_sent - before[idx].bytes_sent;
+    packets += stats.packets_sent - before[idx].packets_sent;
+    resent += stats.resent_values - before[idx].resent_values;
+    if (stats.max_convergence_ms > acknowledged_ms)
+      acknowledged_ms = stats.max_convergence_ms;
+  }
+
+  std::printf("BENCH {\"bench\":\"replicator\",\"boards\":%zu,"
+              "\"loss_percent\":%u,\"writes_per_s\":%.1f,"
+              "\"bytes_per_s_per_board\":%.0f,"
+              "\"packets_per_s_per_board\":%.1f,\"resent_values\":%u,"
+              "\"convergence_avg_ms\":%.1f,\"convergence_max_ms\":%.1f,"
+              "\"acknowledged_max_ms\":%u}\n",
+              BOARD_COUNT, loss_percent, WRITES / seconds,
+              bytes / seconds / BOARD_COUNT,
+              packets / seconds / BOARD_COUNT, resent, total_ms / WRITES,
+              max_ms, acknowledged_ms);
+}
+
+}
+
+TEST(ReplicatorBench, lossless)
+{
+  SIM::serialEnabled() = false;
+  static bench_replicator::Game game(42201);
+  bench_replicator::run(game, 0);
+  for (auto &board : game.boards) board.destroy();
+}
+
+TEST(ReplicatorBench, lossy)
+{
+  SIM::serialEnabled() = false;
+  static bench_replicator::Game game(42211);
+  bench_replicator::run(game, 20);
+  for (auto &board : game.boards) board.destroy();
+}
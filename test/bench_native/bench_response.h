@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "net/attribute_store.h"
+#include "net/http_response.h"
+#include "net/web_pages.h"
+
+#pragma once
+
+namespace bench_response
+{
+
+/// Client counting the writes (each would be a send() call on a socket).
+struct CountingClient
+{
+  size_t write(const uint8_t *, size_t length)
+  {
+    writes++;
+    bytes += length;
+    return length;
+  }
+
+  size_t writes = 0;
+  size_t bytes = 0;
+};
+
+/// Writer sending every fragment immediately, like the page used to be sent.
+struct UnbufferedWriter
+{
+  void write(const char *data, size_t length)
+  {
+    client->write(reinterpret_cast<const uint8_t*>(data), length);
+  }
+  void writeStatic(const char *data, size_t length) { write(data, length); }
+  void print(const char *text) { write(text, std::strlen(text)); }
+  void print(uint32_t number) { print(std::to_string(number).c_str()); }
+  /// Escapes like ResponseWriter, sending every run and entity at once.
+  void printEscaped(const char *text)
+  {
+    const char *run = text;
+    for (; *text; text++)
+    {
+      const char *entity = nullptr;
+      switch (*text)
+      {
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '&': entity = "&amp;"; break;
+        case '"': entity = "&quot;"; break;
+        default: continue;
+      }
+      if (text != run) write(run, text - run);
+      print(entity);
+      run = text + 1;
+    }
+    if (text != run) write(run, text - run);
+  }
+
+  CountingClient *client;
+};
+
+using Attributes = PTS::AttributeStore<200>;
+
+const Attributes &makeAttributes(size_t count)
+{
+  static Attributes attributes;
+  for (size_t idx = 0; idx != 200; idx++)
+  {
+    const std::string name = "attribute_" + std::to_string(idx);
+    if (idx < count)
+      attributes.add(name.c_str(), std::to_string(idx * 7919).c_str(),
+                     "Benchmark attribute.");
+    else
+      attributes.remove(name.c_str());
+  }
+  return attributes;
+}
+
+/// Renders pages for the given time and prints the results.
+template<typename RENDER>
+void run(const char *name, size_t attribute_count, RENDER render)
+{
+  const Attributes::Snapshot attributes =
+    makeAttributes(attribute_count).snapshot();
+  CountingClient client;
+  size_t pages = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed{};
+  while (elapsed.count() < 0.5)
+  {
+    for (size_t idx = 0; idx != 100; idx++, pages++)
+      render(client, attributes);
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  std::printf("BENCH {\"bench\":\"%s\",\"attributes\":%zu,"
+              "\"pages_per_second\":%.0f,\"writes_per_page\":%.2f,"
+              "\"bytes_per_page\":%zu}\n",
+              name, attribute_count, pages / elapsed.count(),
+              static_cast<double>(client.writes) / pages,
+              client.bytes / pages);
+}
+
+}
+
+TEST(ResponseWriterBench, attribute_page)
+{
+  static PTS::ResponseWriter<bench_response::CountingClient> writer;
+
+  for (size_t attribute_count : {4, 40, 200})
+  {
+    bench_response::run("page_buffered", attribute_count,
+      [](bench_response::CountingClient &client,
+         const bench_response::Attributes::Snapshot &attributes)
+    {
+      writer.begin(client, "200 OK");
+      writer.header("Connection", "close");
+      PTS::PAGE::renderAttributes(writer, attributes, "192.168.4.2", 50000);
+      writer.end();
+    });
+
+    bench_response::run("page_unbuffered", attribute_count,
+      [](bench_response::CountingClient &client,
+         const bench_response::Attributes::Snapshot &attributes)
+    {
+      bench_response::UnbufferedWriter unbuffered{&client};
+      unbuffered.print("HTTP/1.1 200 OK\r\n");
+      unbuffered.print("Content-type:text/html\r\n");
+      unbuffered.print("Connection: close\r\n\r\n");
+      PTS::PAGE::renderAttributes(unbuffered, attributes, "192.168.4.2",
+                                  50000);
+    });
+  }
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include "net/attribute_store.h"
+#include "net/scoreboard_codec.h"
+#include "net/scoreboard_feed.h"
+
+#pragma once
+
+namespace bench_scoreboard_feed
+{
+
+using Store = PTS::AttributeStore<16>;
+using View = PTS::ScoreboardView<16>;
+
+constexpr uint16_t PORT = 42131;
+/// The time measured for every number of listeners.
+constexpr int RUN_MS = 2000;
+
+/// A simulated phone, listening to the feed.
+struct Listener
+{
+  WiFiUDP socket;
+  View view;
+};
+
+/// Runs a feed with a busy game (the score changing every 10 ms) for
+/// RUN_MS, with the given number of listeners on the loopback, and prints
+/// the cost of the board.
+void run(size_t listener_count)
+{
+  using Clock = std::chrono::steady_clock;
+  SIM::serialEnabled() = false;
+
+  Store store;
+  PTS::AttributeHandle score =
+    store.add("score", PTS::AttributeValue::fromInteger(0), "");
+  for (int idx = 0; idx != 15; idx++)
+    store.add(("attribute_" + std::to_string(idx)).c_str(), "a value", "");
+
+  std::unique_ptr<Listener[]> listeners(new Listener[listener_count]);
+  for (size_t idx = 0; idx != listener_count; idx++)
+    ASSERT_TRUE(listeners[idx].socket.begin(PORT));
+
+  // The listeners decode on their own thread, like phones would.
+  std::atomic<bool> running(true);
+  std::thread receiver([&]()
+  {
+    uint8_t packet[PTS::SCOREBOARD::PACKET_SIZE];
+    while (running)
+    {
+      for (size_t idx = 0; idx != listener_count; idx++)
+      {
+        Listener &listener = listeners[idx];
+        for (int length; (length = listener.socket.parsePacket()) > 0;)
+        {
+          listener.socket.read(packet, sizeof(packet));
+          listener.view.receive(packet, static_cast<size_t>(length));
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  PTS::ScoreboardFeed<Store> feed(store, IPAddress(255, 255, 255, 255), PORT);
+  feed.begin();
+  feed.start();
+  const auto start = Clock::now();
+  for (int32_t value = 1; Clock::now() - start < std::chrono::milliseconds(
+                                                   RUN_MS); value++)
+  {
+    store.set(score, PTS::AttributeType::INTEGER,
+              static_cast<uint32_t>(value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  feed.destroy();
+  const double seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  running = false;
+  receiver.join();
+
+  // Every listener got every datagram, and has the last score. The board
+  // sends the same datagrams whatever the number of listeners: the encoding
+  // and the bytes on the air stay flat. Only the time in the socket grows on
+  // the host, as the loopback copies the datagram to every listening socket
+  // within the send (a radio sends it once).
+  const PTS::ScoreboardFeedStats stats = feed.stats();
+  const double frames = stats.frames;
+  size_t synced = 0;
+  uint32_t received = 0;
+  for (size_t idx = 0; idx != listener_count; idx++)
+  {
+    synced += listeners[idx].view.synced();
+    received += listeners[idx].view.packets();
+  }
+  ASSERT_EQ(listener_count, synced);
+
+  std::printf("BENCH {\"bench\":\"scoreboard_feed\",\"listeners\":%zu,"
+              "\"frames_per_s\":%.1f,\"packets_per_s\":%.1f,"
+              "\"bytes_per_s\":%.0f,\"encode_us_per_frame\":%.2f,"
+              "\"send_us_per_frame\":%.2f,\"delivered_percent\":%.1f}\n",
+              listener_count, stats.frames / seconds,
+              stats.packets / seconds, stats.bytes / seconds,
+              (stats.busy_us - stats.send_us) / frames, stats.send_us / frames,
+              100.0 * received / (stats.packets * listener_count));
+  SIM::serialEnabled() = true;
+}
+
+}
+
+TEST(ScoreboardFeedBench, listeners)
+{
+  for (size_t listeners : {1, 10, 100})
+    bench_scoreboard_feed::run(listeners);
+}
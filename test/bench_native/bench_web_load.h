@@ -0,0 +1,357 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <malloc.h>
+#include <sys/resource.h>
+#include "bench_web_server.h"
+
+#pragma once
+
+/// Load and soak benchmark of the WebServer over loopback sockets. The run is
+/// configured with environment variables, so long soaks don't need a rebuild:
+///   PTS_LOAD_CLIENTS    number of concurrent clients (default 12)
+///   PTS_LOAD_SECONDS    duration of the run (default 3)
+///   PTS_LOAD_MIX        weights of the client roles (default
+///                       "page:2,api:6,asset:2,push:2")
+///   PTS_LOAD_UPDATE_HZ  attribute updates per second (default 200)
+///   PTS_LOAD_ATTRIBUTES number of updated attributes (default 16)
+/// Roles: "page" fetches the attribute page, "api" polls the attribute deltas
+/// with If-None-Match, "asset" fetches the style sheet, "push" subscribes to
+/// the events. Every role prints a BENCH line, followed by a summary of the
+/// attribute writer and the memory use.
+namespace bench_web_load
+{
+
+enum Role : size_t { PAGE, API, ASSET, PUSH, ROLE_COUNT };
+
+static const char *const ROLE_NAMES[ROLE_COUNT] = {"page", "api", "asset",
+                                                   "push"};
+
+/// The configuration of a run.
+struct Config
+{
+  size_t clients;
+  double seconds;
+  size_t weights[ROLE_COUNT];
+  double update_hz;
+  size_t attributes;
+};
+
+/// \return the value of an environment variable, or the fallback.
+double environment(const char *name, double fallback)
+{
+  const char *value = std::getenv(name);
+  return value ? std::atof(value) : fallback;
+}
+
+/// Reads the configuration from the environment.
+Config readConfig()
+{
+  Config config{};
+  config.clients = static_cast<size_t>(environment("PTS_LOAD_CLIENTS", 12));
+  config.seconds = environment("PTS_LOAD_SECONDS", 3);
+  config.update_hz = environment("PTS_LOAD_UPDATE_HZ", 200);
+  config.attributes = std::min<size_t>(
+    static_cast<size_t>(environment("PTS_LOAD_ATTRIBUTES", 16)),
+    WEB_MAX_ATTRIBUTES - 4);
+
+  const char *mix = std::getenv("PTS_LOAD_MIX");
+  std::string text = mix ? mix : "page:2,api:6,asset:2,push:2";
+  for (size_t start = 0; start < text.size();)
+  {
+    size_t end = text.find(',', start);
+    if (end == std::string::npos) end = text.size();
+    const std::string item = text.substr(start, end - start);
+    const size_t colon = item.find(':');
+    for (size_t role = 0; role != ROLE_COUNT; role++)
+      if (colon != std::string::npos && item.compare(0, colon,
+                                                     ROLE_NAMES[role]) == 0)
+        config.weights[role] = std::strtoul(item.c_str() + colon + 1,
+                                            nullptr, 10);
+    start = end + 1;
+  }
+  return config;
+}
+
+/// Distributes the clients among the roles in proportion to the weights.
+std::vector<Role> assignRoles(const Config &config)
+{
+  size_t total = 0;
+  for (const size_t weight : config.weights) total += weight;
+
+  std::vector<Role> roles;
+  std::vector<double> credits(ROLE_COUNT, 0.0);
+  for (size_t idx = 0; total != 0 && idx != config.clients; idx++)
+  {
+    // Largest remainder: the role furthest behind its share is next.
+    size_t next = 0;
+    for (size_t role = 0; role != ROLE_COUNT; role++)
+    {
+      credits[role] += static_cast<double>(config.weights[role]) / total;
+      if (credits[role] > credits[next]) next = role;
+    }
+    credits[next] -= 1.0;
+    roles.push_back(static_cast<Role>(next));
+  }
+  return roles;
+}
+
+/// The latencies of a role, in microseconds.
+struct RoleResult
+{
+  std::vector<uint32_t> latencies;
+  size_t clients = 0;
+  size_t failures = 0;
+  size_t not_modified = 0;
+};
+
+/// \return the given percentile of sorted values.
+uint32_t percentile(const std::vector<uint32_t> &sorted, double fraction)
+{
+  if (sorted.empty()) return 0;
+  return sorted[std::min(sorted.size() - 1,
+                         static_cast<size_t>(fraction * sorted.size()))];
+}
+
+/// \return the microseconds since a moment.
+uint32_t microsecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return static_cast<uint32_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count());
+}
+
+/// The moments the attribute versions were published, for the push latency.
+class PublishTimes
+{
+ public:
+  static constexpr size_t SIZE = 1 << 16;
+
+  void record(uint32_t version)
+  {
+    m_times[version % SIZE] = std::chrono::steady_clock::now()
+      .time_since_epoch().count();
+  }
+
+  /// \return the microseconds since the version was published.
+  uint32_t since(uint32_t version) const
+  {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    const auto published =
+      std::chrono::steady_clock::duration(m_times[version % SIZE].load());
+    return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        now - published).count());
+  }
+
+ private:
+  std::atomic<int64_t> m_times[SIZE] = {};
+};
+
+/// Runs a request loop of a page, api or asset client.
+void runRequests(Role role, const std::atomic<bool> &stop, RoleResult &result)
+{
+  static const char PAGE_REQUEST[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "\r\n";
+
+  bench_web_server::HttpClient client;
+  std::string request;
+  while (!stop)
+  {
+    const int expected = 200;
+    if (role == PAGE)
+    {
+      request = PAGE_REQUEST;
+    }
+    else if (role == API)
+    {
+      // Polls like a dashboard: unchanged versions are answered with a 304.
+      request = "GET /api/attributes HTTP/1.1\r\nHost: 192.168.4.1\r\n";
+      if (!client.etag().empty())
+        request += "If-None-Match: " + client.etag() + "\r\n";
+      request += "\r\n";
+    }
+    else
+    {
+      const PTS::StaticAsset *asset = PTS::ASSETS::find("/static/style.css");
+      if (!asset) return;
+      request = std::string("GET ") + asset->path + " HTTP/1.1\r\n"
+                "Host: 192.168.4.1\r\nAccept-Encoding: gzip\r\n\r\n";
+    }
+
+    const auto sent = std::chrono::steady_clock::now();
+    const int status = client.request(request.c_str());
+    result.latencies.push_back(microsecondsSince(sent));
+    if (status == 304 && role == API) result.not_modified++;
+    else if (status != expected) result.failures++;
+  }
+}
+
+/// Runs an event subscriber, timing every event from the publishing of the
+/// newest version it carries (so the coalescing delay is included).
+void runPush(const std::atomic<bool> &stop,
+             const PublishTimes &times,
+             RoleResult &result)
+{
+  static const char REQUEST[] =
+    "GET /api/events HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "\r\n";
+
+  const int fd = bench_web_server::connectSlowly();
+  if (fd < 0)
+  {
+    result.failures++;
+    return;
+  }
+  const timeval timeout{0, 100000};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  ::send(fd, REQUEST, sizeof(REQUEST) - 1, MSG_NOSIGNAL);
+
+  std::string stream;
+  char buffer[2048];
+  while (!stop)
+  {
+    const ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (length == 0) break;
+    if (length < 0) continue;
+    stream.append(buffer, static_cast<size_t>(length));
+
+    for (size_t id = stream.find("id: "); id != std::string::npos;
+         id = stream.find("id: "))
+    {
+      const size_t end = stream.find('\n', id);
+      if (end == std::string::npos) break;
+      const uint32_t version = std::strtoul(stream.c_str() + id + 4,
+                                            nullptr, 10);
+      result.latencies.push_back(times.since(version));
+      stream.erase(0, end);
+    }
+    if (stream.size() > 4096) stream.erase(0, stream.size() - 64);
+  }
+  ::close(fd);
+}
+
+/// \return the bytes allocated on the heap.
+size_t heapInUse() { return mallinfo2().uordblks; }
+
+/// Runs the configured load and prints the results.
+void run(const Config &config)
+{
+  std::vector<PTS::AttributeHandle> handles;
+  for (size_t idx = 0; idx != config.attributes; idx++)
+    handles.push_back(PTS::WebServer::instance().registerAttribute(
+      "load_" + std::to_string(idx), PTS::AttributeValue::fromInteger(0),
+      "Load test attribute."));
+
+  const std::vector<Role> roles = assignRoles(config);
+  std::vector<RoleResult> results(roles.size());
+  for (RoleResult &result : results)
+    result.latencies.reserve(static_cast<size_t>(config.seconds * 100000));
+
+  static PublishTimes times;
+  std::atomic<bool> stop(false);
+  const size_t heap_baseline = heapInUse();
+  std::vector<std::thread> clients;
+  for (size_t idx = 0; idx != roles.size(); idx++)
+  {
+    clients.emplace_back([&, idx]
+    {
+      if (roles[idx] == PUSH) runPush(stop, times, results[idx]);
+      else runRequests(roles[idx], stop, results[idx]);
+    });
+  }
+
+  // The writer publishes at the configured rate, round robin over the
+  // attributes, and samples the heap in between.
+  std::vector<uint32_t> stalls;
+  stalls.reserve(static_cast<size_t>(config.seconds * config.update_hz) + 1);
+  size_t peak_heap = heap_baseline;
+  const auto period = std::chrono::duration<double>(1.0 / config.update_hz);
+  const auto start = std::chrono::steady_clock::now();
+  auto next = start;
+  for (int32_t value = 1;
+       std::chrono::steady_clock::now() - start <
+         std::chrono::duration<double>(config.seconds);
+       value++)
+  {
+    const PTS::AttributeHandle handle = handles[value % handles.size()];
+    const auto before = std::chrono::steady_clock::now();
+    PTS::WebServer::instance().updateInteger(handle, value);
+    stalls.push_back(static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - before).count()));
+    times.record(PTS::WebServer::instance().attributesVersion());
+
+    peak_heap = std::max(peak_heap, heapInUse());
+    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      period);
+    std::this_thread::sleep_until(next);
+  }
+  stop = true;
+  for (auto &client : clients) client.join();
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  for (size_t role = 0; role != ROLE_COUNT; role++)
+  {
+    RoleResult merged;
+    for (size_t idx = 0; idx != roles.size(); idx++)
+    {
+      if (roles[idx] != role) continue;
+      merged.clients++;
+      merged.failures += results[idx].failures;
+      merged.not_modified += results[idx].not_modified;
+      merged.latencies.insert(merged.latencies.end(),
+                              results[idx].latencies.begin(),
+                              results[idx].latencies.end());
+    }
+    if (merged.clients == 0) continue;
+
+    std::sort(merged.latencies.begin(), merged.latencies.end());
+    EXPECT_EQ(0u, merged.failures) << ROLE_NAMES[role];
+    std::printf("BENCH {\"bench\":\"web_load\",\"role\":\"%s\","
+                "\"clients\":%zu,\"count\":%zu,\"per_second\":%.0f,"
+                "\"not_modified\":%zu,\"p50_ms\":%.2f,\"p90_ms\":%.2f,"
+                "\"p99_ms\":%.2f,\"max_ms\":%.2f,\"failures\":%zu}\n",
+                ROLE_NAMES[role], merged.clients, merged.latencies.size(),
+                merged.latencies.size() / elapsed.count(),
+                merged.not_modified, percentile(merged.latencies, 0.5) / 1e3,
+                percentile(merged.latencies, 0.9) / 1e3,
+                percentile(merged.latencies, 0.99) / 1e3,
+                percentile(merged.latencies, 1.0) / 1e3, merged.failures);
+  }
+
+  std::sort(stalls.begin(), stalls.end());
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  std::printf("BENCH {\"bench\":\"web_load_summary\",\"clients\":%zu,"
+              "\"seconds\":%.1f,\"updates\":%zu,\"updates_per_second\":%.0f,"
+              "\"stall_p50_ns\":%u,\"stall_p99_ns\":%u,\"stall_max_ns\":%u,"
+              "\"peak_heap_growth_bytes\":%zu,\"max_rss_kb\":%ld}\n",
+              roles.size(), elapsed.count(), stalls.size(),
+              stalls.size() / elapsed.count(), percentile(stalls, 0.5),
+              percentile(stalls, 0.99), percentile(stalls, 1.0),
+              peak_heap - heap_baseline, usage.ru_maxrss);
+
+  for (size_t idx = 0; idx != config.attributes; idx++)
+    PTS::WebServer::instance().deleteAttribute("load_" + std::to_string(idx));
+}
+
+}
+
+TEST(WebServerBench, load)
+{
+  bench_web_server::ServerRunner server;
+
+  bench_web_load::run(bench_web_load::readConfig());
+}
@@ -0,0 +1,373 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "net/web_server.h"
+
+#pragma once
+
+namespace bench_web_server
+{
+
+/// Runs the WebServer task like the Module does, until stopped.
+class ServerRunner
+{
+ public:
+  explicit ServerRunner() : m_stop(false)
+  {
+    SIM::serialEnabled() = false;
+    PTS::WebServer::instance().begin();
+    m_thread = std::thread([this]
+    {
+      TickType_t last_tick = xTaskGetTickCount();
+      while (!m_stop)
+      {
+        PTS::WebServer::instance().threadFunc();
+        xTaskDelayUntil(&last_tick, configTICK_RATE_HZ / 10);
+      }
+    });
+  }
+
+  ~ServerRunner()
+  {
+    m_stop = true;
+    m_thread.join();
+  }
+
+ private:
+  std::atomic<bool> m_stop;
+  std::thread m_thread;
+};
+
+/// A keep-alive HTTP client, reconnecting when the server closes on it.
+class HttpClient
+{
+ public:
+  explicit HttpClient() : m_fd(-1), m_reconnects(0), m_etag() { }
+  ~HttpClient() { disconnect(); }
+
+  /// Sends a request and reads the whole response.
+  /// \return the status code, 0 if the request failed.
+  int request(const char *request)
+  {
+    for (int attempt = 0; attempt != 2; attempt++)
+    {
+      if (m_fd < 0 && !connect()) return 0;
+
+      const size_t length = std::strlen(request);
+      if (::send(m_fd, request, length, MSG_NOSIGNAL) ==
+          static_cast<ssize_t>(length))
+      {
+        const int status = readResponse();
+        if (status != 0) return status;
+      }
+      // The server closed the kept-alive connection, retry on a new one.
+      disconnect();
+      m_reconnects++;
+    }
+    return 0;
+  }
+
+  [[nodiscard]] size_t reconnects() const { return m_reconnects; }
+
+  /// \return the ETag of the last response, empty if it had none.
+  [[nodiscard]] const std::string &etag() const { return m_etag; }
+
+ private:
+  bool connect()
+  {
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int flag = 1;
+    ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    const timeval timeout{5, 0};
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(80 + SIM::portOffset());
+    if (::connect(m_fd, reinterpret_cast<sockaddr*>(&address),
+                  sizeof(address)) == 0)
+      return true;
+
+    disconnect();
+    return false;
+  }
+
+  void disconnect()
+  {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+  }
+
+  /// Reads a response with a Content-Length or a chunked body.
+  int readResponse()
+  {
+    size_t length = 0;
+    const char *head_end = nullptr;
+    while (!head_end)
+    {
+      const ssize_t part = ::recv(m_fd, m_buffer + length,
+                                  sizeof(m_buffer) - 1 - length, 0);
+      if (part <= 0) return 0;
+      length += static_cast<size_t>(part);
+      m_buffer[length] = '\0';
+      head_end = std::strstr(m_buffer, "\r\n\r\n");
+    }
+
+    const bool close = std::strstr(m_buffer, "Connection: close") != nullptr;
+    const bool chunked =
+      std::strstr(m_buffer, "Transfer-Encoding: chunked") != nullptr;
+    const char *content_length = std::strstr(m_buffer, "Content-Length: ");
+    const char *etag = std::strstr(m_buffer, "ETag: ");
+    m_etag = etag ? std::string(etag + 6, std::strcspn(etag + 6, "\r\n"))
+                  : std::string();
+    const size_t head_length = head_end + 4 - m_buffer;
+    const int status = std::atoi(m_buffer + 9);
+
+    if (chunked)
+    {
+      // The bodies served contain no "\r\n0\r\n\r\n" of their own, so the
+      // end of the last chunk is all that needs to be found.
+      std::string tail(m_buffer + head_length, length - head_length);
+      while (tail != "0\r\n\r\n" &&
+             (tail.size() < 7 ||
+              tail.compare(tail.size() - 7, 7, "\r\n0\r\n\r\n") != 0))
+      {
+        const ssize_t part = ::recv(m_fd, m_buffer, sizeof(m_buffer), 0);
+        if (part <= 0) return 0;
+        tail.append(m_buffer, static_cast<size_t>(part));
+        if (tail.size() > 7) tail.erase(0, tail.size() - 7);
+      }
+    }
+    else
+    {
+      size_t remaining = content_length
+        ? std::strtoul(content_length + 16, nullptr, 10) : 0;
+      remaining -= std::min(remaining, length - head_length);
+      while (remaining != 0)
+      {
+        const ssize_t part = ::recv(m_fd, m_buffer,
+                                    std::min(remaining, sizeof(m_buffer)), 0);
+        if (part <= 0) return 0;
+        remaining -= static_cast<size_t>(part);
+      }
+    }
+
+    if (close)
+    {
+      disconnect();
+      m_reconnects++;
+    }
+    return status;
+  }
+
+  int m_fd;
+  size_t m_reconnects;
+  std::string m_etag;
+  char m_buffer[4096];
+};
+
+/// Runs concurrent keep-alive clients fetching the attributes and reports
+/// the throughput and latency percentiles.
+void run(size_t client_count, double seconds)
+{
+  static const char REQUEST[] =
+    "GET /api/attributes HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "\r\n";
+
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> failures(0);
+  std::atomic<size_t> reconnects(0);
+  std::vector<std::vector<uint32_t>> latencies(client_count);
+  std::vector<std::thread> clients;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t idx = 0; idx != client_count; idx++)
+  {
+    clients.emplace_back([&, idx]
+    {
+      HttpClient client;
+      while (!stop)
+      {
+        const auto sent = std::chrono::steady_clock::now();
+        if (client.request(REQUEST) != 200) failures++;
+        latencies[idx].push_back(static_cast<uint32_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - sent).count()));
+      }
+      reconnects += client.reconnects();
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto &client : clients) client.join();
+  const std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  std::vector<uint32_t> all;
+  for (const auto &client_latencies : latencies)
+    all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+  std::sort(all.begin(), all.end());
+  ASSERT_FALSE(all.empty());
+  const auto percentile = [&all](double fraction)
+  {
+    return all[std::min(all.size() - 1,
+                        static_cast<size_t>(fraction * all.size()))] / 1000.0;
+  };
+
+  EXPECT_EQ(0u, failures.load());
+  std::printf("BENCH {\"bench\":\"web_server_keep_alive\",\"clients\":%zu,"
+              "\"max_connections\":%zu,\"requests_per_second\":%.0f,"
+              "\"p50_ms\":%.2f,\"p99_ms\":%.2f,\"max_ms\":%.2f,"
+              "\"reconnects\":%zu,\"failures\":%zu}\n",
+              client_count, static_cast<size_t>(WEB_MAX_CONNECTIONS),
+              all.size() / elapsed.count(), percentile(0.5),
+              percentile(0.99), all.back() / 1000.0, reconnects.load(),
+              failures.load());
+}
+
+/// Connects to the server with a small receive buffer, so the server has to
+/// wait for the client to read a page.
+int connectSlowly()
+{
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  const int buffer_size = 1024;
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(80 + SIM::portOffset());
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) != 0)
+  {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/// Measures how long attribute updates take while slow clients download
+/// the page and subscribe to the events without reading them.
+void stall(size_t reader_count, double seconds)
+{
+  static const char REQUEST[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+  static const char EVENTS_REQUEST[] =
+    "GET /api/events HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "\r\n";
+
+  PTS::AttributeHandle handles[16];
+  for (size_t idx = 0; idx != 16; idx++)
+  {
+    const std::string name = "stress_" + std::to_string(idx);
+    handles[idx] = PTS::WebServer::instance().registerAttribute(
+      name, PTS::AttributeValue::fromInteger(0), "Stress test attribute.");
+  }
+
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> pages(0);
+  std::vector<std::thread> readers;
+  for (size_t idx = 0; idx != reader_count; idx++)
+  {
+    readers.emplace_back([&, idx]
+    {
+      // Every other reader subscribes to the events and never reads them.
+      if (idx % 2)
+      {
+        const int fd = connectSlowly();
+        if (fd < 0) return;
+        ::send(fd, EVENTS_REQUEST, sizeof(EVENTS_REQUEST) - 1, MSG_NOSIGNAL);
+        while (!stop) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ::close(fd);
+        return;
+      }
+
+      char buffer[128];
+      while (!stop)
+      {
+        const int fd = connectSlowly();
+        if (fd < 0) continue;
+        ::send(fd, REQUEST, sizeof(REQUEST) - 1, MSG_NOSIGNAL);
+        while (!stop && ::recv(fd, buffer, sizeof(buffer), 0) > 0)
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        ::close(fd);
+        pages++;
+      }
+    });
+  }
+
+  std::vector<uint32_t> stalls;
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed{};
+  for (int32_t value = 1; elapsed.count() < seconds; value++)
+  {
+    const auto before = std::chrono::steady_clock::now();
+    for (const PTS::AttributeHandle handle : handles)
+      PTS::WebServer::instance().updateInteger(handle, value);
+    const auto after = std::chrono::steady_clock::now();
+    stalls.push_back(static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        after - before).count() / 16));
+
+    // Like a loop() publishing its state every 100 us.
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    elapsed = after - start;
+  }
+  stop = true;
+  for (auto &reader : readers) reader.join();
+
+  std::sort(stalls.begin(), stalls.end());
+  const auto percentile = [&stalls](double fraction)
+  {
+    return stalls[std::min(stalls.size() - 1,
+                           static_cast<size_t>(fraction * stalls.size()))];
+  };
+
+  std::printf("BENCH {\"bench\":\"web_server_writer_stall\","
+              "\"slow_readers\":%zu,\"pages\":%zu,\"updates\":%zu,"
+              "\"p50_ns\":%u,\"p99_ns\":%u,\"max_us\":%.1f}\n",
+              reader_count, pages.load(), stalls.size() * 16,
+              percentile(0.5), percentile(0.99), stalls.back() / 1000.0);
+  for (size_t idx = 0; idx != 16; idx++)
+    PTS::WebServer::instance().deleteAttribute("stress_" +
+                                               std::to_string(idx));
+}
+
+}
+
+TEST(WebServerBench, keep_alive_clients)
+{
+  bench_web_server::ServerRunner server;
+  PTS::WebServer::instance().upsterAttribute("seconds", "0", "Game time");
+  PTS::WebServer::instance().upsterAttribute("keypad", "", "Keypad buffer");
+
+  bench_web_server::run(1, 2.0);
+  bench_web_server::run(8, 2.0);
+  bench_web_server::run(32, 2.0);
+}
+
+TEST(WebServerBench, writer_stalls)
+{
+  bench_web_server::ServerRunner server;
+
+  bench_web_server::stall(0, 1.0);
+  bench_web_server::stall(4, 2.0);
+}
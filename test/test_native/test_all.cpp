@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include "test_log_ring.h"
+#include "test_http_request.h"
+#include "test_http_response.h"
+#include "test_http_router.h"
+#include "test_json_writer.h"
+#include "test_byte_buffer.h"
+#include "test_attribute_store.h"
+#include "test_static_assets.h"
+#include "test_time_series.h"
+#include "test_mpsc_queue.h"
+#include "test_json_parser.h"
+#include "test_game_config.h"
+#include "test_game_image.h"
+#include "test_command_batch.h"
+#include "test_module_command.h"
+#include "test_replicator.h"
+#include "test_scoreboard_feed.h"
+#include "test_rgbled.h"
+#include "test_animator.h"
+#include "test_buzzer_module.h"
+#include "test_output_frame.h"
+#include "test_io_expander.h"
+#include "test_led_strip.h"
+#include "test_wire_disconnect.h"
+#include "test_countdown_module.h"
+#include "test_web_server.h"
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
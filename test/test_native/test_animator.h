@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "modules/hw/animator_module.h"
+#include "modules/module_factory.h"
+#include "utils/hw/led.h"
+#include "utils/hw/rgbled.h"
+#include "utils/hw/status_bar.h"
+
+#pragma once
+
+namespace test_animator
+{
+
+/// Renders frames by hand for a time, at 100 Hz.
+template<typename ANIMATOR>
+void render(const ANIMATOR &animator, int duration_ms)
+{
+  for (int elapsed = 0; elapsed < duration_ms; elapsed += 10)
+  {
+    animator.threadFunc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+}
+
+TEST(Timeline, keyframes)
+{
+  constexpr PTS::Timeline blink = PTS::Timeline::blink(100, 300);
+  static_assert(blink.length() == 400);
+  static_assert(blink.level(0) == 255 && blink.level(99) == 255);
+  static_assert(blink.level(100) == 0 && blink.level(399) == 0);
+  static_assert(blink.level(400) == 255 && blink.cycle(850) == 2);
+
+  constexpr PTS::Timeline pulse =
+    PTS::Timeline::pulse(1000, PTS::Color::fromRgb(0xFF8000));
+  static_assert(pulse.at(0) == PTS::COLOR::OFF);
+  static_assert(pulse.at(250) == PTS::Color{127, 64, 0});
+  static_assert(pulse.at(500) == PTS::Color{255, 128, 0});
+  static_assert(pulse.at(750) == PTS::Color{128, 64, 0});
+  static_assert(pulse.at(1000) == PTS::COLOR::OFF);
+
+  // A timeline without loop stays at its end.
+  constexpr PTS::Timeline fill = PTS::Timeline::fill(1000);
+  static_assert(!fill.finished(999) && fill.level(500) == 127);
+  static_assert(fill.finished(1000) && fill.level(5000) == 255);
+
+  // Keyframes beyond MAX_KEYFRAMES are dropped.
+  PTS::Timeline timeline;
+  for (uint32_t idx = 0; idx != 10; idx++)
+    timeline.add(idx * 10, PTS::COLOR::WHITE);
+  ASSERT_EQ(70u, timeline.length());
+}
+
+TEST(AnimatorModule, writes_changes_only)
+{
+  PTS::AnimatorModule<4> animator;
+  PTS::LED led(12);
+  led.begin();
+  ASSERT_TRUE(animator.play(led, PTS::Timeline::blink(100, 100)));
+
+  // 50 frames of 2.5 periods, but only the 5 changes are written.
+  test_animator::render(animator, 500);
+  const PTS::AnimatorStats stats = animator.stats();
+  ASSERT_GE(stats.frames, 50u);
+  ASSERT_GE(stats.writes, 4u);
+  ASSERT_LE(stats.writes, 6u);
+
+  // A paused light stays at the frame of the pause.
+  animator.pause(led);
+  animator.threadFunc();
+  const int level = digitalRead(12);
+  test_animator::render(animator, 300);
+  ASSERT_EQ(level, digitalRead(12));
+
+  animator.stop(led);
+  ASSERT_FALSE(animator.playing(led));
+  ASSERT_EQ(0u, animator.size());
+}
+
+TEST(AnimatorModule, fades_rgbleds_in_hardware)
+{
+  PTS::AnimatorModule<4> animator;
+  PTS::RGBLED led(25, 26, 27);
+  led.begin();
+  animator.play(led, PTS::Timeline::pulse(400, PTS::COLOR::RED));
+
+  test_animator::render(animator, 100);
+  // The fade runs alone between two keyframes.
+  ASSERT_GT(ledcRead(led.channel()), PTS::RGBLED::gamma(16));
+  ASSERT_LT(ledcRead(led.channel()), PTS::RGBLED::MAX_DUTY);
+  test_animator::render(animator, 700);
+  // A write per keyframe, 4 of them in 2 periods.
+  const uint32_t writes = animator.stats().writes;
+  ASSERT_GE(writes, 4u);
+  ASSERT_LE(writes, 5u);
+  animator.stop(led);
+}
+
+TEST(AnimatorModule, writes_rgbleds_unlocked)
+{
+  PTS::AnimatorModule<4> animator;
+  PTS::RGBLED led(25, 26, 27);
+  led.begin();
+  animator.play(led, PTS::Timeline::pulse(400, PTS::COLOR::RED));
+
+  std::atomic<bool> rendered(false);
+  std::atomic<bool> paused(false);
+  std::thread renderer;
+  std::thread player;
+  {
+    // A slow RGBLED write, as a fade waiting for the running one before
+    // IDF 5.
+    std::lock_guard<std::mutex> ledc(SIM::ledcLock());
+    renderer = std::thread([&]() { animator.threadFunc(); rendered = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // The timelines can be changed meanwhile.
+    player = std::thread([&]() { animator.pause(led); paused = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(rendered);
+    EXPECT_TRUE(paused);
+  }
+  renderer.join();
+  player.join();
+  ASSERT_EQ(1u, animator.stats().writes);
+  animator.stop(led);
+}
+
+TEST(AnimatorModule, fills_status_bars)
+{
+  PTS::AnimatorModule<4> animator;
+  PTS::StatusBar<4> bar({PTS::LED(12), PTS::LED(13), PTS::LED(14),
+                         PTS::LED(15)});
+  bar.begin();
+  bar.clear();
+
+  animator.play(bar, PTS::Timeline::fill(400));
+  test_animator::render(animator, 250);
+  ASSERT_EQ(HIGH, digitalRead(12));
+  ASSERT_EQ(HIGH, digitalRead(13));
+  ASSERT_EQ(LOW, digitalRead(15));
+  test_animator::render(animator, 250);
+  for (uint8_t pin = 12; pin != 16; pin++) ASSERT_EQ(HIGH, digitalRead(pin));
+  // A bar filling up is written 4 times, and not once done.
+  ASSERT_EQ(5u, animator.stats().writes); // With the empty first frame.
+
+  animator.play(bar, PTS::Timeline::chase(400), true);
+  test_animator::render(animator, 150);
+  ASSERT_EQ(LOW, digitalRead(12));
+  ASSERT_EQ(HIGH, digitalRead(13));
+  ASSERT_EQ(LOW, digitalRead(14));
+  animator.stop(bar);
+}
+
+TEST(ModuleFactory, animates_blinkers)
+{
+  PTS::GameConfig config;
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(R"({"modules": [
+    {"type": "blinker", "name": "blinker", "pin": 2, "on_ms": 50,
+     "off_ms": 50}]})", config));
+
+  static PTS::ModuleFactory<> factory;
+  ASSERT_TRUE(factory.build(config));
+  factory.begin();
+  factory.start();
+
+  int changes = 0;
+  int level = digitalRead(2);
+  for (int idx = 0; idx != 50; idx++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (digitalRead(2) != level) changes++;
+    level = digitalRead(2);
+  }
+  ASSERT_GE(changes, 6);
+
+  ASSERT_EQ(PTS::CommandResult::APPLIED,
+            factory.post("blinker", PTS::ModuleCommand::STOP));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(LOW, digitalRead(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(LOW, digitalRead(2));
+  factory.clear();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
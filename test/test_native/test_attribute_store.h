@@ -0,0 +1,264 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "net/attribute_store.h"
+
+#pragma once
+
+namespace test_attribute_store
+{
+
+using Store = PTS::AttributeStore<4, 16, 16, 16>;
+
+}
+
+TEST(AttributeStore, handles)
+{
+  test_attribute_store::Store store;
+  test_attribute_store::Store::View view;
+
+  const PTS::AttributeHandle first = store.add("first", "1", "First.");
+  const PTS::AttributeHandle second = store.add("second", "2", "");
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+  ASSERT_FALSE(store.add("first", "again", ""));
+  ASSERT_EQ(2u, store.version());
+
+  ASSERT_TRUE(store.update(second, "22"));
+  ASSERT_TRUE(store.read(second, view));
+  ASSERT_STREQ("second", view.name);
+  ASSERT_STREQ("22", view.value);
+  ASSERT_EQ(3u, view.version);
+
+  // Deleting invalidates the handles, even when the slot is reused.
+  ASSERT_TRUE(store.remove("first"));
+  ASSERT_EQ(4u, store.deletedVersion());
+  ASSERT_TRUE(store.add("third", "3", ""));
+  ASSERT_FALSE(store.update(first, "stale"));
+  ASSERT_FALSE(store.read(first, view));
+  ASSERT_FALSE(store.update(PTS::AttributeHandle(), "invalid"));
+
+  ASSERT_TRUE(store.find("third"));
+  ASSERT_FALSE(store.find("first"));
+}
+
+TEST(AttributeStore, truncation)
+{
+  test_attribute_store::Store store;
+  test_attribute_store::Store::View view;
+
+  const PTS::AttributeHandle handle =
+    store.add("a_very_long_attribute_name", "0123456789abcdefXYZ", "");
+  ASSERT_TRUE(store.find("a_very_long_attribute_name"));
+  ASSERT_TRUE(store.read(handle, view));
+  ASSERT_STREQ("a_very_long_att", view.name);
+  ASSERT_STREQ("0123456789abcde", view.value);
+}
+
+TEST(AttributeStore, consistent_reads)
+{
+  test_attribute_store::Store store;
+  const PTS::AttributeHandle handle = store.add("value", "", "");
+  std::atomic<bool> stop(false);
+
+  // Every written value is a single repeated digit, of varying length.
+  std::thread writer([&]
+  {
+    char value[16];
+    for (size_t idx = 0; !stop; idx++)
+    {
+      const size_t length = 1 + idx % 15;
+      std::memset(value, '0' + idx % 10, length);
+      value[length] = '\0';
+      store.update(handle, value);
+    }
+  });
+
+  size_t torn = 0;
+  for (size_t idx = 0; idx != 200000; idx++)
+  {
+    store.forEach([&torn](const test_attribute_store::Store::View &view)
+    {
+      const size_t length = std::strlen(view.value);
+      for (size_t pos = 1; pos < length; pos++)
+        if (view.value[pos] != view.value[0]) torn++;
+    });
+  }
+  stop = true;
+  writer.join();
+
+  ASSERT_EQ(0u, torn);
+}
+
+TEST(AttributeStore, typed_values)
+{
+  static const char *const STATES[] = {"idle", "armed", "defused"};
+  test_attribute_store::Store store;
+  test_attribute_store::Store::View view;
+
+  const PTS::AttributeHandle integer =
+    store.add("integer", PTS::AttributeValue::fromInteger(-42), "");
+  const PTS::AttributeHandle real =
+    store.add("real", PTS::AttributeValue::fromFloat(3.14159f, 3), "");
+  const PTS::AttributeHandle flag =
+    store.add("flag", PTS::AttributeValue::fromBool(false), "");
+  const PTS::AttributeHandle state =
+    store.add("state", PTS::AttributeValue::fromEnum(1, STATES, 3), "");
+
+  ASSERT_TRUE(store.read(integer, view));
+  ASSERT_STREQ("-42", view.value);
+  ASSERT_TRUE(store.read(real, view));
+  ASSERT_STREQ("3.142", view.value);
+  ASSERT_TRUE(store.read(flag, view));
+  ASSERT_STREQ("false", view.value);
+  ASSERT_TRUE(store.read(state, view));
+  ASSERT_STREQ("armed", view.value);
+
+  // The types must match, text updates don't apply to typed attributes.
+  ASSERT_TRUE(store.set(flag, PTS::AttributeType::BOOL, true));
+  ASSERT_FALSE(store.set(flag, PTS::AttributeType::INTEGER, 1));
+  ASSERT_FALSE(store.update(integer, "text"));
+  ASSERT_TRUE(store.read(flag, view));
+  ASSERT_STREQ("true", view.value);
+
+  ASSERT_TRUE(store.set(state, PTS::AttributeType::ENUM, 7));
+  ASSERT_TRUE(store.read(state, view));
+  ASSERT_STREQ("?", view.value);
+
+  ASSERT_TRUE(store.remove("state"));
+  const PTS::AttributeHandle duration =
+    store.add("duration", PTS::AttributeValue::fromDuration(0), "");
+  ASSERT_TRUE(store.set(duration, PTS::AttributeType::DURATION, 83999));
+  ASSERT_TRUE(store.read(duration, view));
+  ASSERT_STREQ("01:23", view.value);
+  ASSERT_TRUE(store.set(duration, PTS::AttributeType::DURATION, 3723000));
+  ASSERT_TRUE(store.read(duration, view));
+  ASSERT_STREQ("1:02:03", view.value);
+}
+
+TEST(AttributeStore, typed_reads_under_writes)
+{
+  test_attribute_store::Store store;
+  const PTS::AttributeHandle handle =
+    store.add("count", PTS::AttributeValue::fromInteger(0), "");
+  const uint32_t base = store.version();
+  std::atomic<bool> stop(false);
+
+  // Every write is a new version, so the text always matches the version.
+  std::thread writer([&]
+  {
+    for (int32_t count = 1; !stop; count++)
+      store.set(handle, PTS::AttributeType::INTEGER,
+                static_cast<uint32_t>(count));
+  });
+
+  // Readers format their own copies side by side.
+  std::atomic<size_t> mismatched(0);
+  auto read = [&]
+  {
+    test_attribute_store::Store::View view;
+    for (size_t idx = 0; idx != 100000; idx++)
+      if (store.read(handle, view) &&
+          std::to_string(view.version - base) != view.value)
+        mismatched++;
+  };
+  std::thread other_reader(read);
+  read();
+  other_reader.join();
+  stop = true;
+  writer.join();
+
+  ASSERT_EQ(0u, mismatched.load());
+}
+
+TEST(AttributeStore, unchanged_writes)
+{
+  test_attribute_store::Store store;
+  test_attribute_store::Store::View view;
+
+  const PTS::AttributeHandle text = store.add("text", "a", "");
+  const PTS::AttributeHandle integer =
+    store.add("integer", PTS::AttributeValue::fromInteger(0), "");
+  ASSERT_EQ(2u, store.version());
+
+  // Writing the current value keeps the versions.
+  ASSERT_TRUE(store.update(text, "a"));
+  ASSERT_TRUE(store.set(integer, PTS::AttributeType::INTEGER, 0));
+  ASSERT_EQ(2u, store.version());
+
+  ASSERT_TRUE(store.set(integer, PTS::AttributeType::INTEGER, 5));
+  ASSERT_TRUE(store.set(integer, PTS::AttributeType::INTEGER, 5));
+  ASSERT_EQ(3u, store.version());
+
+  // Only the attributes modified after the version are visited.
+  size_t visited = 0;
+  store.forEach(2, [&](const test_attribute_store::Store::View &attribute)
+  {
+    visited++;
+    ASSERT_STREQ("integer", attribute.name);
+    ASSERT_STREQ("5", attribute.value);
+  });
+  ASSERT_EQ(1u, visited);
+
+  // Formatting doesn't count as a modification.
+  ASSERT_TRUE(store.read(integer, view));
+  ASSERT_EQ(3u, view.version);
+  ASSERT_EQ(3u, store.version());
+}
+
+TEST(AttributeStore, snapshots)
+{
+  test_attribute_store::Store store;
+  const PTS::AttributeHandle handle = store.add("value", "1", "");
+  store.add("other", "2", "");
+
+  const test_attribute_store::Store::Snapshot first = store.snapshot();
+  ASSERT_EQ(2u, first.version());
+  ASSERT_EQ(2u, first.size());
+
+  // Unchanged versions share the copy.
+  ASSERT_EQ(first.begin(), store.snapshot().begin());
+
+  // Held snapshots are immutable, new ones see the modifications.
+  ASSERT_TRUE(store.update(handle, "3"));
+  const test_attribute_store::Store::Snapshot second = store.snapshot();
+  ASSERT_NE(first.begin(), second.begin());
+  ASSERT_STREQ("1", first.begin()->value);
+  ASSERT_STREQ("3", second.begin()->value);
+  ASSERT_EQ(3u, second.version());
+
+  // With every frame held, the newest copy is returned.
+  ASSERT_TRUE(store.update(handle, "4"));
+  ASSERT_EQ(second.begin(), store.snapshot().begin());
+
+  size_t visited = 0;
+  second.forEach(2, [&visited](const test_attribute_store::Store::View &view)
+  {
+    visited++;
+    ASSERT_STREQ("value", view.name);
+  });
+  ASSERT_EQ(1u, visited);
+}
+
+TEST(AttributeStore, snapshot_reuse)
+{
+  test_attribute_store::Store store;
+  const PTS::AttributeHandle handle = store.add("value", "0", "");
+
+  // Released frames are reused, the held one is never overwritten.
+  const test_attribute_store::Store::Snapshot held = store.snapshot();
+  for (size_t idx = 1; idx != 10; idx++)
+  {
+    ASSERT_TRUE(store.update(handle, std::to_string(idx).c_str()));
+    const test_attribute_store::Store::Snapshot snapshot = store.snapshot();
+    ASSERT_STREQ(std::to_string(idx).c_str(), snapshot.begin()->value);
+    ASSERT_STREQ("0", held.begin()->value);
+  }
+
+  // Removed attributes are left out.
+  ASSERT_TRUE(store.remove("value"));
+  ASSERT_EQ(0u, store.snapshot().size());
+  ASSERT_EQ(store.version(), store.snapshot().deletedVersion());
+}
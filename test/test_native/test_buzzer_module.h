@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "modules/hw/buzzer_module.h"
+
+#pragma once
+
+namespace test_buzzer_module
+{
+
+using Buzzer = PTS::BuzzerModule<1000>;
+
+void sleep(int ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+/// \return the tone sounding on a channel, 0 if silent.
+uint32_t tone(int8_t channel)
+{
+  return ledcRead(channel) != 0 ? ledcReadFreq(channel) : 0;
+}
+
+}
+
+TEST(BuzzerModule, plays_scripts)
+{
+  using namespace test_buzzer_module;
+  static constexpr PTS::Note SCRIPT[] = {{440, 100}, {0, 100}, {880, 100}};
+
+  Buzzer buzzer("buzzer", 23);
+  buzzer.begin();
+  const int8_t channel = static_cast<int8_t>(SIM::ledcPins()[23]);
+  ASSERT_NE(-1, channel);
+  ASSERT_EQ(0, channel % 2); // A timer of its own.
+
+  // The default tone sounds from the start.
+  buzzer.start();
+  sleep(50);
+  ASSERT_EQ(1000u, tone(channel));
+
+  buzzer.play(SCRIPT);
+  sleep(50);
+  ASSERT_EQ(440u, tone(channel));
+  sleep(100);
+  ASSERT_EQ(0u, tone(channel));
+  sleep(100);
+  ASSERT_EQ(880u, tone(channel));
+  sleep(100);
+  ASSERT_EQ(0u, tone(channel));
+  ASSERT_FALSE(buzzer.playing());
+
+  // The tone changes at the boundaries only, 4 of them after the default.
+  ASSERT_EQ(5u, buzzer.changes());
+
+  buzzer.destroy();
+  sleep(100);
+}
+
+TEST(BuzzerModule, speeds_up_countdowns)
+{
+  using namespace test_buzzer_module;
+  Buzzer buzzer("buzzer", 23);
+  buzzer.begin();
+  const int8_t channel = static_cast<int8_t>(SIM::ledcPins()[23]);
+  buzzer.countdown(3000);
+  buzzer.start();
+
+  // Beeps are counted on their starts, a tenth of the time left apart: every
+  // 300 ms first, every 100 ms at the end.
+  auto count = [channel](int duration_ms)
+  {
+    int beeps = 0;
+    uint32_t previous = 0;
+    for (int elapsed = 0; elapsed < duration_ms; elapsed += 5)
+    {
+      const uint32_t current = tone(channel);
+      if (current != 0 && previous == 0) beeps++;
+      previous = current;
+      sleep(5);
+    }
+    return beeps;
+  };
+  const int first_second = count(1000);
+  count(1000);
+  const int last_second = count(950);
+  EXPECT_LE(first_second, 5);
+  EXPECT_GE(last_second, 8);
+
+  // The long final tone, then silence.
+  sleep(200);
+  ASSERT_EQ(1000u, tone(channel));
+  sleep(1500);
+  ASSERT_EQ(0u, tone(channel));
+
+  buzzer.destroy();
+  sleep(100);
+}
+
+TEST(BuzzerModule, silent_while_paused)
+{
+  using namespace test_buzzer_module;
+  Buzzer buzzer("buzzer", 23);
+  buzzer.begin();
+  const int8_t channel = static_cast<int8_t>(SIM::ledcPins()[23]);
+  buzzer.start();
+  sleep(50);
+  ASSERT_EQ(1000u, tone(channel));
+
+  buzzer.post(PTS::ModuleCommand::SUSPEND);
+  sleep(50);
+  ASSERT_EQ(0u, tone(channel));
+  buzzer.post(PTS::ModuleCommand::RESUME);
+  sleep(50);
+  ASSERT_EQ(1000u, tone(channel));
+
+  buzzer.post(PTS::ModuleCommand::STOP);
+  sleep(100);
+  ASSERT_EQ(0u, tone(channel));
+}
+
+TEST(BuzzerModule, zero_length_notes)
+{
+  using namespace test_buzzer_module;
+  static constexpr PTS::Note SILENT[] = {{440, 0}};
+  static constexpr PTS::Note CLICK[] = {{440, 0}, {880, 50}};
+
+  Buzzer buzzer("buzzer", 23);
+  buzzer.begin();
+
+  // A loop of no length would never end its tick, it is silence.
+  buzzer.play(SILENT, true);
+  buzzer.threadFunc();
+  ASSERT_FALSE(buzzer.playing());
+  ASSERT_EQ(0u, buzzer.sounding());
+
+  // A note of no length is passed, even by a tick late by whole loops.
+  buzzer.play(CLICK, true);
+  buzzer.threadFunc();
+  sleep(180);
+  buzzer.threadFunc();
+  ASSERT_TRUE(buzzer.playing());
+  ASSERT_EQ(880u, buzzer.sounding());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "utils/sw/byte_buffer.h"
+#include "utils/sw/json_writer.h"
+
+#pragma once
+
+TEST(ByteBuffer, write_and_consume)
+{
+  PTS::ByteBuffer<8> buffer;
+  ASSERT_TRUE(buffer.empty());
+
+  ASSERT_TRUE(buffer.print("abcde"));
+  ASSERT_EQ(5u, buffer.size());
+  ASSERT_EQ(3u, buffer.space());
+
+  buffer.consume(2);
+  ASSERT_EQ(std::string("cde"), std::string(buffer.data(), buffer.size()));
+
+  ASSERT_TRUE(buffer.print("fghij"));
+  ASSERT_EQ(std::string("cdefghij"), std::string(buffer.data(), buffer.size()));
+  ASSERT_FALSE(buffer.overflowed());
+}
+
+TEST(ByteBuffer, rejects_whole_writes)
+{
+  PTS::ByteBuffer<8> buffer;
+  ASSERT_TRUE(buffer.print("abcdef"));
+
+  // A write that doesn't fit stores nothing.
+  ASSERT_FALSE(buffer.print("ghi"));
+  ASSERT_TRUE(buffer.overflowed());
+  ASSERT_EQ(std::string("abcdef"), std::string(buffer.data(), buffer.size()));
+
+  buffer.consume(100);
+  ASSERT_TRUE(buffer.empty());
+  ASSERT_TRUE(buffer.overflowed());
+
+  buffer.clear();
+  ASSERT_FALSE(buffer.overflowed());
+}
+
+TEST(ByteBuffer, json_target)
+{
+  PTS::ByteBuffer<16> buffer;
+  PTS::JsonWriter<PTS::ByteBuffer<16>> json(buffer);
+
+  json.beginObject().key("a").value(static_cast<uint32_t>(1)).endObject();
+  ASSERT_EQ(std::string("{\"a\":1}"),
+            std::string(buffer.data(), buffer.size()));
+  ASSERT_FALSE(buffer.overflowed());
+
+  json.beginObject().key("long key").value("long value").endObject();
+  ASSERT_TRUE(buffer.overflowed());
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "net/command_batch.h"
+
+#pragma once
+
+namespace test_command_batch
+{
+
+const char *parse(const char *text, PTS::CommandBatch &batch)
+{
+  return PTS::CommandBatchParser::parse(text, std::strlen(text), batch);
+}
+
+}
+
+TEST(CommandBatch, parse)
+{
+  using test_command_batch::parse;
+  using Kind = PTS::RemoteCommand::Kind;
+  using Value = PTS::RemoteCommand::Value;
+
+  PTS::CommandBatch batch;
+  ASSERT_EQ(nullptr, parse(R"([
+    {"op": "reset", "module": "wires"},
+    {"module": "wires", "op": "start"},
+    {"op": "set", "attribute": "status", "value": "armed"},
+    {"op": "set", "attribute": "lives", "value": 3},
+    {"op": "set", "attribute": "ratio", "value": 0.5},
+    {"op": "set", "attribute": "open", "value": true}])", batch));
+
+  ASSERT_EQ(6u, batch.command_count);
+  ASSERT_EQ(Kind::MODULE, batch.commands[0].kind);
+  ASSERT_EQ(PTS::ModuleCommand::RESET, batch.commands[0].command);
+  ASSERT_STREQ("wires", batch.commands[0].target);
+  ASSERT_EQ(PTS::ModuleCommand::START, batch.commands[1].command);
+
+  ASSERT_EQ(Kind::SET, batch.commands[2].kind);
+  ASSERT_STREQ("status", batch.commands[2].target);
+  ASSERT_EQ(Value::TEXT, batch.commands[2].value);
+  ASSERT_STREQ("armed", batch.commands[2].text);
+  ASSERT_EQ(Value::NUMBER, batch.commands[3].value);
+  ASSERT_TRUE(batch.commands[3].integral);
+  ASSERT_EQ(3.0, batch.commands[3].number);
+  ASSERT_FALSE(batch.commands[4].integral);
+  ASSERT_EQ(Value::BOOL, batch.commands[5].value);
+  ASSERT_TRUE(batch.commands[5].flag);
+
+  size_t count = 0;
+  for (const PTS::RemoteCommand &command : batch)
+    count += command.kind != Kind::NONE;
+  ASSERT_EQ(6u, count);
+}
+
+TEST(CommandBatch, rejects_invalid_batches)
+{
+  using test_command_batch::parse;
+
+  PTS::CommandBatch batch;
+  ASSERT_STREQ("expected a list of commands",
+               parse(R"({"op": "reset"})", batch));
+  ASSERT_STREQ("no commands", parse("[]", batch));
+  ASSERT_STREQ("incomplete JSON", parse("", batch));
+  ASSERT_STREQ("invalid JSON", parse("[{\"op\" \"reset\"}]", batch));
+  ASSERT_STREQ("unknown op",
+               parse(R"([{"op": "explode", "module": "wires"}])", batch));
+  ASSERT_STREQ("unknown key",
+               parse(R"([{"op": "stop", "modul": "wires"}])", batch));
+  ASSERT_STREQ("command without op", parse(R"([{"module": "wires"}])", batch));
+  ASSERT_STREQ("module command without module",
+               parse(R"([{"op": "stop", "attribute": "wires"}])", batch));
+  ASSERT_STREQ("set without attribute",
+               parse(R"([{"op": "set", "value": 1}])", batch));
+  ASSERT_STREQ("set without value",
+               parse(R"([{"op": "set", "attribute": "lives"}])", batch));
+  ASSERT_STREQ("unexpected null",
+               parse(R"([{"op": "set", "attribute": "a", "value": null}])",
+                     batch));
+  ASSERT_STREQ("invalid name",
+               parse(R"([{"op": "stop", "module": "wi\u0001res"}])", batch));
+
+  std::string many = "[";
+  for (size_t idx = 0; idx != PTS::CommandBatch::MAX_COMMANDS + 1; idx++)
+    many += std::string(idx ? "," : "") + R"({"op": "stop", "module": "m"})";
+  ASSERT_STREQ("too many commands", parse((many + "]").c_str(), batch));
+}
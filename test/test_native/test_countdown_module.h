@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "modules/countdown_module.h"
+
+#pragma once
+
+namespace test_countdown_module
+{
+
+using Countdown = PTS::CountdownModule<>;
+
+/// The updates a consumer was fed.
+struct Updates
+{
+  std::mutex lock;
+  std::vector<PTS::CountdownTime> times;
+  std::vector<int64_t> at_us;
+
+  static void feed(void *arg, const PTS::CountdownTime &time)
+  {
+    Updates &updates = *static_cast<Updates*>(arg);
+    std::lock_guard<std::mutex> guard(updates.lock);
+    updates.times.push_back(time);
+    updates.at_us.push_back(esp_timer_get_time());
+  }
+
+  size_t size()
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    return times.size();
+  }
+};
+
+/// The time of the expiry callback.
+std::atomic<int64_t> expired_at{0};
+
+void sleep(int ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+/// Keeps every core busy, and more, while it lives.
+class Load
+{
+ public:
+  Load() : m_stop(false)
+  {
+    const unsigned count =
+      2 * std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned idx = 0; idx != count; idx++)
+      m_threads.emplace_back([this]()
+      {
+        volatile uint64_t spin = 0;
+        while (!m_stop.load(std::memory_order_relaxed)) spin = spin + 1;
+      });
+  }
+
+  ~Load()
+  {
+    m_stop = true;
+    for (std::thread &thread : m_threads) thread.join();
+  }
+
+ private:
+  std::atomic<bool> m_stop;
+  std::vector<std::thread> m_threads;
+};
+
+}
+
+TEST(CountdownClock, does_not_drift_over_an_hour)
+{
+  // An hour-long game: paused a thousand times, struck three times.
+  constexpr int64_t HOUR_US = 3600ll * 1000000;
+  PTS::CountdownClock clock(HOUR_US);
+  ASSERT_EQ(PTS::CountdownClock::NEVER, clock.when(0));
+
+  int64_t now = 1000;
+  int64_t run_us = 0; // The real time run, at the normal rate.
+  clock.run(now);
+  for (int pause = 0; pause != 1000; pause++)
+  {
+    now += 1234567;
+    run_us += 1234567;
+    clock.hold(now);
+    now += 777;
+    clock.run(now);
+  }
+  ASSERT_EQ(HOUR_US - run_us, clock.left(now));
+
+  // Strikes at 1.25, 1.5 and 1.75 times the rate.
+  int64_t left = HOUR_US - run_us;
+  for (uint32_t strike = 1; strike != 4; strike++)
+  {
+    now += 40000000;
+    left -= 40000000ll * (100 + (strike - 1) * 25) / 100;
+    clock.rate(100 + strike * 25, now);
+    ASSERT_EQ(left, clock.left(now));
+  }
+
+  // The expiry is exact, to the microsecond.
+  const int64_t expiry = clock.when(0);
+  ASSERT_EQ(now + (left * 100 + 174) / 175, expiry);
+  ASSERT_EQ(0, clock.left(expiry));
+  ASSERT_LT(0, clock.left(expiry - 1));
+  ASSERT_EQ(0, clock.left(expiry + HOUR_US));
+}
+
+TEST(CountdownModule, pauses_and_feeds_on_changes)
+{
+  using namespace test_countdown_module;
+  Countdown countdown("countdown", 10000);
+  Updates updates;
+  ASSERT_TRUE(countdown.subscribe(&Updates::feed, &updates, 0));
+  countdown.begin();
+  ASSERT_EQ(PTS::Stateful::ACTIVE, countdown.getState());
+
+  // It runs from the first tick on.
+  ASSERT_FALSE(countdown.time().running);
+  ASSERT_EQ(PTS::CountdownClock::NEVER, countdown.deadline());
+  countdown.threadFunc();
+  ASSERT_TRUE(countdown.time().running);
+  ASSERT_EQ(1u, updates.size());
+  sleep(20);
+
+  countdown.pause();
+  const PTS::CountdownTime paused = countdown.time();
+  ASSERT_FALSE(paused.running);
+  ASSERT_LT(paused.left_us, 10000000 - 20000);
+  ASSERT_EQ(10u, paused.seconds());
+  sleep(20);
+  ASSERT_EQ(paused.left_us, countdown.time().left_us);
+
+  // A command pausing the module holds it too, until its next tick.
+  countdown.resume();
+  countdown.idle();
+  ASSERT_FALSE(countdown.time().running);
+  countdown.threadFunc();
+  ASSERT_TRUE(countdown.time().running);
+
+  ASSERT_EQ(1u, countdown.strike());
+  ASSERT_EQ(125u, countdown.time().rate);
+  ASSERT_EQ(6u, updates.size());
+  ASSERT_EQ(1u, updates.times.back().strikes);
+
+  countdown.reset();
+  ASSERT_EQ(0u, countdown.strikes());
+  ASSERT_EQ(100u, countdown.time().rate);
+  ASSERT_GT(countdown.time().left_us, 10000000 - 5000);
+  countdown.pause();
+}
+
+TEST(CountdownModule, expires_on_time_under_load)
+{
+  using namespace test_countdown_module;
+  // The accuracy of the simulated esp_timer task, with every core busy.
+  constexpr int64_t TOLERANCE_US = 50000;
+
+  Countdown countdown("countdown", 600);
+  Updates display, seconds;
+  // A display refreshing every 50 ms, and one of tenths of game time.
+  ASSERT_TRUE(countdown.subscribe(&Updates::feed, &display, 50));
+  ASSERT_TRUE(countdown.subscribe(&Updates::feed, &seconds, 100, true));
+  countdown.onExpiry([](void*) { expired_at = esp_timer_get_time(); },
+                     nullptr);
+  countdown.begin();
+
+  {
+    const Load load;
+    countdown.threadFunc();
+    sleep(150);
+    // Twice as fast from here on.
+    for (int strike = 0; strike != 4; strike++) countdown.strike();
+    const PTS::CountdownTime time = countdown.time();
+    const int64_t deadline = countdown.deadline();
+    ASSERT_NEAR(esp_timer_get_time() + time.left_us / 2, deadline,
+                TOLERANCE_US);
+    while (countdown.getState() == PTS::Stateful::ACTIVE) sleep(5);
+    sleep(5);
+
+    ASSERT_EQ(PTS::Stateful::FAILED, countdown.getState());
+    ASSERT_GE(expired_at.load(), deadline);
+    ASSERT_LT(expired_at.load(), deadline + TOLERANCE_US);
+  }
+  ASSERT_EQ(0, countdown.time().left_us);
+  ASSERT_EQ(4u, countdown.strike()); // An expired countdown takes none.
+
+  // The display was fed at its period, up to the expiry.
+  std::lock_guard<std::mutex> guard(display.lock);
+  ASSERT_GE(display.times.size(), 6u);
+  for (size_t idx = 1; idx != display.at_us.size(); idx++)
+    ASSERT_LE(display.at_us[idx] - display.at_us[idx - 1],
+              50000 + TOLERANCE_US);
+  ASSERT_TRUE(display.times.back().expired);
+  ASSERT_EQ(0u, display.times.back().seconds());
+
+  // The tenths were fed as the time left passed them, and at the changes:
+  // the start, the strikes and the expiry (a change may feed a tenth due).
+  std::lock_guard<std::mutex> guard_seconds(seconds.lock);
+  ASSERT_GE(seconds.times.size(), 10u);
+  ASSERT_LE(seconds.times.size(), 11u);
+  for (size_t idx = 1; idx != seconds.times.size(); idx++)
+    ASSERT_LE(seconds.times[idx].left_us, seconds.times[idx - 1].left_us);
+  ASSERT_TRUE(seconds.times.back().expired);
+}
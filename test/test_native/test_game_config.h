@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include "modules/game_config.h"
+#include "modules/module_factory.h"
+
+#pragma once
+
+namespace test_game_config
+{
+
+const char *const GAME = R"({
+  "name": "test",
+  "modules": [
+    {"type": "keypad", "name": "keypad", "cols": [25, 33, 32],
+     "rows": [35, 34, 39, 36], "keys": ["123", "456", "789", "*0#"]},
+    {"type": "wire_disconnect", "name": "wires", "wires": [16, 17, 18, 5],
+     "steps": [1, 2, 2, 0], "forbidden": [], "led": [19, 21, 22]},
+    {"type": "blinker", "name": "blinker", "pin": 2, "on_ms": 100},
+    {"type": "buzzer", "name": "buzzer", "pin": 23, "tone_hz": 1000},
+    {"type": "led", "name": "armed", "pin": 4, "on": true}]})";
+
+/// Parses a game with a module replaced.
+const char *parseWith(const std::string &module, PTS::GameConfig &config)
+{
+  const std::string game =
+    "{\"modules\": [{\"type\": \"led\", \"name\": \"armed\", \"pin\": 4}, " +
+    module + "]}";
+  return PTS::GameConfigParser::parse(game.c_str(), config);
+}
+
+}
+
+TEST(GameConfig, parse)
+{
+  PTS::GameConfig config;
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(test_game_config::GAME,
+                                                  config));
+
+  ASSERT_STREQ("test", config.name);
+  ASSERT_EQ(5u, config.module_count);
+
+  const PTS::ModuleConfig &keypad = config.modules[0];
+  ASSERT_EQ(PTS::ModuleType::KEYPAD, keypad.type);
+  ASSERT_STREQ("keypad", keypad.name);
+  ASSERT_EQ(3u, keypad.col_count);
+  ASSERT_EQ(4u, keypad.row_count);
+  ASSERT_EQ(36u, keypad.row_pins[3]);
+  ASSERT_EQ('#', keypad.keys[3][2]);
+
+  ASSERT_EQ(PTS::ModuleType::WIRE_DISCONNECT, config.modules[1].type);
+  ASSERT_EQ(18u, config.modules[1].wire_pins[2]);
+  ASSERT_EQ(4u, config.modules[1].wire_step_count);
+  ASSERT_EQ(2u, config.modules[1].wire_steps[2]);
+  ASSERT_EQ(0u, config.modules[1].forbidden_wires);
+  ASSERT_EQ(100u, config.modules[2].on_ms);
+  ASSERT_EQ(500u, config.modules[2].off_ms); // The default.
+  ASSERT_EQ(1000u, config.modules[3].tone_hz);
+  ASSERT_TRUE(config.modules[4].on);
+}
+
+TEST(GameConfig, rejects_invalid_games)
+{
+  using test_game_config::parseWith;
+  const std::pair<const char*, const char*> cases[] = {
+    {R"({"type": "led", "name": "x", "pin": 4})", "pin used twice"},
+    {R"({"type": "led", "name": "armed", "pin": 5})",
+     "duplicate module name"},
+    {R"({"type": "led", "name": "x", "pin": 35})",
+     "input only pin used as output"},
+    {R"({"type": "led", "name": "x", "pin": 7})", "unusable pin"},
+    {R"({"type": "led", "name": "x", "pin": 40})", "unusable pin"},
+    {R"({"type": "led", "name": "x"})", "module without pin"},
+    {R"({"type": "lamp", "name": "x", "pin": 5})", "unknown type"},
+    {R"({"type": "led", "name": "x", "pn": 5})", "unknown key"},
+    {R"({"type": "led", "name": "x", "pin": "5"})", "unexpected string"},
+    {R"({"type": "led", "name": "x", "pin": -5})",
+     "expected an unsigned integer"},
+    {R"({"type": "keypad", "name": "x", "cols": [12, 13],
+         "rows": [14, 15], "keys": ["12", "34"]})",
+     "unsupported keypad layout"},
+    {R"({"type": "keypad", "name": "x", "cols": [12, 13, 14],
+         "rows": [15, 16, 17, 18], "keys": ["123", "456", "789", "*0"]})",
+     "keypad keys don't match the columns"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [],
+         "led": [14, 15, 16]})", "wire disconnect needs 1 to 16 wires"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [12, 13],
+         "steps": [1], "led": [14, 15, 16]})",
+     "wire steps don't match the wires"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [12, 13],
+         "forbidden": [2], "led": [14, 15, 16]})",
+     "forbidden wire out of range"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [12, 13],
+         "steps": [1, 1], "forbidden": [1], "led": [14, 15, 16]})",
+     "forbidden wire with a step"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [12, 13],
+         "steps": [0, 0], "led": [14, 15, 16]})",
+     "wire disconnect needs a wire to cut"},
+    {R"({"type": "wire_disconnect", "name": "x", "wires": [12, 13],
+         "forbidden": [0, 1], "led": [14, 15, 16]})",
+     "wire disconnect needs a wire to cut"},
+    {R"({"type": "buzzer", "name": "x", "pin": 5})",
+     "buzzer needs a tone of 1 to 20000 Hz"},
+    {R"({"type": "led", "name": "012345678901234567890123", "pin": 5})",
+     "value too long"},
+    {R"({"type": "led", "name": "x", "pin": 5)", "invalid JSON"},
+  };
+
+  for (const auto &[module, error] : cases)
+  {
+    PTS::GameConfig config;
+    const char *result = parseWith(module, config);
+    ASSERT_NE(nullptr, result) << module;
+    EXPECT_STREQ(error, result) << module;
+  }
+
+  PTS::GameConfig config;
+  ASSERT_STREQ("no modules",
+               PTS::GameConfigParser::parse("{\"modules\": []}", config));
+  ASSERT_STREQ("incomplete file",
+               PTS::GameConfigParser::parse("{\"modules\": [", config));
+}
+
+TEST(ModuleFactory, build)
+{
+  PTS::GameConfig config;
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(test_game_config::GAME,
+                                                  config));
+
+  static PTS::ModuleFactory<> factory;
+  ASSERT_TRUE(factory.build(config));
+  ASSERT_EQ(5u, factory.size());
+  factory.begin();
+
+  ASSERT_EQ(OUTPUT, SIM::pinModes()[25].load()); // A keypad column.
+  ASSERT_EQ(OUTPUT, SIM::pinModes()[4].load()); // The armed led.
+  ASSERT_FALSE(factory.readKey("keypad").has_value());
+  ASSERT_FALSE(factory.readKey("armed").has_value());
+  ASSERT_EQ(PTS::Stateful::ACTIVE, factory.state("wires"));
+  ASSERT_FALSE(factory.state("keypad").has_value());
+
+  // A keypad looked up once, its handle goes invalid with the next build.
+  const PTS::ModuleHandle keypad =
+    factory.lookup("keypad", PTS::ModuleType::KEYPAD);
+  ASSERT_TRUE(keypad);
+  ASSERT_FALSE(factory.readKey(keypad).has_value());
+  ASSERT_FALSE(factory.lookup("armed", PTS::ModuleType::KEYPAD));
+  ASSERT_FALSE(factory.lookup("nope", PTS::ModuleType::KEYPAD));
+
+  // Objects that don't fit are not built (the keypad and the wires do).
+  static PTS::ModuleFactory<2000> small_factory;
+  ASSERT_FALSE(small_factory.build(config));
+  ASSERT_STREQ("out of module memory", small_factory.error());
+  ASSERT_EQ(0u, small_factory.size());
+
+  ASSERT_TRUE(factory.built(keypad));
+  ASSERT_TRUE(factory.build(config));
+  ASSERT_FALSE(factory.built(keypad));
+}
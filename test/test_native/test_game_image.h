@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "modules/game_config.h"
+#include "modules/game_image.h"
+#include "modules/module_factory.h"
+
+#pragma once
+
+namespace test_game_image
+{
+
+const char *const GAME = R"({
+  "name": "test",
+  "modules": [
+    {"type": "keypad", "name": "keypad", "cols": [25, 33, 32],
+     "rows": [35, 34, 39, 36], "keys": ["123", "456", "789", "*0#"]},
+    {"type": "wire_disconnect", "name": "wires", "wires": [16, 17, 18],
+     "led": [19, 21, 22]},
+    {"type": "led", "name": "armed", "pin": 4, "on": true}]})";
+
+/// The compiled GAME, in a (larger) partition.
+struct Partition
+{
+  Partition()
+  {
+    std::memset(data, 0xff, sizeof(data)); // Erased flash.
+    PTS::GameConfig config;
+    PTS::GameConfigParser::parse(GAME, config);
+    length = PTS::GameImage::write(config, data, sizeof(data));
+  }
+
+  alignas(PTS::ModuleConfig) uint8_t data[1024];
+  size_t length;
+};
+
+}
+
+TEST(GameImage, write_and_open)
+{
+  test_game_image::Partition partition;
+  ASSERT_EQ(PTS::GameImage::imageSize(3), partition.length);
+
+  PTS::GameImage image;
+  ASSERT_FALSE(image);
+  ASSERT_EQ(nullptr, image.open(partition.data, sizeof(partition.data)));
+  ASSERT_TRUE(image);
+  ASSERT_STREQ("test", image.name());
+  ASSERT_EQ(3u, image.size());
+
+  // The records are viewed in place.
+  ASSERT_EQ(static_cast<const void*>(partition.data +
+                                     sizeof(PTS::GameImageHeader)),
+            static_cast<const void*>(image.modules()));
+  ASSERT_EQ(PTS::ModuleType::KEYPAD, image.modules()[0].type);
+  ASSERT_EQ('#', image.modules()[0].keys[3][2]);
+  ASSERT_EQ(18u, image.modules()[1].wire_pins[2]);
+  ASSERT_TRUE(image.modules()[2].on);
+
+  size_t count = 0;
+  for (const PTS::ModuleConfig &module : image) count += module.name[0] != 0;
+  ASSERT_EQ(3u, count);
+}
+
+TEST(GameImage, rejects_invalid_images)
+{
+  test_game_image::Partition partition;
+  PTS::GameImage image;
+  auto header = reinterpret_cast<PTS::GameImageHeader*>(partition.data);
+
+  // Nothing written, or not all of it.
+  uint8_t erased[64];
+  std::memset(erased, 0xff, sizeof(erased));
+  ASSERT_STREQ("no game image", image.open(erased, sizeof(erased)));
+  ASSERT_STREQ("truncated game image",
+               image.open(partition.data, partition.length - 1));
+
+  // A bit flipped in a record.
+  partition.data[partition.length - 10] ^= 0x10;
+  ASSERT_STREQ("corrupt game image",
+               image.open(partition.data, sizeof(partition.data)));
+  ASSERT_FALSE(image);
+  partition.data[partition.length - 10] ^= 0x10;
+
+  // Written by another version of the compiler.
+  header->version++;
+  ASSERT_STREQ("unsupported game image version",
+               image.open(partition.data, sizeof(partition.data)));
+  header->version--;
+  header->module_size++;
+  ASSERT_STREQ("unsupported game image version",
+               image.open(partition.data, sizeof(partition.data)));
+  header->module_size--;
+
+  // Valid checksum, invalid module: the firmware checks it again.
+  auto modules = reinterpret_cast<PTS::ModuleConfig*>(header + 1);
+  modules[2].pin = 7;
+  header->checksum = PTS::GameImage::checksum(partition.data,
+                                              partition.length);
+  size_t failed = 0;
+  ASSERT_STREQ("unusable pin",
+               image.open(partition.data, sizeof(partition.data), &failed));
+  ASSERT_EQ(2u, failed);
+}
+
+TEST(GameImage, builds_modules)
+{
+  test_game_image::Partition partition;
+  PTS::GameImage image;
+  ASSERT_EQ(nullptr, image.open(partition.data, sizeof(partition.data)));
+
+  static PTS::ModuleFactory<> factory;
+  ASSERT_TRUE(factory.build(image.modules(), image.size()));
+  ASSERT_EQ(3u, factory.size());
+  ASSERT_TRUE(factory.state("wires").has_value());
+  ASSERT_FALSE(factory.readKey("keypad").has_value());
+  factory.clear();
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include "net/http_request.h"
+
+#pragma once
+
+namespace test_http_request
+{
+
+const char REQUEST[] =
+  "GET /api/attributes?since=42&name=a%20b HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "User-Agent: test\r\n"
+  "If-None-Match: \"v42\"  \r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n";
+
+}
+
+TEST(RequestParser, whole_request)
+{
+  PTS::RequestParser<> parser;
+
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE,
+            parser.feed(test_http_request::REQUEST,
+                        std::strlen(test_http_request::REQUEST)));
+
+  const PTS::HttpRequest &request = parser.request();
+  ASSERT_EQ(PTS::HttpMethod::GET, request.method());
+  ASSERT_STREQ("/api/attributes", request.path());
+  ASSERT_EQ(PTS::fnv1a("/api/attributes", 15), request.pathHash());
+  ASSERT_STREQ("since=42&name=a%20b", request.query());
+  ASSERT_STREQ("192.168.4.1", request.header(PTS::HttpHeader::HOST));
+  ASSERT_STREQ("\"v42\"", request.header(PTS::HttpHeader::IF_NONE_MATCH));
+  ASSERT_EQ(nullptr, request.header(PTS::HttpHeader::CONTENT_TYPE));
+  ASSERT_TRUE(request.keepAlive());
+
+  char value[16];
+  ASSERT_TRUE(request.queryParam("since", value, sizeof(value)));
+  ASSERT_STREQ("42", value);
+  ASSERT_TRUE(request.queryParam("name", value, sizeof(value)));
+  ASSERT_STREQ("a b", value);
+  ASSERT_FALSE(request.queryParam("missing", value, sizeof(value)));
+}
+
+TEST(RequestParser, byte_by_byte)
+{
+  PTS::RequestParser<> parser;
+  const size_t length = std::strlen(test_http_request::REQUEST);
+
+  for (size_t idx = 0; idx != length - 1; idx++)
+    ASSERT_EQ(PTS::RequestParser<>::INCOMPLETE,
+              parser.feed(test_http_request::REQUEST + idx, 1));
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE,
+            parser.feed(test_http_request::REQUEST + length - 1, 1));
+  ASSERT_STREQ("/api/attributes", parser.request().path());
+}
+
+TEST(RequestParser, body_and_pipelining)
+{
+  PTS::RequestParser<> parser;
+  const char requests[] =
+    "POST /api/commands HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "hello"
+    "GET / HTTP/1.1\r\n\r\n";
+
+  size_t consumed = 0;
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE,
+            parser.feed(requests, std::strlen(requests), &consumed));
+  ASSERT_EQ(PTS::HttpMethod::POST, parser.request().method());
+  ASSERT_EQ(std::string("hello"),
+            std::string(parser.request().body(),
+                        parser.request().bodyLength()));
+  ASSERT_FALSE(parser.request().keepAlive());
+
+  parser.reset();
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE,
+            parser.feed(requests + consumed,
+                        std::strlen(requests) - consumed));
+  ASSERT_STREQ("/", parser.request().path());
+}
+
+TEST(RequestParser, errors)
+{
+  PTS::RequestParser<> bad_target;
+  const char no_slash[] = "GET index.html HTTP/1.1\r\n\r\n";
+  ASSERT_EQ(PTS::RequestParser<>::BAD_REQUEST,
+            bad_target.feed(no_slash, std::strlen(no_slash)));
+
+  PTS::RequestParser<> bad_version;
+  const char version[] = "GET / SPDY/3\r\n\r\n";
+  ASSERT_EQ(PTS::RequestParser<>::BAD_REQUEST,
+            bad_version.feed(version, std::strlen(version)));
+
+  PTS::RequestParser<16> too_large;
+  const char long_path[] = "GET /a/very/long/path/indeed HTTP/1.1\r\n\r\n";
+  ASSERT_EQ(PTS::RequestParser<16>::TOO_LARGE,
+            too_large.feed(long_path, std::strlen(long_path)));
+}
+
+TEST(RequestParser, http_1_0)
+{
+  PTS::RequestParser<> parser;
+  const char request[] = "GET / HTTP/1.0\n\n";
+
+  ASSERT_EQ(PTS::RequestParser<>::COMPLETE,
+            parser.feed(request, std::strlen(request)));
+  ASSERT_EQ(0, parser.request().minorVersion());
+  ASSERT_FALSE(parser.request().keepAlive());
+}
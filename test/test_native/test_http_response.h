@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "net/http_response.h"
+
+#pragma once
+
+namespace test_http_response
+{
+
+/// Client recording every write separately.
+struct RecordingClient
+{
+  size_t write(const uint8_t *data, size_t length)
+  {
+    writes.emplace_back(reinterpret_cast<const char*>(data), length);
+    return length;
+  }
+
+  std::string received() const
+  {
+    std::string result;
+    for (const auto &write : writes) result += write;
+    return result;
+  }
+
+  std::vector<std::string> writes;
+};
+
+}
+
+TEST(ResponseWriter, content_length)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 64> writer;
+
+  writer.begin(client, "200 OK", "text/plain");
+  writer.header("Connection", "close");
+  writer.print("value: ");
+  writer.print(static_cast<uint32_t>(1234));
+  ASSERT_TRUE(writer.end());
+
+  ASSERT_EQ(1u, client.writes.size());
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Connection: close\r\n"
+                        "Content-Length: 11\r\n"
+                        "\r\n"
+                        "value: 1234"), client.received());
+}
+
+TEST(ResponseWriter, chunked)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 8> writer;
+
+  writer.begin(client, "200 OK", nullptr);
+  writer.print("0123456789abc");
+  ASSERT_TRUE(writer.end());
+
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n"
+                        "8\r\n01234567\r\n"
+                        "5\r\n89abc\r\n"
+                        "0\r\n\r\n"), client.received());
+}
+
+TEST(ResponseWriter, keep_alive)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 8> writer;
+
+  // Unchunked bodies outgrowing the buffer end with the connection.
+  writer.begin(client, "200 OK", nullptr, false);
+  ASSERT_FALSE(writer.closesConnection());
+  writer.print("0123456789");
+  ASSERT_TRUE(writer.end());
+  ASSERT_TRUE(writer.closesConnection());
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Connection: close\r\n"
+                        "\r\n"
+                        "0123456789"), client.received());
+
+  // Without keep-alive every response announces the close, once.
+  client.writes.clear();
+  writer.setKeepAlive(false);
+  writer.begin(client, "200 OK", nullptr, false);
+  writer.print("0123456789");
+  ASSERT_TRUE(writer.end());
+  ASSERT_TRUE(writer.closesConnection());
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Connection: close\r\n"
+                        "\r\n"
+                        "0123456789"), client.received());
+
+  writer.setKeepAlive(true);
+  writer.begin(client, "204 No Content", nullptr);
+  ASSERT_TRUE(writer.end());
+  ASSERT_FALSE(writer.closesConnection());
+}
+
+TEST(ResponseWriter, static_fragment)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 8> writer;
+
+  writer.begin(client, "200 OK", nullptr);
+  writer.print("ab");
+  writer.writeStatic("0123456789abcdef", 16);
+  writer.print("cd");
+  ASSERT_TRUE(writer.end());
+
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n"
+                        "2\r\nab\r\n"
+                        "10\r\n0123456789abcdef\r\n"
+                        "2\r\ncd\r\n"
+                        "0\r\n\r\n"), client.received());
+}
+
+TEST(ResponseWriter, static_body)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 8> writer;
+  static const uint8_t BODY[] = "0123456789abcdef";
+
+  // The body is longer than the buffer, yet keeps the Content-Length.
+  writer.begin(client, "200 OK", nullptr);
+  ASSERT_TRUE(writer.end(BODY, 16));
+
+  ASSERT_EQ(2u, client.writes.size());
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Content-Length: 16\r\n"
+                        "\r\n"), client.writes[0]);
+  ASSERT_EQ(std::string("0123456789abcdef"), client.writes[1]);
+  ASSERT_FALSE(writer.closesConnection());
+}
+
+TEST(ResponseWriter, suspended_body)
+{
+  test_http_response::RecordingClient client;
+  test_http_response::RecordingClient other;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 8> writer;
+
+  writer.begin(client, "200 OK", nullptr);
+  writer.print("abc");
+  ASSERT_TRUE(writer.suspend());
+
+  // Another response is written while the body waits.
+  writer.begin(other, "204 No Content", nullptr);
+  ASSERT_TRUE(writer.end());
+
+  writer.resume(client);
+  writer.print("def");
+  ASSERT_TRUE(writer.end());
+
+  ASSERT_EQ(std::string("HTTP/1.1 200 OK\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n"
+                        "3\r\nabc\r\n"
+                        "3\r\ndef\r\n"
+                        "0\r\n\r\n"), client.received());
+  ASSERT_EQ(std::string("HTTP/1.1 204 No Content\r\n"
+                        "Content-Length: 0\r\n"
+                        "\r\n"), other.received());
+}
+
+TEST(ResponseWriter, mss_sized_writes)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 256, 100> writer;
+
+  writer.begin(client, "200 OK", nullptr);
+  for (size_t idx = 0; idx != 250; idx++) writer.print("x");
+  ASSERT_TRUE(writer.end());
+
+  for (const auto &write : client.writes) ASSERT_LE(write.size(), 100u);
+  ASSERT_EQ(3u, client.writes.size());
+  ASSERT_EQ(3u, writer.writeCount());
+}
+
+TEST(ResponseWriter, escaping)
+{
+  test_http_response::RecordingClient client;
+  PTS::ResponseWriter<test_http_response::RecordingClient, 64> writer;
+
+  writer.begin(client, "200 OK", nullptr);
+  writer.printEscaped("<a href=\"x\">&</a>");
+  ASSERT_TRUE(writer.end());
+
+  const std::string received = client.received();
+  ASSERT_EQ(std::string("&lt;a href=&quot;x&quot;&gt;&amp;&lt;/a&gt;"),
+            received.substr(received.find("\r\n\r\n") + 4));
+}
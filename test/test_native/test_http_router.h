@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "net/http_router.h"
+
+#pragma once
+
+namespace test_http_router
+{
+
+using TestRouter = PTS::Router<4, int&>;
+
+/// Parses the request and dispatches it, storing the called handler's id.
+TestRouter::Result dispatch(const TestRouter &router, const char *request,
+                            int &called)
+{
+  PTS::RequestParser<> parser;
+  parser.feed(request, std::strlen(request));
+  called = 0;
+  return router.dispatch(parser.request(), called);
+}
+
+}
+
+TEST(Router, dispatch)
+{
+  test_http_router::TestRouter router;
+  router.on(PTS::HttpMethod::GET, "/",
+            [](const PTS::HttpRequest&, int &called) { called = 1; });
+  router.on(PTS::HttpMethod::GET, "/log",
+            [](const PTS::HttpRequest&, int &called) { called = 2; });
+  router.on(PTS::HttpMethod::GET, "/assets/*",
+            [](const PTS::HttpRequest&, int &called) { called = 3; });
+  router.on(PTS::HttpMethod::POST, "/log",
+            [](const PTS::HttpRequest&, int &called) { called = 4; });
+
+  int called;
+  ASSERT_EQ(test_http_router::TestRouter::HANDLED,
+    test_http_router::dispatch(router, "GET / HTTP/1.1\r\n\r\n", called));
+  ASSERT_EQ(1, called);
+  ASSERT_EQ(test_http_router::TestRouter::HANDLED,
+    test_http_router::dispatch(router, "GET /log HTTP/1.1\r\n\r\n", called));
+  ASSERT_EQ(2, called);
+  ASSERT_EQ(test_http_router::TestRouter::HANDLED,
+    test_http_router::dispatch(router, "POST /log HTTP/1.1\r\n\r\n", called));
+  ASSERT_EQ(4, called);
+  ASSERT_EQ(test_http_router::TestRouter::HANDLED,
+    test_http_router::dispatch(router, "GET /assets/app.js HTTP/1.1\r\n\r\n",
+                               called));
+  ASSERT_EQ(3, called);
+  ASSERT_EQ(test_http_router::TestRouter::NOT_FOUND,
+    test_http_router::dispatch(router, "GET /logs HTTP/1.1\r\n\r\n", called));
+  ASSERT_EQ(test_http_router::TestRouter::METHOD_NOT_ALLOWED,
+    test_http_router::dispatch(router, "PUT / HTTP/1.1\r\n\r\n", called));
+  ASSERT_EQ(0, called);
+}
+
+TEST(Router, full_table)
+{
+  test_http_router::TestRouter router;
+  for (int idx = 0; idx != 4; idx++)
+    ASSERT_TRUE(router.on(PTS::HttpMethod::GET, "/",
+                          [](const PTS::HttpRequest&, int&) { }));
+  ASSERT_FALSE(router.on(PTS::HttpMethod::GET, "/",
+                         [](const PTS::HttpRequest&, int&) { }));
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <SPI.h>
+#include <Wire.h>
+#include "modules/hw/io_scanner_module.h"
+#include "utils/hw/button.h"
+#include "utils/hw/io_expander.h"
+#include "utils/hw/led.h"
+
+#pragma once
+
+TEST(IoExpander, shifts_chains_in_one_transfer)
+{
+  SIM::ShiftRegisterChain chips(3, 2);
+  SPIClass spi;
+  spi.sim_device = &chips;
+  PTS::ShiftRegisterChain<3, 2> chain(spi, 25, 26);
+  chain.begin();
+  ASSERT_EQ(OUTPUT, SIM::pinModes()[25]);
+  ASSERT_EQ(HIGH, digitalRead(25));
+  ASSERT_EQ(LOW, digitalRead(26));
+
+  chips.setInput(0, 0x01);
+  chips.setInput(2, 0x80);
+  chain.write(0, HIGH);
+  chain.write(15, HIGH);
+  ASSERT_EQ(LOW, chain.read(0)); // Not scanned yet.
+  ASSERT_EQ(0, chips.output(0));
+
+  spi.sim_stats = {};
+  chain.scan();
+  ASSERT_EQ(1u, spi.sim_stats.transactions);
+  ASSERT_EQ(3u, spi.sim_stats.bytes);
+  ASSERT_EQ(HIGH, chain.read(0));
+  ASSERT_EQ(LOW, chain.read(1));
+  ASSERT_EQ(HIGH, chain.read(23));
+  ASSERT_EQ(LOW, chain.read(24)); // No such line.
+  ASSERT_EQ(0x01, chips.output(0));
+  ASSERT_EQ(0x80, chips.output(1));
+
+  chain.write(0, LOW);
+  chain.scan();
+  ASSERT_EQ(0x00, chips.output(0));
+  ASSERT_EQ(0x80, chips.output(1));
+}
+
+TEST(IoExpander, skips_unchanged_output_chains)
+{
+  SIM::ShiftRegisterChain chips(0, 1);
+  SPIClass spi;
+  spi.sim_device = &chips;
+  PTS::ShiftRegisterChain<0, 1> chain(spi, 25, 26);
+  chain.begin();
+  spi.sim_stats = {};
+
+  chain.scan();
+  ASSERT_EQ(0u, spi.sim_stats.transactions);
+  chain.write(3, HIGH);
+  chain.write(3, HIGH);
+  chain.scan();
+  chain.scan();
+  ASSERT_EQ(1u, spi.sim_stats.transactions);
+  ASSERT_EQ(0x08, chips.output(0));
+}
+
+TEST(IoExpander, batches_mcp23017_ports)
+{
+  SIM::Mcp23017 chip;
+  TwoWire wire;
+  wire.sim_devices[0x21] = &chip;
+  PTS::Mcp23017 expander(wire, 0x21);
+
+  expander.mode(0, OUTPUT);
+  expander.mode(9, INPUT_PULLUP);
+  expander.write(0, HIGH);
+  expander.begin();
+  ASSERT_TRUE(expander.present());
+  ASSERT_EQ(0xFFFE, chip.word(SIM::Mcp23017::IODIRA));
+  ASSERT_EQ(0x0200, chip.word(SIM::Mcp23017::GPPUA));
+  ASSERT_EQ(0x0001, chip.word(SIM::Mcp23017::OLATA));
+
+  // Without changes, a scan is a single read of both ports.
+  chip.setInputs(0x8200);
+  wire.sim_stats = {};
+  expander.scan();
+  ASSERT_EQ(1u, wire.sim_stats.transactions);
+  ASSERT_EQ(HIGH, expander.read(9));
+  ASSERT_EQ(HIGH, expander.read(15));
+  ASSERT_EQ(LOW, expander.read(1));
+  ASSERT_EQ(HIGH, expander.read(0)); // Reads back the output.
+
+  // Changed outputs take one more.
+  expander.write(0, LOW);
+  expander.scan();
+  ASSERT_EQ(3u, wire.sim_stats.transactions);
+  ASSERT_EQ(0x0000, chip.word(SIM::Mcp23017::OLATA));
+}
+
+TEST(IoExpander, reports_missing_mcp23017)
+{
+  SIM::Mcp23017 chip;
+  chip.setInputs(0xFFFF);
+  TwoWire wire;
+  PTS::Mcp23017 expander(wire, 0x22);
+  expander.mode(0, OUTPUT);
+  expander.write(0, HIGH);
+  expander.begin();
+  ASSERT_FALSE(expander.present());
+  ASSERT_EQ(LOW, expander.read(1));
+
+  // Set up as soon as it answers.
+  wire.sim_devices[0x22] = &chip;
+  expander.scan();
+  ASSERT_TRUE(expander.present());
+  ASSERT_EQ(HIGH, expander.read(1));
+  ASSERT_EQ(0x0001, chip.word(SIM::Mcp23017::OLATA));
+  ASSERT_EQ(0xFFFE, chip.word(SIM::Mcp23017::IODIRA));
+}
+
+TEST(IoExpander, drives_buttons_and_leds)
+{
+  SIM::ShiftRegisterChain chips(1, 1);
+  SPIClass spi;
+  spi.sim_device = &chips;
+  const PTS::ShiftRegisterChain<1, 1> chain(spi, 25, 26);
+  PTS::IoScannerModule<1> scanner;
+  ASSERT_TRUE(scanner.add(chain));
+  ASSERT_FALSE(scanner.add(chain));
+  scanner.begin();
+
+  static int falls = 0;
+  falls = 0;
+  const PTS::Button<0> button(PTS::IoPin(chain, 5));
+  button.onFalling([]() { falls++; });
+  chips.setInput(0, 0x20);
+  scanner.threadFunc();
+  button.begin();
+  ASSERT_EQ(HIGH, button.currentState());
+
+  chips.setInput(0, 0x00);
+  button.update();
+  ASSERT_EQ(0, falls); // Not scanned yet.
+  scanner.threadFunc();
+  button.update();
+  ASSERT_EQ(1, falls);
+
+  const PTS::LED led(PTS::IoPin(chain, 2));
+  led.begin();
+  led.on();
+  PTS::OutputFrame frame;
+  PTS::LED(PTS::IoPin(chain, 7)).stage(frame, true);
+  ASSERT_TRUE(frame.empty()); // Staged by the backend instead.
+  scanner.threadFunc();
+  ASSERT_EQ(0x84, chips.output(0));
+  ASSERT_EQ(3u, scanner.scans());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "utils/sw/json_parser.h"
+
+#pragma once
+
+namespace test_json_parser
+{
+
+/// Handler recording the events as text.
+struct Recorder
+{
+  bool beginObject() { events += "{"; return true; }
+  bool endObject() { events += "}"; return true; }
+  bool beginArray() { events += "["; return true; }
+  bool endArray() { events += "]"; return true; }
+  bool key(const char *name, size_t length)
+  {
+    events += "k:" + std::string(name, length) + " ";
+    return true;
+  }
+  bool string(const char *text, size_t length)
+  {
+    events += "s:" + std::string(text, length) + " ";
+    return std::string(text) != "stop";
+  }
+  bool number(const char *text, size_t)
+  {
+    events += "n:" + std::string(text) + " ";
+    return true;
+  }
+  bool boolean(bool flag) { events += flag ? "true " : "false "; return true; }
+  bool null() { events += "null "; return true; }
+
+  std::string events;
+};
+
+using Parser = PTS::JsonParser<Recorder, 16, 4>;
+
+/// Parses a document in chunks of the given size.
+Parser::Error parse(const std::string &json, Recorder &recorder,
+                    size_t chunk = 1000)
+{
+  Parser parser(recorder);
+  for (size_t offset = 0; offset < json.size(); offset += chunk)
+    parser.feed(json.data() + offset, std::min(chunk, json.size() - offset));
+  parser.finish();
+  return parser.error();
+}
+
+}
+
+TEST(JsonParser, events)
+{
+  using namespace test_json_parser;
+  const std::string json =
+    " {\"a\": [1, -2.5e3, true, false, null, {}, []],\n"
+    "  \"b\": \"x\\\"\\n\\u00e9\", \"c\": 7} ";
+  const std::string expected =
+    "{k:a [n:1 n:-2.5e3 true false null {}[]]k:b s:x\"\n\xc3\xa9 k:c n:7 }";
+
+  // Any chunking gives the same events.
+  for (size_t chunk : {1, 3, 1000})
+  {
+    Recorder recorder;
+    ASSERT_EQ(Parser::Error::NONE, parse(json, recorder, chunk));
+    ASSERT_EQ(expected, recorder.events);
+  }
+
+  Recorder number;
+  ASSERT_EQ(Parser::Error::NONE, parse("42", number));
+  ASSERT_EQ("n:42 ", number.events);
+}
+
+TEST(JsonParser, errors)
+{
+  using namespace test_json_parser;
+  const std::pair<const char*, Parser::Error> cases[] = {
+    {"{\"a\" 1}", Parser::Error::SYNTAX},
+    {"[1,]", Parser::Error::SYNTAX},
+    {"{\"a\":1,}", Parser::Error::SYNTAX},
+    {"[1 2]", Parser::Error::SYNTAX},
+    {"[1.2.3]", Parser::Error::SYNTAX},
+    {"[tru]", Parser::Error::SYNTAX},
+    {"{} {}", Parser::Error::SYNTAX},
+    {"[[[[[1]]]]]", Parser::Error::TOO_DEEP},
+    {"\"0123456789abcdef\"", Parser::Error::TOO_LONG},
+    {"[\"stop\", 1]", Parser::Error::ABORTED},
+    {"{\"a\": [1", Parser::Error::INCOMPLETE},
+    {"", Parser::Error::INCOMPLETE},
+  };
+
+  for (const auto &[json, error] : cases)
+  {
+    Recorder recorder;
+    EXPECT_EQ(error, parse(json, recorder)) << json;
+  }
+
+  // Nothing is reported after the failure.
+  Recorder recorder;
+  parse("[\"stop\", 1]", recorder);
+  ASSERT_EQ("[s:stop ", recorder.events);
+}
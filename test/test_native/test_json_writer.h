@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "utils/sw/json_writer.h"
+
+#pragma once
+
+namespace test_json_writer
+{
+
+/// Target collecting the written JSON.
+struct StringTarget
+{
+  void write(const char *data, size_t length) { text.append(data, length); }
+
+  std::string text;
+};
+
+}
+
+TEST(JsonWriter, nesting)
+{
+  test_json_writer::StringTarget target;
+  PTS::JsonWriter<test_json_writer::StringTarget> json(target);
+
+  json.beginObject()
+      .key("version").value(static_cast<uint32_t>(42))
+      .key("full").value(true)
+      .key("list").beginArray()
+        .value(static_cast<int32_t>(-7))
+        .beginObject().endObject()
+        .null()
+      .endArray()
+      .key("ratio").value(0.5)
+      .endObject();
+
+  ASSERT_EQ(std::string("{\"version\":42,\"full\":true,"
+                        "\"list\":[-7,{},null],\"ratio\":0.5}"), target.text);
+}
+
+TEST(JsonWriter, escaping)
+{
+  test_json_writer::StringTarget target;
+  PTS::JsonWriter<test_json_writer::StringTarget> json(target);
+
+  json.value("say \"hi\"\\\n\x01");
+
+  ASSERT_EQ(std::string("\"say \\\"hi\\\"\\\\\\n\\u0001\""), target.text);
+}
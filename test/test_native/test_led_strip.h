@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <driver/rmt.h>
+#include "utils/hw/led_strip.h"
+
+#pragma once
+
+namespace test_led_strip
+{
+
+/// \return the bits of the symbols of a byte, most significant first, or -1
+/// for a symbol that isn't a WS2812 bit.
+int decode(const rmt_item32_t *items)
+{
+  int byte = 0;
+  for (size_t bit = 0; bit != 8; bit++)
+  {
+    const rmt_item32_t &item = items[bit];
+    if (item.level0 != 1 || item.level1 != 0) return -1;
+    if (item.duration0 == PTS::WS2812::T1H &&
+        item.duration1 == PTS::WS2812::T1L)
+      byte = byte << 1 | 1;
+    else if (item.duration0 == PTS::WS2812::T0H &&
+             item.duration1 == PTS::WS2812::T0L)
+      byte = byte << 1;
+    else
+      return -1;
+  }
+  return byte;
+}
+
+}
+
+TEST(LedStrip, encodes_bits)
+{
+  // 0.8 us high and 0.45 us low, 0.4 us high and 0.85 us low at 25 ns.
+  ASSERT_EQ(0x00128020u, PTS::WS2812::symbol(true));
+  ASSERT_EQ(0x00228010u, PTS::WS2812::symbol(false));
+
+  const uint8_t bytes[] = {0xA5, 0x00, 0xFF, 0x3C};
+  rmt_item32_t items[32];
+  PTS::WS2812::encode(bytes, 4, items);
+  const uint32_t one = PTS::WS2812::symbol(true);
+  const uint32_t zero = PTS::WS2812::symbol(false);
+  const uint32_t expected[8] = {one, zero, one, zero, zero, one, zero, one};
+  for (size_t bit = 0; bit != 8; bit++)
+    ASSERT_EQ(expected[bit], items[bit].val) << bit;
+  for (size_t idx = 0; idx != 4; idx++)
+    ASSERT_EQ(bytes[idx], test_led_strip::decode(&items[idx * 8])) << idx;
+}
+
+TEST(LedStrip, sends_green_red_blue)
+{
+  using test_led_strip::decode;
+  PTS::LedStrip<3> strip(18, 0);
+  strip.begin();
+  ASSERT_EQ(OUTPUT, SIM::pinModes()[18]);
+  strip.set(0, PTS::COLOR::RED);
+  strip.set(2, PTS::Color{0, 0x80, 0xFF});
+  ASSERT_TRUE(strip.show());
+  strip.wait();
+
+  const SIM::RmtChannel channel = SIM::rmtChannel(RMT_CHANNEL_0);
+  ASSERT_EQ(1u, channel.transmissions);
+  ASSERT_EQ(PTS::LedStrip<3>::ITEMS, channel.sent.size());
+  ASSERT_EQ(0x00, decode(&channel.sent[0]));
+  ASSERT_EQ(0xFF, decode(&channel.sent[8]));
+  ASSERT_EQ(0x00, decode(&channel.sent[16]));
+  ASSERT_EQ(0x00, decode(&channel.sent[24]));
+  // Gamma corrected, rounded to a byte.
+  ASSERT_EQ((PTS::RGBLED::gamma(0x80) * 255 + PTS::RGBLED::MAX_DUTY / 2) /
+              PTS::RGBLED::MAX_DUTY,
+            static_cast<uint32_t>(decode(&channel.sent[48])));
+  ASSERT_EQ(0xFF, decode(&channel.sent[64]));
+
+  // Then the line is held low for the reset.
+  const rmt_item32_t &reset = channel.sent.back();
+  ASSERT_EQ(PTS::WS2812::RESET, reset.duration0);
+  ASSERT_EQ(0u, reset.level0);
+  ASSERT_EQ(0u, reset.duration1);
+}
+
+TEST(LedStrip, double_buffers_frames)
+{
+  using test_led_strip::decode;
+  PTS::LedStrip<300> strip(19, 2);
+  strip.begin();
+
+  // Every frame is encoded while the previous one is sent, into the other
+  // buffer, so none changes while it is sent.
+  for (uint8_t frame = 1; frame != 6; frame++)
+  {
+    strip.fill(PTS::Color{frame, frame, frame});
+    ASSERT_TRUE(strip.show());
+  }
+  ASSERT_FALSE(strip.show()); // Nothing changed.
+  strip.wait();
+  SIM::RmtChannel channel = SIM::rmtChannel(RMT_CHANNEL_2);
+  ASSERT_EQ(5u, channel.transmissions);
+  ASSERT_EQ(0u, channel.torn);
+  ASSERT_EQ(5u, strip.frames());
+
+  // A buffer last encoded two frames ago is brought up to date.
+  strip.set(299, PTS::COLOR::BLUE);
+  strip.show();
+  strip.set(0, PTS::COLOR::WHITE);
+  strip.show();
+  strip.wait();
+  channel = SIM::rmtChannel(RMT_CHANNEL_2);
+  ASSERT_EQ(0xFF, decode(&channel.sent[0]));
+  ASSERT_EQ(0xFF, decode(&channel.sent[299 * 24 + 16]));
+  ASSERT_EQ(0u, channel.torn);
+}
+
+TEST(LedStrip, scales_brightness)
+{
+  using test_led_strip::decode;
+  PTS::LedStrip<2> strip(21, 4);
+  strip.begin();
+  strip.bar(1, PTS::COLOR::WHITE);
+  ASSERT_EQ(PTS::COLOR::WHITE, strip.pixel(0));
+  ASSERT_EQ(PTS::COLOR::OFF, strip.pixel(1));
+
+  strip.brightness(128);
+  strip.show();
+  strip.wait();
+  SIM::RmtChannel channel = SIM::rmtChannel(RMT_CHANNEL_4);
+  ASSERT_EQ(128, decode(&channel.sent[0]));
+  ASSERT_EQ(0, decode(&channel.sent[24]));
+
+  strip.brightness(0);
+  strip.show();
+  strip.wait();
+  channel = SIM::rmtChannel(RMT_CHANNEL_4);
+  ASSERT_EQ(0, decode(&channel.sent[0]));
+}
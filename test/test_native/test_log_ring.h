@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/sw/log_ring.h"
+
+#pragma once
+
+namespace test_log_ring
+{
+
+/// Reads everything currently available from the cursor.
+template<size_t SIZE>
+std::string readAll(const PTS::LogRing<SIZE> &ring,
+                    typename PTS::LogRing<SIZE>::Cursor &cursor)
+{
+  std::string result;
+  char buffer[7];
+  size_t length;
+  while ((length = ring.read(cursor, buffer, sizeof(buffer))) != 0)
+    result.append(buffer, length);
+  return result;
+}
+
+}
+
+TEST(LogRing, read_in_order)
+{
+  PTS::LogRing<64> ring;
+  PTS::LogRing<64>::Cursor cursor = ring.oldest();
+
+  ring.write("hello ", 6);
+  ring.write("world\n", 6);
+
+  ASSERT_EQ(std::string("hello world\n"), test_log_ring::readAll(ring, cursor));
+  ASSERT_EQ(std::string(""), test_log_ring::readAll(ring, cursor));
+}
+
+TEST(LogRing, overrun_skips_to_oldest)
+{
+  PTS::LogRing<8> ring;
+  PTS::LogRing<8>::Cursor cursor = ring.oldest();
+
+  ring.write("0123456789abcdef", 16);
+
+  ASSERT_EQ(16u, ring.newest());
+  ASSERT_EQ(std::string("89abcdef"), test_log_ring::readAll(ring, cursor));
+}
+
+TEST(LogRing, tail_starts_at_line)
+{
+  PTS::LogRing<32> ring;
+
+  ring.write("first line\nsecond line\nthird\n", 29);
+
+  PTS::LogRing<32>::Cursor cursor = ring.tail(10);
+  ASSERT_EQ(std::string("third\n"), test_log_ring::readAll(ring, cursor));
+
+  cursor = ring.tail(100);
+  ASSERT_EQ(std::string("first line\nsecond line\nthird\n"),
+            test_log_ring::readAll(ring, cursor));
+}
+
+TEST(LogRing, independent_cursors)
+{
+  PTS::LogRing<16> ring;
+  PTS::LogRing<16>::Cursor fast = ring.oldest();
+  PTS::LogRing<16>::Cursor slow = ring.oldest();
+
+  ring.write("abcd", 4);
+  ASSERT_EQ(std::string("abcd"), test_log_ring::readAll(ring, fast));
+  ring.write("efgh", 4);
+  ASSERT_EQ(std::string("efgh"), test_log_ring::readAll(ring, fast));
+
+  ASSERT_EQ(std::string("abcdefgh"), test_log_ring::readAll(ring, slow));
+}
+
+TEST(LogRing, concurrent_readers)
+{
+  constexpr size_t READERS = 32;
+  constexpr unsigned LINES = 20000;
+
+  PTS::LogRing<1024> ring;
+  std::atomic<bool> done{false};
+  std::atomic<size_t> failures{0};
+  std::vector<std::thread> readers;
+
+  // Every reader has to see complete lines with strictly increasing numbers,
+  // gaps are only allowed when a slow reader has been overrun by the writer.
+  for (size_t reader = 0; reader != READERS; reader++)
+  {
+    readers.emplace_back([&ring, &done, &failures, reader]()
+    {
+      PTS::LogRing<1024>::Cursor cursor = ring.tail(1024);
+      std::string pending;
+      long last = -1;
+      char buffer[64];
+      bool synced = true;
+
+      for (;;)
+      {
+        const bool finished = done.load();
+        const PTS::LogRing<1024>::Cursor before = cursor;
+        const size_t length = ring.read(cursor, buffer, sizeof(buffer));
+
+        // An overrun moves the cursor, resynchronize on the next line.
+        if (cursor - before != length)
+        {
+          pending.clear();
+          synced = false;
+        }
+        pending.append(buffer, length);
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos)
+        {
+          const std::string line = pending.substr(0, newline);
+          pending.erase(0, newline + 1);
+          if (!synced)
+          {
+            synced = true;
+            continue;
+          }
+          const long value = std::strtol(line.c_str(), nullptr, 10);
+          if (line.size() != 8 || value <= last) failures++;
+          last = value;
+        }
+
+        if (length == 0 && finished) break;
+        // Make some of the readers slow.
+        if (reader % 4 == 0) std::this_thread::yield();
+      }
+    });
+  }
+
+  char line[16];
+  for (unsigned value = 0; value != LINES; value++)
+  {
+    std::snprintf(line, sizeof(line), "%08u\n", value);
+    ring.write(line, 9);
+  }
+  done = true;
+
+  for (auto &thread : readers) thread.join();
+
+  ASSERT_EQ(0u, failures.load());
+  ASSERT_EQ(LINES * 9u, ring.newest());
+}
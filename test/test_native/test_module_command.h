@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "modules/module_base.h"
+#include "modules/module_factory.h"
+
+#pragma once
+
+namespace test_module_command
+{
+
+/// A module counting its ticks and resets, ticking every 5 ms.
+class Counter : public PTS::Module<1024, tskIDLE_PRIORITY, 200>
+{
+ public:
+  explicit Counter() : Module("counter"), ticks(0), resets(0) { }
+
+  void begin() const override { }
+  void threadFunc() const override { ticks++; }
+  void reset() const override { resets++; }
+
+  mutable std::atomic<int> ticks;
+  mutable std::atomic<int> resets;
+};
+
+/// A module sounding on its slow ticks, and silenced as it rests.
+class Sounder : public PTS::Module<1024, tskIDLE_PRIORITY, 200>
+{
+ public:
+  explicit Sounder() : Module("sounder"), ticking(false), sounding(false) { }
+
+  void begin() const override { }
+  void threadFunc() const override
+  {
+    ticking = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    sounding = true;
+    ticking = false;
+  }
+  void idle() const override { sounding = false; }
+
+  mutable std::atomic<bool> ticking;
+  mutable std::atomic<bool> sounding;
+};
+
+/// Waits (at most a second) for a condition.
+template<typename CONDITION>
+bool waitFor(CONDITION condition)
+{
+  for (int idx = 0; idx != 200; idx++)
+  {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return condition();
+}
+
+/// \return the number of ticks within 50 ms.
+int ticksWithin(const Counter &counter)
+{
+  const int ticks = counter.ticks;
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  return counter.ticks - ticks;
+}
+
+}
+
+TEST(ModuleCommand, mailbox)
+{
+  using namespace test_module_command;
+  using PTS::CommandResult;
+  using PTS::ModuleCommand;
+  SIM::serialEnabled() = false;
+
+  static Counter counter;
+  counter.ticks = 0;
+  counter.resets = 0;
+  // Without a thread only a reset can be done, right away.
+  ASSERT_EQ(CommandResult::NOT_RUNNING, counter.post(ModuleCommand::SUSPEND));
+  ASSERT_EQ(CommandResult::APPLIED, counter.post(ModuleCommand::RESET));
+  ASSERT_EQ(1, counter.resets);
+
+  ASSERT_EQ(CommandResult::APPLIED, counter.post(ModuleCommand::START));
+  ASSERT_TRUE(waitFor([]() { return counter.ticks > 0; }));
+
+  // The commands are applied by the module, in order, between its ticks.
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::SUSPEND));
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::RESET));
+  ASSERT_TRUE(waitFor([]() { return counter.resets == 2; }));
+  ASSERT_EQ(0, ticksWithin(counter));
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::RESUME));
+  ASSERT_TRUE(waitFor([]() { return ticksWithin(counter) > 0; }));
+
+  // A module that doesn't drain its mailbox doesn't hold up the poster.
+  counter.suspend();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int idx = 0; idx != 4; idx++)
+    ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::RESET));
+  ASSERT_EQ(CommandResult::MAILBOX_FULL, counter.post(ModuleCommand::RESET));
+  counter.resume();
+  ASSERT_TRUE(waitFor([]() { return counter.resets == 6; }));
+
+  // Stopping deletes the thread from within.
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::STOP));
+  ASSERT_TRUE(waitFor([]() { return !counter.isRunning(); }));
+  ASSERT_EQ(0, ticksWithin(counter));
+  ASSERT_EQ(CommandResult::APPLIED, counter.post(ModuleCommand::STOP));
+
+  // The commands behind a STOP don't reach the restarted thread.
+  counter.start();
+  counter.suspend();
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::STOP));
+  ASSERT_EQ(CommandResult::QUEUED, counter.post(ModuleCommand::SUSPEND));
+  counter.resume();
+  ASSERT_TRUE(waitFor([]() { return !counter.isRunning(); }));
+  ASSERT_EQ(CommandResult::APPLIED, counter.post(ModuleCommand::START));
+  ASSERT_TRUE(waitFor([]() { return ticksWithin(counter) > 0; }));
+  counter.destroy();
+  SIM::serialEnabled() = true;
+}
+
+TEST(ModuleCommand, destroy_rests_after_the_last_tick)
+{
+  using namespace test_module_command;
+  SIM::serialEnabled() = false;
+
+  // Destroyed by another task in the middle of a tick, the module rests
+  // after it, not before.
+  static Sounder sounder;
+  sounder.start();
+  ASSERT_TRUE(waitFor([]() { return sounder.ticking.load(); }));
+  sounder.destroy();
+  ASSERT_FALSE(sounder.sounding);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(sounder.sounding);
+  ASSERT_FALSE(sounder.isRunning());
+  SIM::serialEnabled() = true;
+}
+
+TEST(ModuleCommand, factory_post)
+{
+  using PTS::CommandResult;
+  using PTS::ModuleCommand;
+
+  PTS::GameConfig config;
+  ASSERT_EQ(nullptr, PTS::GameConfigParser::parse(R"({"modules": [
+    {"type": "wire_disconnect", "name": "wires", "wires": [16, 17, 18],
+     "led": [19, 21, 22]},
+    {"type": "led", "name": "armed", "pin": 4}]})", config));
+  static PTS::ModuleFactory<> factory;
+  ASSERT_TRUE(factory.build(config));
+  factory.begin();
+
+  ASSERT_EQ(CommandResult::UNKNOWN_MODULE,
+            factory.post("nope", ModuleCommand::RESET));
+  ASSERT_EQ(CommandResult::UNSUPPORTED,
+            factory.post("armed", ModuleCommand::RESET));
+  ASSERT_EQ(CommandResult::NOT_RUNNING,
+            factory.post("wires", ModuleCommand::SUSPEND));
+  ASSERT_EQ(CommandResult::APPLIED,
+            factory.post("wires", ModuleCommand::RESET));
+  ASSERT_EQ(PTS::Stateful::ACTIVE, factory.state("wires"));
+  factory.clear();
+}
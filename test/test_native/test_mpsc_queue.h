@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "utils/sw/mpsc_queue.h"
+
+#pragma once
+
+TEST(MpscQueue, fifo)
+{
+  PTS::MpscQueue<int, 4> queue;
+  int value;
+  ASSERT_FALSE(queue.pop(value));
+
+  for (int idx = 0; idx != 4; idx++) ASSERT_TRUE(queue.push(idx));
+  // A full queue rejects the value.
+  ASSERT_FALSE(queue.push(4));
+
+  for (int idx = 0; idx != 4; idx++)
+  {
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(idx, value);
+    ASSERT_TRUE(queue.push(idx + 4));
+  }
+  ASSERT_TRUE(queue.pop(value));
+  ASSERT_EQ(4, value);
+}
+
+TEST(MpscQueue, multiple_producers)
+{
+  constexpr int PRODUCERS = 4;
+  constexpr int COUNT = 20000;
+  PTS::MpscQueue<int, 64> queue;
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer != PRODUCERS; producer++)
+  {
+    producers.emplace_back([&queue, producer]()
+    {
+      for (int idx = 0; idx != COUNT; idx++)
+        while (!queue.push(producer * COUNT + idx)) std::this_thread::yield();
+    });
+  }
+
+  // Every value arrives once, in order per producer.
+  std::vector<int> next(PRODUCERS, 0);
+  int value;
+  for (int received = 0; received != PRODUCERS * COUNT;)
+  {
+    if (!queue.pop(value)) continue;
+    ASSERT_EQ(next[value / COUNT]++, value % COUNT);
+    received++;
+  }
+  for (auto &producer : producers) producer.join();
+  ASSERT_FALSE(queue.pop(value));
+}
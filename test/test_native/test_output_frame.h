@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <soc/soc.h>
+#include "modules/hw/animator_module.h"
+#include "utils/hw/led.h"
+#include "utils/hw/output_frame.h"
+#include "utils/hw/status_bar.h"
+
+#pragma once
+
+TEST(OutputFrame, commits_at_once)
+{
+  PTS::OutputFrame frame;
+  ASSERT_TRUE(frame.empty());
+  frame.set(2, true);
+  frame.set(4, true);
+  frame.set(4, false); // The last level staged counts.
+  frame.set(33, true);
+  frame.set(40, true); // No such pin.
+  ASSERT_EQ((uint64_t(1) << 2) | (uint64_t(1) << 33), frame.setMask());
+  ASSERT_EQ(uint64_t(1) << 4, frame.clearMask());
+
+  SIM::takeRegisterWrites();
+  digitalWrite(4, HIGH);
+  frame.commit();
+  ASSERT_TRUE(frame.empty());
+  ASSERT_EQ(HIGH, digitalRead(2));
+  ASSERT_EQ(LOW, digitalRead(4));
+  ASSERT_EQ(HIGH, digitalRead(33));
+
+  // A register write per bank and direction, none for the empty ones.
+  const std::vector<SIM::RegisterWrite> writes = SIM::takeRegisterWrites();
+  ASSERT_EQ(3u, writes.size());
+  ASSERT_EQ(GPIO_OUT_W1TS_REG, writes[0].reg);
+  ASSERT_EQ(1u << 2, writes[0].value);
+  ASSERT_EQ(GPIO_OUT_W1TC_REG, writes[1].reg);
+  ASSERT_EQ(1u << 4, writes[1].value);
+  ASSERT_EQ(GPIO_OUT1_W1TS_REG, writes[2].reg);
+  ASSERT_EQ(1u << 1, writes[2].value);
+
+  frame.commit();
+  ASSERT_TRUE(SIM::takeRegisterWrites().empty());
+}
+
+TEST(OutputFrame, status_bars_change_at_once)
+{
+  PTS::StatusBar<8> bar({PTS::LED(12), PTS::LED(13), PTS::LED(14),
+                         PTS::LED(15), PTS::LED(16), PTS::LED(17),
+                         PTS::LED(18), PTS::LED(19)});
+  bar.begin();
+  bar.fill(6);
+  SIM::takeRegisterWrites();
+
+  // Two LEDs off and one on, in a single pair of writes.
+  bar.dot(6);
+  std::vector<SIM::RegisterWrite> writes = SIM::takeRegisterWrites();
+  ASSERT_EQ(2u, writes.size());
+  ASSERT_EQ(1u << 18, writes[0].value);
+  ASSERT_EQ(0x3Fu << 12, writes[1].value);
+
+  bar.clear();
+  writes = SIM::takeRegisterWrites();
+  ASSERT_EQ(1u, writes.size());
+  ASSERT_EQ(GPIO_OUT_W1TC_REG, writes[0].reg);
+  ASSERT_EQ(0xFFu << 12, writes[0].value);
+}
+
+TEST(OutputFrame, animator_frames_change_at_once)
+{
+  PTS::AnimatorModule<4> animator;
+  const PTS::LED leds[3] = {PTS::LED(21), PTS::LED(22), PTS::LED(23)};
+  for (const PTS::LED &led : leds)
+  {
+    led.begin();
+    animator.play(led, PTS::Timeline::blink(50, 50));
+  }
+
+  // The three blinkers start together, and are written together.
+  SIM::takeRegisterWrites();
+  animator.threadFunc();
+  const std::vector<SIM::RegisterWrite> writes = SIM::takeRegisterWrites();
+  ASSERT_EQ(1u, writes.size());
+  ASSERT_EQ(GPIO_OUT_W1TS_REG, writes[0].reg);
+  ASSERT_EQ(7u << 21, writes[0].value);
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include "net/replicator.h"
+
+#pragma once
+
+namespace test_replicator
+{
+
+using Board = PTS::Replicator<4, 3>;
+
+constexpr size_t BOARD_COUNT = 3;
+constexpr uint16_t BASE_PORT = 42101;
+
+/// Three boards on the loopback, every one sending to the other two.
+struct Game
+{
+  explicit Game(uint16_t base_port = BASE_PORT) : base_port(base_port)
+  {
+    for (size_t idx = 0; idx != BOARD_COUNT; idx++) build(idx);
+  }
+
+  /// Builds a board (again, as a powered on one).
+  void build(size_t idx)
+  {
+    Board &board = boards[idx].emplace(idx, base_port + idx);
+    score[idx] = board.add("score", PTS::ReplicaType::INTEGER);
+    state[idx] = board.add("wires", PTS::ReplicaType::STATE);
+    countdown[idx] = board.add("countdown", PTS::ReplicaType::COUNTDOWN);
+    for (size_t peer = 0; peer != BOARD_COUNT; peer++)
+      if (peer != idx)
+        board.addDestination(IPAddress(127, 0, 0, 1), base_port + peer);
+  }
+
+  void start()
+  {
+    for (std::optional<Board> &board : boards)
+    {
+      board->begin();
+      board->start();
+    }
+  }
+
+  /// Powers a board off, closing its socket.
+  void powerOff(size_t idx)
+  {
+    boards[idx]->destroy();
+    boards[idx].reset();
+  }
+
+  void stop()
+  {
+    for (std::optional<Board> &board : boards)
+      if (board) board->destroy();
+    // The deleted threads end at their next delay.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  const uint16_t base_port;
+  std::optional<Board> boards[BOARD_COUNT];
+  PTS::ReplicaHandle score[BOARD_COUNT];
+  PTS::ReplicaHandle state[BOARD_COUNT];
+  PTS::ReplicaHandle countdown[BOARD_COUNT];
+};
+
+/// \return the game of both tests, the ports are bound once.
+Game &game()
+{
+  static Game instance;
+  return instance;
+}
+
+/// Waits (at most three seconds) for a condition.
+template<typename CONDITION>
+bool waitFor(CONDITION condition)
+{
+  for (int idx = 0; idx != 300; idx++)
+  {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+/// \return true, if every board has the score.
+bool scoreIs(const Game &game, int32_t score)
+{
+  for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+    if (game.boards[idx]->getInteger(game.score[idx]) != score) return false;
+  return true;
+}
+
+}
+
+TEST(Replicator, converges)
+{
+  using namespace test_replicator;
+  SIM::serialEnabled() = false;
+
+  static Game &game = test_replicator::game();
+  game.start();
+
+  // Every board may write, the others follow.
+  ASSERT_TRUE(game.boards[0]->setInteger(game.score[0], 42));
+  ASSERT_TRUE(game.boards[1]->setState(game.state[1], PTS::Stateful::PASSED));
+  ASSERT_TRUE(game.boards[2]->setCountdown(game.countdown[2], 60000, true));
+  ASSERT_FALSE(game.boards[0]->setBool(game.score[0], true));
+  ASSERT_TRUE(waitFor([]() { return scoreIs(game, 42); }));
+  ASSERT_TRUE(waitFor([]() {
+    for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+    {
+      const Board &board = *game.boards[idx];
+      if (board.getState(game.state[idx]) != PTS::Stateful::PASSED ||
+          !board.countdownRunning(game.countdown[idx]))
+        return false;
+    }
+    return true;
+  }));
+
+  // The countdown runs on the local clocks, off by the latency at most.
+  for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+  {
+    const uint32_t remaining = game.boards[idx]->remaining(game.countdown[idx]);
+    ASSERT_LE(remaining, 60000u);
+    ASSERT_GT(remaining, 55000u);
+  }
+
+  // Of concurrent writes, the same one wins everywhere.
+  game.boards[0]->setInteger(game.score[0], 1);
+  game.boards[2]->setInteger(game.score[2], 2);
+  ASSERT_TRUE(waitFor([]() {
+    const int32_t score = game.boards[0]->getInteger(game.score[0]);
+    return (score == 1 || score == 2) && scoreIs(game, score);
+  }));
+
+  // A stopped countdown holds its time.
+  ASSERT_TRUE(game.boards[1]->setCountdown(game.countdown[1], 1234, false));
+  ASSERT_TRUE(waitFor([]() {
+    for (size_t idx = 0; idx != BOARD_COUNT; idx++)
+      if (game.boards[idx]->remaining(game.countdown[idx]) != 1234)
+        return false;
+    return true;
+  }));
+
+  // The writes of the board are acknowledged by both peers.
+  ASSERT_TRUE(waitFor([]() {
+    return game.boards[1]->stats().converged_writes >= 2;
+  }));
+  const PTS::ReplicationStats stats = game.boards[1]->stats();
+  ASSERT_EQ(2, stats.peers);
+  ASSERT_GT(stats.packets_received, 0u);
+  ASSERT_GT(stats.bytes_sent, 0u);
+  ASSERT_LT(stats.max_convergence_ms, 1000u);
+
+  game.stop();
+  SIM::serialEnabled() = true;
+}
+
+TEST(Replicator, converges_despite_loss)
+{
+  using namespace test_replicator;
+  SIM::serialEnabled() = false;
+
+  static Game &game = test_replicator::game();
+  game.start();
+  SIM::udpLossPercent() = 30;
+
+  // Some of the packets of the series are lost, the last write arrives
+  // anyway.
+  for (int32_t score = 1; score <= 20; score++)
+  {
+    game.boards[0]->setInteger(game.score[0], score);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  ASSERT_TRUE(waitFor([]() { return scoreIs(game, 20); }));
+  ASSERT_TRUE(waitFor([]() {
+    return game.boards[0]->stats().converged_writes >= 1;
+  }));
+
+  uint32_t resent = 0;
+  for (const std::optional<Board> &board : game.boards)
+    resent += board->stats().resent_values;
+  ASSERT_GT(resent, 0u);
+
+  SIM::udpLossPercent() = 0;
+  game.stop();
+  SIM::serialEnabled() = true;
+}
+
+TEST(Replicator, resyncs_a_restarted_board)
+{
+  using namespace test_replicator;
+  SIM::serialEnabled() = false;
+
+  static Game game(BASE_PORT + BOARD_COUNT);
+  game.start();
+
+  // Board 0 writes its score a few times, board 1 the state of its wires.
+  for (int32_t score = 1; score <= 5; score++)
+    ASSERT_TRUE(game.boards[0]->setInteger(game.score[0], score));
+  ASSERT_TRUE(game.boards[1]->setState(game.state[1], PTS::Stateful::PASSED));
+  ASSERT_TRUE(waitFor([]() {
+    return game.boards[2]->getInteger(game.score[2]) == 5 &&
+           game.boards[2]->getState(game.state[2]) == PTS::Stateful::PASSED;
+  }));
+
+  // Board 1 is gone, and board 2 is restarted: it gets the state written by
+  // board 1 from board 0.
+  game.powerOff(1);
+  game.powerOff(2);
+  game.build(2);
+  game.boards[2]->begin();
+  game.boards[2]->start();
+  ASSERT_TRUE(waitFor([]() {
+    return game.boards[2]->getInteger(game.score[2]) == 5 &&
+           game.boards[2]->getState(game.state[2]) == PTS::Stateful::PASSED;
+  }));
+
+  // Its clock moved past the writes it missed, so its writes win.
+  ASSERT_TRUE(game.boards[2]->setInteger(game.score[2], 42));
+  ASSERT_TRUE(waitFor([]() {
+    return game.boards[0]->getInteger(game.score[0]) == 42;
+  }));
+  ASSERT_EQ(42, game.boards[2]->getInteger(game.score[2]));
+
+  game.stop();
+  SIM::serialEnabled() = true;
+}
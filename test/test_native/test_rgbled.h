@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <thread>
+#include "utils/hw/ledc.h"
+#include "utils/hw/rgbled.h"
+
+#pragma once
+
+TEST(RGBLED, gamma)
+{
+  ASSERT_EQ(0u, PTS::RGBLED::gamma(0));
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, PTS::RGBLED::gamma(255));
+  // The duty is the component to the power 2.2, half the brightness to the
+  // eye is about a fifth of the power.
+  for (int idx : {1, 64, 128, 200})
+    ASSERT_NEAR(std::pow(idx / 255.0, 2.2) * PTS::RGBLED::MAX_DUTY,
+                PTS::RGBLED::gamma(static_cast<uint8_t>(idx)), 0.5);
+  for (int idx = 1; idx != 256; idx++)
+    ASSERT_LE(PTS::RGBLED::gamma(static_cast<uint8_t>(idx - 1)),
+              PTS::RGBLED::gamma(static_cast<uint8_t>(idx)));
+
+  constexpr PTS::Color color = PTS::Color::fromRgb(0x12AB7F);
+  static_assert(color == PTS::Color{0x12, 0xAB, 0x7F});
+  static_assert(color.rgb() == 0x12AB7F);
+}
+
+TEST(RGBLED, sets_colors)
+{
+  PTS::RGBLED led(25, 26, 27);
+  // Colours set before begin() are shown by it.
+  led.set(PTS::Color::fromRgb(0xFF8000));
+  led.begin();
+  const int8_t channel = led.channel();
+  ASSERT_NE(PTS::LEDC::NO_CHANNEL, channel);
+  ASSERT_EQ(channel, SIM::ledcPins()[25]);
+  ASSERT_EQ(channel + 2, SIM::ledcPins()[27]);
+
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, ledcRead(channel));
+  ASSERT_EQ(PTS::RGBLED::gamma(0x80), ledcRead(channel + 1));
+  ASSERT_EQ(0u, ledcRead(channel + 2));
+
+  led.cyan();
+  ASSERT_TRUE(PTS::COLOR::CYAN == led.color());
+  ASSERT_EQ(0u, ledcRead(channel));
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, ledcRead(channel + 1));
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, ledcRead(channel + 2));
+}
+
+TEST(RGBLED, fades_in_hardware)
+{
+  PTS::RGBLED led(25, 26, 27);
+  led.begin();
+  const int8_t channel = led.channel();
+  led.off();
+
+  led.fade(PTS::COLOR::WHITE, 400);
+  // The colour is the end of the fade at once, the duty gets there alone.
+  ASSERT_TRUE(PTS::COLOR::WHITE == led.color());
+  const uint32_t writes = SIM::ledcWrites(channel);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  const uint32_t duty = ledcRead(channel);
+  ASSERT_GT(duty, PTS::RGBLED::MAX_DUTY / 4);
+  ASSERT_LT(duty, PTS::RGBLED::MAX_DUTY * 3 / 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, ledcRead(channel));
+  ASSERT_EQ(writes, SIM::ledcWrites(channel));
+
+  // A colour set mid-fade stops it.
+  led.fade(PTS::COLOR::OFF, 400);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  led.red();
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  ASSERT_EQ(PTS::RGBLED::MAX_DUTY, ledcRead(channel));
+  ASSERT_EQ(0u, ledcRead(channel + 1));
+}
+
+TEST(RGBLED, falls_back_to_digital)
+{
+  // Every LED takes 3 channels, the sixth finds one.
+  PTS::RGBLED *leds[6];
+  for (uint8_t idx = 0; idx != 6; idx++)
+  {
+    leds[idx] = new PTS::RGBLED(idx * 3, idx * 3 + 1, idx * 3 + 2);
+    leds[idx]->begin();
+  }
+  ASSERT_EQ(PTS::LEDC::NO_CHANNEL, leds[5]->channel());
+  leds[5]->set(PTS::Color::fromRgb(0xC04000));
+  ASSERT_EQ(HIGH, digitalRead(15));
+  ASSERT_EQ(LOW, digitalRead(16));
+  ASSERT_EQ(LOW, digitalRead(17));
+
+  // Deleted LEDs give their channels back.
+  const int8_t channel = leds[0]->channel();
+  for (PTS::RGBLED *led : leds) delete led;
+  ASSERT_EQ(channel, PTS::LEDC::allocate(3));
+  PTS::LEDC::release(channel, 3);
+  ASSERT_EQ(-1, SIM::ledcPins()[0]);
+}
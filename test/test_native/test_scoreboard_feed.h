@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "net/attribute_store.h"
+#include "net/scoreboard_codec.h"
+#include "net/scoreboard_feed.h"
+
+#pragma once
+
+namespace test_scoreboard_feed
+{
+
+using Packets = std::vector<std::vector<uint8_t>>;
+
+/// Collects the encoded datagrams.
+struct Collector
+{
+  void operator()(const uint8_t *packet, size_t length) const
+  {
+    packets->emplace_back(packet, packet + length);
+  }
+
+  Packets *packets;
+};
+
+/// Feeds datagrams to a view.
+template<typename VIEW>
+void receive(VIEW &view, const Packets &packets)
+{
+  for (const auto &packet : packets)
+    ASSERT_TRUE(view.receive(packet.data(), packet.size()));
+}
+
+}
+
+TEST(ScoreboardFeed, codec)
+{
+  using namespace test_scoreboard_feed;
+
+  Packets packets;
+  PTS::ScoreboardEncoder<Collector> encoder(Collector{&packets});
+  PTS::ScoreboardView<8> view;
+
+  encoder.beginFrame(true, 0, 5);
+  encoder.add("score", "42");
+  encoder.add("status", "armed");
+  encoder.endFrame();
+  ASSERT_EQ(1u, packets.size());
+  // Header, then hash, name and value of both.
+  ASSERT_EQ(16u + (4 + 6 + 3) + (4 + 7 + 6), packets[0].size());
+  receive(view, packets);
+  ASSERT_TRUE(view.synced());
+  ASSERT_EQ(5u, view.version());
+  ASSERT_EQ(2u, view.size());
+  ASSERT_STREQ("42", view.value("score"));
+  ASSERT_STREQ("armed", view.value("status"));
+
+  // Deltas only carry the hashes.
+  packets.clear();
+  encoder.beginFrame(false, 5, 7);
+  encoder.add("score", "43");
+  encoder.endFrame();
+  ASSERT_EQ(16u + 4 + 3, packets[0].size());
+  receive(view, packets);
+  ASSERT_EQ(7u, view.version());
+  ASSERT_STREQ("43", view.value("score"));
+
+  // A lost delta: the values still arrive, but the view is behind until the
+  // next keyframe, which also drops the deleted attributes.
+  packets.clear();
+  encoder.beginFrame(false, 7, 8);
+  encoder.add("score", "44");
+  encoder.endFrame();
+  encoder.beginFrame(false, 8, 9);
+  encoder.add("score", "45");
+  encoder.endFrame();
+  ASSERT_TRUE(view.receive(packets[1].data(), packets[1].size()));
+  ASSERT_FALSE(view.synced());
+  ASSERT_EQ(1u, view.lost());
+  ASSERT_STREQ("45", view.value("score"));
+
+  packets.clear();
+  encoder.beginFrame(true, 0, 10);
+  encoder.add("score", "45");
+  encoder.endFrame();
+  receive(view, packets);
+  ASSERT_TRUE(view.synced());
+  ASSERT_EQ(10u, view.version());
+  ASSERT_EQ(1u, view.size());
+  ASSERT_EQ(nullptr, view.value("status"));
+
+  ASSERT_FALSE(view.receive(packets[0].data(), 10));
+  packets[0].push_back(0);
+  ASSERT_FALSE(view.receive(packets[0].data(), packets[0].size()));
+  packets[0][4] = 2;
+  ASSERT_FALSE(view.receive(packets[0].data(), packets[0].size() - 1));
+}
+
+TEST(ScoreboardFeed, splits_frames)
+{
+  using namespace test_scoreboard_feed;
+
+  Packets packets;
+  PTS::ScoreboardEncoder<Collector> encoder(Collector{&packets});
+  PTS::ScoreboardView<64> view;
+
+  // 64 attributes of 4 + 12 + 41 bytes don't fit a datagram.
+  const std::string value(40, 'x');
+  encoder.beginFrame(true, 0, 64);
+  for (int idx = 0; idx != 64; idx++)
+    encoder.add(("attribute_" + std::to_string(idx + 10)).c_str(),
+                value.c_str());
+  encoder.endFrame();
+  ASSERT_EQ(3u, packets.size());
+  for (const auto &packet : packets)
+    ASSERT_LE(packet.size(), PTS::SCOREBOARD::PACKET_SIZE);
+
+  // An incomplete keyframe doesn't bring the view in sync.
+  ASSERT_TRUE(view.receive(packets[0].data(), packets[0].size()));
+  ASSERT_TRUE(view.receive(packets[2].data(), packets[2].size()));
+  ASSERT_FALSE(view.synced());
+
+  packets.clear();
+  encoder.beginFrame(true, 0, 65);
+  for (int idx = 0; idx != 64; idx++)
+    encoder.add(("attribute_" + std::to_string(idx + 10)).c_str(),
+                value.c_str());
+  encoder.endFrame();
+  receive(view, packets);
+  ASSERT_TRUE(view.synced());
+  ASSERT_EQ(64u, view.size());
+  ASSERT_STREQ(value.c_str(), view.value("attribute_73"));
+}
+
+TEST(ScoreboardFeed, broadcast)
+{
+  using namespace test_scoreboard_feed;
+  using Store = PTS::AttributeStore<8>;
+  SIM::serialEnabled() = false;
+
+  Store store;
+  const PTS::AttributeHandle score =
+    store.add("score", PTS::AttributeValue::fromInteger(0), "");
+  store.add("status", "armed", "");
+
+  // Every viewer gets the same datagrams.
+  WiFiUDP viewers[3];
+  PTS::ScoreboardView<8> views[3];
+  for (WiFiUDP &viewer : viewers) ASSERT_TRUE(viewer.begin(42121));
+
+  PTS::ScoreboardFeed<Store, 50> feed(store, IPAddress(255, 255, 255, 255),
+                                      42121);
+  feed.begin();
+  feed.start();
+  store.set(score, PTS::AttributeType::INTEGER, 7);
+
+  bool done = false;
+  for (int round = 0; round != 200 && !done; round++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    done = true;
+    for (size_t idx = 0; idx != 3; idx++)
+    {
+      uint8_t packet[PTS::SCOREBOARD::PACKET_SIZE];
+      for (int length; (length = viewers[idx].parsePacket()) > 0;)
+      {
+        viewers[idx].read(packet, sizeof(packet));
+        views[idx].receive(packet, static_cast<size_t>(length));
+      }
+      const char *value = views[idx].value("score");
+      done = done && views[idx].synced() && value && value[0] == '7';
+    }
+  }
+  ASSERT_TRUE(done);
+  ASSERT_STREQ("armed", views[2].value("status"));
+
+  const PTS::ScoreboardFeedStats stats = feed.stats();
+  ASSERT_GE(stats.keyframes, 1u);
+  ASSERT_GE(stats.packets, stats.frames);
+  feed.destroy();
+  // The deleted thread ends at its next delay.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  SIM::serialEnabled() = true;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include "net/static_assets.h"
+
+#pragma once
+
+namespace test_static_assets
+{
+
+static const uint8_t STYLE[] = {0x1f, 0x8b};
+static const uint8_t SCRIPT[] = {0x1f, 0x8b, 0x08};
+
+static constexpr PTS::StaticAsset ASSETS[] = {
+  {"/static/style.css", PTS::fnv1a("/static/style.css", 17),
+   "text/css", "\"0123\"", "0123", STYLE, sizeof(STYLE)},
+  {"/static/app.js", PTS::fnv1a("/static/app.js", 14),
+   "text/javascript", "\"4567\"", "4567", SCRIPT, sizeof(SCRIPT)},
+};
+
+const PTS::StaticAsset *find(const char *path)
+{
+  return PTS::findAsset(ASSETS, 2, path, PTS::fnv1a(path, std::strlen(path)));
+}
+
+}
+
+TEST(StaticAssets, lookup)
+{
+  const PTS::StaticAsset *script = test_static_assets::find("/static/app.js");
+  ASSERT_NE(nullptr, script);
+  ASSERT_STREQ("text/javascript", script->content_type);
+  ASSERT_EQ(3u, script->length);
+
+  ASSERT_EQ(&test_static_assets::ASSETS[0],
+            test_static_assets::find("/static/style.css"));
+  ASSERT_EQ(nullptr, test_static_assets::find("/static/style.cs"));
+  ASSERT_EQ(nullptr, test_static_assets::find("/static/"));
+  ASSERT_EQ(nullptr, PTS::findAsset(nullptr, 0, "/static/app.js", 0));
+}
+
+TEST(StaticAssets, embedded)
+{
+  // Every embedded asset is gzipped and found by its path.
+  for (size_t idx = 0; idx != PTS::ASSETS::WEB_ASSET_COUNT; idx++)
+  {
+    const PTS::StaticAsset &asset = PTS::ASSETS::WEB_ASSETS[idx];
+    ASSERT_EQ(&asset, PTS::ASSETS::find(asset.path));
+    ASSERT_GE(asset.length, 2u);
+    ASSERT_EQ(0x1f, asset.data[0]);
+    ASSERT_EQ(0x8b, asset.data[1]);
+    ASSERT_EQ(std::string("\"") + asset.version + "\"", asset.etag);
+  }
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "utils/sw/time_series.h"
+
+#pragma once
+
+namespace test_time_series
+{
+
+using Series = PTS::TimeSeries<4, 3, 2>;
+
+std::vector<Series::Bucket> buckets(const Series &series,
+                                    Series::Resolution resolution)
+{
+  std::vector<Series::Bucket> result;
+  series.forEachBucket(resolution, [&result](const Series::Bucket &bucket)
+  { result.push_back(bucket); });
+  return result;
+}
+
+} // namespace test_time_series
+
+TEST(TimeSeries, raw_ring_overwrites_oldest)
+{
+  using namespace test_time_series;
+  Series series;
+  ASSERT_EQ(0u, series.size(Series::RAW));
+
+  for (uint32_t idx = 0; idx != 6; idx++)
+    series.add(idx * 100, static_cast<float>(idx));
+
+  ASSERT_EQ(4u, series.size(Series::RAW));
+  std::vector<float> values;
+  series.forEachSample([&values](const Series::Sample &sample)
+  { values.push_back(sample.value); });
+  ASSERT_EQ((std::vector<float>{2, 3, 4, 5}), values);
+
+  // Out of order samples are recorded at the time of the previous one.
+  series.add(10, 6);
+  ASSERT_EQ(500u, buckets(series, Series::RAW).back().time_ms);
+}
+
+TEST(TimeSeries, downsamples)
+{
+  using namespace test_time_series;
+  Series series;
+  series.add(100, 1);
+  series.add(900, 3);
+  series.add(1500, 10);
+  series.add(12000, -2);
+
+  const auto seconds = buckets(series, Series::SECOND);
+  ASSERT_EQ(3u, seconds.size());
+  ASSERT_EQ(0u, seconds[0].time_ms);
+  ASSERT_FLOAT_EQ(1, seconds[0].min);
+  ASSERT_FLOAT_EQ(3, seconds[0].max);
+  ASSERT_FLOAT_EQ(2, seconds[0].mean);
+  ASSERT_EQ(1000u, seconds[1].time_ms);
+  // The unfinished second comes last.
+  ASSERT_EQ(12000u, seconds[2].time_ms);
+  ASSERT_FLOAT_EQ(-2, seconds[2].mean);
+
+  const auto ten_seconds = buckets(series, Series::TEN_SECONDS);
+  ASSERT_EQ(2u, ten_seconds.size());
+  ASSERT_EQ(0u, ten_seconds[0].time_ms);
+  ASSERT_FLOAT_EQ(1, ten_seconds[0].min);
+  ASSERT_FLOAT_EQ(10, ten_seconds[0].max);
+  ASSERT_FLOAT_EQ(14.0f / 3, ten_seconds[0].mean);
+  ASSERT_EQ(10000u, ten_seconds[1].time_ms);
+  ASSERT_FLOAT_EQ(-2, ten_seconds[1].max);
+}
+
+TEST(TimeSeries, bucket_rings_are_bounded)
+{
+  using namespace test_time_series;
+  Series series;
+  for (uint32_t second = 0; second != 100; second++)
+    series.add(second * 1000, static_cast<float>(second));
+
+  // The kept buckets and the unfinished one.
+  ASSERT_EQ(4u, series.size(Series::SECOND));
+  ASSERT_EQ(3u, series.size(Series::TEN_SECONDS));
+  const auto ten_seconds = buckets(series, Series::TEN_SECONDS);
+  ASSERT_EQ(70000u, ten_seconds[0].time_ms);
+  ASSERT_EQ(90000u, ten_seconds[2].time_ms);
+  ASSERT_FLOAT_EQ(94.5f, ten_seconds[2].mean);
+
+  series.clear();
+  ASSERT_EQ(0u, series.size(Series::RAW));
+  ASSERT_EQ(0u, series.size(Series::TEN_SECONDS));
+}
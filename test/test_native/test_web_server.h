@@ -0,0 +1,638 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "net/web_server.h"
+
+#pragma once
+
+namespace test_web_server
+{
+
+const PTS::WebServer &server() { return PTS::WebServer::instance(); }
+
+/// Runs the WebServer task like the Module does, while it lives.
+class Runner
+{
+ public:
+  explicit Runner() : m_stop(false)
+  {
+    SIM::serialEnabled() = false;
+    server().begin();
+    m_thread = std::thread([this]
+    {
+      TickType_t last_tick = xTaskGetTickCount();
+      while (!m_stop)
+      {
+        server().threadFunc();
+        xTaskDelayUntil(&last_tick, configTICK_RATE_HZ / 10);
+      }
+    });
+  }
+
+  ~Runner()
+  {
+    m_stop = true;
+    m_thread.join();
+    SIM::serialEnabled() = true;
+  }
+
+ private:
+  std::atomic<bool> m_stop;
+  std::thread m_thread;
+};
+
+/// A received response, with its body de-chunked.
+struct Response
+{
+  int status = 0;
+  std::string head;
+  std::string body;
+
+  /// \return true, if the head has the header line ("Name: value").
+  [[nodiscard]] bool has(const std::string &line) const
+  {
+    return head.find("\r\n" + line + "\r\n") != std::string::npos;
+  }
+
+  /// \return the value of a header, empty if there is none.
+  [[nodiscard]] std::string header(const std::string &name) const
+  {
+    const size_t start = head.find("\r\n" + name + ": ");
+    if (start == std::string::npos) return "";
+    const size_t value = start + name.size() + 4;
+    return head.substr(value, head.find("\r\n", value) - value);
+  }
+};
+
+/// \return a GET request of HTTP/1.1, with extra header lines.
+std::string get(const std::string &target, const std::string &headers = "")
+{
+  return "GET " + target + " HTTP/1.1\r\nHost: 192.168.4.1\r\n" + headers +
+         "\r\n";
+}
+
+/// A connection to the server over the loopback.
+class Client
+{
+ public:
+  /// \param receive_buffer the size of the socket's receive buffer, 0 for
+  /// the default one.
+  explicit Client(int receive_buffer = 0) : m_fd(-1), m_received()
+  {
+    m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int flag = 1;
+    ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    if (receive_buffer != 0)
+      ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer,
+                   sizeof(receive_buffer));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(80 + SIM::portOffset());
+    ::connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  }
+
+  ~Client() { ::close(m_fd); }
+
+  bool send(const std::string &data)
+  {
+    return ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(data.size());
+  }
+
+  Response request(const std::string &data)
+  {
+    return send(data) ? read() : Response();
+  }
+
+  /// Reads the next response, waiting at most timeout_ms for every part.
+  Response read(int timeout_ms = 6000)
+  {
+    Response response;
+    size_t head_end;
+    while ((head_end = m_received.find("\r\n\r\n")) == std::string::npos)
+      if (!receive(timeout_ms)) return response;
+    response.head = m_received.substr(0, head_end + 2);
+    m_received.erase(0, head_end + 4);
+    response.status = std::atoi(response.head.c_str() + 9);
+    if (response.status == 304) return response;
+
+    if (response.has("Transfer-Encoding: chunked"))
+    {
+      for (;;)
+      {
+        size_t line_end;
+        while ((line_end = m_received.find("\r\n")) == std::string::npos)
+          if (!receive(timeout_ms)) return Response();
+        const size_t size = std::strtoul(m_received.c_str(), nullptr, 16);
+        while (m_received.size() < line_end + 2 + size + 2)
+          if (!receive(timeout_ms)) return Response();
+        response.body += m_received.substr(line_end + 2, size);
+        m_received.erase(0, line_end + 2 + size + 2);
+        if (size == 0) return response;
+      }
+    }
+
+    const std::string length = response.header("Content-Length");
+    const size_t size = std::strtoul(length.c_str(), nullptr, 10);
+    while (m_received.size() < size)
+      if (!receive(timeout_ms)) return Response();
+    response.body = m_received.substr(0, size);
+    m_received.erase(0, size);
+    return response;
+  }
+
+  /// Reads the stream up to and including a text.
+  /// \return what was read, empty if the text didn't arrive in time.
+  std::string readUntil(const std::string &text, int timeout_ms = 3000)
+  {
+    size_t found;
+    while ((found = m_received.find(text)) == std::string::npos)
+      if (!receive(timeout_ms)) return "";
+    const std::string read = m_received.substr(0, found + text.size());
+    m_received.erase(0, found + text.size());
+    return read;
+  }
+
+  /// \return true, if the server closes the connection within the time
+  /// (what it sends before is read and dropped).
+  bool closed(int timeout_ms)
+  {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(timeout_ms);
+    for (;;)
+    {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+      pollfd readable{m_fd, POLLIN, 0};
+      if (::poll(&readable, 1, left > 0 ? static_cast<int>(left) : 0) <= 0)
+        return false;
+
+      char buffer[4096];
+      if (::recv(m_fd, buffer, sizeof(buffer), 0) <= 0) return true;
+    }
+  }
+
+ private:
+  /// Receives what arrives within the time.
+  /// \return false, if nothing did (or the connection was closed).
+  bool receive(int timeout_ms)
+  {
+    pollfd readable{m_fd, POLLIN, 0};
+    if (::poll(&readable, 1, timeout_ms) <= 0) return false;
+
+    char buffer[4096];
+    const ssize_t length = ::recv(m_fd, buffer, sizeof(buffer), 0);
+    if (length <= 0) return false;
+    m_received.append(buffer, static_cast<size_t>(length));
+    return true;
+  }
+
+  int m_fd;
+  /// The bytes received but not read yet.
+  std::string m_received;
+};
+
+/// \return the number of times a text occurs in another.
+size_t countOf(const std::string &text, const std::string &part)
+{
+  size_t count = 0;
+  for (size_t found = text.find(part); found != std::string::npos;
+       found = text.find(part, found + part.size()))
+    count++;
+  return count;
+}
+
+/// \return the quoted global attribute version, as the ETag of the
+/// attributes.
+std::string versionTag()
+{
+  return "\"" + std::to_string(server().attributesVersion()) + "\"";
+}
+
+}
+
+TEST(WebServer, attributes_since_and_not_modified)
+{
+  using namespace test_web_server;
+  const Runner runner;
+  const PTS::AttributeHandle score = server().registerAttribute(
+    "ws_score", PTS::AttributeValue::fromInteger(1), "The score");
+  ASSERT_TRUE(score);
+  ASSERT_TRUE(server().registerAttribute("ws_status", "armed", "The status"));
+  Client client;
+
+  const std::string version = std::to_string(server().attributesVersion());
+  const Response full = client.request(get("/api/attributes"));
+  ASSERT_EQ(200, full.status);
+  ASSERT_EQ("HTTP/1.1 200 OK", full.head.substr(0, full.head.find("\r\n")));
+  ASSERT_TRUE(full.has("Content-Type: application/json"));
+  ASSERT_TRUE(full.has("Cache-Control: no-cache"));
+  ASSERT_EQ(versionTag(), full.header("ETag"));
+  ASSERT_EQ(0u, full.body.find("{\"version\":" + version + ",\"full\":true,"));
+  ASSERT_NE(std::string::npos, full.body.find(
+    "\"ws_score\":{\"value\":\"1\",\"description\":\"The score\""));
+  ASSERT_NE(std::string::npos, full.body.find("\"ws_status\""));
+
+  // Unchanged attributes are not sent again, by ETag or by version.
+  const Response by_tag = client.request(
+    get("/api/attributes", "If-None-Match: " + versionTag() + "\r\n"));
+  ASSERT_EQ(304, by_tag.status);
+  ASSERT_EQ(versionTag(), by_tag.header("ETag"));
+  ASSERT_TRUE(by_tag.has("Content-Length: 0"));
+  ASSERT_TRUE(by_tag.body.empty());
+  ASSERT_EQ(304, client.request(get("/api/attributes?since=" + version))
+                   .status);
+
+  // A delta has only the attributes changed since.
+  server().updateInteger(score, 2);
+  const std::string changed = std::to_string(server().attributesVersion());
+  const Response delta =
+    client.request(get("/api/attributes?since=" + version));
+  ASSERT_EQ(200, delta.status);
+  ASSERT_EQ(versionTag(), delta.header("ETag"));
+  ASSERT_EQ("{\"version\":" + changed + ",\"full\":false,\"attributes\":{"
+            "\"ws_score\":{\"value\":\"2\",\"description\":\"The score\","
+            "\"version\":" + changed + "}}}", delta.body);
+
+  // A delta from before a deletion can't tell what is gone, it is full.
+  ASSERT_TRUE(server().deleteAttribute("ws_status"));
+  const Response after_deletion =
+    client.request(get("/api/attributes?since=" + changed));
+  ASSERT_EQ(200, after_deletion.status);
+  ASSERT_NE(std::string::npos, after_deletion.body.find("\"full\":true"));
+  ASSERT_EQ(std::string::npos, after_deletion.body.find("ws_status"));
+  ASSERT_TRUE(server().deleteAttribute("ws_score"));
+}
+
+TEST(WebServer, event_frames_and_reset)
+{
+  using namespace test_web_server;
+  const Runner runner;
+  const PTS::AttributeHandle count = server().registerAttribute(
+    "ws_count", PTS::AttributeValue::fromInteger(0), "");
+  ASSERT_TRUE(count);
+
+  // A client resuming at the current version gets the changes only.
+  Client resumed;
+  ASSERT_TRUE(resumed.send(get("/api/events", "Last-Event-ID: " +
+    std::to_string(server().attributesVersion()) + "\r\n")));
+  const std::string head = resumed.readUntil("retry: 2000\n\n");
+  ASSERT_EQ(0u, head.find("HTTP/1.1 200 OK\r\n"));
+  ASSERT_NE(std::string::npos, head.find("Content-Type: text/event-stream"));
+  ASSERT_NE(std::string::npos, head.find("Connection: close"));
+
+  server().updateInteger(count, 7);
+  const std::string version = std::to_string(server().attributesVersion());
+  ASSERT_EQ("id: " + version + "\ndata: {\"version\":" + version +
+            ",\"full\":false,\"attributes\":{\"ws_count\":{\"value\":\"7\","
+            "\"version\":" + version + "}}}\n\n",
+            resumed.readUntil("\n\n"));
+
+  // Attributes too many for a frame make the client fetch them instead.
+  const std::string long_value(47, 'v');
+  const std::string long_description(63, 'd');
+  for (int idx = 0; idx != 16; idx++)
+    ASSERT_TRUE(server().registerAttribute("ws_long_" + std::to_string(idx),
+                                           long_value, long_description));
+  const std::string reset_version =
+    std::to_string(server().attributesVersion());
+  Client fresh;
+  ASSERT_TRUE(fresh.send(get("/api/events")));
+  ASSERT_NE("", fresh.readUntil("retry: 2000\n\n"));
+  ASSERT_EQ("id: " + reset_version + "\nevent: reset\ndata: {}\n\n",
+            fresh.readUntil("\n\n"));
+
+  // Subscribers beyond the limit are refused, and their connections closed.
+  Client more[2];
+  for (Client &subscriber : more)
+  {
+    ASSERT_TRUE(subscriber.send(get("/api/events")));
+    ASSERT_NE("", subscriber.readUntil("retry: 2000\n\n"));
+  }
+  Client refused;
+  const Response unavailable = refused.request(get("/api/events"));
+  ASSERT_EQ(503, unavailable.status);
+  ASSERT_EQ("10", unavailable.header("Retry-After"));
+  ASSERT_TRUE(unavailable.has("Connection: close"));
+  ASSERT_TRUE(refused.closed(1000));
+
+  for (int idx = 0; idx != 16; idx++)
+    ASSERT_TRUE(server().deleteAttribute("ws_long_" + std::to_string(idx)));
+  ASSERT_TRUE(server().deleteAttribute("ws_count"));
+}
+
+TEST(WebServer, keep_alive_and_timeouts)
+{
+  using namespace test_web_server;
+  const Runner runner;
+
+  // Requests of HTTP/1.1 keep the connection, pipelined ones too.
+  Client client;
+  const Response first = client.request(get("/api/attributes"));
+  ASSERT_EQ(200, first.status);
+  ASSERT_FALSE(first.has("Connection: close"));
+  ASSERT_TRUE(client.send(get("/api/attributes") + get("/nowhere")));
+  ASSERT_EQ(200, client.read().status);
+  const Response missing = client.read();
+  ASSERT_EQ(404, missing.status);
+  ASSERT_EQ("HTTP/1.1 404 Not Found",
+            missing.head.substr(0, missing.head.find("\r\n")));
+  ASSERT_EQ(405, client.request("POST / HTTP/1.1\r\n"
+                                "Content-Length: 0\r\n\r\n").status);
+  ASSERT_FALSE(client.closed(100));
+
+  // HTTP/1.0, a "Connection: close" and a bad request end the connection.
+  Client old;
+  const Response closing = old.request("GET /api/attributes HTTP/1.0\r\n\r\n");
+  ASSERT_EQ(200, closing.status);
+  ASSERT_TRUE(closing.has("Connection: close"));
+  ASSERT_TRUE(old.closed(1000));
+  Client asked;
+  ASSERT_EQ(200, asked.request(get("/api/attributes",
+                                   "Connection: close\r\n")).status);
+  ASSERT_TRUE(asked.closed(1000));
+  Client bad;
+  const Response rejected = bad.request("GET nowhere HTTP/1.1\r\n\r\n");
+  ASSERT_EQ(400, rejected.status);
+  ASSERT_TRUE(rejected.has("Connection: close"));
+  ASSERT_TRUE(bad.closed(1000));
+
+  // A started request times out after 3 s, an idle connection after 5 s.
+  Client partial;
+  Client idle;
+  ASSERT_TRUE(partial.send("GET /api/attri"));
+  ASSERT_EQ(200, idle.request(get("/api/attributes")).status);
+  const Response timeout = partial.read();
+  ASSERT_EQ(408, timeout.status);
+  ASSERT_TRUE(timeout.has("Connection: close"));
+  ASSERT_TRUE(partial.closed(1000));
+  ASSERT_FALSE(idle.closed(500));
+  ASSERT_TRUE(idle.closed(3000));
+}
+TEST(WebServer, assets_not_modified_and_not_acceptable)
+{
+  using namespace test_web_server;
+  const Runner runner;
+  Client client;
+
+  ASSERT_EQ(404, client.request(get("/static/missing.css",
+                                    "Accept-Encoding: gzip\r\n")).status);
+  for (size_t idx = 0; idx != PTS::ASSETS::WEB_ASSET_COUNT; idx++)
+  {
+    const PTS::StaticAsset &asset = PTS::ASSETS::WEB_ASSETS[idx];
+    const Response sent = client.request(
+      get(asset.path, "Accept-Encoding: gzip, deflate, br\r\n"));
+    ASSERT_EQ(200, sent.status);
+    ASSERT_EQ(asset.content_type, sent.header("Content-Type"));
+    ASSERT_TRUE(sent.has("Content-Encoding: gzip"));
+    ASSERT_EQ(asset.etag, sent.header("ETag"));
+    ASSERT_TRUE(sent.has("Cache-Control: public, max-age=31536000, "
+                         "immutable"));
+    ASSERT_EQ(std::string(reinterpret_cast<const char*>(asset.data),
+                          asset.length), sent.body);
+
+    const Response cached = client.request(
+      get(asset.path, std::string("If-None-Match: ") + asset.etag + "\r\n"));
+    ASSERT_EQ(304, cached.status);
+    ASSERT_EQ(asset.etag, cached.header("ETag"));
+    ASSERT_TRUE(cached.body.empty());
+
+    // The assets are only stored gzipped.
+    ASSERT_EQ(406, client.request(get(asset.path)).status);
+    ASSERT_EQ(406, client.request(get(asset.path, "Accept-Encoding: br\r\n"))
+                     .status);
+  }
+
+  // Pipelined to a slow reader, the assets are sent from flash as the
+  // socket takes them.
+  Client slow(1024);
+  std::string requests;
+  for (size_t idx = 0; idx != PTS::ASSETS::WEB_ASSET_COUNT; idx++)
+    requests += get(PTS::ASSETS::WEB_ASSETS[idx].path,
+                    "Accept-Encoding: gzip\r\n");
+  ASSERT_TRUE(slow.send(requests));
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  for (size_t idx = 0; idx != PTS::ASSETS::WEB_ASSET_COUNT; idx++)
+  {
+    const PTS::StaticAsset &asset = PTS::ASSETS::WEB_ASSETS[idx];
+    ASSERT_EQ(std::string(reinterpret_cast<const char*>(asset.data),
+                          asset.length), slow.read().body);
+  }
+}
+
+TEST(WebServer, history_csv_and_binary)
+{
+  using namespace test_web_server;
+  const Runner runner;
+  const PTS::AttributeHandle level = server().registerAttribute(
+    "ws_level", PTS::AttributeValue::fromInteger(0), "");
+  ASSERT_TRUE(server().enableHistory(level));
+  for (int32_t value = 10; value <= 30; value += 10)
+    ASSERT_TRUE(server().updateInteger(level, value));
+  Client client;
+
+  const Response csv =
+    client.request(get("/api/history?name=ws_level&resolution=raw"));
+  ASSERT_EQ(200, csv.status);
+  ASSERT_TRUE(csv.has("Content-Type: text/csv; charset=utf-8"));
+  ASSERT_TRUE(csv.has("Cache-Control: no-store"));
+  ASSERT_EQ(0u, csv.body.find("time_ms,value\n"));
+  size_t lines = 0;
+  for (size_t end = csv.body.find('\n'); end != std::string::npos;
+       end = csv.body.find('\n', end + 1))
+    lines++;
+  ASSERT_EQ(4u, lines);
+  ASSERT_NE(std::string::npos, csv.body.find(",10\n"));
+  ASSERT_EQ(csv.body.size() - 4, csv.body.rfind(",30\n"));
+
+  const Response buckets = client.request(get("/api/history?name=ws_level"));
+  ASSERT_EQ(200, buckets.status);
+  ASSERT_EQ(0u, buckets.body.find("time_ms,min,max,mean\n"));
+
+  // A 12 byte header, then a time and a float for every sample.
+  const Response binary = client.request(
+    get("/api/history?name=ws_level&resolution=raw&format=binary"));
+  ASSERT_EQ(200, binary.status);
+  ASSERT_TRUE(binary.has("Content-Type: application/octet-stream"));
+  ASSERT_EQ(12u + 3 * 8, binary.body.size());
+  const uint8_t *data = reinterpret_cast<const uint8_t*>(binary.body.data());
+  ASSERT_EQ(0, std::memcmp(data, "PTSH", 4));
+  ASSERT_EQ(1, data[4]);
+  ASSERT_EQ(0, data[5]);
+  ASSERT_EQ(8, data[6]);
+  ASSERT_EQ(3u, data[8] | data[9] << 8 | data[10] << 16 | data[11] << 24);
+  float last;
+  std::memcpy(&last, data + 12 + 2 * 8 + 4, sizeof(last));
+  ASSERT_EQ(30.0f, last);
+
+  ASSERT_EQ(404, client.request(get("/api/history?name=ws_none")).status);
+  ASSERT_EQ(400, client.request(
+    get("/api/history?name=ws_level&resolution=5s")).status);
+  ASSERT_EQ(400, client.request(
+    get("/api/history?name=ws_level&format=xml")).status);
+  ASSERT_TRUE(server().deleteAttribute("ws_level"));
+}
+
+TEST(WebServer, command_results)
+{
+  using namespace test_web_server;
+  const Runner runner;
+  server().onModuleCommand([](const char *module, PTS::ModuleCommand)
+  {
+    return std::strcmp(module, "ws_wires") == 0
+      ? PTS::CommandResult::QUEUED : PTS::CommandResult::UNKNOWN_MODULE;
+  });
+  ASSERT_TRUE(server().registerAttribute("ws_state", "idle", "", true));
+  ASSERT_TRUE(server().registerAttribute(
+    "ws_points", PTS::AttributeValue::fromInteger(0), "", true));
+  // Fed by the board, so not remote.
+  ASSERT_TRUE(server().registerAttribute("ws_fed", "1", ""));
+  Client client;
+
+  const std::string batch =
+    "[{\"op\": \"reset\", \"module\": \"ws_wires\"},"
+    " {\"op\": \"start\", \"module\": \"ws_clock\"},"
+    " {\"op\": \"set\", \"attribute\": \"ws_state\", \"value\": \"armed\"},"
+    " {\"op\": \"set\", \"attribute\": \"ws_points\", \"value\": 5},"
+    " {\"op\": \"set\", \"attribute\": \"ws_points\", \"value\": \"five\"},"
+    " {\"op\": \"set\", \"attribute\": \"ws_fed\", \"value\": \"2\"},"
+    " {\"op\": \"set\", \"attribute\": \"ws_none\", \"value\": 1}]";
+  const Response results = client.request(
+    "POST /api/commands HTTP/1.1\r\nContent-Type: application/json\r\n"
+    "Content-Length: " + std::to_string(batch.size()) + "\r\n\r\n" + batch);
+  ASSERT_EQ(200, results.status);
+  ASSERT_TRUE(results.has("Cache-Control: no-store"));
+  ASSERT_EQ("{\"results\":["
+            "{\"op\":\"reset\",\"module\":\"ws_wires\",\"result\":\"queued\"},"
+            "{\"op\":\"start\",\"module\":\"ws_clock\","
+            "\"result\":\"unknown module\"},"
+            "{\"op\":\"set\",\"attribute\":\"ws_state\","
+            "\"result\":\"applied\"},"
+            "{\"op\":\"set\",\"attribute\":\"ws_points\","
+            "\"result\":\"applied\"},"
+            "{\"op\":\"set\",\"attribute\":\"ws_points\","
+            "\"result\":\"wrong type\"},"
+            "{\"op\":\"set\",\"attribute\":\"ws_fed\","
+            "\"result\":\"read-only\"},"
+            "{\"op\":\"set\",\"attribute\":\"ws_none\","
+            "\"result\":\"unknown attribute\"}]}", results.body);
+  ASSERT_EQ("armed", server().readAttribute("ws_state").value());
+  ASSERT_EQ("5", server().readAttribute("ws_points").value());
+  ASSERT_EQ("1", server().readAttribute("ws_fed").value());
+
+  // Nothing of a malformed batch is run.
+  const std::string broken =
+    "[{\"op\": \"set\", \"attribute\": \"ws_state\", \"value\": \"x\"},";
+  const Response rejected = client.request(
+    "POST /api/commands HTTP/1.1\r\n"
+    "Content-Length: " + std::to_string(broken.size()) + "\r\n\r\n" + broken);
+  ASSERT_EQ(400, rejected.status);
+  ASSERT_EQ(0u, rejected.body.find("{\"error\":"));
+  ASSERT_EQ("armed", server().readAttribute("ws_state").value());
+
+  server().onModuleCommand(nullptr);
+  ASSERT_TRUE(server().deleteAttribute("ws_state"));
+  ASSERT_TRUE(server().deleteAttribute("ws_points"));
+  ASSERT_TRUE(server().deleteAttribute("ws_fed"));
+}
+
+TEST(WebServer, large_bodies_follow_the_socket)
+{
+  using namespace test_web_server;
+  const Runner runner;
+
+  // Attributes escaping to about 1 kB each, 20 kB and more in total.
+  size_t count = 0;
+  for (; count != WEB_MAX_ATTRIBUTES; count++)
+  {
+    std::string name = "ws_big_" + std::to_string(count);
+    name.resize(31, '"');
+    if (!server().registerAttribute(name, std::string(47, '<'),
+                                    std::string(63, '&')))
+      break;
+  }
+  ASSERT_GE(count, 24u);
+
+  // A reader slower than the server gets every body complete, the
+  // pipelined requests are answered in order.
+  Client slow(1024);
+  ASSERT_TRUE(slow.send(get("/") + get("/api/attributes") + get("/log")));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  const Response page = slow.read();
+  ASSERT_EQ(200, page.status);
+  ASSERT_GT(page.body.size(), 20000u);
+  ASSERT_EQ(count, countOf(page.body, "<tr data-name=\"ws_big_"));
+  ASSERT_EQ("</html>\n", page.body.substr(page.body.size() - 8));
+  const Response json = slow.read();
+  ASSERT_EQ(200, json.status);
+  ASSERT_EQ(count, countOf(json.body, "\"ws_big_"));
+  ASSERT_EQ("}}", json.body.substr(json.body.size() - 2));
+  ASSERT_EQ(200, slow.read().status);
+  ASSERT_FALSE(slow.closed(100));
+
+  for (size_t idx = 0; idx != count; idx++)
+  {
+    std::string name = "ws_big_" + std::to_string(idx);
+    name.resize(31, '"');
+    ASSERT_TRUE(server().deleteAttribute(name));
+  }
+}
+
+TEST(WebServer, stalled_client_is_dropped)
+{
+  using namespace test_web_server;
+  const Runner runner;
+
+  // A client asking for many pages without reading them, through a small
+  // receive window.
+  Client stalled(1024);
+  std::string pages;
+  for (int idx = 0; idx != 64; idx++) pages += get("/");
+  ASSERT_TRUE(stalled.send(pages));
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // The others are served meanwhile.
+  Client other;
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(200, other.request(get("/api/attributes")).status);
+  ASSERT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(500));
+
+  // The stalled one is closed once its backlog overflows or times out.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+  ASSERT_TRUE(stalled.closed(1000));
+  ASSERT_EQ(200, other.request(get("/api/attributes")).status);
+}
+
+TEST(WebServer, log_streams_are_limited)
+{
+  using namespace test_web_server;
+  const Runner runner;
+
+  Client streams[4];
+  for (Client &stream : streams)
+  {
+    ASSERT_TRUE(stream.send(get("/log/stream")));
+    ASSERT_EQ(0u, stream.readUntil("\r\n\r\n").find("HTTP/1.1 200 OK\r\n"));
+  }
+
+  // One stream too many is refused, and its connection closed.
+  Client refused;
+  const Response unavailable = refused.request(get("/log/stream"));
+  ASSERT_EQ(503, unavailable.status);
+  ASSERT_EQ("10", unavailable.header("Retry-After"));
+  ASSERT_TRUE(unavailable.has("Connection: close"));
+  ASSERT_TRUE(unavailable.has("Content-Length: 0"));
+  ASSERT_TRUE(refused.closed(1000));
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include <SPI.h>
+#include <soc/soc.h>
+#include "modules/basic_wire_disconnect.h"
+#include "utils/hw/io_expander.h"
+
+#pragma once
+
+namespace test_wire_disconnect
+{
+
+/// The wires read disconnected, a bit per wire.
+using Mask = PTS::WireDisconnect<>::Mask;
+
+/// Runs the ticks cutting a wire: the first reads it disconnected, the
+/// second confirms it.
+template<typename MODULE>
+void cut(const MODULE &module, Mask &low, size_t wire)
+{
+  low |= Mask(1) << wire;
+  module.evaluate(low);
+  module.evaluate(low);
+}
+
+}
+
+TEST(WireDisconnect, cuts_in_the_order_passed)
+{
+  const PTS::RGBLED led(12, 13, 14);
+  const PTS::WireDisconnect<> module("wires", {16, 17, 18}, led);
+  for (uint8_t pin : {16, 17, 18}) digitalWrite(pin, HIGH);
+  module.begin();
+  ASSERT_EQ(PTS::Stateful::ACTIVE, module.getState());
+  ASSERT_EQ(PTS::COLOR::BLUE, led.color());
+
+  // A tick reads every wire with the two input registers.
+  const uint32_t reads = SIM::registerReads();
+  module.threadFunc();
+  ASSERT_EQ(reads + 2, SIM::registerReads());
+
+  // A bounce isn't a cut.
+  digitalWrite(16, LOW);
+  module.threadFunc();
+  digitalWrite(16, HIGH);
+  module.threadFunc();
+  ASSERT_EQ(0u, module.cut());
+
+  for (uint8_t pin : {16, 17, 18})
+  {
+    digitalWrite(pin, LOW);
+    module.threadFunc();
+    module.threadFunc();
+  }
+  ASSERT_EQ(0b111u, module.cut());
+  ASSERT_EQ(PTS::Stateful::PASSED, module.getState());
+  ASSERT_EQ(PTS::COLOR::GREEN, led.color());
+
+  // Re-armed with the wires reconnected.
+  for (uint8_t pin : {16, 17, 18}) digitalWrite(pin, HIGH);
+  module.reset();
+  ASSERT_EQ(PTS::Stateful::ACTIVE, module.getState());
+  ASSERT_EQ(0u, module.cut());
+  module.threadFunc();
+  digitalWrite(17, LOW);
+  module.threadFunc();
+  module.threadFunc();
+  ASSERT_EQ(PTS::Stateful::FAILED, module.getState());
+  ASSERT_EQ(PTS::COLOR::RED, led.color());
+}
+
+TEST(WireDisconnect, follows_the_rules)
+{
+  using test_wire_disconnect::cut;
+  using test_wire_disconnect::Mask;
+  // Wire 0 first, then 1 and 2 in any order; 3 anytime, 4 never.
+  const uint8_t pins[] = {16, 17, 18, 19, 21};
+  const uint8_t steps[] = {1, 2, 2, 0, 0};
+  const PTS::RGBLED led(12, 13, 14);
+  const auto build = [&](const char *name)
+  {
+    auto module = std::make_unique<PTS::WireDisconnect<5>>(
+      name, pins, 5, steps, Mask(1) << 4, led);
+    module->begin();
+    module->evaluate(0);
+    return module;
+  };
+
+  auto module = build("in_order");
+  Mask low = 0;
+  cut(*module, low, 3);
+  cut(*module, low, 0);
+  cut(*module, low, 2);
+  ASSERT_EQ(PTS::Stateful::ACTIVE, module->getState());
+  cut(*module, low, 1);
+  ASSERT_EQ(PTS::Stateful::PASSED, module->getState());
+
+  module = build("too_early");
+  low = 0;
+  cut(*module, low, 2);
+  ASSERT_EQ(PTS::Stateful::FAILED, module->getState());
+
+  module = build("forbidden");
+  low = 0;
+  cut(*module, low, 0);
+  cut(*module, low, 4);
+  ASSERT_EQ(PTS::Stateful::FAILED, module->getState());
+
+  // Without steps, the wires but the forbidden ones are cut in order.
+  module = std::make_unique<PTS::WireDisconnect<5>>("in_passed_order", pins,
+                                                    3, nullptr, 0b010, led);
+  module->begin();
+  module->evaluate(0);
+  low = 0;
+  cut(*module, low, 0);
+  cut(*module, low, 2);
+  ASSERT_EQ(PTS::Stateful::PASSED, module->getState());
+
+  // Wires disconnected from the start never count.
+  module = std::make_unique<PTS::WireDisconnect<5>>("unplugged", pins, 5,
+                                                    steps, 0, led);
+  module->begin();
+  low = 0b10;
+  module->evaluate(low);
+  cut(*module, low, 0);
+  ASSERT_EQ(0b01u, module->cut());
+  ASSERT_EQ(PTS::Stateful::ACTIVE, module->getState());
+}
+
+TEST(WireDisconnect, scales_on_expanders)
+{
+  // 40 wires on five 74HC165s, scanned in a single transfer.
+  SIM::ShiftRegisterChain chips(5, 0);
+  SPIClass spi;
+  spi.sim_device = &chips;
+  const PTS::ShiftRegisterChain<5, 0> chain(spi, 25, 26);
+  for (size_t reg = 0; reg != 5; reg++) chips.setInput(reg, 0xFF);
+  chain.begin();
+
+  std::vector<PTS::IoPin> wires;
+  for (uint8_t line = 0; line != 40; line++) wires.emplace_back(chain, line);
+  // Every other wire is to be cut, in order, the rest are forbidden.
+  uint8_t steps[40] = {};
+  uint64_t forbidden = 0;
+  for (uint8_t wire = 0; wire != 40; wire++)
+  {
+    if (wire % 2 == 0) steps[wire] = static_cast<uint8_t>(wire / 2 + 1);
+    else forbidden |= uint64_t(1) << wire;
+  }
+  const PTS::RGBLED led(12, 13, 14);
+  const PTS::WireDisconnect<64> module("wires", wires.data(), wires.size(),
+                                       steps, forbidden, led);
+  module.begin();
+  chain.scan();
+  module.threadFunc();
+
+  uint8_t inputs[5] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  for (uint8_t wire = 0; wire != 40; wire += 2)
+  {
+    inputs[wire / 8] &= static_cast<uint8_t>(~(1u << (wire % 8)));
+    chips.setInput(wire / 8, inputs[wire / 8]);
+    chain.scan();
+    module.threadFunc();
+    module.threadFunc();
+  }
+  ASSERT_EQ(0x5555555555u, module.cut());
+  ASSERT_EQ(PTS::Stateful::PASSED, module.getState());
+}
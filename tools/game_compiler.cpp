@@ -0,0 +1,147 @@
+//===-- tools/game_compiler.cpp - Game compiler host tool -----------------===//
+//
+// Project-Thunderstrike (PTS) collection source file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the game compiler, a host tool validating a game
+/// setup file (see modules/game_config.h) and compiling it into the binary
+/// image the firmware boots from without parsing (see modules/game_image.h).
+///
+/// It uses the parser and the checks of the firmware, so whatever it accepts
+/// the board builds. Build and run it from the project directory:
+///
+///   c++ -std=gnu++17 -O2 -Isrc tools/game_compiler.cpp -o game_compiler
+///   ./game_compiler data/game.json game.bin
+///
+/// then write the image into the "game" partition (see partitions.csv):
+///
+///   esptool.py write_flash 0x3e0000 game.bin
+///
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "modules/game_config.h"
+#include "modules/game_image.h"
+
+namespace
+{
+
+/// The names of the module types, for the summary.
+const char *typeName(PTS::ModuleType type)
+{
+  switch (type)
+  {
+    case PTS::ModuleType::KEYPAD: return "keypad";
+    case PTS::ModuleType::WIRE_DISCONNECT: return "wire_disconnect";
+    case PTS::ModuleType::BLINKER: return "blinker";
+    case PTS::ModuleType::BUZZER: return "buzzer";
+    case PTS::ModuleType::LED: return "led";
+    default: return "?";
+  }
+}
+
+/// Reads a whole file.
+/// \return false, if the file can't be read, true otherwise.
+bool readFile(const char *path, std::vector<char> &content)
+{
+  std::FILE *file = std::fopen(path, "rb");
+  if (!file) return false;
+
+  char chunk[4096];
+  for (size_t length; (length = std::fread(chunk, 1, sizeof(chunk), file));)
+    content.insert(content.end(), chunk, chunk + length);
+  const bool failed = std::ferror(file);
+  std::fclose(file);
+  return !failed;
+}
+
+/// Prints the position of an offset in a file as line:column.
+void printPosition(const char *path, const std::vector<char> &content,
+                   size_t offset)
+{
+  size_t line = 1;
+  size_t column = 1;
+  for (size_t idx = 0; idx != offset && idx != content.size(); idx++)
+  {
+    if (content[idx] == '\n')
+    {
+      line++;
+      column = 1;
+    }
+    else
+    {
+      column++;
+    }
+  }
+  std::fprintf(stderr, "%s:%zu:%zu: ", path, line, column);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    std::fprintf(stderr, "usage: %s <game.json> <game.bin>\n", argv[0]);
+    return 2;
+  }
+  const char *input_path = argv[1];
+  const char *output_path = argv[2];
+
+  std::vector<char> content;
+  if (!readFile(input_path, content))
+  {
+    std::fprintf(stderr, "%s: can't read the file\n", input_path);
+    return 1;
+  }
+
+  static PTS::GameConfig config;
+  PTS::GameConfigParser parser(config);
+  parser.feed(content.data(), content.size());
+  if (!parser.finish())
+  {
+    if (parser.failedModule() < config.module_count &&
+        config.modules[parser.failedModule()].name[0] != '\0')
+    {
+      std::fprintf(stderr, "%s: module \"%s\": %s\n", input_path,
+                   config.modules[parser.failedModule()].name,
+                   parser.error());
+    }
+    else
+    {
+      printPosition(input_path, content, parser.offset());
+      std::fprintf(stderr, "%s\n", parser.error());
+    }
+    return 1;
+  }
+
+  // The image is checked the way the firmware opens it.
+  alignas(PTS::ModuleConfig)
+    uint8_t image[PTS::GameImage::imageSize(PTS::GameConfig::MAX_MODULES)];
+  const size_t length = PTS::GameImage::write(config, image, sizeof(image));
+  PTS::GameImage check;
+  if (length == 0 || check.open(image, length))
+  {
+    std::fprintf(stderr, "%s: the image failed its check\n", output_path);
+    return 1;
+  }
+
+  std::FILE *output = std::fopen(output_path, "wb");
+  if (!output || std::fwrite(image, 1, length, output) != length ||
+      std::fclose(output) != 0)
+  {
+    std::fprintf(stderr, "%s: can't write the file\n", output_path);
+    return 1;
+  }
+
+  std::printf("%s: game \"%s\", %zu bytes (image version %u)\n", output_path,
+              check.name(), length, PTS::GAME_IMAGE_VERSION);
+  for (const PTS::ModuleConfig &module : check)
+    std::printf("  %-16s %s\n", typeName(module.type), module.name);
+  return 0;
+}
@@ -0,0 +1,90 @@
+//===-- tools/scoreboard_client.cpp - Scoreboard feed reference client ----===//
+//
+// Project-Thunderstrike (PTS) collection source file.
+// Find more information at:
+// https://github.com/itsthatMatthew/Project-Thunderstrike
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file This file contains the reference client of the scoreboard feed (see
+/// net/scoreboard_feed.h), a host tool printing the attributes of a board
+/// whenever they change. It decodes the feed with the ScoreboardView of the
+/// firmware. Build and run it from the project directory, on a host in the
+/// network of the board:
+///
+///   c++ -std=gnu++17 -O2 -Isrc tools/scoreboard_client.cpp -o scoreboard
+///   ./scoreboard               (the broadcast feed on the default port)
+///   ./scoreboard 4211 239.1.2.3  (a multicast feed)
+///
+//===----------------------------------------------------------------------===//
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "net/scoreboard_codec.h"
+
+int main(int argc, char **argv)
+{
+  if (argc > 3)
+  {
+    std::fprintf(stderr, "usage: %s [port] [multicast group]\n", argv[0]);
+    return 2;
+  }
+  const int port = argc > 1 ? std::atoi(argv[1]) : 4211;
+
+  const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  const int enable = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  if (fd < 0 ||
+      ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    std::perror("can't listen");
+    return 1;
+  }
+  if (argc > 2)
+  {
+    ip_mreq request{};
+    request.imr_multiaddr.s_addr = ::inet_addr(argv[2]);
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request,
+                     sizeof(request)) != 0)
+    {
+      std::perror("can't join the group");
+      return 1;
+    }
+  }
+
+  static PTS::ScoreboardView<> view;
+  uint32_t printed_version = 0;
+  bool printed_synced = false;
+  uint8_t packet[PTS::SCOREBOARD::PACKET_SIZE];
+  for (;;)
+  {
+    const ssize_t length = ::recv(fd, packet, sizeof(packet), 0);
+    if (length < 0)
+    {
+      std::perror("can't receive");
+      return 1;
+    }
+    if (!view.receive(packet, static_cast<size_t>(length))) continue;
+    if (view.version() == printed_version && view.synced() == printed_synced)
+      continue;
+
+    // A complete frame with changes.
+    printed_version = view.version();
+    printed_synced = view.synced();
+    std::printf("--- version %u%s (%u datagrams, %u lost)\n", printed_version,
+                printed_synced ? "" : ", catching up", view.packets(),
+                view.lost());
+    for (const auto &attribute : view)
+      std::printf("  %-24s %s\n", attribute.name, attribute.value);
+    std::fflush(stdout);
+  }
+}
@@ -0,0 +1,29 @@
+// Keeps the attribute table of the page up to date from the pushed deltas.
+// The rows are updated in place, the page is only reloaded when attributes
+// appear or disappear.
+(function () {
+  var table = document.getElementById('attributes');
+  var events =
+    new EventSource('/api/events?since=' + table.dataset.version);
+
+  events.onmessage = function (event) {
+    var delta = JSON.parse(event.data);
+    if (delta.full) {
+      location.reload();
+      return;
+    }
+    for (var name in delta.attributes) {
+      var row = table.querySelector(
+        'tr[data-name="' + CSS.escape(name) + '"]');
+      if (!row) {
+        location.reload();
+        return;
+      }
+      row.cells[1].textContent = delta.attributes[name].value;
+    }
+  };
+
+  events.addEventListener('reset', function () {
+    location.reload();
+  });
+})();